@@ -0,0 +1,409 @@
+/* Copyright (C) 2003, 2004, 2005, 2006, 2008, 2009 Dean Beeler, Jerome Fisher
+ * Copyright (C) 2011-2019 Dean Beeler, Jerome Fisher, Sergey V. Mikayev
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License as published by
+ *  the Free Software Foundation, either version 2.1 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+
+#include "internals.h"
+
+#include "BenchmarkCorpus.h"
+#include "Structures.h"
+#include "Synth.h"
+
+namespace MT32Emu {
+
+static const Bit32u SAMPLES_PER_MILLISECOND = SAMPLE_RATE / 1000;
+static const Bit32u DEFAULT_TAIL_LENGTH = 2 * SAMPLE_RATE;
+
+// With the default channel assignment, melodic parts 1-8 receive MIDI channels 2-9 and the rhythm part channel 10.
+static const Bit8u FIRST_MELODIC_CHANNEL = 1;
+static const Bit8u RHYTHM_CHANNEL = 9;
+
+static inline Bit32u ms(Bit32u milliseconds) {
+	return milliseconds * SAMPLES_PER_MILLISECOND;
+}
+
+static bool isEarlier(const CorpusEvent &event1, const CorpusEvent &event2) {
+	return event1.timestamp < event2.timestamp;
+}
+
+CorpusSequence::CorpusSequence(const char *useName) : name(useName), tailLength(DEFAULT_TAIL_LENGTH), length(0) {}
+
+const std::string &CorpusSequence::getName() const {
+	return name;
+}
+
+Bit32u CorpusSequence::getLength() const {
+	return length;
+}
+
+const std::vector<CorpusEvent> &CorpusSequence::getEvents() const {
+	return events;
+}
+
+void CorpusSequence::addShortMessage(Bit32u timestamp, Bit32u shortMessage) {
+	CorpusEvent event;
+	event.timestamp = timestamp;
+	event.shortMessage = shortMessage;
+	events.push_back(event);
+}
+
+void CorpusSequence::addNote(Bit32u timestamp, Bit32u duration, Bit8u channel, Bit8u key, Bit8u velocity) {
+	addShortMessage(timestamp, 0x90 | channel | (key << 8) | (velocity << 16));
+	addShortMessage(timestamp + duration, 0x80 | channel | (key << 8) | (64 << 16));
+}
+
+void CorpusSequence::addProgramChange(Bit32u timestamp, Bit8u channel, Bit8u program) {
+	addShortMessage(timestamp, 0xC0 | channel | (program << 8));
+}
+
+void CorpusSequence::addControlChange(Bit32u timestamp, Bit8u channel, Bit8u controller, Bit8u value) {
+	addShortMessage(timestamp, 0xB0 | channel | (controller << 8) | (value << 16));
+}
+
+void CorpusSequence::addPitchBend(Bit32u timestamp, Bit8u channel, Bit32u value) {
+	addShortMessage(timestamp, 0xE0 | channel | ((value & 0x7F) << 8) | (((value >> 7) & 0x7F) << 16));
+}
+
+void CorpusSequence::addMemoryWrite(Bit32u timestamp, Bit32u address, const Bit8u *data, Bit32u dataLength) {
+	CorpusEvent event;
+	event.timestamp = timestamp;
+	event.shortMessage = 0;
+	const Bit8u header[] = {0xF0, SYSEX_MANUFACTURER_ROLAND, 0x10, SYSEX_MDL_MT32, SYSEX_CMD_DT1};
+	event.sysex.assign(header, header + sizeof(header));
+	const Bit8u addressBytes[] = {Bit8u((address >> 16) & 0x7F), Bit8u((address >> 8) & 0x7F), Bit8u(address & 0x7F)};
+	event.sysex.insert(event.sysex.end(), addressBytes, addressBytes + sizeof(addressBytes));
+	event.sysex.insert(event.sysex.end(), data, data + dataLength);
+	Bit32u checksum = 0;
+	for (size_t i = sizeof(header); i < event.sysex.size(); i++) {
+		checksum += event.sysex[i];
+	}
+	event.sysex.push_back(Bit8u((128 - (checksum & 0x7F)) & 0x7F));
+	event.sysex.push_back(0xF7);
+	events.push_back(event);
+}
+
+void CorpusSequence::setTailLength(Bit32u useTailLength) {
+	tailLength = useTailLength;
+}
+
+void CorpusSequence::finish() {
+	std::stable_sort(events.begin(), events.end(), isEarlier);
+	length = (events.empty() ? 0 : events.back().timestamp) + tailLength;
+}
+
+void CorpusSequence::append(const CorpusSequence &sequence) {
+	for (std::vector<CorpusEvent>::const_iterator it = sequence.events.begin(); it != sequence.events.end(); it++) {
+		events.push_back(*it);
+		events.back().timestamp += length;
+	}
+	length += sequence.length;
+}
+
+// Fills in a timbre with a plain, sustained sound, the callers then adjust the structure and the waveforms.
+static void makeBasicTimbre(TimbreParam &timbre, const char *name) {
+	memset(&timbre, 0, sizeof(timbre));
+	memset(timbre.common.name, ' ', sizeof(timbre.common.name));
+	memcpy(timbre.common.name, name, std::min(strlen(name), sizeof(timbre.common.name)));
+	timbre.common.partialMute = 15;
+	for (int t = 0; t < 4; t++) {
+		TimbreParam::PartialParam &partial = timbre.partial[t];
+		partial.wg.pitchCoarse = 36;
+		partial.wg.pitchFine = 50;
+		partial.wg.pitchKeyfollow = 11;
+		partial.wg.pitchBenderEnabled = 1;
+		partial.wg.pulseWidth = Bit8u(20 * t);
+		partial.wg.pulseWidthVeloSensitivity = 7;
+		for (int i = 0; i < 5; i++) {
+			partial.pitchEnv.level[i] = 50;
+		}
+		partial.pitchLFO.rate = 60;
+		partial.pitchLFO.depth = 5;
+		partial.pitchLFO.modSensitivity = 40;
+		partial.tvf.cutoff = 80;
+		partial.tvf.resonance = Bit8u(5 * t);
+		partial.tvf.keyfollow = 11;
+		partial.tvf.biasPoint = 64;
+		partial.tvf.biasLevel = 7;
+		partial.tvf.envDepth = 30;
+		partial.tvf.envTime[0] = 10;
+		partial.tvf.envTime[1] = 40;
+		partial.tvf.envTime[4] = 30;
+		partial.tvf.envLevel[0] = 100;
+		partial.tvf.envLevel[1] = 70;
+		partial.tvf.envLevel[2] = 60;
+		partial.tvf.envLevel[3] = 60;
+		partial.tva.level = 90;
+		partial.tva.veloSensitivity = 50;
+		partial.tva.biasPoint1 = 64;
+		partial.tva.biasLevel1 = 12;
+		partial.tva.biasPoint2 = 64;
+		partial.tva.biasLevel2 = 12;
+		partial.tva.envTime[0] = 5;
+		partial.tva.envTime[1] = 30;
+		partial.tva.envTime[2] = 40;
+		partial.tva.envTime[3] = 50;
+		partial.tva.envTime[4] = 40;
+		partial.tva.envLevel[0] = 100;
+		partial.tva.envLevel[1] = 90;
+		partial.tva.envLevel[2] = 80;
+		partial.tva.envLevel[3] = 75;
+	}
+}
+
+static void addTimbreTempWrite(CorpusSequence &sequence, Bit32u timestamp, Bit8u partNum, const TimbreParam &timbre) {
+	const Bit32u address = MT32EMU_SYSEXMEMADDR(MT32EMU_MEMADDR(0x040000) + partNum * sizeof(TimbreParam));
+	sequence.addMemoryWrite(timestamp, address, reinterpret_cast<const Bit8u *>(&timbre), sizeof(TimbreParam));
+}
+
+static void addReverbSettingsWrite(CorpusSequence &sequence, Bit32u timestamp, Bit8u mode, Bit8u time, Bit8u level) {
+	const Bit8u reverbSettings[] = {mode, time, level};
+	sequence.addMemoryWrite(timestamp, 0x100001, reverbSettings, sizeof(reverbSettings));
+}
+
+// Writes a single byte of the PatchParam in the patch temp area of a part, at the given offset.
+static void addPatchTempWrite(CorpusSequence &sequence, Bit32u timestamp, Bit8u partNum, size_t offset, Bit8u value) {
+	const Bit32u address = MT32EMU_SYSEXMEMADDR(MT32EMU_MEMADDR(0x030000) + partNum * sizeof(MemParams::PatchTemp) + offset);
+	sequence.addMemoryWrite(timestamp, address, &value, 1);
+}
+
+static void addRhythmTempReverbSwitchWrite(CorpusSequence &sequence, Bit32u timestamp, Bit8u key, Bit8u reverbSwitch) {
+	const Bit32u address = MT32EMU_SYSEXMEMADDR(MT32EMU_MEMADDR(0x030110) + (key - 24) * sizeof(MemParams::RhythmTemp)
+		+ offsetof(MemParams::RhythmTemp, reverbSwitch));
+	sequence.addMemoryWrite(timestamp, address, &reverbSwitch, 1);
+}
+
+static void makeChordsSequence(CorpusSequence &sequence) {
+	for (Bit8u part = 0; part < 8; part++) {
+		sequence.addProgramChange(0, FIRST_MELODIC_CHANNEL + part, Bit8u(part * 16 + 3));
+	}
+	for (Bit32u bar = 0; bar < 16; bar++) {
+		for (Bit8u part = 0; part < 8; part++) {
+			// Half of the parts play in each bar.
+			if ((bar + part) % 2 != 0) continue;
+			const Bit8u root = Bit8u(48 + (bar * 5 + part * 3) % 24);
+			const Bit8u velocity = Bit8u(60 + (bar * 7 + part * 11) % 50);
+			for (Bit8u interval = 0; interval <= 7; interval += (interval == 0 ? 4 : 3)) {
+				sequence.addNote(ms(1000 * bar + 10 * part), ms(900), FIRST_MELODIC_CHANNEL + part, root + interval, velocity);
+			}
+		}
+	}
+}
+
+static void makeDrumsSequence(CorpusSequence &sequence) {
+	static const Bit8u TOMS[] = {41, 43, 45, 47, 48, 50};
+	for (Bit32u eighth = 0; eighth < 64; eighth++) {
+		const Bit32u timestamp = ms(250 * eighth);
+		if (eighth % 4 == 0) sequence.addNote(timestamp, ms(100), RHYTHM_CHANNEL, 36, 110);
+		if (eighth % 4 == 2) sequence.addNote(timestamp, ms(100), RHYTHM_CHANNEL, 38, 100);
+		sequence.addNote(timestamp, ms(50), RHYTHM_CHANNEL, eighth % 8 == 7 ? 46 : 42, Bit8u(60 + (eighth * 13) % 40));
+		if (eighth % 16 >= 12) sequence.addNote(timestamp + ms(125), ms(100), RHYTHM_CHANNEL, TOMS[eighth % 6], 90);
+		if (eighth % 32 == 0) sequence.addNote(timestamp, ms(100), RHYTHM_CHANNEL, 49, 100);
+	}
+}
+
+static void makePitchBendSequence(CorpusSequence &sequence) {
+	const Bit8u channel = FIRST_MELODIC_CHANNEL;
+	sequence.addProgramChange(0, channel, 10);
+	sequence.addProgramChange(0, channel + 1, 52);
+	for (Bit32u phrase = 0; phrase < 4; phrase++) {
+		const Bit32u phraseStart = ms(2000 * phrase);
+		sequence.addNote(phraseStart, ms(1800), channel, Bit8u(55 + 3 * phrase), 100);
+		sequence.addNote(phraseStart, ms(1800), channel, Bit8u(62 + 3 * phrase), 90);
+		// Triangle sweep of the bender over the full range, one step each 10 ms.
+		for (Bit32u step = 0; step < 180; step++) {
+			const Bit32u position = step % 90;
+			const Bit32u bend = position < 45 ? 8192 + position * 180 : 8192 + (90 - position) * 180;
+			sequence.addPitchBend(phraseStart + ms(10 * step), channel, phrase % 2 == 0 ? bend : 16384 - bend);
+		}
+		sequence.addControlChange(phraseStart, channel + 1, 1, Bit8u(phrase * 40));
+		sequence.addControlChange(phraseStart, channel + 1, 64, 127);
+		for (Bit32u note = 0; note < 8; note++) {
+			sequence.addNote(phraseStart + ms(200 * note), ms(100), channel + 1, Bit8u(60 + (note * 5) % 12), 80);
+		}
+		sequence.addControlChange(phraseStart + ms(1900), channel + 1, 64, 0);
+	}
+	sequence.addPitchBend(ms(8000), channel, 8192);
+}
+
+static void makePartialStealingSequence(CorpusSequence &sequence) {
+	for (Bit8u part = 0; part < 8; part++) {
+		sequence.addProgramChange(0, FIRST_MELODIC_CHANNEL + part, Bit8u(part * 8 + 1));
+	}
+	for (Bit32u cluster = 0; cluster < 40; cluster++) {
+		const Bit8u part = Bit8u(cluster % 8);
+		for (Bit8u note = 0; note < 6; note++) {
+			sequence.addNote(ms(150 * cluster), ms(1000), FIRST_MELODIC_CHANNEL + part, Bit8u(40 + (cluster * 7 + note * 5) % 48), 100);
+		}
+		if (cluster % 2 == 0) sequence.addNote(ms(150 * cluster), ms(100), RHYTHM_CHANNEL, cluster % 4 == 0 ? 36 : 38, 120);
+	}
+}
+
+static void makeRingModulationSequence(CorpusSequence &sequence) {
+	TimbreParam timbre;
+	makeBasicTimbre(timbre, "RingMod");
+	// Synth partials ring modulated and mixed, followed by a PCM partial ring modulated by a synth one.
+	timbre.common.partialStructure12 = 1;
+	timbre.common.partialStructure34 = 10;
+	timbre.partial[1].wg.waveform = 1;
+	timbre.partial[1].wg.pitchCoarse = 43;
+	timbre.partial[2].wg.pcmWave = 3;
+	timbre.partial[3].wg.pitchCoarse = 31;
+	addTimbreTempWrite(sequence, 0, 0, timbre);
+	for (Bit32u note = 0; note < 12; note++) {
+		sequence.addNote(ms(50 + 500 * note), ms(400), FIRST_MELODIC_CHANNEL, Bit8u(36 + note * 3), Bit8u(70 + note * 3));
+	}
+}
+
+static void makePCMLoopsSequence(CorpusSequence &sequence) {
+	TimbreParam timbre;
+	makeBasicTimbre(timbre, "PCMLoops");
+	// Both pairs consist of PCM partials that use looped waves with distinct periods.
+	timbre.common.partialStructure12 = 5;
+	timbre.common.partialStructure34 = 5;
+	for (int t = 0; t < 4; t++) {
+		timbre.partial[t].wg.pcmWave = Bit8u(4 * t + 1);
+		timbre.partial[t].wg.pitchFine = Bit8u(45 + 3 * t);
+	}
+	addTimbreTempWrite(sequence, 0, 1, timbre);
+	for (Bit32u note = 0; note < 4; note++) {
+		sequence.addNote(ms(50 + 1500 * note), ms(3000), FIRST_MELODIC_CHANNEL + 1, Bit8u(30 + note * 19), 100);
+	}
+}
+
+static void makeReverbModesSequence(CorpusSequence &sequence) {
+	sequence.addProgramChange(0, FIRST_MELODIC_CHANNEL, 20);
+	for (Bit8u mode = 0; mode < 4; mode++) {
+		const Bit32u modeStart = ms(2500 * mode);
+		addReverbSettingsWrite(sequence, modeStart, mode, Bit8u(7 - mode), 7);
+		for (Bit32u note = 0; note < 4; note++) {
+			sequence.addNote(modeStart + ms(20 + 250 * note), ms(80), FIRST_MELODIC_CHANNEL, Bit8u(60 + 4 * note), 110);
+		}
+		sequence.addNote(modeStart + ms(1000), ms(80), RHYTHM_CHANNEL, 38, 120);
+	}
+}
+
+static void makeReverbSwitchSequence(CorpusSequence &sequence) {
+	for (Bit8u part = 0; part < 8; part++) {
+		sequence.addProgramChange(0, FIRST_MELODIC_CHANNEL + part, Bit8u(part * 16 + 5));
+	}
+	// A program change reloads the reverb switch of the part, so the switches are only turned off after those are handled.
+	// Half of the melodic parts and the snare drum bypass reverb, the rest of the output is still fed to reverb.
+	for (Bit8u part = 0; part < 8; part += 2) {
+		addPatchTempWrite(sequence, ms(20), part, offsetof(PatchParam, reverbSwitch), 0);
+	}
+	addRhythmTempReverbSwitchWrite(sequence, ms(20), 38, 0);
+	for (Bit32u bar = 0; bar < 8; bar++) {
+		for (Bit8u part = 0; part < 8; part++) {
+			if ((bar + part) % 4 >= 2) continue;
+			const Bit8u root = Bit8u(48 + (bar * 7 + part * 5) % 24);
+			sequence.addNote(ms(100 + 1000 * bar + 10 * part), ms(700), FIRST_MELODIC_CHANNEL + part, root, 100);
+			sequence.addNote(ms(100 + 1000 * bar + 10 * part), ms(700), FIRST_MELODIC_CHANNEL + part, root + 7, 90);
+		}
+		for (Bit32u beat = 0; beat < 4; beat++) {
+			sequence.addNote(ms(100 + 1000 * bar + 250 * beat), ms(100), RHYTHM_CHANNEL, beat % 2 == 0 ? 36 : 38, 110);
+		}
+	}
+}
+
+// Bursts of controller messages as sent by a hardware controller or a sequencer that doesn't thin them out,
+// with several messages of each kind sharing a timestamp or following within the same control tick.
+// Some bursts are interrupted with notes and SysEx messages.
+static void makeDenseControllersSequence(CorpusSequence &sequence) {
+	const Bit8u channel = FIRST_MELODIC_CHANNEL;
+	for (Bit8u part = 0; part < 3; part++) {
+		sequence.addProgramChange(0, channel + part, Bit8u(part * 16 + 7));
+	}
+	for (Bit32u phrase = 0; phrase < 4; phrase++) {
+		const Bit32u phraseStart = ms(1000 * phrase);
+		for (Bit8u part = 0; part < 3; part++) {
+			sequence.addNote(phraseStart, ms(900), channel + part, Bit8u(48 + 12 * part + phrase), 100);
+		}
+		for (Bit32u burst = 0; burst < 40; burst++) {
+			// The bursts start at different phases of the control tick.
+			const Bit32u burstStart = phraseStart + ms(20 * burst) + burst % 8;
+			for (Bit32u i = 0; i < 4; i++) {
+				const Bit32u step = burst * 4 + i;
+				sequence.addPitchBend(burstStart + i / 2, channel, 6144 + (step * 731) % 4096);
+				sequence.addControlChange(burstStart + i, channel + 1, 1, Bit8u((step * 3) % 128));
+				sequence.addControlChange(burstStart + i, channel + 2, i % 2 == 0 ? 7 : 11, Bit8u(127 - (burst + i) % 64));
+			}
+			if (burst % 10 == 5) {
+				sequence.addNote(burstStart + 1, ms(50), channel, Bit8u(72 + phrase), 90);
+			} else if (burst % 10 == 7) {
+				addPatchTempWrite(sequence, burstStart + 1, 0, offsetof(PatchParam, benderRange), Bit8u(2 + (burst + phrase) % 10));
+			}
+		}
+	}
+	sequence.addPitchBend(ms(4000), channel, 8192);
+}
+
+void makeBenchmarkCorpus(std::vector<CorpusSequence> &corpus) {
+	corpus.clear();
+	corpus.push_back(CorpusSequence("chords"));
+	makeChordsSequence(corpus.back());
+	corpus.push_back(CorpusSequence("drums"));
+	makeDrumsSequence(corpus.back());
+	corpus.push_back(CorpusSequence("pitch-bend"));
+	makePitchBendSequence(corpus.back());
+	corpus.push_back(CorpusSequence("partial-stealing"));
+	makePartialStealingSequence(corpus.back());
+	corpus.push_back(CorpusSequence("ring-modulation"));
+	makeRingModulationSequence(corpus.back());
+	corpus.push_back(CorpusSequence("pcm-loops"));
+	makePCMLoopsSequence(corpus.back());
+	corpus.push_back(CorpusSequence("reverb-modes"));
+	makeReverbModesSequence(corpus.back());
+	corpus.push_back(CorpusSequence("reverb-switch"));
+	makeReverbSwitchSequence(corpus.back());
+	corpus.push_back(CorpusSequence("dense-controllers"));
+	makeDenseControllersSequence(corpus.back());
+	for (size_t i = 0; i < corpus.size(); i++) {
+		corpus[i].finish();
+	}
+}
+
+CorpusPlayer::CorpusPlayer(Synth &useSynth, const CorpusSequence &useSequence, bool useLooped) :
+	synth(useSynth), sequence(useSequence), looped(useLooped), startTimestamp(useSynth.getInternalRenderedSampleCount()), nextEventIx(0)
+{}
+
+void CorpusPlayer::enqueueEvents(Bit32u lookAheadLength) {
+	const std::vector<CorpusEvent> &events = sequence.getEvents();
+	const Bit32u horizon = synth.getInternalRenderedSampleCount() + lookAheadLength;
+	for (;;) {
+		if (nextEventIx == events.size()) {
+			if (!looped || Bit32s(horizon - (startTimestamp + sequence.getLength())) < 0) return;
+			startTimestamp += sequence.getLength();
+			nextEventIx = 0;
+			continue;
+		}
+		const CorpusEvent &event = events[nextEventIx];
+		const Bit32u timestamp = startTimestamp + event.timestamp;
+		if (Bit32s(timestamp - horizon) >= 0) return;
+		const bool enqueued = event.sysex.empty() ? synth.playMsg(event.shortMessage, timestamp) : synth.playSysex(&event.sysex[0], Bit32u(event.sysex.size()), timestamp);
+		// The queue is full, try again later.
+		if (!enqueued) return;
+		nextEventIx++;
+	}
+}
+
+bool CorpusPlayer::isFinished() const {
+	return !looped && nextEventIx == sequence.getEvents().size();
+}
+
+} // namespace MT32Emu
@@ -0,0 +1,101 @@
+/* Copyright (C) 2003, 2004, 2005, 2006, 2008, 2009 Dean Beeler, Jerome Fisher
+ * Copyright (C) 2011-2019 Dean Beeler, Jerome Fisher, Sergey V. Mikayev
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License as published by
+ *  the Free Software Foundation, either version 2.1 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef MT32EMU_BENCHMARK_CORPUS_H
+#define MT32EMU_BENCHMARK_CORPUS_H
+
+#include <string>
+#include <vector>
+
+#include "Types.h"
+
+namespace MT32Emu {
+
+class Synth;
+
+struct CorpusEvent {
+	// In samples at the internal synth sample rate, relative to the start of the sequence.
+	Bit32u timestamp;
+	// Short MIDI message, or 0 for a SysEx message.
+	Bit32u shortMessage;
+	std::vector<Bit8u> sysex;
+};
+
+// Timed MIDI sequence that is generated programmatically rather than loaded from a standard MIDI file,
+// so that the benchmarks and the tests have no external dependencies.
+class CorpusSequence {
+public:
+	explicit CorpusSequence(const char *name);
+
+	const std::string &getName() const;
+	// Returns the length of the sequence in samples at the internal synth sample rate, including the release tail.
+	Bit32u getLength() const;
+	const std::vector<CorpusEvent> &getEvents() const;
+
+	void addShortMessage(Bit32u timestamp, Bit32u shortMessage);
+	void addNote(Bit32u timestamp, Bit32u duration, Bit8u channel, Bit8u key, Bit8u velocity);
+	void addProgramChange(Bit32u timestamp, Bit8u channel, Bit8u program);
+	void addControlChange(Bit32u timestamp, Bit8u channel, Bit8u controller, Bit8u value);
+	void addPitchBend(Bit32u timestamp, Bit8u channel, Bit32u value);
+	// Adds a Roland DT1 SysEx message that writes the data at the given (SysEx-padded) address of the MT-32 memory.
+	void addMemoryWrite(Bit32u timestamp, Bit32u address, const Bit8u *data, Bit32u length);
+	// Keeps the sequence going for the given number of samples after the last event.
+	void setTailLength(Bit32u tailLength);
+
+	// Must be called once all the events are added.
+	void finish();
+
+	// Appends all the events of another finished sequence, so that they follow the tail of this finished sequence.
+	void append(const CorpusSequence &sequence);
+
+private:
+	std::string name;
+	std::vector<CorpusEvent> events;
+	Bit32u tailLength;
+	Bit32u length;
+};
+
+// Builds the corpus of MIDI sequences which covers polyphonic chords on all the melodic parts, drums, pitch bends,
+// partial stealing, ring modulation, looped PCM waves, all the reverb modes, parts that bypass reverb and bursts
+// of dense controller messages.
+void makeBenchmarkCorpus(std::vector<CorpusSequence> &corpus);
+
+// Feeds the events of a sequence to a synth, in pieces, as the rendering goes on.
+class CorpusPlayer {
+public:
+	// Unless looped, the events of the sequence are only played once.
+	CorpusPlayer(Synth &synth, const CorpusSequence &sequence, bool looped);
+
+	// Enqueues the events that are due before the given number of samples is rendered after the current position.
+	// When a looped sequence ends, it starts over.
+	void enqueueEvents(Bit32u lookAheadLength);
+
+	// Returns true when all the events of a sequence that is not looped are enqueued.
+	bool isFinished() const;
+
+private:
+	Synth &synth;
+	const CorpusSequence &sequence;
+	const bool looped;
+	// Value of the synth rendered sample counter at the beginning of the current pass through the sequence.
+	Bit32u startTimestamp;
+	size_t nextEventIx;
+};
+
+} // namespace MT32Emu
+
+#endif // #ifndef MT32EMU_BENCHMARK_CORPUS_H
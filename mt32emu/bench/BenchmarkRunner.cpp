@@ -0,0 +1,155 @@
+/* Copyright (C) 2003, 2004, 2005, 2006, 2008, 2009 Dean Beeler, Jerome Fisher
+ * Copyright (C) 2011-2019 Dean Beeler, Jerome Fisher, Sergey V. Mikayev
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License as published by
+ *  the Free Software Foundation, either version 2.1 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+#include "internals.h"
+
+#include "BenchmarkRunner.h"
+#include "Clock.h"
+#include "CPUFeatures.h"
+#include "Synth.h"
+
+namespace MT32Emu {
+
+static const Bit32u DEFAULT_REPETITION_COUNT = 10;
+static const Bit32u DEFAULT_SAMPLE_COUNT = 4 * SAMPLE_RATE;
+
+static volatile double sink = 0;
+
+static void printJSONString(FILE *out, const std::string &str) {
+	fputc('"', out);
+	for (std::string::const_iterator it = str.begin(); it != str.end(); it++) {
+		if (*it == '"' || *it == '\\') fputc('\\', out);
+		fputc(*it, out);
+	}
+	fputc('"', out);
+}
+
+BenchmarkRunner::BenchmarkRunner() : repetitionCount(DEFAULT_REPETITION_COUNT), sampleCount(DEFAULT_SAMPLE_COUNT) {}
+
+BenchmarkRunner::~BenchmarkRunner() {
+	for (size_t i = 0; i < benchmarks.size(); i++) {
+		delete benchmarks[i];
+	}
+}
+
+void BenchmarkRunner::add(Benchmark *benchmark) {
+	benchmarks.push_back(benchmark);
+}
+
+void BenchmarkRunner::setFilter(const char *useFilter) {
+	filter = useFilter == NULL ? "" : useFilter;
+}
+
+void BenchmarkRunner::setRepetitionCount(Bit32u useRepetitionCount) {
+	repetitionCount = useRepetitionCount > 0 ? useRepetitionCount : 1;
+}
+
+void BenchmarkRunner::setSampleCount(Bit32u useSampleCount) {
+	sampleCount = useSampleCount > 0 ? useSampleCount : 1;
+}
+
+bool BenchmarkRunner::matchesFilter(const Benchmark &benchmark) const {
+	return filter.empty() || strstr(benchmark.getName(), filter.c_str()) != NULL;
+}
+
+void BenchmarkRunner::list(FILE *out) const {
+	for (size_t i = 0; i < benchmarks.size(); i++) {
+		if (matchesFilter(*benchmarks[i])) fprintf(out, "%s\n", benchmarks[i]->getName());
+	}
+}
+
+BenchmarkResult BenchmarkRunner::measure(Benchmark &benchmark) {
+	std::vector<double> timings;
+	benchmark.setUp();
+	// The first run is not measured, it only warms up the caches and the branch predictor.
+	benchmark.run(sampleCount);
+	for (Bit32u repetition = 0; repetition < repetitionCount; repetition++) {
+		benchmark.reset();
+		double startNanos = Clock::getNanoseconds();
+		benchmark.run(sampleCount);
+		timings.push_back((Clock::getNanoseconds() - startNanos) / sampleCount);
+	}
+	benchmark.tearDown();
+
+	BenchmarkResult result;
+	result.name = benchmark.getName();
+	result.sampleCount = sampleCount;
+	result.repetitionCount = repetitionCount;
+	std::sort(timings.begin(), timings.end());
+	result.min = timings.front();
+	size_t middle = timings.size() / 2;
+	result.median = (timings.size() & 1) ? timings[middle] : 0.5 * (timings[middle - 1] + timings[middle]);
+	double sum = 0;
+	for (size_t i = 0; i < timings.size(); i++) {
+		sum += timings[i];
+	}
+	result.mean = sum / timings.size();
+	double squaredDeviationSum = 0;
+	for (size_t i = 0; i < timings.size(); i++) {
+		squaredDeviationSum += (timings[i] - result.mean) * (timings[i] - result.mean);
+	}
+	result.stddev = timings.size() > 1 ? sqrt(squaredDeviationSum / (timings.size() - 1)) : 0;
+	return result;
+}
+
+void BenchmarkRunner::run(FILE *progressOut) {
+	results.clear();
+	for (size_t i = 0; i < benchmarks.size(); i++) {
+		Benchmark &benchmark = *benchmarks[i];
+		if (!matchesFilter(benchmark)) continue;
+		if (progressOut != NULL) {
+			fprintf(progressOut, "Running %s...\n", benchmark.getName());
+			fflush(progressOut);
+		}
+		results.push_back(measure(benchmark));
+	}
+}
+
+void BenchmarkRunner::printTable(FILE *out) const {
+	fprintf(out, "%-48s %12s %12s %12s %12s\n", "Benchmark (ns/sample)", "min", "median", "mean", "stddev");
+	for (size_t i = 0; i < results.size(); i++) {
+		const BenchmarkResult &result = results[i];
+		fprintf(out, "%-48s %12.3f %12.3f %12.3f %12.3f\n", result.name.c_str(), result.min, result.median, result.mean, result.stddev);
+	}
+}
+
+void BenchmarkRunner::printJSON(FILE *out) const {
+	fprintf(out, "{\n\t\"library_version\": \"%s\",\n\t\"cpu_level\": \"%s\",\n\t\"unit\": \"ns/sample\",\n\t\"benchmarks\": [",
+		Synth::getLibraryVersionString(), CPUFeatures::getLevelName(CPUFeatures::getActiveLevel()));
+	for (size_t i = 0; i < results.size(); i++) {
+		const BenchmarkResult &result = results[i];
+		fprintf(out, i == 0 ? "\n\t\t{\"name\": " : ",\n\t\t{\"name\": ");
+		printJSONString(out, result.name);
+		fprintf(out, ", \"samples\": %u, \"repetitions\": %u, \"min\": %.4f, \"median\": %.4f, \"mean\": %.4f, \"stddev\": %.4f}",
+			result.sampleCount, result.repetitionCount, result.min, result.median, result.mean, result.stddev);
+	}
+	fprintf(out, "\n\t]\n}\n");
+}
+
+double BenchmarkRunner::getSink() {
+	return sink;
+}
+
+void BenchmarkRunner::consume(double value) {
+	sink = sink + value;
+}
+
+} // namespace MT32Emu
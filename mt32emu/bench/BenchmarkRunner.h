@@ -0,0 +1,90 @@
+/* Copyright (C) 2003, 2004, 2005, 2006, 2008, 2009 Dean Beeler, Jerome Fisher
+ * Copyright (C) 2011-2019 Dean Beeler, Jerome Fisher, Sergey V. Mikayev
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License as published by
+ *  the Free Software Foundation, either version 2.1 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef MT32EMU_BENCHMARK_RUNNER_H
+#define MT32EMU_BENCHMARK_RUNNER_H
+
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#include "Types.h"
+
+namespace MT32Emu {
+
+// Interface of a single benchmark case. The runner measures the time spent in run() that is expected to process
+// the requested number of samples. setUp(), reset() and tearDown() are excluded from the measurement.
+class Benchmark {
+public:
+	virtual ~Benchmark() {}
+	virtual const char *getName() const = 0;
+	virtual void setUp() {}
+	// Invoked before each measured run. Benchmarks that advance through their input should restore the initial state here,
+	// so that each repetition processes the same content.
+	virtual void reset() {}
+	virtual void run(Bit32u sampleCount) = 0;
+	virtual void tearDown() {}
+};
+
+struct BenchmarkResult {
+	std::string name;
+	Bit32u sampleCount;
+	Bit32u repetitionCount;
+	// Figures below are in nanoseconds per processed sample.
+	double min;
+	double median;
+	double mean;
+	double stddev;
+};
+
+// Owns the registered benchmarks, runs those matching the filter and reports the per-sample timings
+// as a human-readable table or as JSON suitable for comparing the results across commits.
+class BenchmarkRunner {
+public:
+	BenchmarkRunner();
+	~BenchmarkRunner();
+
+	// Takes ownership of the benchmark.
+	void add(Benchmark *benchmark);
+
+	void setFilter(const char *filter);
+	void setRepetitionCount(Bit32u repetitionCount);
+	void setSampleCount(Bit32u sampleCount);
+
+	void list(FILE *out) const;
+	void run(FILE *progressOut);
+	void printTable(FILE *out) const;
+	void printJSON(FILE *out) const;
+
+	// Returns a sum of the values passed to consume(), so that the compiler cannot discard the benchmarked computations.
+	static double getSink();
+	static void consume(double value);
+
+private:
+	std::vector<Benchmark *> benchmarks;
+	std::vector<BenchmarkResult> results;
+	std::string filter;
+	Bit32u repetitionCount;
+	Bit32u sampleCount;
+
+	bool matchesFilter(const Benchmark &benchmark) const;
+	BenchmarkResult measure(Benchmark &benchmark);
+};
+
+} // namespace MT32Emu
+
+#endif // #ifndef MT32EMU_BENCHMARK_RUNNER_H
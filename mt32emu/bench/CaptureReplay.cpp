@@ -0,0 +1,376 @@
+/* Copyright (C) 2003, 2004, 2005, 2006, 2008, 2009 Dean Beeler, Jerome Fisher
+ * Copyright (C) 2011-2019 Dean Beeler, Jerome Fisher, Sergey V. Mikayev
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License as published by
+ *  the Free Software Foundation, either version 2.1 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <cstdarg>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+#include "internals.h"
+
+#include "CaptureReplay.h"
+#include "Clock.h"
+#include "FileStream.h"
+#include "MidiCapture.h"
+#include "ROMInfo.h"
+#include "Synth.h"
+#include "SyntheticROMs.h"
+
+namespace MT32Emu {
+
+// Number of output frames rendered in one go at most, roughly corresponds to a typical audio buffer.
+static const Bit32u BLOCK_SIZE = 512;
+
+static const char * const RECORD_TYPE_NAMES[] = {
+	"short messages", "SysEx messages", "setting changes", "memory writes", "soft resets", "end marks"
+};
+
+// Keeps the report clean of the synth status messages.
+class QuietReportHandler : public ReportHandler {
+public:
+	void printDebug(const char *, va_list) {}
+	void showLCDMessage(const char *) {}
+};
+
+// The whole capture is loaded upfront, so that reading the file does not affect the timings.
+class LoadedCapture {
+public:
+	MidiCaptureHeader header;
+	std::vector<MidiCaptureRecord> records;
+	Bit32u recordCounts[MidiCaptureRecordType_END + 1];
+
+	bool load(const char *fileName, FILE *report) {
+		MidiCaptureReader reader;
+		if (!reader.open(fileName)) {
+			fprintf(report, "Unable to read MIDI capture from %s\n", fileName);
+			return false;
+		}
+		header = reader.getHeader();
+		memset(recordCounts, 0, sizeof(recordCounts));
+		std::vector<size_t> dataOffsets;
+		MidiCaptureRecord record;
+		while (reader.read(record)) {
+			dataOffsets.push_back(data.size());
+			data.insert(data.end(), record.sysexData, record.sysexData + record.sysexLength);
+			records.push_back(record);
+			recordCounts[record.type]++;
+		}
+		if (reader.isCorrupted()) {
+			fprintf(report, "Warning: MIDI capture is corrupted after %u records, replaying what has been read\n", Bit32u(records.size()));
+		}
+		for (size_t i = 0; i < records.size(); i++) {
+			records[i].sysexData = records[i].sysexLength > 0 ? &data[dataOffsets[i]] : NULL;
+		}
+		return true;
+	}
+
+private:
+	std::vector<Bit8u> data;
+};
+
+class ROMImages {
+public:
+	ROMImages() : controlROMFile(NULL), pcmROMFile(NULL), controlROMImage(NULL), pcmROMImage(NULL) {}
+
+	~ROMImages() {
+		if (controlROMImage != NULL) ROMImage::freeROMImage(controlROMImage);
+		if (pcmROMImage != NULL) ROMImage::freeROMImage(pcmROMImage);
+		delete controlROMFile;
+		delete pcmROMFile;
+	}
+
+	bool load(const CaptureReplayOptions &options, const MidiCaptureHeader &header, FILE *report) {
+		if (options.controlROMFileName == NULL && options.pcmROMFileName == NULL) {
+			if (strcmp(header.controlROMSHA1, syntheticROMs.getControlROMImage().getFile()->getSHA1()) == 0
+				&& strcmp(header.pcmROMSHA1, syntheticROMs.getPCMROMImage().getFile()->getSHA1()) == 0) {
+				return true;
+			}
+			fprintf(report, "MIDI capture was taken with ROMs %s and %s, the ROM images must be specified\n", header.controlROMShortName, header.pcmROMShortName);
+			return false;
+		}
+		if (options.controlROMFileName == NULL || options.pcmROMFileName == NULL) {
+			fprintf(report, "Both the control and the PCM ROM images must be specified\n");
+			return false;
+		}
+		controlROMImage = loadROMImage(controlROMFile, options.controlROMFileName, header.controlROMSHA1, report);
+		pcmROMImage = loadROMImage(pcmROMFile, options.pcmROMFileName, header.pcmROMSHA1, report);
+		return controlROMImage != NULL && pcmROMImage != NULL;
+	}
+
+	const ROMImage &getControlROMImage() const {
+		return controlROMImage != NULL ? *controlROMImage : syntheticROMs.getControlROMImage();
+	}
+
+	const ROMImage &getPCMROMImage() const {
+		return pcmROMImage != NULL ? *pcmROMImage : syntheticROMs.getPCMROMImage();
+	}
+
+private:
+	SyntheticROMs syntheticROMs;
+	FileStream *controlROMFile;
+	FileStream *pcmROMFile;
+	const ROMImage *controlROMImage;
+	const ROMImage *pcmROMImage;
+
+	static const ROMImage *loadROMImage(FileStream *&file, const char *fileName, const char *expectedSHA1, FILE *report) {
+		file = new FileStream;
+		if (!file->open(fileName)) {
+			fprintf(report, "Unable to open ROM image %s\n", fileName);
+			return NULL;
+		}
+		if (strcmp(file->getSHA1(), expectedSHA1) != 0) {
+			fprintf(report, "Warning: ROM image %s differs from the one the MIDI capture was taken with\n", fileName);
+		}
+		return ROMImage::makeROMImage(file);
+	}
+};
+
+class CaptureRenderer {
+public:
+	CaptureRenderer(Synth &useSynth, FILE *useOutputFile) :
+		synth(useSynth), outputFile(useOutputFile), outputSampleRate(synth.getStereoOutputSampleRate()),
+		frameCount(0), digest(2166136261u)
+	{}
+
+	// Renders until the internal rendered sample count reaches the target. In the analogue output modes that resample
+	// the output, the target may be overshot by a sample or so, which is deterministic nevertheless.
+	void renderUntil(Bit32u targetSampleCount) {
+		for (;;) {
+			const Bit32s remaining = Bit32s(targetSampleCount - synth.getInternalRenderedSampleCount());
+			if (remaining <= 0) return;
+			Bit32u frames = Bit32u((double(remaining) * outputSampleRate + SAMPLE_RATE - 1) / SAMPLE_RATE);
+			if (frames > BLOCK_SIZE) frames = BLOCK_SIZE;
+			if (frames == 0) frames = 1;
+			synth.render(buffer, frames);
+			consume(frames);
+		}
+	}
+
+	Bit32u getFrameCount() const {
+		return frameCount;
+	}
+
+	Bit32u getDigest() const {
+		return digest;
+	}
+
+private:
+	Synth &synth;
+	FILE *outputFile;
+	const Bit32u outputSampleRate;
+	Bit32u frameCount;
+	Bit32u digest;
+	Bit16s buffer[2 * BLOCK_SIZE];
+
+	void consume(Bit32u frames) {
+		// FNV-1a over the samples, independent of the host byte order.
+		for (Bit32u i = 0; i < 2 * frames; i++) {
+			const Bit16u sample = Bit16u(buffer[i]);
+			digest = (digest ^ (sample & 0xFF)) * 16777619u;
+			digest = (digest ^ (sample >> 8)) * 16777619u;
+		}
+		if (outputFile != NULL) fwrite(buffer, sizeof(Bit16s), 2 * frames, outputFile);
+		frameCount += frames;
+	}
+};
+
+static float floatFromBits(Bit32u bits) {
+	float value;
+	memcpy(&value, &bits, sizeof(value));
+	return value;
+}
+
+static bool applySetting(Synth &synth, const MidiCaptureRecord &record) {
+	const bool enabled = record.data != 0;
+	switch (record.setting) {
+	case MidiCaptureSetting_REVERB_ENABLED:
+		if (record.timed) return synth.setReverbEnabled(enabled, record.timestamp);
+		synth.setReverbEnabled(enabled);
+		break;
+	case MidiCaptureSetting_REVERB_OVERRIDDEN:
+		synth.setReverbOverridden(enabled);
+		break;
+	case MidiCaptureSetting_REVERB_COMPATIBILITY_MODE:
+		synth.setReverbCompatibilityMode(enabled);
+		break;
+	case MidiCaptureSetting_DAC_INPUT_MODE:
+		if (record.timed) return synth.setDACInputMode(DACInputMode(record.data), record.timestamp);
+		synth.setDACInputMode(DACInputMode(record.data));
+		break;
+	case MidiCaptureSetting_OUTPUT_GAIN:
+		if (record.timed) return synth.setOutputGain(floatFromBits(record.data), record.timestamp);
+		synth.setOutputGain(floatFromBits(record.data));
+		break;
+	case MidiCaptureSetting_REVERB_OUTPUT_GAIN:
+		if (record.timed) return synth.setReverbOutputGain(floatFromBits(record.data), record.timestamp);
+		synth.setReverbOutputGain(floatFromBits(record.data));
+		break;
+	case MidiCaptureSetting_REVERSED_STEREO_ENABLED:
+		if (record.timed) return synth.setReversedStereoEnabled(enabled, record.timestamp);
+		synth.setReversedStereoEnabled(enabled);
+		break;
+	case MidiCaptureSetting_NICE_AMP_RAMP_ENABLED:
+		synth.setNiceAmpRampEnabled(enabled);
+		break;
+	case MidiCaptureSetting_NICE_PANNING_ENABLED:
+		synth.setNicePanningEnabled(enabled);
+		break;
+	case MidiCaptureSetting_NICE_PARTIAL_MIXING_ENABLED:
+		synth.setNicePartialMixingEnabled(enabled);
+		break;
+	case MidiCaptureSetting_CONTROLLER_COALESCING_ENABLED:
+		synth.setControllerCoalescingEnabled(enabled);
+		break;
+	case MidiCaptureSetting_PARTIAL_CULLING_ENABLED:
+		synth.setPartialCullingEnabled(enabled);
+		break;
+	case MidiCaptureSetting_PARTIAL_CULLING_THRESHOLD:
+		synth.setPartialCullingThreshold(record.data);
+		break;
+	case MidiCaptureSetting_PARTIAL_CULLING_HOLD_TIME:
+		synth.setPartialCullingHoldTime(record.data);
+		break;
+	case MidiCaptureSetting_NOTE_RENDER_CACHE_ENABLED:
+		synth.setNoteRenderCacheEnabled(enabled);
+		break;
+	}
+	return true;
+}
+
+struct ReplayResult {
+	double nanos;
+	Bit32u frameCount;
+	Bit32u digest;
+	Bit32u rejectedCount;
+};
+
+static bool replay(const LoadedCapture &capture, const ROMImages &romImages, FILE *outputFile, ReplayResult &result) {
+	const MidiCaptureHeader &header = capture.header;
+	QuietReportHandler reportHandler;
+	Synth synth(&reportHandler);
+	// TVP draws the timer jitter from rand(), it needs to be seeded for the replay to be repeatable.
+	srand(1);
+	synth.selectRendererType(header.rendererType);
+	if (!synth.open(romImages.getControlROMImage(), romImages.getPCMROMImage(), header.partialCount, header.analogOutputMode)) return false;
+	// The captured timestamps already include the MIDI interface delay.
+	synth.setMIDIDelayMode(MIDIDelayMode_IMMEDIATE);
+
+	CaptureRenderer renderer(synth, outputFile);
+	result.rejectedCount = 0;
+	const double startNanos = Clock::getNanoseconds();
+	for (size_t i = 0; i < capture.records.size(); i++) {
+		const MidiCaptureRecord &record = capture.records[i];
+		// Each input is fed at the same point of rendering it was received at originally.
+		renderer.renderUntil(record.renderedSampleCount);
+		bool accepted = true;
+		switch (record.type) {
+		case MidiCaptureRecordType_SHORT_MESSAGE:
+			accepted = synth.playMsg(record.data, record.timestamp);
+			break;
+		case MidiCaptureRecordType_SYSEX:
+			accepted = synth.playSysex(record.sysexData, record.sysexLength, record.timestamp);
+			break;
+		case MidiCaptureRecordType_SETTING:
+			accepted = applySetting(synth, record);
+			break;
+		case MidiCaptureRecordType_MEMORY_WRITE:
+			synth.writeMemory(record.data, record.sysexLength, record.sysexData);
+			break;
+		case MidiCaptureRecordType_SOFT_RESET:
+			synth.softReset();
+			break;
+		case MidiCaptureRecordType_END:
+			break;
+		}
+		if (!accepted) result.rejectedCount++;
+	}
+	result.nanos = Clock::getNanoseconds() - startNanos;
+	result.frameCount = renderer.getFrameCount();
+	result.digest = renderer.getDigest();
+	return true;
+}
+
+int replayCapture(const CaptureReplayOptions &options, FILE *report) {
+	LoadedCapture capture;
+	if (!capture.load(options.captureFileName, report)) return 1;
+	const MidiCaptureHeader &header = capture.header;
+
+	ROMImages romImages;
+	if (!romImages.load(options, header, report)) return 1;
+
+	static const char * const ANALOG_OUTPUT_MODE_NAMES[] = { "digital", "coarse", "accurate", "oversampled" };
+	fprintf(report, "Capture: %s\n", options.captureFileName);
+	fprintf(report, "ROMs: %s, %s\n", header.controlROMShortName, header.pcmROMShortName);
+	fprintf(report, "Synth: %u partials, %s renderer, %s analogue output\n", header.partialCount,
+		header.rendererType == RendererType_FLOAT ? "float" : "int",
+		Bit32u(header.analogOutputMode) < 4 ? ANALOG_OUTPUT_MODE_NAMES[header.analogOutputMode] : "unknown");
+	fprintf(report, "Records:");
+	for (int i = 0; i < MidiCaptureRecordType_END; i++) {
+		fprintf(report, " %u %s%s", capture.recordCounts[i], RECORD_TYPE_NAMES[i], i + 1 < MidiCaptureRecordType_END ? "," : "\n");
+	}
+	if (capture.recordCounts[MidiCaptureRecordType_END] == 0) {
+		fprintf(report, "Warning: MIDI capture lacks the end mark, the tail is not rendered\n");
+	}
+	if (header.startSampleCount != 0) {
+		fprintf(report, "Warning: MIDI capture was started %u samples after the synth had been opened, the initial synth state may differ\n", header.startSampleCount);
+	}
+
+	FILE *outputFile = NULL;
+	if (options.outputFileName != NULL) {
+		outputFile = fopen(options.outputFileName, "wb");
+		if (outputFile == NULL) {
+			fprintf(report, "Unable to open %s for writing\n", options.outputFileName);
+			return 1;
+		}
+	}
+
+	int exitCode = 0;
+	double bestNanos = 0;
+	ReplayResult firstResult;
+	for (Bit32u run = 0; run < options.repetitionCount; run++) {
+		ReplayResult result;
+		if (!replay(capture, romImages, run == 0 ? outputFile : NULL, result)) {
+			fprintf(report, "Unable to open the synth\n");
+			exitCode = 1;
+			break;
+		}
+		const double seconds = result.nanos * 1e-9;
+		const double audioSeconds = double(result.frameCount) / Synth::getStereoOutputSampleRate(header.analogOutputMode);
+		fprintf(report, "Run %u: %u frames in %.3f s, %.1f x realtime, %.1f ns/frame, digest %08x\n", run + 1, result.frameCount,
+			seconds, seconds > 0 ? audioSeconds / seconds : 0.0, result.frameCount > 0 ? result.nanos / result.frameCount : 0.0, result.digest);
+		if (run == 0) {
+			firstResult = result;
+			bestNanos = result.nanos;
+			if (result.rejectedCount > 0) {
+				fprintf(report, "Warning: %u inputs were rejected by the synth\n", result.rejectedCount);
+			}
+		} else {
+			if (result.nanos < bestNanos) bestNanos = result.nanos;
+			if (result.digest != firstResult.digest || result.frameCount != firstResult.frameCount) {
+				fprintf(report, "Error: the replay is not deterministic, run %u differs from run 1\n", run + 1);
+				exitCode = 1;
+			}
+		}
+	}
+	if (exitCode == 0 && options.repetitionCount > 1) {
+		fprintf(report, "Best: %.3f s, %.1f ns/frame\n", bestNanos * 1e-9, firstResult.frameCount > 0 ? bestNanos / firstResult.frameCount : 0.0);
+	}
+	if (outputFile != NULL) fclose(outputFile);
+	return exitCode;
+}
+
+} // namespace MT32Emu
@@ -0,0 +1,46 @@
+/* Copyright (C) 2003, 2004, 2005, 2006, 2008, 2009 Dean Beeler, Jerome Fisher
+ * Copyright (C) 2011-2019 Dean Beeler, Jerome Fisher, Sergey V. Mikayev
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License as published by
+ *  the Free Software Foundation, either version 2.1 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef MT32EMU_CAPTURE_REPLAY_H
+#define MT32EMU_CAPTURE_REPLAY_H
+
+#include <cstdio>
+
+#include "Types.h"
+
+namespace MT32Emu {
+
+struct CaptureReplayOptions {
+	const char *captureFileName;
+	// ROM images to use when the capture was not taken with the synthetic ROMs, may be NULL otherwise.
+	const char *controlROMFileName;
+	const char *pcmROMFileName;
+	// If not NULL, the output of the first run is saved to this file as raw 16-bit stereo samples in native byte order.
+	const char *outputFileName;
+	Bit32u repetitionCount;
+};
+
+// Re-renders a capture recorded with Synth::startMidiCapture() as fast as possible for the specified number of times
+// and reports the timing of each run along with a digest of the rendered output. The replay is deterministic, so the digest
+// must be the same in all runs. It only matches the original output bit-exactly if that was rendered in blocks of the same
+// lengths with the same seed of rand(), which drives the pitch jitter in TVP. The report goes to the given stream.
+// Returns the process exit code.
+int replayCapture(const CaptureReplayOptions &options, FILE *report);
+
+} // namespace MT32Emu
+
+#endif // #ifndef MT32EMU_CAPTURE_REPLAY_H
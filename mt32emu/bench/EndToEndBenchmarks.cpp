@@ -0,0 +1,241 @@
+/* Copyright (C) 2003, 2004, 2005, 2006, 2008, 2009 Dean Beeler, Jerome Fisher
+ * Copyright (C) 2011-2019 Dean Beeler, Jerome Fisher, Sergey V. Mikayev
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License as published by
+ *  the Free Software Foundation, either version 2.1 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <cstdarg>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+#include "internals.h"
+
+#include "EndToEndBenchmarks.h"
+#include "BenchmarkCorpus.h"
+#include "BenchmarkRunner.h"
+#include "SampleRateConverter.h"
+#include "Synth.h"
+#include "SyntheticROMs.h"
+
+namespace MT32Emu {
+
+// Number of output frames rendered in one go, roughly corresponds to a typical audio buffer.
+static const Bit32u BLOCK_SIZE = 512;
+// Numbers of output frames rendered in one go by the benchmarks of the fixed per-call overhead. Emulators rendering
+// in sync with the emulated CPU tend to request a millisecond of output or less at a time.
+static const Bit32u CALL_SIZES[] = {1, 8, 32, 128, 4096};
+static const double CONVERTED_SAMPLE_RATE = 48000.0;
+
+// Keeps the output of the benchmarks clean of the synth status messages.
+class QuietReportHandler : public ReportHandler {
+public:
+	void printDebug(const char *, va_list) {}
+	void showLCDMessage(const char *) {}
+};
+
+static const char *getRendererTypeName(RendererType rendererType) {
+	return rendererType == RendererType_FLOAT ? "float" : "int";
+}
+
+static const char *getAnalogOutputModeName(AnalogOutputMode mode) {
+	switch (mode) {
+	case AnalogOutputMode_DIGITAL_ONLY:
+		return "digital";
+	case AnalogOutputMode_COARSE:
+		return "coarse";
+	case AnalogOutputMode_ACCURATE:
+		return "accurate";
+	case AnalogOutputMode_OVERSAMPLED:
+		return "oversampled";
+	}
+	return "unknown";
+}
+
+static const char *getSRCQualityName(SamplerateConversionQuality quality) {
+	switch (quality) {
+	case SamplerateConversionQuality_FASTEST:
+		return "src-fastest";
+	case SamplerateConversionQuality_FAST:
+		return "src-fast";
+	case SamplerateConversionQuality_GOOD:
+		return "src-good";
+	case SamplerateConversionQuality_BEST:
+		return "src-best";
+	}
+	return "unknown";
+}
+
+// The images are only generated when the first end-to-end benchmark is set up.
+static const SyntheticROMs &getSyntheticROMs() {
+	static const SyntheticROMs syntheticROMs;
+	return syntheticROMs;
+}
+
+template <class Sample>
+class EndToEndBenchmark : public Benchmark {
+public:
+	// When convertSampleRate is false, the output of the synth is taken as is and srcQuality is ignored.
+	// Unless callSize is 0, the output is requested in pieces of callSize frames rather than in blocks of BLOCK_SIZE.
+	EndToEndBenchmark(const CorpusSequence &useSequence, RendererType useRendererType, AnalogOutputMode useAnalogOutputMode,
+		bool useConvertSampleRate, SamplerateConversionQuality useSRCQuality, Bit32u callSize, bool useNoteRenderCache) :
+		sequence(useSequence), rendererType(useRendererType), analogOutputMode(useAnalogOutputMode),
+		convertSampleRate(useConvertSampleRate), srcQuality(useSRCQuality), blockSize(callSize == 0 ? BLOCK_SIZE : callSize),
+		noteRenderCache(useNoteRenderCache), synth(NULL), sampleRateConverter(NULL), player(NULL), buffer(2 * blockSize)
+	{
+		name = std::string("EndToEnd/") + getRendererTypeName(rendererType) + "/" + getAnalogOutputModeName(analogOutputMode)
+			+ "/" + (convertSampleRate ? getSRCQualityName(srcQuality) : "native") + "/" + sequence.getName();
+		if (callSize != 0) {
+			char callSizeName[24];
+			sprintf(callSizeName, "/call-%u", callSize);
+			name += callSizeName;
+		}
+		if (noteRenderCache) {
+			name += "/note-cache";
+		}
+	}
+
+	~EndToEndBenchmark() {
+		tearDown();
+	}
+
+	const char *getName() const {
+		return name.c_str();
+	}
+
+	void setUp() {
+		const SyntheticROMs &roms = getSyntheticROMs();
+		// TVP draws the timer jitter from rand(), it needs to be seeded for the repetitions to render the same output.
+		srand(1);
+		synth = new Synth(&reportHandler);
+		synth->selectRendererType(rendererType);
+		synth->setNoteRenderCacheEnabled(noteRenderCache);
+		if (!synth->open(roms.getControlROMImage(), roms.getPCMROMImage(), analogOutputMode)) {
+			fprintf(stderr, "%s: unable to open synth with the synthetic ROMs\n", name.c_str());
+			delete synth;
+			synth = NULL;
+			return;
+		}
+		if (convertSampleRate) {
+			sampleRateConverter = new SampleRateConverter(*synth, CONVERTED_SAMPLE_RATE, srcQuality);
+		}
+		player = new CorpusPlayer(*synth, sequence, true);
+	}
+
+	void reset() {
+		// The corpus is played in a loop, so it would be at a different position each time otherwise.
+		tearDown();
+		setUp();
+	}
+
+	void run(Bit32u sampleCount) {
+		if (synth == NULL) return;
+		double sum = 0;
+		while (sampleCount > 0) {
+			const Bit32u length = sampleCount < blockSize ? sampleCount : blockSize;
+			// The output sample rate is never below the internal one, so a block never spans more internal samples.
+			// The events are enqueued ahead the same way regardless of the block size, so that the timing is the same.
+			player->enqueueEvents(blockSize > BLOCK_SIZE ? blockSize : BLOCK_SIZE);
+			if (sampleRateConverter != NULL) {
+				sampleRateConverter->getOutputSamples(&buffer[0], length);
+			} else {
+				synth->render(&buffer[0], length);
+			}
+			sum += buffer[0] + buffer[2 * length - 1];
+			sampleCount -= length;
+		}
+		BenchmarkRunner::consume(sum);
+	}
+
+	void tearDown() {
+		delete player;
+		player = NULL;
+		delete sampleRateConverter;
+		sampleRateConverter = NULL;
+		if (synth != NULL) {
+			synth->close();
+			delete synth;
+			synth = NULL;
+		}
+	}
+
+private:
+	const CorpusSequence &sequence;
+	const RendererType rendererType;
+	const AnalogOutputMode analogOutputMode;
+	const bool convertSampleRate;
+	const SamplerateConversionQuality srcQuality;
+	const Bit32u blockSize;
+	const bool noteRenderCache;
+	std::string name;
+	QuietReportHandler reportHandler;
+	Synth *synth;
+	SampleRateConverter *sampleRateConverter;
+	CorpusPlayer *player;
+	std::vector<Sample> buffer;
+};
+
+static void addEndToEndBenchmark(BenchmarkRunner &runner, const CorpusSequence &sequence, RendererType rendererType,
+	AnalogOutputMode analogOutputMode, bool convertSampleRate, SamplerateConversionQuality srcQuality, Bit32u callSize = 0,
+	bool noteRenderCache = false)
+{
+	if (rendererType == RendererType_FLOAT) {
+		runner.add(new EndToEndBenchmark<float>(sequence, rendererType, analogOutputMode, convertSampleRate, srcQuality, callSize, noteRenderCache));
+	} else {
+		runner.add(new EndToEndBenchmark<Bit16s>(sequence, rendererType, analogOutputMode, convertSampleRate, srcQuality, callSize, noteRenderCache));
+	}
+}
+
+void addEndToEndBenchmarks(BenchmarkRunner &runner) {
+	// The benchmarks only refer to the sequences, so these must outlive the runner.
+	static std::vector<CorpusSequence> corpus;
+	static CorpusSequence completeCorpus("corpus");
+	makeBenchmarkCorpus(corpus);
+	for (size_t i = 0; i < corpus.size(); i++) {
+		completeCorpus.append(corpus[i]);
+	}
+
+	static const RendererType RENDERER_TYPES[] = {RendererType_BIT16S, RendererType_FLOAT};
+	for (Bit32u i = 0; i < sizeof(RENDERER_TYPES) / sizeof(RENDERER_TYPES[0]); i++) {
+		for (int mode = AnalogOutputMode_DIGITAL_ONLY; mode <= AnalogOutputMode_OVERSAMPLED; mode++) {
+			AnalogOutputMode analogOutputMode = AnalogOutputMode(mode);
+			addEndToEndBenchmark(runner, completeCorpus, RENDERER_TYPES[i], analogOutputMode, false, SamplerateConversionQuality_GOOD);
+			for (int quality = SamplerateConversionQuality_FASTEST; quality <= SamplerateConversionQuality_BEST; quality++) {
+				addEndToEndBenchmark(runner, completeCorpus, RENDERER_TYPES[i], analogOutputMode, true, SamplerateConversionQuality(quality));
+			}
+		}
+	}
+
+	// Individual sequences help to attribute a change in the overall timing to a particular feature.
+	for (size_t i = 0; i < corpus.size(); i++) {
+		addEndToEndBenchmark(runner, corpus[i], RendererType_FLOAT, AnalogOutputMode_ACCURATE, false, SamplerateConversionQuality_GOOD);
+	}
+
+	// The note render cache only pays off with the notes repeated exactly, so the gain varies much between the sequences.
+	for (size_t i = 0; i < corpus.size(); i++) {
+		addEndToEndBenchmark(runner, corpus[i], RendererType_BIT16S, AnalogOutputMode_DIGITAL_ONLY, false, SamplerateConversionQuality_GOOD);
+		addEndToEndBenchmark(runner, corpus[i], RendererType_BIT16S, AnalogOutputMode_DIGITAL_ONLY, false, SamplerateConversionQuality_GOOD, 0, true);
+	}
+
+	// The throughput with tiny calls shows the fixed cost per call, compared to the throughput with large calls.
+	// The sample rate conversion from 32 kHz is included, as emulators tend to mix the output at a different rate.
+	for (Bit32u i = 0; i < sizeof(CALL_SIZES) / sizeof(CALL_SIZES[0]); i++) {
+		addEndToEndBenchmark(runner, completeCorpus, RendererType_BIT16S, AnalogOutputMode_DIGITAL_ONLY, false, SamplerateConversionQuality_GOOD, CALL_SIZES[i]);
+		addEndToEndBenchmark(runner, completeCorpus, RendererType_BIT16S, AnalogOutputMode_COARSE, true, SamplerateConversionQuality_GOOD, CALL_SIZES[i]);
+		addEndToEndBenchmark(runner, completeCorpus, RendererType_FLOAT, AnalogOutputMode_COARSE, true, SamplerateConversionQuality_GOOD, CALL_SIZES[i]);
+	}
+}
+
+} // namespace MT32Emu
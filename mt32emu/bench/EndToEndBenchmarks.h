@@ -0,0 +1,32 @@
+/* Copyright (C) 2003, 2004, 2005, 2006, 2008, 2009 Dean Beeler, Jerome Fisher
+ * Copyright (C) 2011-2019 Dean Beeler, Jerome Fisher, Sergey V. Mikayev
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License as published by
+ *  the Free Software Foundation, either version 2.1 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef MT32EMU_END_TO_END_BENCHMARKS_H
+#define MT32EMU_END_TO_END_BENCHMARKS_H
+
+namespace MT32Emu {
+
+class BenchmarkRunner;
+
+// Registers benchmarks that render the benchmark corpus with a complete synth which is loaded with the synthetic
+// ROM pair, for each combination of the renderer type, the analogue output mode and the sample rate conversion.
+// The timings of these benchmarks are reported per output frame.
+void addEndToEndBenchmarks(BenchmarkRunner &runner);
+
+} // namespace MT32Emu
+
+#endif // #ifndef MT32EMU_END_TO_END_BENCHMARKS_H
@@ -0,0 +1,611 @@
+/* Copyright (C) 2003, 2004, 2005, 2006, 2008, 2009 Dean Beeler, Jerome Fisher
+ * Copyright (C) 2011-2019 Dean Beeler, Jerome Fisher, Sergey V. Mikayev
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License as published by
+ *  the Free Software Foundation, either version 2.1 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <cmath>
+#include <cstdio>
+#include <string>
+
+#include "internals.h"
+
+#include "KernelBenchmarks.h"
+#include "BenchmarkRunner.h"
+#include "Analog.h"
+#include "BReverbModel.h"
+#include "CPUFeatures.h"
+#include "DSPKernels.h"
+#include "LA32FloatWaveGenerator.h"
+#include "LA32WaveGenerator.h"
+#include "Tables.h"
+#include "srchelper/srctools/include/IIR2xResampler.h"
+#include "srchelper/srctools/include/LinearResampler.h"
+#include "srchelper/srctools/include/ResamplerModel.h"
+#include "srchelper/srctools/include/SincResampler.h"
+
+namespace MT32Emu {
+
+// Number of samples processed in one go, roughly corresponds to a typical audio buffer.
+static const Bit32u BLOCK_SIZE = 512;
+
+static const Bit32u SYNTHETIC_PCM_WAVE_LENGTH = 8192;
+// Amplitude value that corresponds to a moderately loud note, see Partial::getAmpValue().
+static const Bit32u LA32_AMP = 67117056 - (200 << 18);
+// Pitch changes every so often to exercise different sample steps, middle C is 37133 for synth waves.
+static const Bit32u LA32_PITCH_CHANGE_PERIOD = 1024;
+static const Bit16u LA32_PITCHES[] = {28941, 33037, 37133, 41229, 45325, 39181};
+static const Bit32u LA32_PITCH_COUNT = sizeof(LA32_PITCHES) / sizeof(LA32_PITCHES[0]);
+
+// Simple deterministic noise generator, the results must not depend on the C library.
+class NoiseGenerator {
+public:
+	NoiseGenerator() : state(1) {}
+
+	// Returns a value uniformly distributed in range [-1, 1).
+	float next() {
+		state = state * 1664525 + 1013904223;
+		return float(Bit32s(state)) / 2147483648.0f;
+	}
+
+private:
+	Bit32u state;
+};
+
+static void fillNoise(IntSample *buffer, Bit32u length, NoiseGenerator &noise) {
+	for (Bit32u i = 0; i < length; i++) {
+		buffer[i] = IntSample(noise.next() * 8192.0f);
+	}
+}
+
+static void fillNoise(FloatSample *buffer, Bit32u length, NoiseGenerator &noise) {
+	for (Bit32u i = 0; i < length; i++) {
+		buffer[i] = noise.next() * 0.25f;
+	}
+}
+
+static double sumSamples(const IntSample *buffer, Bit32u length) {
+	Bit32s sum = 0;
+	for (Bit32u i = 0; i < length; i++) {
+		sum += buffer[i];
+	}
+	return sum;
+}
+
+static double sumSamples(const FloatSample *buffer, Bit32u length) {
+	double sum = 0;
+	for (Bit32u i = 0; i < length; i++) {
+		sum += buffer[i];
+	}
+	return sum;
+}
+
+static const char *getRendererTypeName(RendererType rendererType) {
+	return rendererType == RendererType_FLOAT ? "float" : "int";
+}
+
+// Produces a looped PCM wave encoded in the logarithmic format of the PCM ROM, see Synth::loadPCMROM().
+static void generateSyntheticPCMWave(Bit16s *wave, Bit32u length) {
+	static const double PI = 3.1415926535897932;
+	for (Bit32u i = 0; i < length; i++) {
+		double phase = 2.0 * PI * 16.0 * i / length;
+		double value = 0.6 * sin(phase) + 0.3 * sin(3.0 * phase) + 0.1 * sin(7.0 * phase);
+		double magnitude = fabs(value);
+		Bit32s logValue = magnitude < 1e-6 ? 0 : Bit32s(32767.0 + 2048.0 * log(magnitude) / log(2.0));
+		if (logValue < 0) logValue = 0;
+		wave[i] = Bit16s((value < 0 ? 0x8000 : 0) | logValue);
+	}
+}
+
+enum LA32BenchmarkWave {
+	LA32BenchmarkWave_SQUARE,
+	LA32BenchmarkWave_SQUARE_RESONANT,
+	LA32BenchmarkWave_SAWTOOTH,
+	LA32BenchmarkWave_PCM,
+	LA32BenchmarkWave_RING_MODULATED,
+	LA32BenchmarkWave_RING_MODULATED_PCM
+};
+
+static const char *getLA32BenchmarkWaveName(LA32BenchmarkWave wave) {
+	switch (wave) {
+	case LA32BenchmarkWave_SQUARE:
+		return "square";
+	case LA32BenchmarkWave_SQUARE_RESONANT:
+		return "square-resonant";
+	case LA32BenchmarkWave_SAWTOOTH:
+		return "saw";
+	case LA32BenchmarkWave_PCM:
+		return "pcm";
+	case LA32BenchmarkWave_RING_MODULATED:
+		return "ring-mod";
+	case LA32BenchmarkWave_RING_MODULATED_PCM:
+		return "ring-mod-pcm";
+	}
+	return "unknown";
+}
+
+// Drives a partial pair the same way as Partial::produceOutput() does, but with constant envelopes.
+template <class LA32PairImpl>
+class LA32PairBenchmark : public Benchmark {
+public:
+	LA32PairBenchmark(RendererType rendererType, LA32BenchmarkWave useWave) : wave(useWave) {
+		name = std::string("LA32/") + getRendererTypeName(rendererType) + "/" + getLA32BenchmarkWaveName(wave);
+		generateSyntheticPCMWave(pcmWave, SYNTHETIC_PCM_WAVE_LENGTH);
+	}
+
+	const char *getName() const {
+		return name.c_str();
+	}
+
+	void setUp() {
+		Tables::getInstance();
+		const bool ringModulated = wave == LA32BenchmarkWave_RING_MODULATED || wave == LA32BenchmarkWave_RING_MODULATED_PCM;
+		la32Pair.init(ringModulated, false);
+		switch (wave) {
+		case LA32BenchmarkWave_SQUARE:
+		case LA32BenchmarkWave_RING_MODULATED:
+			la32Pair.initSynth(LA32PartialPair::MASTER, false, 0, 1);
+			break;
+		case LA32BenchmarkWave_SQUARE_RESONANT:
+			la32Pair.initSynth(LA32PartialPair::MASTER, false, 128, 25);
+			break;
+		case LA32BenchmarkWave_SAWTOOTH:
+			la32Pair.initSynth(LA32PartialPair::MASTER, true, 64, 10);
+			break;
+		case LA32BenchmarkWave_PCM:
+		case LA32BenchmarkWave_RING_MODULATED_PCM:
+			la32Pair.initPCM(LA32PartialPair::MASTER, pcmWave, SYNTHETIC_PCM_WAVE_LENGTH, true);
+			break;
+		}
+		if (ringModulated) {
+			la32Pair.initSynth(LA32PartialPair::SLAVE, true, 32, 15);
+		}
+		samplePosition = 0;
+	}
+
+	void run(Bit32u sampleCount) {
+		const bool ringModulated = wave == LA32BenchmarkWave_RING_MODULATED || wave == LA32BenchmarkWave_RING_MODULATED_PCM;
+		const bool pcm = wave == LA32BenchmarkWave_PCM || wave == LA32BenchmarkWave_RING_MODULATED_PCM;
+		double sum = 0;
+		for (Bit32u i = 0; i < sampleCount; i++, samplePosition++) {
+			const Bit16u pitch = LA32_PITCHES[(samplePosition / LA32_PITCH_CHANGE_PERIOD) % LA32_PITCH_COUNT];
+			// Sweep the cutoff back and forth, it is ignored for PCM waves.
+			const Bit32u cutoffSweep = samplePosition % 65536;
+			const Bit32u cutoff = pcm ? 0 : ((64 + (cutoffSweep < 32768 ? cutoffSweep : 65535 - cutoffSweep) / 512) << 18);
+			la32Pair.generateNextSample(LA32PartialPair::MASTER, LA32_AMP, pitch, cutoff);
+			if (ringModulated) {
+				la32Pair.generateNextSample(LA32PartialPair::SLAVE, LA32_AMP, pitch + 4096, 100 << 18);
+			}
+			sum += la32Pair.nextOutSample();
+		}
+		BenchmarkRunner::consume(sum);
+	}
+
+private:
+	const LA32BenchmarkWave wave;
+	std::string name;
+	LA32PairImpl la32Pair;
+	Bit16s pcmWave[SYNTHETIC_PCM_WAVE_LENGTH];
+	Bit32u samplePosition;
+};
+
+static const char *getReverbModeName(ReverbMode mode) {
+	switch (mode) {
+	case REVERB_MODE_ROOM:
+		return "room";
+	case REVERB_MODE_HALL:
+		return "hall";
+	case REVERB_MODE_PLATE:
+		return "plate";
+	case REVERB_MODE_TAP_DELAY:
+		return "tap-delay";
+	}
+	return "unknown";
+}
+
+template <class Sample>
+class ReverbBenchmark : public Benchmark {
+public:
+	ReverbBenchmark(RendererType useRendererType, ReverbMode useMode, bool useMT32CompatibleModel) :
+		rendererType(useRendererType), mode(useMode), mt32CompatibleModel(useMT32CompatibleModel), reverbModel(NULL)
+	{
+		name = std::string("BReverb/") + getRendererTypeName(rendererType) + "/" + getReverbModeName(mode) + (mt32CompatibleModel ? "/mt32" : "/cm32l");
+	}
+
+	~ReverbBenchmark() {
+		delete reverbModel;
+	}
+
+	const char *getName() const {
+		return name.c_str();
+	}
+
+	void setUp() {
+		NoiseGenerator noise;
+		fillNoise(inLeft, BLOCK_SIZE, noise);
+		fillNoise(inRight, BLOCK_SIZE, noise);
+		reverbModel = BReverbModel::createBReverbModel(mode, mt32CompatibleModel, rendererType);
+		reverbModel->open();
+		reverbModel->setParameters(5, 5);
+	}
+
+	void run(Bit32u sampleCount) {
+		double sum = 0;
+		while (sampleCount > 0) {
+			Bit32u length = sampleCount < BLOCK_SIZE ? sampleCount : BLOCK_SIZE;
+			reverbModel->process(inLeft, inRight, outLeft, outRight, length);
+			sum += sumSamples(outLeft, length) + sumSamples(outRight, length);
+			sampleCount -= length;
+		}
+		BenchmarkRunner::consume(sum);
+	}
+
+	void tearDown() {
+		delete reverbModel;
+		reverbModel = NULL;
+	}
+
+private:
+	const RendererType rendererType;
+	const ReverbMode mode;
+	const bool mt32CompatibleModel;
+	std::string name;
+	BReverbModel *reverbModel;
+	Sample inLeft[BLOCK_SIZE];
+	Sample inRight[BLOCK_SIZE];
+	Sample outLeft[BLOCK_SIZE];
+	Sample outRight[BLOCK_SIZE];
+};
+
+static const char *getAnalogOutputModeName(AnalogOutputMode mode) {
+	switch (mode) {
+	case AnalogOutputMode_DIGITAL_ONLY:
+		return "digital-only";
+	case AnalogOutputMode_COARSE:
+		return "coarse";
+	case AnalogOutputMode_ACCURATE:
+		return "accurate";
+	case AnalogOutputMode_OVERSAMPLED:
+		return "oversampled";
+	}
+	return "unknown";
+}
+
+// The timings are measured per output sample frame, which differs from the input rate in the accurate and oversampled modes.
+template <class Sample>
+class AnalogBenchmark : public Benchmark {
+public:
+	AnalogBenchmark(RendererType useRendererType, AnalogOutputMode useMode, bool useOldMT32AnalogLPF) :
+		rendererType(useRendererType), mode(useMode), oldMT32AnalogLPF(useOldMT32AnalogLPF), analog(NULL)
+	{
+		name = std::string("Analog/") + getRendererTypeName(rendererType) + "/" + getAnalogOutputModeName(mode) + (oldMT32AnalogLPF ? "/old-lpf" : "");
+	}
+
+	~AnalogBenchmark() {
+		delete analog;
+	}
+
+	const char *getName() const {
+		return name.c_str();
+	}
+
+	void setUp() {
+		NoiseGenerator noise;
+		for (int i = 0; i < STREAM_COUNT; i++) {
+			fillNoise(inStreams[i], MAX_DAC_STREAMS_LENGTH, noise);
+		}
+		analog = Analog::createAnalog(mode, oldMT32AnalogLPF, rendererType);
+		analog->setSynthOutputGain(1.0f);
+		analog->setReverbOutputGain(1.0f, false);
+	}
+
+	void run(Bit32u sampleCount) {
+		double sum = 0;
+		while (sampleCount > 0) {
+			Bit32u length = sampleCount < BLOCK_SIZE ? sampleCount : BLOCK_SIZE;
+			analog->process(outStream, inStreams[0], inStreams[1], inStreams[2], inStreams[3], inStreams[4], inStreams[5], length);
+			sum += sumSamples(outStream, 2 * length);
+			sampleCount -= length;
+		}
+		BenchmarkRunner::consume(sum);
+	}
+
+	void tearDown() {
+		delete analog;
+		analog = NULL;
+	}
+
+private:
+	static const int STREAM_COUNT = 6;
+	// Large enough for the oversampled mode that consumes the least input per output sample.
+	static const Bit32u MAX_DAC_STREAMS_LENGTH = BLOCK_SIZE + 64;
+
+	const RendererType rendererType;
+	const AnalogOutputMode mode;
+	const bool oldMT32AnalogLPF;
+	std::string name;
+	Analog *analog;
+	Sample inStreams[STREAM_COUNT][MAX_DAC_STREAMS_LENGTH];
+	Sample outStream[2 * BLOCK_SIZE];
+};
+
+class NoiseSampleProvider : public SRCTools::FloatSampleProvider {
+public:
+	void getOutputSamples(SRCTools::FloatSample *outBuffer, unsigned int size) {
+		for (unsigned int i = 0; i < 2 * size; i++) {
+			outBuffer[i] = noise.next() * 0.25f;
+		}
+	}
+
+private:
+	NoiseGenerator noise;
+};
+
+// Measures either a single resampler stage or a complete resampler model. The timings are per output sample frame
+// and include generation of the noise input, which is cheap compared to filtering.
+class ResamplerBenchmark : public Benchmark {
+public:
+	enum Kind {
+		IIR_2X_INTERPOLATOR,
+		IIR_2X_DECIMATOR,
+		LINEAR,
+		SINC_UPSAMPLER,
+		SINC_DOWNSAMPLER,
+		MODEL
+	};
+
+	ResamplerBenchmark(Kind useKind, SRCTools::ResamplerModel::Quality useQuality, double useSourceSampleRate, double useTargetSampleRate) :
+		kind(useKind), quality(useQuality), sourceSampleRate(useSourceSampleRate), targetSampleRate(useTargetSampleRate), stage(NULL), model(NULL)
+	{
+		static const char * const QUALITY_NAMES[] = {"fastest", "fast", "good", "best"};
+		static const char * const KIND_NAMES[] = {"IIR2xInterpolator", "IIR2xDecimator", "LinearResampler", "SincResampler", "SincResampler", "ResamplerModel"};
+		char rates[64];
+		sprintf(rates, "%g-%g", sourceSampleRate, targetSampleRate);
+		name = std::string("SRC/") + KIND_NAMES[kind] + "/" + rates;
+		if (kind != LINEAR) {
+			name = name + "/" + QUALITY_NAMES[quality];
+		}
+	}
+
+	~ResamplerBenchmark() {
+		tearDown();
+	}
+
+	const char *getName() const {
+		return name.c_str();
+	}
+
+	void setUp() {
+		const SRCTools::IIRResampler::Quality iirQuality = SRCTools::IIRResampler::Quality(quality);
+		const double passbandFraction = quality == SRCTools::ResamplerModel::FASTEST ? 0.5 : SRCTools::IIRResampler::getPassbandFractionForQuality(iirQuality);
+		switch (kind) {
+		case IIR_2X_INTERPOLATOR:
+			stage = new SRCTools::IIR2xInterpolator(iirQuality);
+			break;
+		case IIR_2X_DECIMATOR:
+			stage = new SRCTools::IIR2xDecimator(iirQuality);
+			break;
+		case LINEAR:
+			stage = new SRCTools::LinearResampler(sourceSampleRate, targetSampleRate);
+			break;
+		case SINC_UPSAMPLER:
+			// Same parameters as ResamplerModel uses after the 2x interpolator.
+			stage = SRCTools::SincResampler::createSincResampler(sourceSampleRate, targetSampleRate, 0.25 * sourceSampleRate * passbandFraction,
+				0.75 * sourceSampleRate, SRCTools::ResamplerModel::DEFAULT_DB_SNR, SRCTools::ResamplerModel::DEFAULT_WINDOWED_SINC_MAX_UPSAMPLE_FACTOR);
+			break;
+		case SINC_DOWNSAMPLER:
+			// Same parameters as ResamplerModel uses before the 2x decimator.
+			stage = SRCTools::SincResampler::createSincResampler(sourceSampleRate, targetSampleRate, 0.25 * targetSampleRate * passbandFraction,
+				0.75 * targetSampleRate, SRCTools::ResamplerModel::DEFAULT_DB_SNR,
+				Bit32u(ceil(SRCTools::ResamplerModel::DEFAULT_WINDOWED_SINC_MAX_DOWNSAMPLE_FACTOR * targetSampleRate / sourceSampleRate)));
+			break;
+		case MODEL:
+			model = &SRCTools::ResamplerModel::createResamplerModel(source, sourceSampleRate, targetSampleRate, quality);
+			return;
+		}
+		model = &SRCTools::ResamplerModel::createResamplerModel(source, *stage);
+	}
+
+	void run(Bit32u sampleCount) {
+		double sum = 0;
+		while (sampleCount > 0) {
+			Bit32u length = sampleCount < BLOCK_SIZE ? sampleCount : BLOCK_SIZE;
+			model->getOutputSamples(outBuffer, length);
+			sum += sumSamples(outBuffer, 2 * length);
+			sampleCount -= length;
+		}
+		BenchmarkRunner::consume(sum);
+	}
+
+	void tearDown() {
+		if (model != NULL) {
+			SRCTools::ResamplerModel::freeResamplerModel(*model, source);
+			model = NULL;
+		}
+		delete stage;
+		stage = NULL;
+	}
+
+private:
+	const Kind kind;
+	const SRCTools::ResamplerModel::Quality quality;
+	const double sourceSampleRate;
+	const double targetSampleRate;
+	std::string name;
+	NoiseSampleProvider source;
+	SRCTools::ResamplerStage *stage;
+	SRCTools::FloatSampleProvider *model;
+	FloatSample outBuffer[2 * BLOCK_SIZE];
+};
+
+enum DSPKernel {
+	DSPKernel_CONVERT_FLOAT_TO_INT,
+	DSPKernel_CONVERT_INT_TO_FLOAT,
+	DSPKernel_MIX_INT,
+	DSPKernel_MIX_FLOAT,
+	DSPKernel_AMPLIFY_INT,
+	DSPKernel_SHIFT_GENERATION1_INT,
+	DSPKernel_SHIFT_GENERATION2_INT,
+	DSPKernel_PAN_AND_MIX_INT,
+	DSPKernel_PAN_AND_MIX_FLOAT,
+	DSPKernel_COUNT
+};
+
+static const char *getDSPKernelName(DSPKernel kernel) {
+	static const char *NAMES[] = {"convert-float-to-int", "convert-int-to-float", "mix-int", "mix-float", "amplify-int", "shift-generation1-int", "shift-generation2-int", "pan-and-mix-int", "pan-and-mix-float"};
+	return NAMES[kernel];
+}
+
+// Measures a DSP kernel bound to the given CPU feature level. The level active before is restored afterwards.
+class DSPKernelBenchmark : public Benchmark {
+public:
+	DSPKernelBenchmark(DSPKernel useKernel, CPUFeatureLevel useLevel) :
+		kernel(useKernel), level(useLevel), savedLevel(CPUFeatureLevel_SCALAR)
+	{
+		name = std::string("DSP/") + getDSPKernelName(kernel) + "/" + CPUFeatures::getLevelName(level);
+	}
+
+	const char *getName() const {
+		return name.c_str();
+	}
+
+	void setUp() {
+		NoiseGenerator noise;
+		fillNoise(intBuffer, BLOCK_SIZE, noise);
+		fillNoise(intAddend, BLOCK_SIZE, noise);
+		fillNoise(floatBuffer, BLOCK_SIZE, noise);
+		fillNoise(floatAddend, BLOCK_SIZE, noise);
+		fillNoise(intBuffer2, BLOCK_SIZE, noise);
+		fillNoise(floatBuffer2, BLOCK_SIZE, noise);
+		savedLevel = CPUFeatures::getActiveLevel();
+		CPUFeatures::forceLevel(level);
+	}
+
+	void run(Bit32u sampleCount) {
+		const DSPKernels &kernels = getDSPKernels();
+		double sum = 0;
+		while (sampleCount > 0) {
+			Bit32u length = sampleCount < BLOCK_SIZE ? sampleCount : BLOCK_SIZE;
+			switch (kernel) {
+			case DSPKernel_CONVERT_FLOAT_TO_INT:
+				kernels.convertFloatToInt(floatAddend, intBuffer, length);
+				sum += sumSamples(intBuffer, length);
+				break;
+			case DSPKernel_CONVERT_INT_TO_FLOAT:
+				kernels.convertIntToFloat(intAddend, floatBuffer, length);
+				sum += sumSamples(floatBuffer, length);
+				break;
+			case DSPKernel_MIX_INT:
+				kernels.mixInt(intBuffer, intAddend, length);
+				sum += sumSamples(intBuffer, length);
+				break;
+			case DSPKernel_MIX_FLOAT:
+				kernels.mixFloat(floatBuffer, floatAddend, length);
+				sum += sumSamples(floatBuffer, length);
+				break;
+			case DSPKernel_AMPLIFY_INT:
+				kernels.amplifyInt(intBuffer, length);
+				sum += sumSamples(intBuffer, length);
+				break;
+			case DSPKernel_SHIFT_GENERATION1_INT:
+				kernels.shiftGeneration1Int(intBuffer, length);
+				sum += sumSamples(intBuffer, length);
+				break;
+			case DSPKernel_SHIFT_GENERATION2_INT:
+				kernels.shiftGeneration2Int(intBuffer, length);
+				sum += sumSamples(intBuffer, length);
+				break;
+			case DSPKernel_PAN_AND_MIX_INT:
+				// Pan factors of a partial panned off-centre, the addend stands for the mono partial output.
+				kernels.panAndMixInt(intBuffer, intBuffer2, intAddend, length, 5851, 2341);
+				sum += sumSamples(intBuffer, length) + sumSamples(intBuffer2, length);
+				break;
+			default:
+				kernels.panAndMixFloat(floatBuffer, floatBuffer2, floatAddend, length, 10, 4);
+				sum += sumSamples(floatBuffer, length) + sumSamples(floatBuffer2, length);
+				break;
+			}
+			sampleCount -= length;
+		}
+		BenchmarkRunner::consume(sum);
+	}
+
+	void tearDown() {
+		CPUFeatures::forceLevel(savedLevel);
+	}
+
+private:
+	const DSPKernel kernel;
+	const CPUFeatureLevel level;
+	CPUFeatureLevel savedLevel;
+	std::string name;
+	IntSample intBuffer[BLOCK_SIZE];
+	IntSample intBuffer2[BLOCK_SIZE];
+	IntSample intAddend[BLOCK_SIZE];
+	FloatSample floatBuffer[BLOCK_SIZE];
+	FloatSample floatBuffer2[BLOCK_SIZE];
+	FloatSample floatAddend[BLOCK_SIZE];
+};
+
+void addKernelBenchmarks(BenchmarkRunner &runner) {
+	for (int kernel = 0; kernel < DSPKernel_COUNT; kernel++) {
+		// Only the levels supported on this machine, so that the variants can be compared side by side.
+		for (int level = CPUFeatureLevel_SCALAR; level <= CPUFeatureLevel_NEON; level++) {
+			if (!CPUFeatures::isSupported(CPUFeatureLevel(level))) continue;
+			runner.add(new DSPKernelBenchmark(DSPKernel(kernel), CPUFeatureLevel(level)));
+		}
+	}
+
+
+	static const LA32BenchmarkWave LA32_WAVES[] = {
+		LA32BenchmarkWave_SQUARE, LA32BenchmarkWave_SQUARE_RESONANT, LA32BenchmarkWave_SAWTOOTH,
+		LA32BenchmarkWave_PCM, LA32BenchmarkWave_RING_MODULATED, LA32BenchmarkWave_RING_MODULATED_PCM
+	};
+	for (Bit32u i = 0; i < sizeof(LA32_WAVES) / sizeof(LA32_WAVES[0]); i++) {
+		runner.add(new LA32PairBenchmark<LA32IntPartialPair>(RendererType_BIT16S, LA32_WAVES[i]));
+		runner.add(new LA32PairBenchmark<LA32FloatPartialPair>(RendererType_FLOAT, LA32_WAVES[i]));
+	}
+
+	for (int mode = REVERB_MODE_ROOM; mode <= REVERB_MODE_TAP_DELAY; mode++) {
+		for (int mt32CompatibleModel = 1; mt32CompatibleModel >= 0; mt32CompatibleModel--) {
+			runner.add(new ReverbBenchmark<IntSample>(RendererType_BIT16S, ReverbMode(mode), mt32CompatibleModel != 0));
+			runner.add(new ReverbBenchmark<FloatSample>(RendererType_FLOAT, ReverbMode(mode), mt32CompatibleModel != 0));
+		}
+	}
+
+	for (int mode = AnalogOutputMode_DIGITAL_ONLY; mode <= AnalogOutputMode_OVERSAMPLED; mode++) {
+		for (int oldMT32AnalogLPF = 0; oldMT32AnalogLPF <= 1; oldMT32AnalogLPF++) {
+			// The LPF variant makes no difference when the analogue circuit is bypassed.
+			if (mode == AnalogOutputMode_DIGITAL_ONLY && oldMT32AnalogLPF) continue;
+			runner.add(new AnalogBenchmark<IntSample>(RendererType_BIT16S, AnalogOutputMode(mode), oldMT32AnalogLPF != 0));
+			runner.add(new AnalogBenchmark<FloatSample>(RendererType_FLOAT, AnalogOutputMode(mode), oldMT32AnalogLPF != 0));
+		}
+	}
+
+	runner.add(new ResamplerBenchmark(ResamplerBenchmark::LINEAR, SRCTools::ResamplerModel::FASTEST, 32000, 44100));
+	for (int quality = SRCTools::ResamplerModel::FAST; quality <= SRCTools::ResamplerModel::BEST; quality++) {
+		SRCTools::ResamplerModel::Quality resamplerQuality = SRCTools::ResamplerModel::Quality(quality);
+		runner.add(new ResamplerBenchmark(ResamplerBenchmark::IIR_2X_INTERPOLATOR, resamplerQuality, 32000, 64000));
+		runner.add(new ResamplerBenchmark(ResamplerBenchmark::IIR_2X_DECIMATOR, resamplerQuality, 96000, 48000));
+		runner.add(new ResamplerBenchmark(ResamplerBenchmark::SINC_UPSAMPLER, resamplerQuality, 64000, 44100));
+		runner.add(new ResamplerBenchmark(ResamplerBenchmark::SINC_DOWNSAMPLER, resamplerQuality, 96000, 88200));
+	}
+	for (int quality = SRCTools::ResamplerModel::FASTEST; quality <= SRCTools::ResamplerModel::BEST; quality++) {
+		SRCTools::ResamplerModel::Quality resamplerQuality = SRCTools::ResamplerModel::Quality(quality);
+		runner.add(new ResamplerBenchmark(ResamplerBenchmark::MODEL, resamplerQuality, 32000, 44100));
+		runner.add(new ResamplerBenchmark(ResamplerBenchmark::MODEL, resamplerQuality, 32000, 48000));
+	}
+}
+
+} // namespace MT32Emu
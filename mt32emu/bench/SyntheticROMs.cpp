@@ -0,0 +1,386 @@
+/* Copyright (C) 2003, 2004, 2005, 2006, 2008, 2009 Dean Beeler, Jerome Fisher
+ * Copyright (C) 2011-2019 Dean Beeler, Jerome Fisher, Sergey V. Mikayev
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License as published by
+ *  the Free Software Foundation, either version 2.1 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <cstdio>
+#include <cstring>
+
+#include "internals.h"
+
+#include "SyntheticROMs.h"
+#include "Structures.h"
+
+namespace MT32Emu {
+
+// Layout of the synthetic control ROM, must match the "ctrl_synthetic" entry of ControlROMMaps in Synth.cpp.
+static const Bit32u PCM_TABLE = 0x0100;
+static const Bit32u PCM_COUNT = 256;
+static const Bit32u TIMBRE_A_MAP = 0x0500;
+static const Bit32u TIMBRE_B_MAP = 0x0580;
+static const Bit32u TIMBRE_R_MAP = 0x0600;
+static const Bit32u TIMBRE_R_COUNT = 64;
+static const Bit32u RHYTHM_SETTINGS = 0x0700;
+static const Bit32u RHYTHM_SETTINGS_COUNT = 85;
+static const Bit32u RESERVE_SETTINGS = 0x0860;
+static const Bit32u PAN_SETTINGS = 0x0870;
+static const Bit32u PROGRAM_SETTINGS = 0x0880;
+static const Bit32u RHYTHM_MAX_TABLE = 0x0890;
+static const Bit32u PATCH_MAX_TABLE = 0x08A0;
+static const Bit32u SYSTEM_MAX_TABLE = 0x08B0;
+static const Bit32u TIMBRE_MAX_TABLE = 0x08D0;
+static const Bit32u SOUND_GROUP_IX_TABLE = 0x0A00;
+static const Bit32u SOUND_GROUPS_TABLE = 0x0A80;
+static const Bit32u SOUND_GROUPS_COUNT = 8;
+static const Bit32u TIMBRE_DATA = 0x1000;
+
+// PCM ROM consists of this many blocks of 2048 samples, this is the granularity of the wave table addressing.
+static const Bit32u PCM_BLOCK_LENGTH = 0x800;
+static const Bit32u PCM_BLOCK_COUNT = SyntheticROMs::PCM_ROM_FILE_SIZE / 2 / PCM_BLOCK_LENGTH;
+// Wave table pitch that makes a PCM wave play at its natural rate on middle C.
+static const Bit32u PCM_NATURAL_PITCH = 20480;
+
+// Number of entries in the sine table, which covers one period.
+static const Bit32u SINE_TABLE_SIZE = 256;
+
+// Deterministic pseudo-random sequence, the generated images must not depend on the C library.
+class SyntheticROMRandom {
+public:
+	SyntheticROMRandom() : state(0x4D543332) {}
+
+	Bit32u next() {
+		state = state * 1103515245 + 12345;
+		return (state >> 16) & 0x7FFF;
+	}
+
+	// Returns a value in range [minValue, maxValue].
+	Bit8u range(Bit32u minValue, Bit32u maxValue) {
+		return Bit8u(minValue + next() % (maxValue - minValue + 1));
+	}
+
+private:
+	Bit32u state;
+};
+
+// Uses the Bhaskara I approximation, which is accurate to about 0.2%, good enough for the purpose.
+static void makeSineTable(Bit32s *table) {
+	static const Bit32u HALF_PERIOD = SINE_TABLE_SIZE / 2;
+	for (Bit32u i = 0; i < HALF_PERIOD; i++) {
+		Bit32u t = i * (HALF_PERIOD - i);
+		Bit32s value = Bit32s((16 * 32767 * t) / (5 * HALF_PERIOD * HALF_PERIOD - 4 * t));
+		table[i] = value;
+		table[i + HALF_PERIOD] = -value;
+	}
+}
+
+// Converts a linear sample to the logarithmic format used in the PCM ROM. The magnitude is stored in bits 1-14
+// as 2048 units per octave, the sign goes to bit 15.
+static Bit16u linearToLog(Bit32s sample) {
+	Bit32u magnitude = Bit32u(sample < 0 ? -sample : sample);
+	if (magnitude > 32767) magnitude = 32767;
+	if (magnitude == 0) return 0;
+	Bit32u octave = 0;
+	while ((magnitude >> (octave + 1)) != 0) {
+		octave++;
+	}
+	Bit32u logMagnitude = 2048 * octave + (((magnitude - (1 << octave)) << 11) >> octave) + 2048;
+	return Bit16u((sample < 0 ? 0x8000 : 0) | (logMagnitude & 0x7FFE));
+}
+
+// Reverse of the bit scrambling undone in Synth::loadPCMROM().
+static void storePCMSample(Bit8u *data, Bit32u sampleIx, Bit16u logSample) {
+	static const int ORDER[15] = {0, 9, 1, 2, 3, 4, 5, 6, 7, 10, 11, 12, 13, 14, 15};
+	Bit8u s = 0;
+	Bit8u c = 0;
+	for (int u = 0; u < 15; u++) {
+		int bit = (logSample >> (15 - u)) & 1;
+		if (ORDER[u] < 8) {
+			s |= Bit8u(bit << (7 - ORDER[u]));
+		} else {
+			c |= Bit8u(bit << (7 - (ORDER[u] - 8)));
+		}
+	}
+	data[2 * sampleIx] = s;
+	data[2 * sampleIx + 1] = c;
+}
+
+struct SyntheticWave {
+	Bit32u firstBlock;
+	// Length is PCM_BLOCK_LENGTH << lengthExponent samples.
+	Bit32u lengthExponent;
+	bool looped;
+};
+
+// The PCM ROM is split into looped single-block waves followed by longer one-shot and looped waves.
+static const SyntheticWave SYNTHETIC_WAVES[] = {
+	{0, 0, true}, {1, 0, true}, {2, 0, true}, {3, 0, true}, {4, 0, true}, {5, 0, true}, {6, 0, true}, {7, 0, true},
+	{8, 0, true}, {9, 0, true}, {10, 0, true}, {11, 0, true}, {12, 0, true}, {13, 0, true}, {14, 0, true}, {15, 0, true},
+	{16, 0, true}, {17, 0, true}, {18, 0, true}, {19, 0, true}, {20, 0, true}, {21, 0, true}, {22, 0, true}, {23, 0, true},
+	{24, 0, true}, {25, 0, true}, {26, 0, true}, {27, 0, true}, {28, 0, true}, {29, 0, true}, {30, 0, true}, {31, 0, true},
+	{32, 3, false}, {40, 3, false}, {48, 3, false}, {56, 3, true},
+	{64, 4, false}, {80, 4, false}, {96, 4, true}, {112, 4, false},
+	{128, 6, false}, {192, 6, true}
+};
+static const Bit32u SYNTHETIC_WAVE_COUNT = sizeof(SYNTHETIC_WAVES) / sizeof(SYNTHETIC_WAVES[0]);
+
+static void generateWave(Bit8u *data, const SyntheticWave &wave, Bit32u waveIx, const Bit32s *sineTable, SyntheticROMRandom &random) {
+	const Bit32u length = PCM_BLOCK_LENGTH << wave.lengthExponent;
+	const Bit32u firstSample = wave.firstBlock * PCM_BLOCK_LENGTH;
+	// Periods that divide the block length keep the looped waves seamless.
+	const Bit32u period = 512 >> (waveIx % 4);
+	const Bit32u harmonicCount = 1 + waveIx % 5;
+	const bool noisy = (waveIx % 7) == 6;
+	for (Bit32u i = 0; i < length; i++) {
+		Bit32s sample = 0;
+		for (Bit32u harmonic = 1; harmonic <= harmonicCount; harmonic++) {
+			Bit32u phase = (i * harmonic * SINE_TABLE_SIZE / period) % SINE_TABLE_SIZE;
+			sample += sineTable[phase] / Bit32s(harmonic * harmonicCount);
+		}
+		if (noisy) {
+			sample = sample / 2 + Bit32s(random.next()) - 16384;
+		}
+		if (!wave.looped) {
+			// One-shot waves decay linearly, like percussive samples.
+			sample = Bit32s(sample / 256 * Bit32s(length - i) / Bit32s(length) * 256);
+		}
+		storePCMSample(data, firstSample + i, linearToLog(sample));
+	}
+}
+
+void SyntheticROMs::generatePCMROM(Bit8u *data) {
+	Bit32s sineTable[SINE_TABLE_SIZE];
+	makeSineTable(sineTable);
+	SyntheticROMRandom random;
+	memset(data, 0, PCM_ROM_FILE_SIZE);
+	for (Bit32u waveIx = 0; waveIx < SYNTHETIC_WAVE_COUNT; waveIx++) {
+		generateWave(data, SYNTHETIC_WAVES[waveIx], waveIx, sineTable, random);
+	}
+}
+
+static void generatePCMTable(Bit8u *data) {
+	ControlROMPCMStruct *pcmTable = reinterpret_cast<ControlROMPCMStruct *>(data + PCM_TABLE);
+	for (Bit32u i = 0; i < PCM_COUNT; i++) {
+		const SyntheticWave &wave = SYNTHETIC_WAVES[i % SYNTHETIC_WAVE_COUNT];
+		const Bit32u pitch = PCM_NATURAL_PITCH + (i % 13) * 4096 / 12 - 4096 / 2;
+		pcmTable[i].pos = Bit8u(wave.firstBlock);
+		// Bit 0 makes the wave follow master tune.
+		pcmTable[i].len = Bit8u((wave.looped ? 0x80 : 0) | (wave.lengthExponent << 4) | 1);
+		pcmTable[i].pitchLSB = Bit8u(pitch & 0xFF);
+		pcmTable[i].pitchMSB = Bit8u(pitch >> 8);
+	}
+}
+
+static void generatePartialParam(TimbreParam::PartialParam &partial, bool rhythm, SyntheticROMRandom &random) {
+	TimbreParam::PartialParam::WGParam &wg = partial.wg;
+	wg.pitchCoarse = random.range(30, 42);
+	wg.pitchFine = random.range(45, 55);
+	wg.pitchKeyfollow = rhythm ? 3 : 11;
+	wg.pitchBenderEnabled = 1;
+	wg.waveform = random.range(0, 3);
+	wg.pcmWave = random.range(0, 127);
+	wg.pulseWidth = random.range(0, 100);
+	wg.pulseWidthVeloSensitivity = random.range(5, 9);
+
+	TimbreParam::PartialParam::PitchEnvParam &pitchEnv = partial.pitchEnv;
+	pitchEnv.depth = random.range(0, 3);
+	pitchEnv.veloSensitivity = random.range(0, 20);
+	pitchEnv.timeKeyfollow = random.range(0, 2);
+	for (int i = 0; i < 4; i++) {
+		pitchEnv.time[i] = random.range(0, 60);
+	}
+	for (int i = 0; i < 5; i++) {
+		pitchEnv.level[i] = random.range(40, 60);
+	}
+
+	TimbreParam::PartialParam::PitchLFOParam &pitchLFO = partial.pitchLFO;
+	pitchLFO.rate = random.range(0, 100);
+	pitchLFO.depth = random.range(0, 20);
+	pitchLFO.modSensitivity = random.range(0, 50);
+
+	TimbreParam::PartialParam::TVFParam &tvf = partial.tvf;
+	tvf.cutoff = random.range(40, 100);
+	tvf.resonance = random.next() % 4 == 0 ? random.range(10, 30) : random.range(0, 5);
+	tvf.keyfollow = random.range(8, 14);
+	tvf.biasPoint = random.range(0, 127);
+	tvf.biasLevel = random.range(4, 10);
+	tvf.envDepth = random.range(0, 60);
+	tvf.envVeloSensitivity = random.range(0, 50);
+	tvf.envDepthKeyfollow = random.range(0, 2);
+	tvf.envTimeKeyfollow = random.range(0, 2);
+	for (int i = 0; i < 5; i++) {
+		tvf.envTime[i] = random.range(0, 60);
+	}
+	for (int i = 0; i < 4; i++) {
+		tvf.envLevel[i] = random.range(40, 100);
+	}
+
+	TimbreParam::PartialParam::TVAParam &tva = partial.tva;
+	tva.level = random.range(70, 100);
+	tva.veloSensitivity = random.range(30, 70);
+	tva.biasPoint1 = random.range(0, 127);
+	tva.biasLevel1 = random.range(8, 12);
+	tva.biasPoint2 = random.range(0, 127);
+	tva.biasLevel2 = random.range(8, 12);
+	tva.envTimeKeyfollow = random.range(0, 2);
+	tva.envTimeVeloSensitivity = random.range(0, 2);
+	tva.envTime[0] = random.range(0, 30);
+	for (int i = 1; i < 5; i++) {
+		tva.envTime[i] = rhythm ? random.range(10, 40) : random.range(10, 70);
+	}
+	tva.envLevel[0] = random.range(80, 100);
+	tva.envLevel[1] = random.range(60, 100);
+	tva.envLevel[2] = random.range(50, 100);
+	tva.envLevel[3] = rhythm ? 0 : random.range(30, 100);
+}
+
+// Writes a timbre in the compressed format, i.e. the muted partials except partial 0 are omitted.
+// Returns the address that follows the written data.
+static Bit32u generateCompressedTimbre(Bit8u *data, Bit32u address, const char *namePrefix, Bit32u timbreNum, bool rhythm, SyntheticROMRandom &random) {
+	TimbreParam timbre;
+	memset(&timbre, 0, sizeof(timbre));
+	sprintf(timbre.common.name, "%s%03u", namePrefix, timbreNum);
+	memset(timbre.common.name + strlen(timbre.common.name), ' ', sizeof(timbre.common.name) - strlen(timbre.common.name));
+	timbre.common.partialStructure12 = random.range(0, 12);
+	timbre.common.partialStructure34 = random.range(0, 12);
+	timbre.common.partialMute = random.range(1, 15);
+	timbre.common.noSustain = rhythm ? 1 : 0;
+	memcpy(data + address, &timbre.common, sizeof(timbre.common));
+	address += sizeof(timbre.common);
+	for (int t = 0; t < 4; t++) {
+		generatePartialParam(timbre.partial[t], rhythm, random);
+		if (t == 0 || ((timbre.common.partialMute >> t) & 1) != 0) {
+			memcpy(data + address, &timbre.partial[t], sizeof(timbre.partial[t]));
+			address += sizeof(timbre.partial[t]);
+		}
+	}
+	return address;
+}
+
+static Bit32u generateTimbreBank(Bit8u *data, Bit32u mapAddress, Bit32u timbreCount, Bit32u address, const char *namePrefix, bool rhythm, SyntheticROMRandom &random) {
+	for (Bit32u i = 0; i < timbreCount; i++) {
+		data[mapAddress + 2 * i] = Bit8u(address & 0xFF);
+		data[mapAddress + 2 * i + 1] = Bit8u(address >> 8);
+		address = generateCompressedTimbre(data, address, namePrefix, i + 1, rhythm, random);
+	}
+	return address;
+}
+
+static void generateMaxTables(Bit8u *data) {
+	static const Bit8u RHYTHM_MAX[4] = {127, 100, 14, 1};
+	static const Bit8u PATCH_MAX[16] = {3, 63, 48, 100, 24, 3, 1, 0, 100, 14, 0, 0, 0, 0, 0, 0};
+	static const Bit8u SYSTEM_MAX[23] = {127, 3, 7, 7, 32, 32, 32, 32, 32, 32, 32, 32, 32, 16, 16, 16, 16, 16, 16, 16, 16, 16, 100};
+	static const Bit8u TIMBRE_MAX[72] = {
+		// Common
+		127, 127, 127, 127, 127, 127, 127, 127, 127, 127, 12, 12, 15, 1,
+		// WG
+		96, 100, 16, 1, 3, 127, 100, 14,
+		// Pitch envelope
+		10, 100, 4, 100, 100, 100, 100, 100, 100, 100, 100, 100,
+		// Pitch LFO
+		100, 100, 100,
+		// TVF
+		100, 30, 16, 127, 14, 100, 100, 4, 4, 100, 100, 100, 100, 100, 100, 100, 100, 100,
+		// TVA
+		100, 100, 127, 12, 127, 12, 4, 4, 100, 100, 100, 100, 100, 100, 100, 100, 100
+	};
+	memcpy(data + RHYTHM_MAX_TABLE, RHYTHM_MAX, sizeof(RHYTHM_MAX));
+	memcpy(data + PATCH_MAX_TABLE, PATCH_MAX, sizeof(PATCH_MAX));
+	memcpy(data + SYSTEM_MAX_TABLE, SYSTEM_MAX, sizeof(SYSTEM_MAX));
+	memcpy(data + TIMBRE_MAX_TABLE, TIMBRE_MAX, sizeof(TIMBRE_MAX));
+}
+
+static void generateSoundGroups(Bit8u *data) {
+	static const char SOUND_GROUP_NAMES[SOUND_GROUPS_COUNT][10] = {
+		"Piano    ", "Organ    ", "Keyboard ", "Brass    ", "Strings  ", "Bass     ", "Synth    ", "Effects  "
+	};
+	for (Bit32u i = 0; i < 128; i++) {
+		data[SOUND_GROUP_IX_TABLE + i] = Bit8u(i / (128 / SOUND_GROUPS_COUNT));
+	}
+	SoundGroup *soundGroups = reinterpret_cast<SoundGroup *>(data + SOUND_GROUPS_TABLE);
+	for (Bit32u i = 0; i < SOUND_GROUPS_COUNT; i++) {
+		memset(&soundGroups[i], 0, sizeof(SoundGroup));
+		memcpy(soundGroups[i].name, SOUND_GROUP_NAMES[i], sizeof(soundGroups[i].name));
+		soundGroups[i].timbreCount = Bit8u(128 / SOUND_GROUPS_COUNT);
+	}
+}
+
+void SyntheticROMs::generateControlROM(Bit8u *data) {
+	static const Bit8u RESERVE[9] = {3, 10, 6, 4, 3, 0, 0, 0, 6};
+	static const Bit8u PAN[9] = {7, 7, 7, 7, 7, 7, 7, 7, 7};
+	static const Bit8u PROGRAMS[8] = {0, 68, 48, 95, 78, 41, 3, 110};
+
+	SyntheticROMRandom random;
+	memset(data, 0, CONTROL_ROM_FILE_SIZE);
+	generatePCMTable(data);
+
+	Bit32u address = TIMBRE_DATA;
+	address = generateTimbreBank(data, TIMBRE_A_MAP, 64, address, "SynA ", false, random);
+	address = generateTimbreBank(data, TIMBRE_B_MAP, 64, address, "SynB ", false, random);
+	generateTimbreBank(data, TIMBRE_R_MAP, TIMBRE_R_COUNT, address, "SynR ", true, random);
+
+	for (Bit32u i = 0; i < RHYTHM_SETTINGS_COUNT; i++) {
+		Bit8u *rhythmSetting = data + RHYTHM_SETTINGS + 4 * i;
+		rhythmSetting[0] = Bit8u(64 + i % TIMBRE_R_COUNT);
+		rhythmSetting[1] = 100;
+		rhythmSetting[2] = Bit8u(i % 15);
+		rhythmSetting[3] = 1;
+	}
+	memcpy(data + RESERVE_SETTINGS, RESERVE, sizeof(RESERVE));
+	memcpy(data + PAN_SETTINGS, PAN, sizeof(PAN));
+	memcpy(data + PROGRAM_SETTINGS, PROGRAMS, sizeof(PROGRAMS));
+	generateMaxTables(data);
+	generateSoundGroups(data);
+}
+
+SyntheticROMs::SyntheticROMs() {
+	controlROMData = new Bit8u[CONTROL_ROM_FILE_SIZE];
+	generateControlROM(controlROMData);
+	pcmROMData = new Bit8u[PCM_ROM_FILE_SIZE];
+	generatePCMROM(pcmROMData);
+	controlROMFile = new ArrayFile(controlROMData, CONTROL_ROM_FILE_SIZE);
+	pcmROMFile = new ArrayFile(pcmROMData, PCM_ROM_FILE_SIZE);
+	controlROMImage = ROMImage::makeROMImage(controlROMFile);
+	pcmROMImage = ROMImage::makeROMImage(pcmROMFile);
+}
+
+SyntheticROMs::~SyntheticROMs() {
+	ROMImage::freeROMImage(controlROMImage);
+	ROMImage::freeROMImage(pcmROMImage);
+	delete controlROMFile;
+	delete pcmROMFile;
+	delete[] controlROMData;
+	delete[] pcmROMData;
+}
+
+const ROMImage &SyntheticROMs::getControlROMImage() const {
+	return *controlROMImage;
+}
+
+const ROMImage &SyntheticROMs::getPCMROMImage() const {
+	return *pcmROMImage;
+}
+
+static bool saveFile(const char *fileName, const Bit8u *data, size_t size) {
+	FILE *file = fopen(fileName, "wb");
+	if (file == NULL) return false;
+	bool written = fwrite(data, 1, size, file) == size;
+	return fclose(file) == 0 && written;
+}
+
+bool SyntheticROMs::save(const char *controlROMFileName, const char *pcmROMFileName) const {
+	return saveFile(controlROMFileName, controlROMData, CONTROL_ROM_FILE_SIZE) && saveFile(pcmROMFileName, pcmROMData, PCM_ROM_FILE_SIZE);
+}
+
+} // namespace MT32Emu
@@ -0,0 +1,62 @@
+/* Copyright (C) 2003, 2004, 2005, 2006, 2008, 2009 Dean Beeler, Jerome Fisher
+ * Copyright (C) 2011-2019 Dean Beeler, Jerome Fisher, Sergey V. Mikayev
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License as published by
+ *  the Free Software Foundation, either version 2.1 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef MT32EMU_SYNTHETIC_ROMS_H
+#define MT32EMU_SYNTHETIC_ROMS_H
+
+#include "File.h"
+#include "ROMInfo.h"
+#include "Types.h"
+
+namespace MT32Emu {
+
+// Generates a structurally valid pair of control and PCM ROM images that the synth accepts, so that the complete
+// rendering engine can be exercised on machines that have no access to the original ROM dumps. The control ROM follows
+// the CM-32L layout with compressed timbre banks and a 256-entry wave table, the timbres and the waves are made up
+// using a fixed pseudo-random sequence and integer arithmetic only. Hence, the images are the same on every platform,
+// and they are identified by the SHA1 digests registered in ROMInfo.cpp. Any change to the generator must be
+// accompanied with an update of those digests.
+class SyntheticROMs {
+public:
+	static const Bit32u CONTROL_ROM_FILE_SIZE = 64 * 1024;
+	static const Bit32u PCM_ROM_FILE_SIZE = 1024 * 1024;
+
+	static void generateControlROM(Bit8u *data);
+	static void generatePCMROM(Bit8u *data);
+
+	// Generates both images and wraps them as ROMImages.
+	SyntheticROMs();
+	~SyntheticROMs();
+
+	const ROMImage &getControlROMImage() const;
+	const ROMImage &getPCMROMImage() const;
+
+	// Saves the images to files with the given names. Returns false on error.
+	bool save(const char *controlROMFileName, const char *pcmROMFileName) const;
+
+private:
+	Bit8u *controlROMData;
+	Bit8u *pcmROMData;
+	ArrayFile *controlROMFile;
+	ArrayFile *pcmROMFile;
+	const ROMImage *controlROMImage;
+	const ROMImage *pcmROMImage;
+};
+
+} // namespace MT32Emu
+
+#endif // #ifndef MT32EMU_SYNTHETIC_ROMS_H
@@ -0,0 +1,138 @@
+/* Copyright (C) 2003, 2004, 2005, 2006, 2008, 2009 Dean Beeler, Jerome Fisher
+ * Copyright (C) 2011-2019 Dean Beeler, Jerome Fisher, Sergey V. Mikayev
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License as published by
+ *  the Free Software Foundation, either version 2.1 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+
+#include "internals.h"
+
+#include "BenchmarkRunner.h"
+#include "CaptureReplay.h"
+#include "CPUFeatures.h"
+#include "EndToEndBenchmarks.h"
+#include "KernelBenchmarks.h"
+#include "SyntheticROMs.h"
+
+using namespace MT32Emu;
+
+static void printUsage(const char *programName) {
+	fprintf(stderr,
+		"Usage: %s [options]\n"
+		"Runs the libmt32emu benchmarks and reports the processing time in nanoseconds per sample.\n"
+		"End-to-end benchmarks report the time per output frame.\n\n"
+		"  -l, --list               List benchmarks matching the filter and exit\n"
+		"  -f, --filter <text>      Only run benchmarks which names contain the text\n"
+		"  -r, --repetitions <n>    Number of measured runs of each benchmark (default 10)\n"
+		"  -s, --samples <n>        Number of samples processed in each run (default 128000)\n"
+		"  -j, --json <file>        Also write the results in JSON format to the file, \"-\" means stdout\n"
+		"  -w, --write-roms <dir>   Save the synthetic control and PCM ROM images to the directory and exit\n"
+		"  -k, --cpu-level <name>   Bind the DSP kernels to the given level: scalar, sse2, sse4.1, avx2, avx512 or neon\n"
+		"  -h, --help               Show this help\n\n"
+		"Replaying MIDI captures recorded with Synth::startMidiCapture():\n"
+		"  -p, --replay <file>      Re-render the capture as fast as possible instead of running the benchmarks\n"
+		"                           (the number of runs is set with -r, default 1)\n"
+		"  -c, --control-rom <file> Control ROM image to use, unless the capture was taken with the synthetic ROMs\n"
+		"  -m, --pcm-rom <file>     PCM ROM image to use, unless the capture was taken with the synthetic ROMs\n"
+		"  -o, --output <file>      Save the output of the first run as raw 16-bit stereo samples\n",
+		programName);
+}
+
+static bool isOption(const char *arg, const char *shortName, const char *longName) {
+	return strcmp(arg, shortName) == 0 || strcmp(arg, longName) == 0;
+}
+
+int main(int argc, char *argv[]) {
+	BenchmarkRunner runner;
+	addKernelBenchmarks(runner);
+	addEndToEndBenchmarks(runner);
+
+	bool listOnly = false;
+	const char *jsonFileName = NULL;
+	const char *romDirName = NULL;
+	CaptureReplayOptions replayOptions = { NULL, NULL, NULL, NULL, 1 };
+	for (int i = 1; i < argc; i++) {
+		const char *arg = argv[i];
+		const bool hasValue = i + 1 < argc;
+		if (isOption(arg, "-l", "--list")) {
+			listOnly = true;
+		} else if (isOption(arg, "-f", "--filter") && hasValue) {
+			runner.setFilter(argv[++i]);
+		} else if (isOption(arg, "-r", "--repetitions") && hasValue) {
+			replayOptions.repetitionCount = Bit32u(atoi(argv[++i]));
+			runner.setRepetitionCount(replayOptions.repetitionCount);
+		} else if (isOption(arg, "-s", "--samples") && hasValue) {
+			runner.setSampleCount(Bit32u(atoi(argv[++i])));
+		} else if (isOption(arg, "-j", "--json") && hasValue) {
+			jsonFileName = argv[++i];
+		} else if (isOption(arg, "-w", "--write-roms") && hasValue) {
+			romDirName = argv[++i];
+		} else if (isOption(arg, "-k", "--cpu-level") && hasValue) {
+			CPUFeatureLevel level;
+			if (!CPUFeatures::findLevel(argv[++i], level) || !CPUFeatures::forceLevel(level)) {
+				fprintf(stderr, "CPU feature level %s is not supported\n", argv[i]);
+				return 1;
+			}
+		} else if (isOption(arg, "-p", "--replay") && hasValue) {
+			replayOptions.captureFileName = argv[++i];
+		} else if (isOption(arg, "-c", "--control-rom") && hasValue) {
+			replayOptions.controlROMFileName = argv[++i];
+		} else if (isOption(arg, "-m", "--pcm-rom") && hasValue) {
+			replayOptions.pcmROMFileName = argv[++i];
+		} else if (isOption(arg, "-o", "--output") && hasValue) {
+			replayOptions.outputFileName = argv[++i];
+		} else {
+			printUsage(argv[0]);
+			return isOption(arg, "-h", "--help") ? 0 : 1;
+		}
+	}
+
+	if (romDirName != NULL) {
+		const std::string controlROMFileName = std::string(romDirName) + "/ctrl_synthetic.rom";
+		const std::string pcmROMFileName = std::string(romDirName) + "/pcm_synthetic.rom";
+		if (!SyntheticROMs().save(controlROMFileName.c_str(), pcmROMFileName.c_str())) {
+			fprintf(stderr, "Unable to save the synthetic ROM images to %s\n", romDirName);
+			return 1;
+		}
+		return 0;
+	}
+
+	if (replayOptions.captureFileName != NULL) {
+		return replayCapture(replayOptions, stdout);
+	}
+
+	if (listOnly) {
+		runner.list(stdout);
+		return 0;
+	}
+
+	const bool jsonToStdout = jsonFileName != NULL && strcmp(jsonFileName, "-") == 0;
+	fprintf(stderr, "DSP kernels: %s\n", CPUFeatures::getLevelName(CPUFeatures::getActiveLevel()));
+	runner.run(stderr);
+	runner.printTable(jsonToStdout ? stderr : stdout);
+	if (jsonFileName != NULL) {
+		FILE *jsonFile = jsonToStdout ? stdout : fopen(jsonFileName, "w");
+		if (jsonFile == NULL) {
+			fprintf(stderr, "Unable to open %s for writing\n", jsonFileName);
+			return 1;
+		}
+		runner.printJSON(jsonFile);
+		if (!jsonToStdout) fclose(jsonFile);
+	}
+	return 0;
+}
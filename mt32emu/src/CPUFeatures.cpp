@@ -0,0 +1,161 @@
+/* Copyright (C) 2003, 2004, 2005, 2006, 2008, 2009 Dean Beeler, Jerome Fisher
+ * Copyright (C) 2011-2019 Dean Beeler, Jerome Fisher, Sergey V. Mikayev
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License as published by
+ *  the Free Software Foundation, either version 2.1 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <cstdlib>
+#include <cstring>
+
+#include "internals.h"
+
+#include "CPUFeatures.h"
+#include "DSPKernels.h"
+
+#if MT32EMU_SIMD_X86
+# ifdef _MSC_VER
+#  include <intrin.h>
+# else
+#  include <cpuid.h>
+# endif
+#endif
+
+namespace MT32Emu {
+
+static const char * const LEVEL_NAMES[] = { "scalar", "sse2", "sse4.1", "avx2", "avx512", "neon" };
+static const unsigned int LEVEL_COUNT = sizeof(LEVEL_NAMES) / sizeof(LEVEL_NAMES[0]);
+
+static const int LEVEL_UNKNOWN = -1;
+
+static volatile int detectedLevel = LEVEL_UNKNOWN;
+static volatile int activeLevel = LEVEL_UNKNOWN;
+
+#if MT32EMU_SIMD_X86
+
+static void cpuid(Bit32u leaf, Bit32u subleaf, Bit32u regs[4]) {
+#ifdef _MSC_VER
+	int info[4];
+	__cpuidex(info, int(leaf), int(subleaf));
+	for (int i = 0; i < 4; i++) regs[i] = Bit32u(info[i]);
+#else
+	unsigned int a, b, c, d;
+	__cpuid_count(leaf, subleaf, a, b, c, d);
+	regs[0] = a;
+	regs[1] = b;
+	regs[2] = c;
+	regs[3] = d;
+#endif
+}
+
+// Returns the lower half of the extended control register XCR0, which tells the register states the OS preserves.
+static Bit32u readXCR0() {
+#ifdef _MSC_VER
+	return Bit32u(_xgetbv(0));
+#else
+	Bit32u eax, edx;
+	__asm__ __volatile__("xgetbv" : "=a" (eax), "=d" (edx) : "c" (0));
+	return eax;
+#endif
+}
+
+static CPUFeatureLevel detectLevel() {
+	Bit32u regs[4];
+	cpuid(0, 0, regs);
+	const Bit32u maxLeaf = regs[0];
+	if (maxLeaf < 1) return CPUFeatureLevel_SCALAR;
+
+	cpuid(1, 0, regs);
+	const bool sse2 = (regs[3] & (1 << 26)) != 0;
+	const bool sse41 = (regs[2] & (1 << 19)) != 0;
+	const bool osxsave = (regs[2] & (1 << 27)) != 0;
+	const bool avx = (regs[2] & (1 << 28)) != 0;
+	if (!sse2) return CPUFeatureLevel_SCALAR;
+	if (!sse41) return CPUFeatureLevel_SSE2;
+	if (!osxsave || !avx || maxLeaf < 7) return CPUFeatureLevel_SSE4_1;
+
+	// The OS must preserve the XMM and YMM registers, and additionally the opmask and ZMM registers for AVX-512.
+	const Bit32u xcr0 = readXCR0();
+	if ((xcr0 & 0x06) != 0x06) return CPUFeatureLevel_SSE4_1;
+	cpuid(7, 0, regs);
+	const bool avx2 = (regs[1] & (1 << 5)) != 0;
+	const bool avx512f = (regs[1] & (1 << 16)) != 0;
+	const bool avx512bw = (regs[1] & (1u << 30)) != 0;
+	if (!avx2) return CPUFeatureLevel_SSE4_1;
+	if (!avx512f || !avx512bw || (xcr0 & 0xE0) != 0xE0) return CPUFeatureLevel_AVX2;
+	return CPUFeatureLevel_AVX512;
+}
+
+#elif MT32EMU_SIMD_NEON
+
+static CPUFeatureLevel detectLevel() {
+	// Advanced SIMD is mandatory in AArch64.
+	return CPUFeatureLevel_NEON;
+}
+
+#else
+
+static CPUFeatureLevel detectLevel() {
+	return CPUFeatureLevel_SCALAR;
+}
+
+#endif
+
+CPUFeatureLevel CPUFeatures::getDetectedLevel() {
+	if (detectedLevel == LEVEL_UNKNOWN) detectedLevel = detectLevel();
+	return CPUFeatureLevel(detectedLevel);
+}
+
+bool CPUFeatures::isSupported(CPUFeatureLevel level) {
+	const CPUFeatureLevel detected = getDetectedLevel();
+	if (level == CPUFeatureLevel_SCALAR) return true;
+	if (detected == CPUFeatureLevel_NEON) return level == CPUFeatureLevel_NEON;
+	return level != CPUFeatureLevel_NEON && level <= detected;
+}
+
+CPUFeatureLevel CPUFeatures::getActiveLevel() {
+	if (activeLevel == LEVEL_UNKNOWN) {
+		CPUFeatureLevel level = getDetectedLevel();
+		CPUFeatureLevel requestedLevel;
+		const char *requestedLevelName = getenv("MT32EMU_CPU_LEVEL");
+		if (requestedLevelName != NULL && findLevel(requestedLevelName, requestedLevel) && isSupported(requestedLevel)) {
+			level = requestedLevel;
+		}
+		bindDSPKernels(level);
+		activeLevel = level;
+	}
+	return CPUFeatureLevel(activeLevel);
+}
+
+bool CPUFeatures::forceLevel(CPUFeatureLevel level) {
+	if (!isSupported(level)) return false;
+	bindDSPKernels(level);
+	activeLevel = level;
+	return true;
+}
+
+const char *CPUFeatures::getLevelName(CPUFeatureLevel level) {
+	return Bit32u(level) < LEVEL_COUNT ? LEVEL_NAMES[level] : "unknown";
+}
+
+bool CPUFeatures::findLevel(const char *name, CPUFeatureLevel &level) {
+	for (unsigned int i = 0; i < LEVEL_COUNT; i++) {
+		if (strcmp(name, LEVEL_NAMES[i]) == 0) {
+			level = CPUFeatureLevel(i);
+			return true;
+		}
+	}
+	return false;
+}
+
+} // namespace MT32Emu
@@ -0,0 +1,77 @@
+/* Copyright (C) 2003, 2004, 2005, 2006, 2008, 2009 Dean Beeler, Jerome Fisher
+ * Copyright (C) 2011-2019 Dean Beeler, Jerome Fisher, Sergey V. Mikayev
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License as published by
+ *  the Free Software Foundation, either version 2.1 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef MT32EMU_CPU_FEATURES_H
+#define MT32EMU_CPU_FEATURES_H
+
+#include "internals.h"
+
+// Architectures and compilers, for which the SIMD variants of the DSP kernels are available. The compiler must be able
+// to generate code for an instruction set extension in a single function, without enabling it for the whole file.
+#if MT32EMU_SIMD_KERNELS
+# if (defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_IX86)) \
+	&& (defined(_MSC_VER) || defined(__clang__) || (defined(__GNUC__) && (__GNUC__ > 4 || (__GNUC__ == 4 && __GNUC_MINOR__ >= 9))))
+#  define MT32EMU_SIMD_X86 1
+# elif defined(__aarch64__) || defined(_M_ARM64)
+#  define MT32EMU_SIMD_NEON 1
+# endif
+#endif
+
+#ifndef MT32EMU_SIMD_X86
+# define MT32EMU_SIMD_X86 0
+#endif
+#ifndef MT32EMU_SIMD_NEON
+# define MT32EMU_SIMD_NEON 0
+#endif
+
+namespace MT32Emu {
+
+// Levels of the SIMD instruction set extensions the DSP kernels can be optimised for. Within an architecture,
+// a higher level implies support for all the lower ones.
+enum CPUFeatureLevel {
+	CPUFeatureLevel_SCALAR,
+	CPUFeatureLevel_SSE2,
+	CPUFeatureLevel_SSE4_1,
+	CPUFeatureLevel_AVX2,
+	// AVX-512 Foundation and Byte/Word instructions.
+	CPUFeatureLevel_AVX512,
+	CPUFeatureLevel_NEON
+};
+
+// Detects the SIMD instruction set extensions supported by the CPU and the operating system once per process,
+// and keeps track of the level the DSP kernels are bound to.
+class CPUFeatures {
+public:
+	// Returns the highest level supported by both the CPU and the build.
+	static CPUFeatureLevel getDetectedLevel();
+	// Returns true if the DSP kernels can be bound to the given level on this machine.
+	static bool isSupported(CPUFeatureLevel level);
+	// Returns the level the DSP kernels are bound to. Unless forced, this is the detected level or the level named
+	// by the environment variable MT32EMU_CPU_LEVEL, if it is set to a supported level.
+	static CPUFeatureLevel getActiveLevel();
+	// Rebinds the DSP kernels to the given level, mainly intended for testing. Returns false if the level is not supported.
+	// Must not be invoked while rendering.
+	static bool forceLevel(CPUFeatureLevel level);
+
+	static const char *getLevelName(CPUFeatureLevel level);
+	// Accepts the names returned by getLevelName(). Returns false if the name is unknown.
+	static bool findLevel(const char *name, CPUFeatureLevel &level);
+};
+
+} // namespace MT32Emu
+
+#endif // #ifndef MT32EMU_CPU_FEATURES_H
@@ -0,0 +1,162 @@
+/* Copyright (C) 2003, 2004, 2005, 2006, 2008, 2009 Dean Beeler, Jerome Fisher
+ * Copyright (C) 2011-2019 Dean Beeler, Jerome Fisher, Sergey V. Mikayev
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License as published by
+ *  the Free Software Foundation, either version 2.1 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <cstdio>
+
+#include "internals.h"
+
+#include "ChromeTraceWriter.h"
+#include "Synth.h"
+
+namespace MT32Emu {
+
+static inline FILE *getFile(void *file) {
+	return static_cast<FILE *>(file);
+}
+
+static int writeEvent(FILE *file, const TraceEvent &event, Bit32u pid, double timestamp) {
+	static const char * const HEADER = "{\"name\":\"%s\",\"cat\":\"mt32emu\",\"ph\":\"%s\",\"ts\":%.3f,\"pid\":%u,\"tid\":1,\"args\":{\"sample\":%u";
+
+	const char *name;
+	const char *phase = "i\",\"s\":\"t";
+	switch (event.type) {
+	case TraceEventType_EVENTS_LOST:
+		name = "Events lost";
+		phase = "i\",\"s\":\"g";
+		break;
+	case TraceEventType_BLOCK_START:
+		name = "Render";
+		phase = "B";
+		break;
+	case TraceEventType_BLOCK_END:
+		name = "Render";
+		phase = "E";
+		break;
+	case TraceEventType_MIDI_MESSAGE:
+		name = "MIDI message";
+		break;
+	case TraceEventType_SYSEX_MESSAGE:
+		name = "SysEx message";
+		break;
+	case TraceEventType_POLY_START:
+		name = "Poly start";
+		break;
+	case TraceEventType_POLY_ABORT:
+		name = "Poly abort";
+		break;
+	case TraceEventType_PARTIAL_ALLOCATION_FAILURE:
+		name = "Partial allocation failure";
+		break;
+	case TraceEventType_MIDI_QUEUE_OVERFLOW:
+		name = "MIDI queue overflow";
+		break;
+	case TraceEventType_REVERB_MODE_CHANGE:
+		name = "Reverb change";
+		break;
+	default:
+		name = "Unknown";
+		break;
+	}
+	int result = fprintf(file, HEADER, name, phase, timestamp, pid, event.renderedSampleCount);
+	if (result < 0) return result;
+
+	switch (event.type) {
+	case TraceEventType_EVENTS_LOST:
+	case TraceEventType_MIDI_QUEUE_OVERFLOW:
+		result = fprintf(file, ",\"count\":%u", event.data1);
+		break;
+	case TraceEventType_BLOCK_START:
+		result = fprintf(file, ",\"length\":%u", event.data1);
+		break;
+	case TraceEventType_BLOCK_END:
+		result = fprintf(file, ",\"samples\":%u", event.data1);
+		break;
+	case TraceEventType_MIDI_MESSAGE:
+		result = fprintf(file, ",\"message\":\"%06X\",\"delay\":%d", event.data1, Bit32s(event.data2));
+		break;
+	case TraceEventType_SYSEX_MESSAGE:
+		result = fprintf(file, ",\"length\":%u,\"delay\":%d", event.data1, Bit32s(event.data2));
+		break;
+	case TraceEventType_POLY_START:
+		result = fprintf(file, ",\"part\":%u,\"key\":%u,\"velocity\":%u", event.data1, event.data2 & 0xFF, (event.data2 >> 8) & 0xFF);
+		break;
+	case TraceEventType_POLY_ABORT:
+		result = fprintf(file, ",\"part\":%u,\"key\":%u", event.data1, event.data2);
+		break;
+	case TraceEventType_PARTIAL_ALLOCATION_FAILURE:
+		result = fprintf(file, ",\"part\":%u,\"needed\":%u", event.data1, event.data2);
+		break;
+	case TraceEventType_REVERB_MODE_CHANGE:
+		result = fprintf(file, ",\"mode\":%u,\"time\":%u,\"level\":%u", event.data1, event.data2 & 0xFF, (event.data2 >> 8) & 0xFF);
+		break;
+	default:
+		result = fprintf(file, ",\"data1\":%u,\"data2\":%u", event.data1, event.data2);
+		break;
+	}
+	if (result < 0) return result;
+	return fputs("}}", file);
+}
+
+ChromeTraceWriter::ChromeTraceWriter() : file(NULL), pid(1), firstEvent(true), startNanos(0) {}
+
+ChromeTraceWriter::~ChromeTraceWriter() {
+	close();
+}
+
+bool ChromeTraceWriter::open(const char *filename, Bit32u processId) {
+	close();
+	file = fopen(filename, "w");
+	if (file == NULL) return false;
+	pid = processId;
+	firstEvent = true;
+	if (fputs("[\n", getFile(file)) < 0) {
+		close();
+		return false;
+	}
+	return true;
+}
+
+bool ChromeTraceWriter::write(const TraceEvent *events, Bit32u count) {
+	if (file == NULL) return false;
+	for (Bit32u i = 0; i < count; i++) {
+		const TraceEvent &event = events[i];
+		if (firstEvent) {
+			startNanos = event.timeNanos;
+		} else if (fputs(",\n", getFile(file)) < 0) {
+			return false;
+		}
+		firstEvent = false;
+		// Timestamps are expressed in microseconds.
+		if (writeEvent(getFile(file), event, pid, (event.timeNanos - startNanos) * 1e-3) < 0) {
+			return false;
+		}
+	}
+	return true;
+}
+
+void ChromeTraceWriter::close() {
+	if (file == NULL) return;
+	fputs("\n]\n", getFile(file));
+	fclose(getFile(file));
+	file = NULL;
+}
+
+bool ChromeTraceWriter::isOpen() const {
+	return file != NULL;
+}
+
+} // namespace MT32Emu
@@ -0,0 +1,59 @@
+/* Copyright (C) 2003, 2004, 2005, 2006, 2008, 2009 Dean Beeler, Jerome Fisher
+ * Copyright (C) 2011-2019 Dean Beeler, Jerome Fisher, Sergey V. Mikayev
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License as published by
+ *  the Free Software Foundation, either version 2.1 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef MT32EMU_CHROME_TRACE_WRITER_H
+#define MT32EMU_CHROME_TRACE_WRITER_H
+
+#include "globals.h"
+#include "Types.h"
+
+namespace MT32Emu {
+
+struct TraceEvent;
+
+/* ChromeTraceWriter class saves the trace events retrieved with Synth::readTraceEvents() to a file in the JSON format
+ * of the Chrome trace event profiling tool, which can be visualised e.g. by chrome://tracing or the Perfetto UI.
+ * Rendered blocks appear as durations, other events appear as instant events with the event data in the arguments.
+ * The JSON array format is used, so that the file remains loadable even if it is not closed properly.
+ */
+class MT32EMU_EXPORT ChromeTraceWriter {
+public:
+	ChromeTraceWriter();
+	// Closes the file if open.
+	~ChromeTraceWriter();
+
+	// Creates the file with the given name and starts the trace. Returns false if the file cannot be created.
+	// The trace events of each writer are attributed to a separate process with the given ID in the trace viewer.
+	bool open(const char *filename, Bit32u processId = 1);
+	// Appends the trace events to the file. Returns false if the file is not open or a write error occurred.
+	// The timestamps are shown relative to the first event written.
+	bool write(const TraceEvent *events, Bit32u count);
+	// Completes the trace and closes the file.
+	void close();
+	// Returns true if the file is open.
+	bool isOpen() const;
+
+private:
+	void *file;
+	Bit32u pid;
+	bool firstEvent;
+	double startNanos;
+}; // class ChromeTraceWriter
+
+} // namespace MT32Emu
+
+#endif // #ifndef MT32EMU_CHROME_TRACE_WRITER_H
@@ -0,0 +1,65 @@
+/* Copyright (C) 2003, 2004, 2005, 2006, 2008, 2009 Dean Beeler, Jerome Fisher
+ * Copyright (C) 2011-2019 Dean Beeler, Jerome Fisher, Sergey V. Mikayev
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License as published by
+ *  the Free Software Foundation, either version 2.1 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#if defined _WIN32 || defined __CYGWIN__
+#include <windows.h>
+#define MT32EMU_CLOCK_WIN32 1
+#else
+#include <time.h>
+#include <sys/time.h>
+#define MT32EMU_CLOCK_WIN32 0
+#endif
+
+#include "internals.h"
+
+#include "Clock.h"
+
+namespace MT32Emu {
+
+#if MT32EMU_CLOCK_WIN32
+
+static double getNanosecondsPerTick() {
+	LARGE_INTEGER frequency;
+	QueryPerformanceFrequency(&frequency);
+	return 1e9 / double(frequency.QuadPart);
+}
+
+double Clock::getNanoseconds() {
+	static const double NANOSECONDS_PER_TICK = getNanosecondsPerTick();
+	LARGE_INTEGER counter;
+	QueryPerformanceCounter(&counter);
+	return double(counter.QuadPart) * NANOSECONDS_PER_TICK;
+}
+
+#else // #if MT32EMU_CLOCK_WIN32
+
+double Clock::getNanoseconds() {
+#ifdef CLOCK_MONOTONIC
+	timespec now;
+	if (clock_gettime(CLOCK_MONOTONIC, &now) == 0) {
+		return double(now.tv_sec) * 1e9 + double(now.tv_nsec);
+	}
+#endif
+	// Fallback for the systems that lack the monotonic clock.
+	timeval tv;
+	gettimeofday(&tv, NULL);
+	return double(tv.tv_sec) * 1e9 + double(tv.tv_usec) * 1e3;
+}
+
+#endif // #if MT32EMU_CLOCK_WIN32
+
+} // namespace MT32Emu
@@ -0,0 +1,135 @@
+/* Copyright (C) 2003, 2004, 2005, 2006, 2008, 2009 Dean Beeler, Jerome Fisher
+ * Copyright (C) 2011-2019 Dean Beeler, Jerome Fisher, Sergey V. Mikayev
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License as published by
+ *  the Free Software Foundation, either version 2.1 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "internals.h"
+
+#include "DSPKernels.h"
+#include "MemoryFences.h"
+#include "Synth.h"
+
+namespace MT32Emu {
+
+static DSPKernels boundKernels;
+static volatile bool kernelsBound = false;
+
+static void convertFloatToIntScalar(const FloatSample *inBuffer, IntSample *outBuffer, Bit32u len) {
+	while (len--) {
+		*(outBuffer++) = Synth::convertSample(*(inBuffer++));
+	}
+}
+
+static void convertIntToFloatScalar(const IntSample *inBuffer, FloatSample *outBuffer, Bit32u len) {
+	while (len--) {
+		*(outBuffer++) = Synth::convertSample(*(inBuffer++));
+	}
+}
+
+static void mixIntScalar(IntSample *buffer, const IntSample *addend, Bit32u len) {
+	while (len--) {
+		*buffer = Synth::clipSampleEx(IntSampleEx(*buffer) + IntSampleEx(*(addend++)));
+		buffer++;
+	}
+}
+
+static void mixFloatScalar(FloatSample *buffer, const FloatSample *addend, Bit32u len) {
+	while (len--) {
+		*(buffer++) += *(addend++);
+	}
+}
+
+static void amplifyIntScalar(IntSample *buffer, Bit32u len) {
+	while (len--) {
+		*buffer = Synth::clipSampleEx(IntSampleEx(*buffer) << 1);
+		++buffer;
+	}
+}
+
+static void shiftGeneration1IntScalar(IntSample *buffer, Bit32u len) {
+	while (len--) {
+		*buffer = IntSample((*buffer & 0x8000) | ((*buffer << 1) & 0x7FFE));
+		++buffer;
+	}
+}
+
+static void shiftGeneration2IntScalar(IntSample *buffer, Bit32u len) {
+	while (len--) {
+		*buffer = IntSample((*buffer & 0x8000) | ((*buffer << 1) & 0x7FFE) | ((*buffer >> 14) & 0x0001));
+		++buffer;
+	}
+}
+
+static void panAndMixIntScalar(IntSample *leftBuffer, IntSample *rightBuffer, const IntSample *monoBuffer, Bit32u len, Bit32s leftPanFactor, Bit32s rightPanFactor) {
+	while (len--) {
+		const IntSampleEx sample = *(monoBuffer++);
+		*leftBuffer = Synth::clipSampleEx(((sample * leftPanFactor) >> 13) + IntSampleEx(*leftBuffer)); // PORTABILITY NOTE: Assumes arithmetic shift.
+		*rightBuffer = Synth::clipSampleEx(((sample * rightPanFactor) >> 13) + IntSampleEx(*rightBuffer));
+		leftBuffer++;
+		rightBuffer++;
+	}
+}
+
+static void panAndMixFloatScalar(FloatSample *leftBuffer, FloatSample *rightBuffer, const FloatSample *monoBuffer, Bit32u len, Bit32s leftPanSetting, Bit32s rightPanSetting) {
+	const FloatSample leftPan = FloatSample(leftPanSetting);
+	const FloatSample rightPan = FloatSample(rightPanSetting);
+	while (len--) {
+		const FloatSample sample = *(monoBuffer++);
+		*(leftBuffer++) += (sample * leftPan) / 14.0f;
+		*(rightBuffer++) += (sample * rightPan) / 14.0f;
+	}
+}
+
+void bindScalarDSPKernels(DSPKernels &kernels) {
+	kernels.convertFloatToInt = convertFloatToIntScalar;
+	kernels.convertIntToFloat = convertIntToFloatScalar;
+	kernels.mixInt = mixIntScalar;
+	kernels.mixFloat = mixFloatScalar;
+	kernels.amplifyInt = amplifyIntScalar;
+	kernels.shiftGeneration1Int = shiftGeneration1IntScalar;
+	kernels.shiftGeneration2Int = shiftGeneration2IntScalar;
+	kernels.panAndMixInt = panAndMixIntScalar;
+	kernels.panAndMixFloat = panAndMixFloatScalar;
+}
+
+void bindDSPKernels(CPUFeatureLevel level) {
+	DSPKernels kernels;
+	bindScalarDSPKernels(kernels);
+#if MT32EMU_SIMD_X86
+	if (level >= CPUFeatureLevel_SSE2 && level <= CPUFeatureLevel_AVX512) bindSSE2DSPKernels(kernels);
+	// None of the kernels gains from SSE4.1 over SSE2.
+	if (level >= CPUFeatureLevel_AVX2 && level <= CPUFeatureLevel_AVX512) bindAVX2DSPKernels(kernels);
+	if (level == CPUFeatureLevel_AVX512) bindAVX512DSPKernels(kernels);
+#endif
+#if MT32EMU_SIMD_NEON
+	if (level == CPUFeatureLevel_NEON) bindNEONDSPKernels(kernels);
+#endif
+#if !MT32EMU_SIMD_X86 && !MT32EMU_SIMD_NEON
+	(void)level;
+#endif
+	boundKernels = kernels;
+	// The kernels must be seen by the other rendering threads before the flag is.
+	releaseFence();
+	kernelsBound = true;
+}
+
+const DSPKernels &getDSPKernels() {
+	// Racing threads bind the same kernels, hence no locking is needed.
+	if (!kernelsBound) CPUFeatures::getActiveLevel();
+	acquireFence();
+	return boundKernels;
+}
+
+} // namespace MT32Emu
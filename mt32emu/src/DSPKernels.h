@@ -0,0 +1,70 @@
+/* Copyright (C) 2003, 2004, 2005, 2006, 2008, 2009 Dean Beeler, Jerome Fisher
+ * Copyright (C) 2011-2019 Dean Beeler, Jerome Fisher, Sergey V. Mikayev
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License as published by
+ *  the Free Software Foundation, either version 2.1 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef MT32EMU_DSP_KERNELS_H
+#define MT32EMU_DSP_KERNELS_H
+
+#include "internals.h"
+#include "CPUFeatures.h"
+
+namespace MT32Emu {
+
+// Table of the hot sample processing loops that benefit from the SIMD instruction set extensions. The entries are bound
+// to the variants optimised for the active CPU feature level, see CPUFeatures. All the variants produce bit-exact results,
+// so the rendered output does not depend on the level. The lengths are in samples, the buffers need not be aligned.
+struct DSPKernels {
+	// Converts normalised float samples to 16-bit integer samples the same way as Synth::convertSample().
+	void (*convertFloatToInt)(const FloatSample *inBuffer, IntSample *outBuffer, Bit32u len);
+	// Converts 16-bit integer samples to normalised float samples the same way as Synth::convertSample().
+	void (*convertIntToFloat)(const IntSample *inBuffer, FloatSample *outBuffer, Bit32u len);
+	// Adds the addend samples to the buffer, saturating the integer samples the same way as Synth::clipSampleEx().
+	void (*mixInt)(IntSample *buffer, const IntSample *addend, Bit32u len);
+	void (*mixFloat)(FloatSample *buffer, const FloatSample *addend, Bit32u len);
+	// Doubles the samples with saturation, as the LA32 output is amplified in DACInputMode_NICE.
+	void (*amplifyInt)(IntSample *buffer, Bit32u len);
+	// Emulate the bit shift of the integer samples on the way to the DAC in DACInputMode_GENERATION1
+	// and DACInputMode_GENERATION2 respectively, the latter also copies bit 14 to bit 0.
+	void (*shiftGeneration1Int)(IntSample *buffer, Bit32u len);
+	void (*shiftGeneration2Int)(IntSample *buffer, Bit32u len);
+	// Pans the mono output of a partial and adds it to the stereo buffers the same way the LA32 does. The integer samples
+	// are multiplied by the pan factors in range -8192..8192, scaled by 2^-13 and saturated when added up. The float samples
+	// are multiplied by the pan settings in range -14..14 divided by 14.
+	void (*panAndMixInt)(IntSample *leftBuffer, IntSample *rightBuffer, const IntSample *monoBuffer, Bit32u len, Bit32s leftPanFactor, Bit32s rightPanFactor);
+	void (*panAndMixFloat)(FloatSample *leftBuffer, FloatSample *rightBuffer, const FloatSample *monoBuffer, Bit32u len, Bit32s leftPanSetting, Bit32s rightPanSetting);
+};
+
+// Returns the kernels bound to the active CPU feature level. The binding happens upon the first call.
+const DSPKernels &getDSPKernels();
+
+// Binds the kernels to the given level, which must be supported. Used by CPUFeatures.
+void bindDSPKernels(CPUFeatureLevel level);
+
+// Each of these functions overrides the entries that are optimised for the respective level,
+// the rest of the table is expected to be filled in with the kernels of the lower levels already.
+void bindScalarDSPKernels(DSPKernels &kernels);
+#if MT32EMU_SIMD_X86
+void bindSSE2DSPKernels(DSPKernels &kernels);
+void bindAVX2DSPKernels(DSPKernels &kernels);
+void bindAVX512DSPKernels(DSPKernels &kernels);
+#endif
+#if MT32EMU_SIMD_NEON
+void bindNEONDSPKernels(DSPKernels &kernels);
+#endif
+
+} // namespace MT32Emu
+
+#endif // #ifndef MT32EMU_DSP_KERNELS_H
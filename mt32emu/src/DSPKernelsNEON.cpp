@@ -0,0 +1,164 @@
+/* Copyright (C) 2003, 2004, 2005, 2006, 2008, 2009 Dean Beeler, Jerome Fisher
+ * Copyright (C) 2011-2019 Dean Beeler, Jerome Fisher, Sergey V. Mikayev
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License as published by
+ *  the Free Software Foundation, either version 2.1 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "internals.h"
+
+#include "DSPKernels.h"
+
+#if MT32EMU_SIMD_NEON
+
+#include <arm_neon.h>
+
+#include "Synth.h"
+
+namespace MT32Emu {
+
+// The remainders that do not fill a vector are processed by the scalar code, which is bit-exact with the vector code.
+// Conversion of floats to integers rounds towards zero and saturates, narrowing saturates as well,
+// that matches the rounding and clipping in Synth::convertSample().
+
+static void convertFloatToIntNEON(const FloatSample *inBuffer, IntSample *outBuffer, Bit32u len) {
+	for (; len >= 8; len -= 8, inBuffer += 8, outBuffer += 8) {
+		const int32x4_t lo = vcvtq_s32_f32(vmulq_n_f32(vld1q_f32(inBuffer), 32768.0f));
+		const int32x4_t hi = vcvtq_s32_f32(vmulq_n_f32(vld1q_f32(inBuffer + 4), 32768.0f));
+		vst1q_s16(outBuffer, vcombine_s16(vqmovn_s32(lo), vqmovn_s32(hi)));
+	}
+	while (len--) {
+		*(outBuffer++) = Synth::convertSample(*(inBuffer++));
+	}
+}
+
+static void convertIntToFloatNEON(const IntSample *inBuffer, FloatSample *outBuffer, Bit32u len) {
+	for (; len >= 8; len -= 8, inBuffer += 8, outBuffer += 8) {
+		const int16x8_t samples = vld1q_s16(inBuffer);
+		vst1q_f32(outBuffer, vmulq_n_f32(vcvtq_f32_s32(vmovl_s16(vget_low_s16(samples))), 1.0f / 32768.0f));
+		vst1q_f32(outBuffer + 4, vmulq_n_f32(vcvtq_f32_s32(vmovl_s16(vget_high_s16(samples))), 1.0f / 32768.0f));
+	}
+	while (len--) {
+		*(outBuffer++) = Synth::convertSample(*(inBuffer++));
+	}
+}
+
+static void mixIntNEON(IntSample *buffer, const IntSample *addend, Bit32u len) {
+	for (; len >= 8; len -= 8, buffer += 8, addend += 8) {
+		vst1q_s16(buffer, vqaddq_s16(vld1q_s16(buffer), vld1q_s16(addend)));
+	}
+	while (len--) {
+		*buffer = Synth::clipSampleEx(IntSampleEx(*buffer) + IntSampleEx(*(addend++)));
+		buffer++;
+	}
+}
+
+static void mixFloatNEON(FloatSample *buffer, const FloatSample *addend, Bit32u len) {
+	for (; len >= 4; len -= 4, buffer += 4, addend += 4) {
+		vst1q_f32(buffer, vaddq_f32(vld1q_f32(buffer), vld1q_f32(addend)));
+	}
+	while (len--) {
+		*(buffer++) += *(addend++);
+	}
+}
+
+static void amplifyIntNEON(IntSample *buffer, Bit32u len) {
+	for (; len >= 8; len -= 8, buffer += 8) {
+		const int16x8_t samples = vld1q_s16(buffer);
+		vst1q_s16(buffer, vqaddq_s16(samples, samples));
+	}
+	while (len--) {
+		*buffer = Synth::clipSampleEx(IntSampleEx(*buffer) << 1);
+		++buffer;
+	}
+}
+
+static void shiftGeneration1IntNEON(IntSample *buffer, Bit32u len) {
+	const int16x8_t signMask = vdupq_n_s16(-0x8000);
+	const int16x8_t valueMask = vdupq_n_s16(0x7FFE);
+	for (; len >= 8; len -= 8, buffer += 8) {
+		const int16x8_t samples = vld1q_s16(buffer);
+		vst1q_s16(buffer, vorrq_s16(vandq_s16(samples, signMask), vandq_s16(vshlq_n_s16(samples, 1), valueMask)));
+	}
+	while (len--) {
+		*buffer = IntSample((*buffer & 0x8000) | ((*buffer << 1) & 0x7FFE));
+		++buffer;
+	}
+}
+
+static void shiftGeneration2IntNEON(IntSample *buffer, Bit32u len) {
+	const int16x8_t signMask = vdupq_n_s16(-0x8000);
+	const int16x8_t valueMask = vdupq_n_s16(0x7FFE);
+	for (; len >= 8; len -= 8, buffer += 8) {
+		const int16x8_t samples = vld1q_s16(buffer);
+		const int16x8_t shifted = vorrq_s16(vandq_s16(samples, signMask), vandq_s16(vshlq_n_s16(samples, 1), valueMask));
+		const int16x8_t lowBit = vreinterpretq_s16_u16(vshrq_n_u16(vshlq_n_u16(vreinterpretq_u16_s16(samples), 1), 15));
+		vst1q_s16(buffer, vorrq_s16(shifted, lowBit));
+	}
+	while (len--) {
+		*buffer = IntSample((*buffer & 0x8000) | ((*buffer << 1) & 0x7FFE) | ((*buffer >> 14) & 0x0001));
+		++buffer;
+	}
+}
+
+static inline int16x4_t panAndMixNEON(const int16x4_t samples, const Bit16s panFactor, const int16x4_t buffer) {
+	return vqmovn_s32(vaddq_s32(vshrq_n_s32(vmull_n_s16(samples, panFactor), 13), vmovl_s16(buffer)));
+}
+
+static void panAndMixIntNEON(IntSample *leftBuffer, IntSample *rightBuffer, const IntSample *monoBuffer, Bit32u len, Bit32s leftPanFactor, Bit32s rightPanFactor) {
+	// The pan factors fit in 16 bits, the panned samples are added with 32-bit precision and saturated upon narrowing.
+	for (; len >= 4; len -= 4, leftBuffer += 4, rightBuffer += 4, monoBuffer += 4) {
+		const int16x4_t samples = vld1_s16(monoBuffer);
+		vst1_s16(leftBuffer, panAndMixNEON(samples, Bit16s(leftPanFactor), vld1_s16(leftBuffer)));
+		vst1_s16(rightBuffer, panAndMixNEON(samples, Bit16s(rightPanFactor), vld1_s16(rightBuffer)));
+	}
+	while (len--) {
+		const IntSampleEx sample = *(monoBuffer++);
+		*leftBuffer = Synth::clipSampleEx(((sample * leftPanFactor) >> 13) + IntSampleEx(*leftBuffer));
+		*rightBuffer = Synth::clipSampleEx(((sample * rightPanFactor) >> 13) + IntSampleEx(*rightBuffer));
+		leftBuffer++;
+		rightBuffer++;
+	}
+}
+
+static void panAndMixFloatNEON(FloatSample *leftBuffer, FloatSample *rightBuffer, const FloatSample *monoBuffer, Bit32u len, Bit32s leftPanSetting, Bit32s rightPanSetting) {
+	const FloatSample leftPan = FloatSample(leftPanSetting);
+	const FloatSample rightPan = FloatSample(rightPanSetting);
+	const float32x4_t divisor = vdupq_n_f32(14.0f);
+	for (; len >= 4; len -= 4, leftBuffer += 4, rightBuffer += 4, monoBuffer += 4) {
+		const float32x4_t samples = vld1q_f32(monoBuffer);
+		vst1q_f32(leftBuffer, vaddq_f32(vld1q_f32(leftBuffer), vdivq_f32(vmulq_n_f32(samples, leftPan), divisor)));
+		vst1q_f32(rightBuffer, vaddq_f32(vld1q_f32(rightBuffer), vdivq_f32(vmulq_n_f32(samples, rightPan), divisor)));
+	}
+	while (len--) {
+		const FloatSample sample = *(monoBuffer++);
+		*(leftBuffer++) += (sample * leftPan) / 14.0f;
+		*(rightBuffer++) += (sample * rightPan) / 14.0f;
+	}
+}
+
+void bindNEONDSPKernels(DSPKernels &kernels) {
+	kernels.convertFloatToInt = convertFloatToIntNEON;
+	kernels.convertIntToFloat = convertIntToFloatNEON;
+	kernels.mixInt = mixIntNEON;
+	kernels.mixFloat = mixFloatNEON;
+	kernels.amplifyInt = amplifyIntNEON;
+	kernels.shiftGeneration1Int = shiftGeneration1IntNEON;
+	kernels.shiftGeneration2Int = shiftGeneration2IntNEON;
+	kernels.panAndMixInt = panAndMixIntNEON;
+	kernels.panAndMixFloat = panAndMixFloatNEON;
+}
+
+} // namespace MT32Emu
+
+#endif // #if MT32EMU_SIMD_NEON
@@ -0,0 +1,446 @@
+/* Copyright (C) 2003, 2004, 2005, 2006, 2008, 2009 Dean Beeler, Jerome Fisher
+ * Copyright (C) 2011-2019 Dean Beeler, Jerome Fisher, Sergey V. Mikayev
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License as published by
+ *  the Free Software Foundation, either version 2.1 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "internals.h"
+
+#include "DSPKernels.h"
+
+#if MT32EMU_SIMD_X86
+
+#include <immintrin.h>
+
+#include "Synth.h"
+
+// The instruction set extensions are only enabled in the functions that use them, so that the rest of the library
+// still runs on any CPU of the architecture.
+#ifdef _MSC_VER
+# define MT32EMU_TARGET_SSE2
+# define MT32EMU_TARGET_AVX2
+# define MT32EMU_TARGET_AVX512
+#else
+# define MT32EMU_TARGET_SSE2 __attribute__((target("sse2")))
+# define MT32EMU_TARGET_AVX2 __attribute__((target("avx2")))
+# define MT32EMU_TARGET_AVX512 __attribute__((target("avx512f,avx512bw")))
+#endif
+
+namespace MT32Emu {
+
+// The remainders that do not fill a vector are processed by the scalar code, which is bit-exact with the vector code.
+
+static inline void convertFloatToIntTail(const FloatSample *inBuffer, IntSample *outBuffer, Bit32u len) {
+	while (len--) {
+		*(outBuffer++) = Synth::convertSample(*(inBuffer++));
+	}
+}
+
+static inline void convertIntToFloatTail(const IntSample *inBuffer, FloatSample *outBuffer, Bit32u len) {
+	while (len--) {
+		*(outBuffer++) = Synth::convertSample(*(inBuffer++));
+	}
+}
+
+static inline void mixIntTail(IntSample *buffer, const IntSample *addend, Bit32u len) {
+	while (len--) {
+		*buffer = Synth::clipSampleEx(IntSampleEx(*buffer) + IntSampleEx(*(addend++)));
+		buffer++;
+	}
+}
+
+static inline void mixFloatTail(FloatSample *buffer, const FloatSample *addend, Bit32u len) {
+	while (len--) {
+		*(buffer++) += *(addend++);
+	}
+}
+
+static inline void amplifyIntTail(IntSample *buffer, Bit32u len) {
+	while (len--) {
+		*buffer = Synth::clipSampleEx(IntSampleEx(*buffer) << 1);
+		++buffer;
+	}
+}
+
+static inline void shiftGeneration1IntTail(IntSample *buffer, Bit32u len) {
+	while (len--) {
+		*buffer = IntSample((*buffer & 0x8000) | ((*buffer << 1) & 0x7FFE));
+		++buffer;
+	}
+}
+
+static inline void shiftGeneration2IntTail(IntSample *buffer, Bit32u len) {
+	while (len--) {
+		*buffer = IntSample((*buffer & 0x8000) | ((*buffer << 1) & 0x7FFE) | ((*buffer >> 14) & 0x0001));
+		++buffer;
+	}
+}
+
+static inline void panAndMixIntTail(IntSample *leftBuffer, IntSample *rightBuffer, const IntSample *monoBuffer, Bit32u len, Bit32s leftPanFactor, Bit32s rightPanFactor) {
+	while (len--) {
+		const IntSampleEx sample = *(monoBuffer++);
+		*leftBuffer = Synth::clipSampleEx(((sample * leftPanFactor) >> 13) + IntSampleEx(*leftBuffer));
+		*rightBuffer = Synth::clipSampleEx(((sample * rightPanFactor) >> 13) + IntSampleEx(*rightBuffer));
+		leftBuffer++;
+		rightBuffer++;
+	}
+}
+
+static inline void panAndMixFloatTail(FloatSample *leftBuffer, FloatSample *rightBuffer, const FloatSample *monoBuffer, Bit32u len, FloatSample leftPan, FloatSample rightPan) {
+	while (len--) {
+		const FloatSample sample = *(monoBuffer++);
+		*(leftBuffer++) += (sample * leftPan) / 14.0f;
+		*(rightBuffer++) += (sample * rightPan) / 14.0f;
+	}
+}
+
+// Truncation of floats to integers and saturating packing match the rounding and clipping in Synth::convertSample().
+// Multiplying by the reciprocal of a power of two is exactly the same as dividing by it.
+
+MT32EMU_TARGET_SSE2 static void convertFloatToIntSSE2(const FloatSample *inBuffer, IntSample *outBuffer, Bit32u len) {
+	const __m128 factor = _mm_set1_ps(32768.0f);
+	for (; len >= 8; len -= 8, inBuffer += 8, outBuffer += 8) {
+		const __m128i lo = _mm_cvttps_epi32(_mm_mul_ps(_mm_loadu_ps(inBuffer), factor));
+		const __m128i hi = _mm_cvttps_epi32(_mm_mul_ps(_mm_loadu_ps(inBuffer + 4), factor));
+		_mm_storeu_si128(reinterpret_cast<__m128i *>(outBuffer), _mm_packs_epi32(lo, hi));
+	}
+	convertFloatToIntTail(inBuffer, outBuffer, len);
+}
+
+MT32EMU_TARGET_SSE2 static void convertIntToFloatSSE2(const IntSample *inBuffer, FloatSample *outBuffer, Bit32u len) {
+	const __m128 factor = _mm_set1_ps(1.0f / 32768.0f);
+	for (; len >= 8; len -= 8, inBuffer += 8, outBuffer += 8) {
+		const __m128i samples = _mm_loadu_si128(reinterpret_cast<const __m128i *>(inBuffer));
+		// Sign extension by means of an arithmetic shift of the 16-bit samples placed in the upper halves.
+		const __m128i lo = _mm_srai_epi32(_mm_unpacklo_epi16(samples, samples), 16);
+		const __m128i hi = _mm_srai_epi32(_mm_unpackhi_epi16(samples, samples), 16);
+		_mm_storeu_ps(outBuffer, _mm_mul_ps(_mm_cvtepi32_ps(lo), factor));
+		_mm_storeu_ps(outBuffer + 4, _mm_mul_ps(_mm_cvtepi32_ps(hi), factor));
+	}
+	convertIntToFloatTail(inBuffer, outBuffer, len);
+}
+
+MT32EMU_TARGET_SSE2 static void mixIntSSE2(IntSample *buffer, const IntSample *addend, Bit32u len) {
+	for (; len >= 8; len -= 8, buffer += 8, addend += 8) {
+		const __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i *>(buffer));
+		const __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i *>(addend));
+		_mm_storeu_si128(reinterpret_cast<__m128i *>(buffer), _mm_adds_epi16(a, b));
+	}
+	mixIntTail(buffer, addend, len);
+}
+
+MT32EMU_TARGET_SSE2 static void mixFloatSSE2(FloatSample *buffer, const FloatSample *addend, Bit32u len) {
+	for (; len >= 4; len -= 4, buffer += 4, addend += 4) {
+		_mm_storeu_ps(buffer, _mm_add_ps(_mm_loadu_ps(buffer), _mm_loadu_ps(addend)));
+	}
+	mixFloatTail(buffer, addend, len);
+}
+
+MT32EMU_TARGET_SSE2 static void amplifyIntSSE2(IntSample *buffer, Bit32u len) {
+	for (; len >= 8; len -= 8, buffer += 8) {
+		const __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i *>(buffer));
+		_mm_storeu_si128(reinterpret_cast<__m128i *>(buffer), _mm_adds_epi16(a, a));
+	}
+	amplifyIntTail(buffer, len);
+}
+
+MT32EMU_TARGET_SSE2 static void shiftGeneration1IntSSE2(IntSample *buffer, Bit32u len) {
+	const __m128i signMask = _mm_set1_epi16(-0x8000);
+	const __m128i valueMask = _mm_set1_epi16(0x7FFE);
+	for (; len >= 8; len -= 8, buffer += 8) {
+		const __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i *>(buffer));
+		_mm_storeu_si128(reinterpret_cast<__m128i *>(buffer), _mm_or_si128(_mm_and_si128(a, signMask), _mm_and_si128(_mm_slli_epi16(a, 1), valueMask)));
+	}
+	shiftGeneration1IntTail(buffer, len);
+}
+
+MT32EMU_TARGET_SSE2 static void shiftGeneration2IntSSE2(IntSample *buffer, Bit32u len) {
+	const __m128i signMask = _mm_set1_epi16(-0x8000);
+	const __m128i valueMask = _mm_set1_epi16(0x7FFE);
+	for (; len >= 8; len -= 8, buffer += 8) {
+		const __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i *>(buffer));
+		const __m128i shifted = _mm_or_si128(_mm_and_si128(a, signMask), _mm_and_si128(_mm_slli_epi16(a, 1), valueMask));
+		_mm_storeu_si128(reinterpret_cast<__m128i *>(buffer), _mm_or_si128(shifted, _mm_and_si128(_mm_srli_epi16(a, 14), _mm_set1_epi16(1))));
+	}
+	shiftGeneration2IntTail(buffer, len);
+}
+
+// The panned samples are added to the buffer with 32-bit precision and saturated upon packing, as clipSampleEx() does.
+// The pan factors fit in 16 bits, so the 32-bit products are assembled from the halves of the 16-bit multiplications.
+MT32EMU_TARGET_SSE2 static inline __m128i panAndMixSSE2(const __m128i samples, const __m128i panFactor, const __m128i buffer) {
+	const __m128i productsLo = _mm_mullo_epi16(samples, panFactor);
+	const __m128i productsHi = _mm_mulhi_epi16(samples, panFactor);
+	const __m128i lo = _mm_srai_epi32(_mm_unpacklo_epi16(productsLo, productsHi), 13);
+	const __m128i hi = _mm_srai_epi32(_mm_unpackhi_epi16(productsLo, productsHi), 13);
+	const __m128i bufferLo = _mm_srai_epi32(_mm_unpacklo_epi16(buffer, buffer), 16);
+	const __m128i bufferHi = _mm_srai_epi32(_mm_unpackhi_epi16(buffer, buffer), 16);
+	return _mm_packs_epi32(_mm_add_epi32(lo, bufferLo), _mm_add_epi32(hi, bufferHi));
+}
+
+MT32EMU_TARGET_SSE2 static void panAndMixIntSSE2(IntSample *leftBuffer, IntSample *rightBuffer, const IntSample *monoBuffer, Bit32u len, Bit32s leftPanFactor, Bit32s rightPanFactor) {
+	const __m128i leftPan = _mm_set1_epi16(Bit16s(leftPanFactor));
+	const __m128i rightPan = _mm_set1_epi16(Bit16s(rightPanFactor));
+	for (; len >= 8; len -= 8, leftBuffer += 8, rightBuffer += 8, monoBuffer += 8) {
+		const __m128i samples = _mm_loadu_si128(reinterpret_cast<const __m128i *>(monoBuffer));
+		__m128i *left = reinterpret_cast<__m128i *>(leftBuffer);
+		__m128i *right = reinterpret_cast<__m128i *>(rightBuffer);
+		_mm_storeu_si128(left, panAndMixSSE2(samples, leftPan, _mm_loadu_si128(left)));
+		_mm_storeu_si128(right, panAndMixSSE2(samples, rightPan, _mm_loadu_si128(right)));
+	}
+	panAndMixIntTail(leftBuffer, rightBuffer, monoBuffer, len, leftPanFactor, rightPanFactor);
+}
+
+MT32EMU_TARGET_SSE2 static void panAndMixFloatSSE2(FloatSample *leftBuffer, FloatSample *rightBuffer, const FloatSample *monoBuffer, Bit32u len, Bit32s leftPanSetting, Bit32s rightPanSetting) {
+	const __m128 leftPan = _mm_set1_ps(FloatSample(leftPanSetting));
+	const __m128 rightPan = _mm_set1_ps(FloatSample(rightPanSetting));
+	const __m128 divisor = _mm_set1_ps(14.0f);
+	for (; len >= 4; len -= 4, leftBuffer += 4, rightBuffer += 4, monoBuffer += 4) {
+		const __m128 samples = _mm_loadu_ps(monoBuffer);
+		_mm_storeu_ps(leftBuffer, _mm_add_ps(_mm_loadu_ps(leftBuffer), _mm_div_ps(_mm_mul_ps(samples, leftPan), divisor)));
+		_mm_storeu_ps(rightBuffer, _mm_add_ps(_mm_loadu_ps(rightBuffer), _mm_div_ps(_mm_mul_ps(samples, rightPan), divisor)));
+	}
+	panAndMixFloatTail(leftBuffer, rightBuffer, monoBuffer, len, FloatSample(leftPanSetting), FloatSample(rightPanSetting));
+}
+
+MT32EMU_TARGET_AVX2 static void convertFloatToIntAVX2(const FloatSample *inBuffer, IntSample *outBuffer, Bit32u len) {
+	const __m256 factor = _mm256_set1_ps(32768.0f);
+	for (; len >= 16; len -= 16, inBuffer += 16, outBuffer += 16) {
+		const __m256i lo = _mm256_cvttps_epi32(_mm256_mul_ps(_mm256_loadu_ps(inBuffer), factor));
+		const __m256i hi = _mm256_cvttps_epi32(_mm256_mul_ps(_mm256_loadu_ps(inBuffer + 8), factor));
+		// Packing works within the 128-bit lanes, the 64-bit quarters need reordering afterwards.
+		const __m256i packed = _mm256_permute4x64_epi64(_mm256_packs_epi32(lo, hi), 0xD8);
+		_mm256_storeu_si256(reinterpret_cast<__m256i *>(outBuffer), packed);
+	}
+	convertFloatToIntTail(inBuffer, outBuffer, len);
+}
+
+MT32EMU_TARGET_AVX2 static void convertIntToFloatAVX2(const IntSample *inBuffer, FloatSample *outBuffer, Bit32u len) {
+	const __m256 factor = _mm256_set1_ps(1.0f / 32768.0f);
+	for (; len >= 8; len -= 8, inBuffer += 8, outBuffer += 8) {
+		const __m256i samples = _mm256_cvtepi16_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i *>(inBuffer)));
+		_mm256_storeu_ps(outBuffer, _mm256_mul_ps(_mm256_cvtepi32_ps(samples), factor));
+	}
+	convertIntToFloatTail(inBuffer, outBuffer, len);
+}
+
+MT32EMU_TARGET_AVX2 static void mixIntAVX2(IntSample *buffer, const IntSample *addend, Bit32u len) {
+	for (; len >= 16; len -= 16, buffer += 16, addend += 16) {
+		const __m256i a = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(buffer));
+		const __m256i b = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(addend));
+		_mm256_storeu_si256(reinterpret_cast<__m256i *>(buffer), _mm256_adds_epi16(a, b));
+	}
+	mixIntTail(buffer, addend, len);
+}
+
+MT32EMU_TARGET_AVX2 static void mixFloatAVX2(FloatSample *buffer, const FloatSample *addend, Bit32u len) {
+	for (; len >= 8; len -= 8, buffer += 8, addend += 8) {
+		_mm256_storeu_ps(buffer, _mm256_add_ps(_mm256_loadu_ps(buffer), _mm256_loadu_ps(addend)));
+	}
+	mixFloatTail(buffer, addend, len);
+}
+
+MT32EMU_TARGET_AVX2 static void amplifyIntAVX2(IntSample *buffer, Bit32u len) {
+	for (; len >= 16; len -= 16, buffer += 16) {
+		const __m256i a = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(buffer));
+		_mm256_storeu_si256(reinterpret_cast<__m256i *>(buffer), _mm256_adds_epi16(a, a));
+	}
+	amplifyIntTail(buffer, len);
+}
+
+MT32EMU_TARGET_AVX2 static void shiftGeneration1IntAVX2(IntSample *buffer, Bit32u len) {
+	const __m256i signMask = _mm256_set1_epi16(-0x8000);
+	const __m256i valueMask = _mm256_set1_epi16(0x7FFE);
+	for (; len >= 16; len -= 16, buffer += 16) {
+		const __m256i a = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(buffer));
+		_mm256_storeu_si256(reinterpret_cast<__m256i *>(buffer), _mm256_or_si256(_mm256_and_si256(a, signMask), _mm256_and_si256(_mm256_slli_epi16(a, 1), valueMask)));
+	}
+	shiftGeneration1IntTail(buffer, len);
+}
+
+MT32EMU_TARGET_AVX2 static void shiftGeneration2IntAVX2(IntSample *buffer, Bit32u len) {
+	const __m256i signMask = _mm256_set1_epi16(-0x8000);
+	const __m256i valueMask = _mm256_set1_epi16(0x7FFE);
+	for (; len >= 16; len -= 16, buffer += 16) {
+		const __m256i a = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(buffer));
+		const __m256i shifted = _mm256_or_si256(_mm256_and_si256(a, signMask), _mm256_and_si256(_mm256_slli_epi16(a, 1), valueMask));
+		_mm256_storeu_si256(reinterpret_cast<__m256i *>(buffer), _mm256_or_si256(shifted, _mm256_and_si256(_mm256_srli_epi16(a, 14), _mm256_set1_epi16(1))));
+	}
+	shiftGeneration2IntTail(buffer, len);
+}
+
+MT32EMU_TARGET_AVX2 static inline __m256i panAndMixAVX2(const IntSample *monoBuffer, const __m256i panFactor, const IntSample *buffer) {
+	const __m256i samplesLo = _mm256_cvtepi16_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i *>(monoBuffer)));
+	const __m256i samplesHi = _mm256_cvtepi16_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i *>(monoBuffer + 8)));
+	const __m256i bufferLo = _mm256_cvtepi16_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i *>(buffer)));
+	const __m256i bufferHi = _mm256_cvtepi16_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i *>(buffer + 8)));
+	const __m256i lo = _mm256_add_epi32(_mm256_srai_epi32(_mm256_mullo_epi32(samplesLo, panFactor), 13), bufferLo);
+	const __m256i hi = _mm256_add_epi32(_mm256_srai_epi32(_mm256_mullo_epi32(samplesHi, panFactor), 13), bufferHi);
+	return _mm256_permute4x64_epi64(_mm256_packs_epi32(lo, hi), 0xD8);
+}
+
+MT32EMU_TARGET_AVX2 static void panAndMixIntAVX2(IntSample *leftBuffer, IntSample *rightBuffer, const IntSample *monoBuffer, Bit32u len, Bit32s leftPanFactor, Bit32s rightPanFactor) {
+	const __m256i leftPan = _mm256_set1_epi32(leftPanFactor);
+	const __m256i rightPan = _mm256_set1_epi32(rightPanFactor);
+	for (; len >= 16; len -= 16, leftBuffer += 16, rightBuffer += 16, monoBuffer += 16) {
+		_mm256_storeu_si256(reinterpret_cast<__m256i *>(leftBuffer), panAndMixAVX2(monoBuffer, leftPan, leftBuffer));
+		_mm256_storeu_si256(reinterpret_cast<__m256i *>(rightBuffer), panAndMixAVX2(monoBuffer, rightPan, rightBuffer));
+	}
+	panAndMixIntTail(leftBuffer, rightBuffer, monoBuffer, len, leftPanFactor, rightPanFactor);
+}
+
+MT32EMU_TARGET_AVX2 static void panAndMixFloatAVX2(FloatSample *leftBuffer, FloatSample *rightBuffer, const FloatSample *monoBuffer, Bit32u len, Bit32s leftPanSetting, Bit32s rightPanSetting) {
+	const __m256 leftPan = _mm256_set1_ps(FloatSample(leftPanSetting));
+	const __m256 rightPan = _mm256_set1_ps(FloatSample(rightPanSetting));
+	const __m256 divisor = _mm256_set1_ps(14.0f);
+	for (; len >= 8; len -= 8, leftBuffer += 8, rightBuffer += 8, monoBuffer += 8) {
+		const __m256 samples = _mm256_loadu_ps(monoBuffer);
+		_mm256_storeu_ps(leftBuffer, _mm256_add_ps(_mm256_loadu_ps(leftBuffer), _mm256_div_ps(_mm256_mul_ps(samples, leftPan), divisor)));
+		_mm256_storeu_ps(rightBuffer, _mm256_add_ps(_mm256_loadu_ps(rightBuffer), _mm256_div_ps(_mm256_mul_ps(samples, rightPan), divisor)));
+	}
+	panAndMixFloatTail(leftBuffer, rightBuffer, monoBuffer, len, FloatSample(leftPanSetting), FloatSample(rightPanSetting));
+}
+
+// The zero-masking forms of the conversions and shifts are used with a full mask. They produce the same code as the plain ones,
+// which GCC implements via an undefined source operand and subsequently warns about with -Wmaybe-uninitialized.
+MT32EMU_TARGET_AVX512 static void convertFloatToIntAVX512(const FloatSample *inBuffer, IntSample *outBuffer, Bit32u len) {
+	const __m512 factor = _mm512_set1_ps(32768.0f);
+	for (; len >= 16; len -= 16, inBuffer += 16, outBuffer += 16) {
+		const __m512i samples = _mm512_maskz_cvttps_epi32(0xFFFF, _mm512_mul_ps(_mm512_loadu_ps(inBuffer), factor));
+		_mm256_storeu_si256(reinterpret_cast<__m256i *>(outBuffer), _mm512_maskz_cvtsepi32_epi16(0xFFFF, samples));
+	}
+	convertFloatToIntTail(inBuffer, outBuffer, len);
+}
+
+MT32EMU_TARGET_AVX512 static void convertIntToFloatAVX512(const IntSample *inBuffer, FloatSample *outBuffer, Bit32u len) {
+	const __m512 factor = _mm512_set1_ps(1.0f / 32768.0f);
+	for (; len >= 16; len -= 16, inBuffer += 16, outBuffer += 16) {
+		const __m512i samples = _mm512_maskz_cvtepi16_epi32(0xFFFF, _mm256_loadu_si256(reinterpret_cast<const __m256i *>(inBuffer)));
+		_mm512_storeu_ps(outBuffer, _mm512_mul_ps(_mm512_maskz_cvtepi32_ps(0xFFFF, samples), factor));
+	}
+	convertIntToFloatTail(inBuffer, outBuffer, len);
+}
+
+MT32EMU_TARGET_AVX512 static void mixIntAVX512(IntSample *buffer, const IntSample *addend, Bit32u len) {
+	for (; len >= 32; len -= 32, buffer += 32, addend += 32) {
+		const __m512i a = _mm512_loadu_si512(buffer);
+		const __m512i b = _mm512_loadu_si512(addend);
+		_mm512_storeu_si512(buffer, _mm512_adds_epi16(a, b));
+	}
+	mixIntTail(buffer, addend, len);
+}
+
+MT32EMU_TARGET_AVX512 static void mixFloatAVX512(FloatSample *buffer, const FloatSample *addend, Bit32u len) {
+	for (; len >= 16; len -= 16, buffer += 16, addend += 16) {
+		_mm512_storeu_ps(buffer, _mm512_add_ps(_mm512_loadu_ps(buffer), _mm512_loadu_ps(addend)));
+	}
+	mixFloatTail(buffer, addend, len);
+}
+
+MT32EMU_TARGET_AVX512 static void amplifyIntAVX512(IntSample *buffer, Bit32u len) {
+	for (; len >= 32; len -= 32, buffer += 32) {
+		const __m512i a = _mm512_loadu_si512(buffer);
+		_mm512_storeu_si512(buffer, _mm512_adds_epi16(a, a));
+	}
+	amplifyIntTail(buffer, len);
+}
+
+MT32EMU_TARGET_AVX512 static void shiftGeneration1IntAVX512(IntSample *buffer, Bit32u len) {
+	const __m512i signMask = _mm512_set1_epi16(-0x8000);
+	const __m512i valueMask = _mm512_set1_epi16(0x7FFE);
+	for (; len >= 32; len -= 32, buffer += 32) {
+		const __m512i a = _mm512_loadu_si512(buffer);
+		_mm512_storeu_si512(buffer, _mm512_or_si512(_mm512_and_si512(a, signMask), _mm512_and_si512(_mm512_slli_epi16(a, 1), valueMask)));
+	}
+	shiftGeneration1IntTail(buffer, len);
+}
+
+MT32EMU_TARGET_AVX512 static void shiftGeneration2IntAVX512(IntSample *buffer, Bit32u len) {
+	const __m512i signMask = _mm512_set1_epi16(-0x8000);
+	const __m512i valueMask = _mm512_set1_epi16(0x7FFE);
+	for (; len >= 32; len -= 32, buffer += 32) {
+		const __m512i a = _mm512_loadu_si512(buffer);
+		const __m512i shifted = _mm512_or_si512(_mm512_and_si512(a, signMask), _mm512_and_si512(_mm512_slli_epi16(a, 1), valueMask));
+		_mm512_storeu_si512(buffer, _mm512_or_si512(shifted, _mm512_and_si512(_mm512_srli_epi16(a, 14), _mm512_set1_epi16(1))));
+	}
+	shiftGeneration2IntTail(buffer, len);
+}
+
+MT32EMU_TARGET_AVX512 static inline __m256i panAndMixAVX512(const __m512i samples, const __m512i panFactor, const IntSample *buffer) {
+	const __m512i bufferSamples = _mm512_maskz_cvtepi16_epi32(0xFFFF, _mm256_loadu_si256(reinterpret_cast<const __m256i *>(buffer)));
+	const __m512i mixed = _mm512_add_epi32(_mm512_maskz_srai_epi32(0xFFFF, _mm512_mullo_epi32(samples, panFactor), 13), bufferSamples);
+	return _mm512_maskz_cvtsepi32_epi16(0xFFFF, mixed);
+}
+
+MT32EMU_TARGET_AVX512 static void panAndMixIntAVX512(IntSample *leftBuffer, IntSample *rightBuffer, const IntSample *monoBuffer, Bit32u len, Bit32s leftPanFactor, Bit32s rightPanFactor) {
+	const __m512i leftPan = _mm512_set1_epi32(leftPanFactor);
+	const __m512i rightPan = _mm512_set1_epi32(rightPanFactor);
+	for (; len >= 16; len -= 16, leftBuffer += 16, rightBuffer += 16, monoBuffer += 16) {
+		const __m512i samples = _mm512_maskz_cvtepi16_epi32(0xFFFF, _mm256_loadu_si256(reinterpret_cast<const __m256i *>(monoBuffer)));
+		_mm256_storeu_si256(reinterpret_cast<__m256i *>(leftBuffer), panAndMixAVX512(samples, leftPan, leftBuffer));
+		_mm256_storeu_si256(reinterpret_cast<__m256i *>(rightBuffer), panAndMixAVX512(samples, rightPan, rightBuffer));
+	}
+	panAndMixIntTail(leftBuffer, rightBuffer, monoBuffer, len, leftPanFactor, rightPanFactor);
+}
+
+MT32EMU_TARGET_AVX512 static void panAndMixFloatAVX512(FloatSample *leftBuffer, FloatSample *rightBuffer, const FloatSample *monoBuffer, Bit32u len, Bit32s leftPanSetting, Bit32s rightPanSetting) {
+	const __m512 leftPan = _mm512_set1_ps(FloatSample(leftPanSetting));
+	const __m512 rightPan = _mm512_set1_ps(FloatSample(rightPanSetting));
+	const __m512 divisor = _mm512_set1_ps(14.0f);
+	for (; len >= 16; len -= 16, leftBuffer += 16, rightBuffer += 16, monoBuffer += 16) {
+		const __m512 samples = _mm512_loadu_ps(monoBuffer);
+		_mm512_storeu_ps(leftBuffer, _mm512_add_ps(_mm512_loadu_ps(leftBuffer), _mm512_div_ps(_mm512_mul_ps(samples, leftPan), divisor)));
+		_mm512_storeu_ps(rightBuffer, _mm512_add_ps(_mm512_loadu_ps(rightBuffer), _mm512_div_ps(_mm512_mul_ps(samples, rightPan), divisor)));
+	}
+	panAndMixFloatTail(leftBuffer, rightBuffer, monoBuffer, len, FloatSample(leftPanSetting), FloatSample(rightPanSetting));
+}
+
+void bindSSE2DSPKernels(DSPKernels &kernels) {
+	kernels.convertFloatToInt = convertFloatToIntSSE2;
+	kernels.convertIntToFloat = convertIntToFloatSSE2;
+	kernels.mixInt = mixIntSSE2;
+	kernels.mixFloat = mixFloatSSE2;
+	kernels.amplifyInt = amplifyIntSSE2;
+	kernels.shiftGeneration1Int = shiftGeneration1IntSSE2;
+	kernels.shiftGeneration2Int = shiftGeneration2IntSSE2;
+	kernels.panAndMixInt = panAndMixIntSSE2;
+	kernels.panAndMixFloat = panAndMixFloatSSE2;
+}
+
+void bindAVX2DSPKernels(DSPKernels &kernels) {
+	kernels.convertFloatToInt = convertFloatToIntAVX2;
+	kernels.convertIntToFloat = convertIntToFloatAVX2;
+	kernels.mixInt = mixIntAVX2;
+	kernels.mixFloat = mixFloatAVX2;
+	kernels.amplifyInt = amplifyIntAVX2;
+	kernels.shiftGeneration1Int = shiftGeneration1IntAVX2;
+	kernels.shiftGeneration2Int = shiftGeneration2IntAVX2;
+	kernels.panAndMixInt = panAndMixIntAVX2;
+	kernels.panAndMixFloat = panAndMixFloatAVX2;
+}
+
+void bindAVX512DSPKernels(DSPKernels &kernels) {
+	kernels.convertFloatToInt = convertFloatToIntAVX512;
+	kernels.convertIntToFloat = convertIntToFloatAVX512;
+	kernels.mixInt = mixIntAVX512;
+	kernels.mixFloat = mixFloatAVX512;
+	kernels.amplifyInt = amplifyIntAVX512;
+	kernels.shiftGeneration1Int = shiftGeneration1IntAVX512;
+	kernels.shiftGeneration2Int = shiftGeneration2IntAVX512;
+	kernels.panAndMixInt = panAndMixIntAVX512;
+	kernels.panAndMixFloat = panAndMixFloatAVX512;
+}
+
+} // namespace MT32Emu
+
+#endif // #if MT32EMU_SIMD_X86
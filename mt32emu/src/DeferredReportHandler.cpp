@@ -0,0 +1,209 @@
+/* Copyright (C) 2003, 2004, 2005, 2006, 2008, 2009 Dean Beeler, Jerome Fisher
+ * Copyright (C) 2011-2019 Dean Beeler, Jerome Fisher, Sergey V. Mikayev
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License as published by
+ *  the Free Software Foundation, either version 2.1 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <cstring>
+
+#include "internals.h"
+
+#include "DeferredReportHandler.h"
+#include "MemoryFences.h"
+
+namespace MT32Emu {
+
+// Number of committed blocks of notifications that may await delivery. Must be a power of 2.
+static const Bit32u DEFERRED_REPORTS_RING_BUFFER_SIZE = 16;
+
+static inline void copyString(char *dst, const char *src, size_t size) {
+	if (src == NULL) {
+		dst[0] = 0;
+		return;
+	}
+	strncpy(dst, src, size - 1);
+	dst[size - 1] = 0;
+}
+
+void DeferredReports::clear() {
+	polyStateChangedParts = 0;
+	programChangedParts = 0;
+	midiMessagePlayed = false;
+	deviceReset = false;
+	deviceReconfig = false;
+	newReverbMode = false;
+	newReverbTime = false;
+	newReverbLevel = false;
+	lcdMessageShown = false;
+}
+
+bool DeferredReports::isEmpty() const {
+	return polyStateChangedParts == 0 && programChangedParts == 0 && !midiMessagePlayed && !deviceReset && !deviceReconfig
+		&& !newReverbMode && !newReverbTime && !newReverbLevel && !lcdMessageShown;
+}
+
+void DeferredReports::copyFrom(const DeferredReports &reports) {
+	// Only copy the parts that are actually in use, the LCD message buffer is quite large.
+	polyStateChangedParts = reports.polyStateChangedParts;
+	programChangedParts = reports.programChangedParts;
+	for (int partNum = 0; partNum < 9; partNum++) {
+		if (programChangedParts & (1 << partNum)) {
+			memcpy(soundGroupNames[partNum], reports.soundGroupNames[partNum], sizeof(soundGroupNames[partNum]));
+			memcpy(patchNames[partNum], reports.patchNames[partNum], sizeof(patchNames[partNum]));
+		}
+	}
+	midiMessagePlayed = reports.midiMessagePlayed;
+	deviceReset = reports.deviceReset;
+	deviceReconfig = reports.deviceReconfig;
+	newReverbMode = reports.newReverbMode;
+	newReverbTime = reports.newReverbTime;
+	newReverbLevel = reports.newReverbLevel;
+	reverbMode = reports.reverbMode;
+	reverbTime = reports.reverbTime;
+	reverbLevel = reports.reverbLevel;
+	lcdMessageShown = reports.lcdMessageShown;
+	if (lcdMessageShown) {
+		strcpy(lcdMessage, reports.lcdMessage);
+	}
+}
+
+void DeferredReports::deliver(ReportHandler &reportHandler) const {
+	if (deviceReset) reportHandler.onDeviceReset();
+	if (deviceReconfig) reportHandler.onDeviceReconfig();
+	if (newReverbMode) reportHandler.onNewReverbMode(reverbMode);
+	if (newReverbTime) reportHandler.onNewReverbTime(reverbTime);
+	if (newReverbLevel) reportHandler.onNewReverbLevel(reverbLevel);
+	for (Bit8u partNum = 0; partNum < 9; partNum++) {
+		if (programChangedParts & (1 << partNum)) {
+			const char *soundGroupName = soundGroupNames[partNum][0] == 0 ? NULL : soundGroupNames[partNum];
+			reportHandler.onProgramChanged(partNum, soundGroupName, patchNames[partNum]);
+		}
+	}
+	for (Bit8u partNum = 0; partNum < 9; partNum++) {
+		if (polyStateChangedParts & (1 << partNum)) {
+			reportHandler.onPolyStateChanged(partNum);
+		}
+	}
+	if (midiMessagePlayed) reportHandler.onMIDIMessagePlayed();
+	if (lcdMessageShown) reportHandler.showLCDMessage(lcdMessage);
+}
+
+DeferredReportHandler::DeferredReportHandler(ReportHandler &useReportHandler) :
+	reportHandler(useReportHandler),
+	ringBuffer(new DeferredReports[DEFERRED_REPORTS_RING_BUFFER_SIZE]),
+	startPosition(0),
+	endPosition(0)
+{
+	pendingReports.clear();
+}
+
+DeferredReportHandler::~DeferredReportHandler() {
+	delete[] ringBuffer;
+}
+
+ReportHandler &DeferredReportHandler::getReportHandler() const {
+	return reportHandler;
+}
+
+void DeferredReportHandler::commitReports() {
+	if (pendingReports.isEmpty()) return;
+	Bit32u newEndPosition = (endPosition + 1) & (DEFERRED_REPORTS_RING_BUFFER_SIZE - 1);
+	// Is ring buffer full? Then just keep on coalescing.
+	if (startPosition == newEndPosition) return;
+	// The slot is only free once the delivering thread has finished reading it,
+	// and the copy must be complete before it is published.
+	acquireFence();
+	ringBuffer[endPosition].copyFrom(pendingReports);
+	releaseFence();
+	endPosition = newEndPosition;
+	pendingReports.clear();
+}
+
+void DeferredReportHandler::deliverReports() {
+	for (;;) {
+		Bit32u committedEndPosition = endPosition;
+		if (startPosition == committedEndPosition) return;
+		acquireFence();
+		while (startPosition != committedEndPosition) {
+			ringBuffer[startPosition].deliver(reportHandler);
+			releaseFence();
+			startPosition = (startPosition + 1) & (DEFERRED_REPORTS_RING_BUFFER_SIZE - 1);
+		}
+	}
+}
+
+void DeferredReportHandler::printDebug(const char *fmt, va_list list) {
+	reportHandler.printDebug(fmt, list);
+}
+
+void DeferredReportHandler::onErrorControlROM() {
+	reportHandler.onErrorControlROM();
+}
+
+void DeferredReportHandler::onErrorPCMROM() {
+	reportHandler.onErrorPCMROM();
+}
+
+void DeferredReportHandler::showLCDMessage(const char *message) {
+	pendingReports.lcdMessageShown = true;
+	copyString(pendingReports.lcdMessage, message, SYSEX_BUFFER_SIZE);
+}
+
+void DeferredReportHandler::onMIDIMessagePlayed() {
+	pendingReports.midiMessagePlayed = true;
+}
+
+bool DeferredReportHandler::onMIDIQueueOverflow() {
+	return reportHandler.onMIDIQueueOverflow();
+}
+
+void DeferredReportHandler::onMIDISystemRealtime(Bit8u systemRealtime) {
+	reportHandler.onMIDISystemRealtime(systemRealtime);
+}
+
+void DeferredReportHandler::onDeviceReset() {
+	pendingReports.deviceReset = true;
+}
+
+void DeferredReportHandler::onDeviceReconfig() {
+	pendingReports.deviceReconfig = true;
+}
+
+void DeferredReportHandler::onNewReverbMode(Bit8u mode) {
+	pendingReports.newReverbMode = true;
+	pendingReports.reverbMode = mode;
+}
+
+void DeferredReportHandler::onNewReverbTime(Bit8u time) {
+	pendingReports.newReverbTime = true;
+	pendingReports.reverbTime = time;
+}
+
+void DeferredReportHandler::onNewReverbLevel(Bit8u level) {
+	pendingReports.newReverbLevel = true;
+	pendingReports.reverbLevel = level;
+}
+
+void DeferredReportHandler::onPolyStateChanged(Bit8u partNum) {
+	pendingReports.polyStateChangedParts |= 1 << partNum;
+}
+
+void DeferredReportHandler::onProgramChanged(Bit8u partNum, const char *soundGroupName, const char *patchName) {
+	pendingReports.programChangedParts |= 1 << partNum;
+	// Both names are copied as they may not outlive the synth, so we don't rely on when the delivery takes place.
+	copyString(pendingReports.soundGroupNames[partNum], soundGroupName, sizeof(pendingReports.soundGroupNames[partNum]));
+	copyString(pendingReports.patchNames[partNum], patchName, sizeof(pendingReports.patchNames[partNum]));
+}
+
+} // namespace MT32Emu
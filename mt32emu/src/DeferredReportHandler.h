@@ -0,0 +1,97 @@
+/* Copyright (C) 2003, 2004, 2005, 2006, 2008, 2009 Dean Beeler, Jerome Fisher
+ * Copyright (C) 2011-2019 Dean Beeler, Jerome Fisher, Sergey V. Mikayev
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License as published by
+ *  the Free Software Foundation, either version 2.1 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef MT32EMU_DEFERRED_REPORT_HANDLER_H
+#define MT32EMU_DEFERRED_REPORT_HANDLER_H
+
+#include "globals.h"
+#include "internals.h"
+#include "Synth.h"
+
+namespace MT32Emu {
+
+/**
+ * Stores ReportHandler notifications gathered during a rendered block. Repeated notifications of the same kind
+ * are coalesced, so that only the latest state is reported once.
+ */
+struct DeferredReports {
+	Bit16u polyStateChangedParts;
+	Bit16u programChangedParts;
+	char soundGroupNames[9][9];
+	char patchNames[9][11];
+	bool midiMessagePlayed;
+	bool deviceReset;
+	bool deviceReconfig;
+	bool newReverbMode;
+	bool newReverbTime;
+	bool newReverbLevel;
+	Bit8u reverbMode;
+	Bit8u reverbTime;
+	Bit8u reverbLevel;
+	bool lcdMessageShown;
+	char lcdMessage[SYSEX_BUFFER_SIZE];
+
+	void clear();
+	bool isEmpty() const;
+	void copyFrom(const DeferredReports &reports);
+	void deliver(ReportHandler &reportHandler) const;
+};
+
+/**
+ * Intercepts the notifications that are reported while processing MIDI events on the rendering thread
+ * and defers their delivery to the wrapped ReportHandler. Callbacks that either expect a return value
+ * or are reported outside the rendering thread are forwarded immediately.
+ * THREAD SAFETY:
+ * The notifications are gathered and committed by the rendering thread, whereas deliverReports() may be invoked
+ * by another single thread. The committed notifications are passed through a ring buffer similar to MidiEventQueue.
+ * When the ring buffer is full, the notifications keep being gathered and coalesced until there is a free slot.
+ */
+class DeferredReportHandler : public ReportHandler {
+private:
+	ReportHandler &reportHandler;
+	DeferredReports pendingReports;
+	DeferredReports *const ringBuffer;
+	volatile Bit32u startPosition;
+	volatile Bit32u endPosition;
+
+public:
+	DeferredReportHandler(ReportHandler &useReportHandler);
+	~DeferredReportHandler();
+
+	ReportHandler &getReportHandler() const;
+	void commitReports();
+	void deliverReports();
+
+	void printDebug(const char *fmt, va_list list);
+	void onErrorControlROM();
+	void onErrorPCMROM();
+	void showLCDMessage(const char *message);
+	void onMIDIMessagePlayed();
+	bool onMIDIQueueOverflow();
+	void onMIDISystemRealtime(Bit8u systemRealtime);
+	void onDeviceReset();
+	void onDeviceReconfig();
+	void onNewReverbMode(Bit8u mode);
+	void onNewReverbTime(Bit8u time);
+	void onNewReverbLevel(Bit8u level);
+	void onPolyStateChanged(Bit8u partNum);
+	void onProgramChanged(Bit8u partNum, const char *soundGroupName, const char *patchName);
+};
+
+} // namespace MT32Emu
+
+#endif // #ifndef MT32EMU_DEFERRED_REPORT_HANDLER_H
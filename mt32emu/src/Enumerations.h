@@ -41,6 +41,9 @@
 #define MT32EMU_RENDERER_TYPE_NAME mt32emu_renderer_type
 #define MT32EMU_RENDERER_TYPE(ident) MT32EMU_RT_##ident
 
+#define MT32EMU_TRACE_EVENT_TYPE_NAME mt32emu_trace_event_type
+#define MT32EMU_TRACE_EVENT_TYPE(ident) MT32EMU_TET_##ident
+
 #else /* #ifdef MT32EMU_C_ENUMERATIONS */
 
 #define MT32EMU_CPP_ENUMERATIONS_H
@@ -63,6 +66,9 @@
 #define MT32EMU_RENDERER_TYPE_NAME RendererType
 #define MT32EMU_RENDERER_TYPE(ident) RendererType_##ident
 
+#define MT32EMU_TRACE_EVENT_TYPE_NAME TraceEventType
+#define MT32EMU_TRACE_EVENT_TYPE(ident) TraceEventType_##ident
+
 namespace MT32Emu {
 
 #endif /* #ifdef MT32EMU_C_ENUMERATIONS */
@@ -160,6 +166,33 @@ enum MT32EMU_RENDERER_TYPE_NAME {
 	MT32EMU_RENDERER_TYPE(FLOAT)
 };
 
+/**
+ * Types of the events recorded in the trace buffer. The meaning of the data fields of the trace event is given for each type.
+ * Sample delays are counted at the internal synth sample rate.
+ */
+enum MT32EMU_TRACE_EVENT_TYPE_NAME {
+	/** Some events were overwritten before being read. data1: the number of lost events. */
+	MT32EMU_TRACE_EVENT_TYPE(EVENTS_LOST),
+	/** Rendering of a block started. data1: the requested length of the block in frames at the output sample rate. */
+	MT32EMU_TRACE_EVENT_TYPE(BLOCK_START),
+	/** Rendering of a block finished. data1: the number of samples produced at the internal synth sample rate. */
+	MT32EMU_TRACE_EVENT_TYPE(BLOCK_END),
+	/** A short MIDI message was retrieved from the MIDI event queue and processed. data1: the message, data2: delay since its timestamp. */
+	MT32EMU_TRACE_EVENT_TYPE(MIDI_MESSAGE),
+	/** A SysEx message was retrieved from the MIDI event queue and processed. data1: the length of the message, data2: delay since its timestamp. */
+	MT32EMU_TRACE_EVENT_TYPE(SYSEX_MESSAGE),
+	/** A new poly started playing. data1: the part number, data2: the key in the lower byte and the velocity in the next one. */
+	MT32EMU_TRACE_EVENT_TYPE(POLY_START),
+	/** A playing poly is being aborted to free partials. data1: the part number, data2: the key. */
+	MT32EMU_TRACE_EVENT_TYPE(POLY_ABORT),
+	/** A note was not played due to lack of free partials or polys. data1: the part number, data2: the number of partials needed. */
+	MT32EMU_TRACE_EVENT_TYPE(PARTIAL_ALLOCATION_FAILURE),
+	/** MIDI events were rejected as the MIDI event queue was full, detected at the start of a block. data1: the number of rejected attempts. */
+	MT32EMU_TRACE_EVENT_TYPE(MIDI_QUEUE_OVERFLOW),
+	/** New reverb settings were applied. data1: the reverb mode, data2: the reverb time in the lower byte and the level in the next one. */
+	MT32EMU_TRACE_EVENT_TYPE(REVERB_MODE_CHANGE)
+};
+
 #ifndef MT32EMU_C_ENUMERATIONS
 
 } // namespace MT32Emu
@@ -184,4 +217,7 @@ enum MT32EMU_RENDERER_TYPE_NAME {
 #undef MT32EMU_RENDERER_TYPE_NAME
 #undef MT32EMU_RENDERER_TYPE
 
+#undef MT32EMU_TRACE_EVENT_TYPE_NAME
+#undef MT32EMU_TRACE_EVENT_TYPE
+
 #endif /* #if (!defined MT32EMU_CPP_ENUMERATIONS_H && !defined MT32EMU_C_ENUMERATIONS) || (!defined MT32EMU_C_ENUMERATIONS_H && defined MT32EMU_C_ENUMERATIONS) */
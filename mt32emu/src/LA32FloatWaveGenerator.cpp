@@ -71,8 +71,6 @@ float LA32FloatWaveGenerator::generateNextSample(const Bit32u ampVal, const Bit1
 		return 0.0f;
 	}
 
-	float sample = 0.0f;
-
 	// SEMI-CONFIRMED: From sample analysis:
 	// (1) Tested with a single partial playing PCM wave 77 with pitchCoarse 36 and no keyfollow, velocity follow, etc.
 	// This gives results within +/- 2 at the output (before any DAC bitshifting)
@@ -83,185 +81,203 @@ float LA32FloatWaveGenerator::generateNextSample(const Bit32u ampVal, const Bit1
 	//
 	// Also still partially unconfirmed is the behaviour when ramping between levels, as well as the timing.
 
+	if (isPCMWave()) {
+		return generateNextPCMWaveSample(ampVal, pitch);
+	}
+	return generateNextSynthWaveSample(ampVal, pitch, cutoffRampVal);
+}
+
+float LA32FloatWaveGenerator::generateNextPCMWaveSample(const Bit32u ampVal, const Bit16u pitch) {
+	float sample = 0.0f;
+
 	float amp = EXP2F(ampVal / -1024.0f / 4096.0f);
 	float freq = EXP2F(pitch / 4096.0f - 16.0f) * SAMPLE_RATE;
 
-	if (isPCMWave()) {
-		// Render PCM waveform
-		int len = pcmWaveLength;
-		int intPCMPosition = int(pcmPosition);
-		if (intPCMPosition >= len && !pcmWaveLooped) {
-			// We're now past the end of a non-looping PCM waveform so it's time to die.
-			deactivate();
-			return 0.0f;
-		}
-		float positionDelta = freq * 2048.0f / SAMPLE_RATE;
-
-		// Linear interpolation
-		float firstSample = getPCMSample(intPCMPosition);
-		// We observe that for partial structures with ring modulation the interpolation is not applied to the slave PCM partial.
-		// It's assumed that the multiplication circuitry intended to perform the interpolation on the slave PCM partial
-		// is borrowed by the ring modulation circuit (or the LA32 chip has a similar lack of resources assigned to each partial pair).
-		if (pcmWaveInterpolated) {
-			sample = firstSample + (getPCMSample(intPCMPosition + 1) - firstSample) * (pcmPosition - intPCMPosition);
-		} else {
-			sample = firstSample;
-		}
-
-		float newPCMPosition = pcmPosition + positionDelta;
-		if (pcmWaveLooped) {
-			newPCMPosition = fmod(newPCMPosition, float(pcmWaveLength));
-		}
-		pcmPosition = newPCMPosition;
+	// Render PCM waveform
+	int len = pcmWaveLength;
+	int intPCMPosition = int(pcmPosition);
+	if (intPCMPosition >= len && !pcmWaveLooped) {
+		// We're now past the end of a non-looping PCM waveform so it's time to die.
+		deactivate();
+		return 0.0f;
+	}
+	float positionDelta = freq * 2048.0f / SAMPLE_RATE;
+
+	// Linear interpolation
+	float firstSample = getPCMSample(intPCMPosition);
+	// We observe that for partial structures with ring modulation the interpolation is not applied to the slave PCM partial.
+	// It's assumed that the multiplication circuitry intended to perform the interpolation on the slave PCM partial
+	// is borrowed by the ring modulation circuit (or the LA32 chip has a similar lack of resources assigned to each partial pair).
+	if (pcmWaveInterpolated) {
+		sample = firstSample + (getPCMSample(intPCMPosition + 1) - firstSample) * (pcmPosition - intPCMPosition);
 	} else {
-		// Render synthesised waveform
-		wavePos *= lastFreq / freq;
-		lastFreq = freq;
-
-		float resAmp = EXP2F(1.0f - (32 - resonance) / 4.0f);
-		{
-			//static const float resAmpFactor = EXP2F(-7);
-			//resAmp = EXP2I(resonance << 10) * resAmpFactor;
-		}
+		sample = firstSample;
+	}
 
-		// The cutoffModifier may not be supposed to be directly added to the cutoff -
-		// it may for example need to be multiplied in some way.
-		// The 240 cutoffVal limit was determined via sample analysis (internal Munt capture IDs: glop3, glop4).
-		// More research is needed to be sure that this is correct, however.
-		float cutoffVal = cutoffRampVal / 262144.0f;
-		if (cutoffVal > MAX_CUTOFF_VALUE) {
-			cutoffVal = MAX_CUTOFF_VALUE;
-		}
+	float newPCMPosition = pcmPosition + positionDelta;
+	if (pcmWaveLooped) {
+		newPCMPosition = fmod(newPCMPosition, float(pcmWaveLength));
+	}
+	pcmPosition = newPCMPosition;
 
-		// Wave length in samples
-		float waveLen = SAMPLE_RATE / freq;
+	// Multiply sample with current TVA value
+	sample *= amp;
+	return sample;
+}
 
-		// Init cosineLen
-		float cosineLen = 0.5f * waveLen;
-		if (cutoffVal > MIDDLE_CUTOFF_VALUE) {
-			cosineLen *= EXP2F((cutoffVal - MIDDLE_CUTOFF_VALUE) / -16.0f); // found from sample analysis
-		}
+float LA32FloatWaveGenerator::generateNextSynthWaveSample(const Bit32u ampVal, const Bit16u pitch, const Bit32u cutoffRampVal) {
+	float sample = 0.0f;
 
-		// Start playing in center of first cosine segment
-		// relWavePos is shifted by a half of cosineLen
-		float relWavePos = wavePos + 0.5f * cosineLen;
-		if (relWavePos > waveLen) {
-			relWavePos -= waveLen;
-		}
+	float amp = EXP2F(ampVal / -1024.0f / 4096.0f);
+	float freq = EXP2F(pitch / 4096.0f - 16.0f) * SAMPLE_RATE;
 
-		// Ratio of positive segment to wave length
-		float pulseLen = 0.5f;
-		if (pulseWidth > 128) {
-			pulseLen = EXP2F((64 - pulseWidth) / 64.0f);
-			//static const float pulseLenFactor = EXP2F(-192 / 64);
-			//pulseLen = EXP2I((256 - pulseWidthVal) << 6) * pulseLenFactor;
-		}
-		pulseLen *= waveLen;
+	// Render synthesised waveform
+	wavePos *= lastFreq / freq;
+	lastFreq = freq;
 
-		float hLen = pulseLen - cosineLen;
+	float resAmp = EXP2F(1.0f - (32 - resonance) / 4.0f);
+	{
+		//static const float resAmpFactor = EXP2F(-7);
+		//resAmp = EXP2I(resonance << 10) * resAmpFactor;
+	}
 
-		// Ignore pulsewidths too high for given freq
-		if (hLen < 0.0f) {
-			hLen = 0.0f;
-		}
+	// The cutoffModifier may not be supposed to be directly added to the cutoff -
+	// it may for example need to be multiplied in some way.
+	// The 240 cutoffVal limit was determined via sample analysis (internal Munt capture IDs: glop3, glop4).
+	// More research is needed to be sure that this is correct, however.
+	float cutoffVal = cutoffRampVal / 262144.0f;
+	if (cutoffVal > MAX_CUTOFF_VALUE) {
+		cutoffVal = MAX_CUTOFF_VALUE;
+	}
 
-		// Correct resAmp for cutoff in range 50..66
-		if ((cutoffVal >= MIDDLE_CUTOFF_VALUE) && (cutoffVal < RESONANCE_DECAY_THRESHOLD_CUTOFF_VALUE)) {
-			resAmp *= sin(FLOAT_PI * (cutoffVal - MIDDLE_CUTOFF_VALUE) / 32.0f);
-		}
+	// Wave length in samples
+	float waveLen = SAMPLE_RATE / freq;
 
-		// Produce filtered square wave with 2 cosine waves on slopes
+	// Init cosineLen
+	float cosineLen = 0.5f * waveLen;
+	if (cutoffVal > MIDDLE_CUTOFF_VALUE) {
+		cosineLen *= EXP2F((cutoffVal - MIDDLE_CUTOFF_VALUE) / -16.0f); // found from sample analysis
+	}
 
-		// 1st cosine segment
-		if (relWavePos < cosineLen) {
-			sample = -cos(FLOAT_PI * relWavePos / cosineLen);
-		} else
+	// Start playing in center of first cosine segment
+	// relWavePos is shifted by a half of cosineLen
+	float relWavePos = wavePos + 0.5f * cosineLen;
+	if (relWavePos > waveLen) {
+		relWavePos -= waveLen;
+	}
 
-		// high linear segment
-		if (relWavePos < (cosineLen + hLen)) {
-			sample = 1.f;
-		} else
+	// Ratio of positive segment to wave length
+	float pulseLen = 0.5f;
+	if (pulseWidth > 128) {
+		pulseLen = EXP2F((64 - pulseWidth) / 64.0f);
+		//static const float pulseLenFactor = EXP2F(-192 / 64);
+		//pulseLen = EXP2I((256 - pulseWidthVal) << 6) * pulseLenFactor;
+	}
+	pulseLen *= waveLen;
 
-		// 2nd cosine segment
-		if (relWavePos < (2 * cosineLen + hLen)) {
-			sample = cos(FLOAT_PI * (relWavePos - (cosineLen + hLen)) / cosineLen);
-		} else {
+	float hLen = pulseLen - cosineLen;
 
-		// low linear segment
-			sample = -1.f;
-		}
+	// Ignore pulsewidths too high for given freq
+	if (hLen < 0.0f) {
+		hLen = 0.0f;
+	}
 
-		if (cutoffVal < MIDDLE_CUTOFF_VALUE) {
+	// Correct resAmp for cutoff in range 50..66
+	if ((cutoffVal >= MIDDLE_CUTOFF_VALUE) && (cutoffVal < RESONANCE_DECAY_THRESHOLD_CUTOFF_VALUE)) {
+		resAmp *= sin(FLOAT_PI * (cutoffVal - MIDDLE_CUTOFF_VALUE) / 32.0f);
+	}
 
-			// Attenuate samples below cutoff 50
-			// Found by sample analysis
-			sample *= EXP2F(-0.125f * (MIDDLE_CUTOFF_VALUE - cutoffVal));
-		} else {
+	// Produce filtered square wave with 2 cosine waves on slopes
 
-			// Add resonance sine. Effective for cutoff > 50 only
-			float resSample = 1.0f;
+	// 1st cosine segment
+	if (relWavePos < cosineLen) {
+		sample = -cos(FLOAT_PI * relWavePos / cosineLen);
+	} else
 
-			// Resonance decay speed factor
-			float resAmpDecayFactor = Tables::getInstance().resAmpDecayFactor[resonance >> 2];
+	// high linear segment
+	if (relWavePos < (cosineLen + hLen)) {
+		sample = 1.f;
+	} else
 
-			// Now relWavePos counts from the middle of first cosine
-			relWavePos = wavePos;
+	// 2nd cosine segment
+	if (relWavePos < (2 * cosineLen + hLen)) {
+		sample = cos(FLOAT_PI * (relWavePos - (cosineLen + hLen)) / cosineLen);
+	} else {
 
-			// negative segments
-			if (!(relWavePos < (cosineLen + hLen))) {
-				resSample = -resSample;
-				relWavePos -= cosineLen + hLen;
+	// low linear segment
+		sample = -1.f;
+	}
 
-				// From the digital captures, the decaying speed of the resonance sine is found a bit different for the positive and the negative segments
-				resAmpDecayFactor += 0.25f;
-			}
+	if (cutoffVal < MIDDLE_CUTOFF_VALUE) {
 
-			// Resonance sine WG
-			resSample *= sin(FLOAT_PI * relWavePos / cosineLen);
+		// Attenuate samples below cutoff 50
+		// Found by sample analysis
+		sample *= EXP2F(-0.125f * (MIDDLE_CUTOFF_VALUE - cutoffVal));
+	} else {
 
-			// Resonance sine amp
-			float resAmpFadeLog2 = -0.125f * resAmpDecayFactor * (relWavePos / cosineLen); // seems to be exact
-			float resAmpFade = EXP2F(resAmpFadeLog2);
+		// Add resonance sine. Effective for cutoff > 50 only
+		float resSample = 1.0f;
 
-			// Now relWavePos set negative to the left from center of any cosine
-			relWavePos = wavePos;
+		// Resonance decay speed factor
+		float resAmpDecayFactor = Tables::getInstance().resAmpDecayFactor[resonance >> 2];
 
-			// negative segment
-			if (!(wavePos < (waveLen - 0.5f * cosineLen))) {
-				relWavePos -= waveLen;
-			} else
+		// Now relWavePos counts from the middle of first cosine
+		relWavePos = wavePos;
 
-			// positive segment
-			if (!(wavePos < (hLen + 0.5f * cosineLen))) {
-				relWavePos -= cosineLen + hLen;
-			}
+		// negative segments
+		if (!(relWavePos < (cosineLen + hLen))) {
+			resSample = -resSample;
+			relWavePos -= cosineLen + hLen;
 
-			// To ensure the output wave has no breaks, two different windows are appied to the beginning and the ending of the resonance sine segment
-			if (relWavePos < 0.5f * cosineLen) {
-				float syncSine = sin(FLOAT_PI * relWavePos / cosineLen);
-				if (relWavePos < 0.0f) {
-					// The window is synchronous square sine here
-					resAmpFade *= syncSine * syncSine;
-				} else {
-					// The window is synchronous sine here
-					resAmpFade *= syncSine;
-				}
-			}
+			// From the digital captures, the decaying speed of the resonance sine is found a bit different for the positive and the negative segments
+			resAmpDecayFactor += 0.25f;
+		}
+
+		// Resonance sine WG
+		resSample *= sin(FLOAT_PI * relWavePos / cosineLen);
+
+		// Resonance sine amp
+		float resAmpFadeLog2 = -0.125f * resAmpDecayFactor * (relWavePos / cosineLen); // seems to be exact
+		float resAmpFade = EXP2F(resAmpFadeLog2);
+
+		// Now relWavePos set negative to the left from center of any cosine
+		relWavePos = wavePos;
 
-			sample += resSample * resAmp * resAmpFade;
+		// negative segment
+		if (!(wavePos < (waveLen - 0.5f * cosineLen))) {
+			relWavePos -= waveLen;
+		} else
+
+		// positive segment
+		if (!(wavePos < (hLen + 0.5f * cosineLen))) {
+			relWavePos -= cosineLen + hLen;
 		}
 
-		// sawtooth waves
-		if (sawtoothWaveform) {
-			sample *= cos(FLOAT_2PI * wavePos / waveLen);
+		// To ensure the output wave has no breaks, two different windows are appied to the beginning and the ending of the resonance sine segment
+		if (relWavePos < 0.5f * cosineLen) {
+			float syncSine = sin(FLOAT_PI * relWavePos / cosineLen);
+			if (relWavePos < 0.0f) {
+				// The window is synchronous square sine here
+				resAmpFade *= syncSine * syncSine;
+			} else {
+				// The window is synchronous sine here
+				resAmpFade *= syncSine;
+			}
 		}
 
-		wavePos++;
+		sample += resSample * resAmp * resAmpFade;
+	}
 
-		// wavePos isn't supposed to be > waveLen
-		if (wavePos > waveLen) {
-			wavePos -= waveLen;
-		}
+	// sawtooth waves
+	if (sawtoothWaveform) {
+		sample *= cos(FLOAT_2PI * wavePos / waveLen);
+	}
+
+	wavePos++;
+
+	// wavePos isn't supposed to be > waveLen
+	if (wavePos > waveLen) {
+		wavePos -= waveLen;
 	}
 
 	// Multiply sample with current TVA value
@@ -269,6 +285,34 @@ float LA32FloatWaveGenerator::generateNextSample(const Bit32u ampVal, const Bit1
 	return sample;
 }
 
+void LA32FloatWaveGenerator::skipNextSynthWaveSample(const Bit16u pitch) {
+	// This must follow generateNextSynthWaveSample() exactly, so that the wave position is the same afterwards.
+	float freq = EXP2F(pitch / 4096.0f - 16.0f) * SAMPLE_RATE;
+	wavePos *= lastFreq / freq;
+	lastFreq = freq;
+	float waveLen = SAMPLE_RATE / freq;
+	wavePos++;
+	if (wavePos > waveLen) {
+		wavePos -= waveLen;
+	}
+}
+
+void LA32FloatWaveGenerator::skipNextPCMWaveSample(const Bit16u pitch) {
+	// This must follow generateNextPCMWaveSample() exactly, so that the PCM position is the same afterwards.
+	float freq = EXP2F(pitch / 4096.0f - 16.0f) * SAMPLE_RATE;
+	int len = pcmWaveLength;
+	if (int(pcmPosition) >= len && !pcmWaveLooped) {
+		deactivate();
+		return;
+	}
+	float positionDelta = freq * 2048.0f / SAMPLE_RATE;
+	float newPCMPosition = pcmPosition + positionDelta;
+	if (pcmWaveLooped) {
+		newPCMPosition = fmod(newPCMPosition, float(pcmWaveLength));
+	}
+	pcmPosition = newPCMPosition;
+}
+
 void LA32FloatWaveGenerator::deactivate() {
 	active = false;
 }
@@ -312,15 +356,6 @@ void LA32FloatPartialPair::generateNextSample(const PairType useMaster, const Bi
 	}
 }
 
-static inline float produceDistortedSample(float sample) {
-	if (sample < -1.0f) {
-		return sample + 2.0f;
-	} else if (1.0f < sample) {
-		return sample - 2.0f;
-	}
-	return sample;
-}
-
 float LA32FloatPartialPair::nextOutSample() {
 	// Note, LA32FloatWaveGenerator produces each sample normalised in terms of a single playing partial,
 	// so the unity sample corresponds to the internal LA32 logarithmic fixed-point unity sample.
@@ -330,16 +365,7 @@ float LA32FloatPartialPair::nextOutSample() {
 	if (!ringModulated) {
 		return 0.25f * (masterOutputSample + slaveOutputSample);
 	}
-	/*
-	 * SEMI-CONFIRMED: Ring modulation model derived from sample analysis of specially constructed patches which exploit distortion.
-	 * LA32 ring modulator found to produce distorted output in case if the absolute value of maximal amplitude of one of the input partials exceeds 8191.
-	 * This is easy to reproduce using synth partials with resonance values close to the maximum. It looks like an integer overflow happens in this case.
-	 * As the distortion is strictly bound to the amplitude of the complete mixed square + resonance wave in the linear space,
-	 * it is reasonable to assume the ring modulation is performed also in the linear space by sample multiplication.
-	 * Most probably the overflow is caused by limited precision of the multiplication circuit as the very similar distortion occurs with panning.
-	 */
-	float ringModulatedSample = produceDistortedSample(masterOutputSample) * produceDistortedSample(slaveOutputSample);
-	return 0.25f * (mixed ? masterOutputSample + ringModulatedSample : ringModulatedSample);
+	return ringModulate(mixed);
 }
 
 void LA32FloatPartialPair::deactivate(const PairType useMaster) {
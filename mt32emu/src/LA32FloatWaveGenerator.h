@@ -84,6 +84,15 @@ public:
 	// Update parameters with respect to TVP, TVA and TVF, and generate next sample
 	float generateNextSample(const Bit32u amp, const Bit16u pitch, const Bit32u cutoff);
 
+	// Same as generateNextSample() for an active WG engine known to generate synth or PCM wave samples respectively
+	float generateNextSynthWaveSample(const Bit32u amp, const Bit16u pitch, const Bit32u cutoff);
+	float generateNextPCMWaveSample(const Bit32u amp, const Bit16u pitch);
+
+	// Advance the state of an active WG engine the same way as generateNextSynthWaveSample() or generateNextPCMWaveSample()
+	// respectively, without computing the output sample
+	void skipNextSynthWaveSample(const Bit16u pitch);
+	void skipNextPCMWaveSample(const Bit16u pitch);
+
 	// Deactivate the WG engine
 	void deactivate();
 
@@ -102,6 +111,28 @@ class LA32FloatPartialPair : public LA32PartialPair {
 	float masterOutputSample;
 	float slaveOutputSample;
 
+	static float produceDistortedSample(const float sample) {
+		if (sample < -1.0f) {
+			return sample + 2.0f;
+		} else if (1.0f < sample) {
+			return sample - 2.0f;
+		}
+		return sample;
+	}
+
+	/*
+	 * SEMI-CONFIRMED: Ring modulation model derived from sample analysis of specially constructed patches which exploit distortion.
+	 * LA32 ring modulator found to produce distorted output in case if the absolute value of maximal amplitude of one of the input partials exceeds 8191.
+	 * This is easy to reproduce using synth partials with resonance values close to the maximum. It looks like an integer overflow happens in this case.
+	 * As the distortion is strictly bound to the amplitude of the complete mixed square + resonance wave in the linear space,
+	 * it is reasonable to assume the ring modulation is performed also in the linear space by sample multiplication.
+	 * Most probably the overflow is caused by limited precision of the multiplication circuit as the very similar distortion occurs with panning.
+	 */
+	float ringModulate(const bool useMixed) const {
+		float ringModulatedSample = produceDistortedSample(masterOutputSample) * produceDistortedSample(slaveOutputSample);
+		return 0.25f * (useMixed ? masterOutputSample + ringModulatedSample : ringModulatedSample);
+	}
+
 public:
 	// ringModulated should be set to false for the structures with mixing or stereo output
 	// ringModulated should be set to true for the structures with ring modulation
@@ -120,6 +151,50 @@ public:
 	// Perform mixing / ring modulation and return the result
 	float nextOutSample();
 
+	// Same as generateNextSample() for the master or the slave WG engine, which is known to be active
+	// and to generate either PCM or synth wave samples
+	template <bool PCM_WAVE>
+	void generateNextMasterSample(const Bit32u amp, const Bit16u pitch, const Bit32u cutoff) {
+		masterOutputSample = PCM_WAVE ? master.generateNextPCMWaveSample(amp, pitch) : master.generateNextSynthWaveSample(amp, pitch, cutoff);
+	}
+
+	template <bool PCM_WAVE>
+	void generateNextSlaveSample(const Bit32u amp, const Bit16u pitch, const Bit32u cutoff) {
+		slaveOutputSample = PCM_WAVE ? slave.generateNextPCMWaveSample(amp, pitch) : slave.generateNextSynthWaveSample(amp, pitch, cutoff);
+	}
+
+	// Same as generateNextMasterSample() and generateNextSlaveSample() respectively, but the output sample is not computed.
+	template <bool PCM_WAVE>
+	void skipNextMasterSample(const Bit16u pitch, const Bit32u) {
+		if (PCM_WAVE) {
+			master.skipNextPCMWaveSample(pitch);
+		} else {
+			master.skipNextSynthWaveSample(pitch);
+		}
+	}
+
+	template <bool PCM_WAVE>
+	void skipNextSlaveSample(const Bit16u pitch, const Bit32u) {
+		if (PCM_WAVE) {
+			slave.skipNextPCMWaveSample(pitch);
+		} else {
+			slave.skipNextSynthWaveSample(pitch);
+		}
+	}
+
+	// The WG engines keep no state derived from the wave position, so nothing is to be done after skipping samples.
+	void resumeAfterSkipping() {}
+
+	// Same as nextOutSample() specialised for the structure given by the template arguments. The kinds of waves
+	// are irrelevant here since the WG engines produce the samples in the linear space.
+	template <bool RING_MODULATED, bool MIXED, bool MASTER_PCM_WAVE, bool SLAVE_PCM_WAVE>
+	float nextOutSample() const {
+		if (!RING_MODULATED) {
+			return 0.25f * (masterOutputSample + slaveOutputSample);
+		}
+		return ringModulate(MIXED);
+	}
+
 	// Deactivate the WG engine
 	void deactivate(const PairType master);
 
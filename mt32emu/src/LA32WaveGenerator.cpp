@@ -118,10 +118,7 @@ void LA32WaveGenerator::computePositions(Bit32u highLinearLength, Bit32u lowLine
 	phase = NEGATIVE_RISING_SINE_SEGMENT;
 }
 
-void LA32WaveGenerator::advancePosition() {
-	wavePosition += getSampleStep();
-	wavePosition %= 4 * SINE_SEGMENT_RELATIVE_LENGTH;
-
+void LA32WaveGenerator::updatePhases() {
 	Bit32u effectiveCutoffValue = (cutoffVal > MIDDLE_CUTOFF_VALUE) ? (cutoffVal - MIDDLE_CUTOFF_VALUE) >> 10 : 0;
 	Bit32u resonanceWaveLengthFactor = getResonanceWaveLengthFactor(effectiveCutoffValue);
 	Bit32u highLinearLength = getHighLinearLength(effectiveCutoffValue);
@@ -131,6 +128,12 @@ void LA32WaveGenerator::advancePosition() {
 	resonancePhase = ResonancePhase(((resonanceSinePosition >> 18) + (phase > POSITIVE_FALLING_SINE_SEGMENT ? 2 : 0)) & 3);
 }
 
+void LA32WaveGenerator::advancePosition() {
+	wavePosition += getSampleStep();
+	wavePosition %= 4 * SINE_SEGMENT_RELATIVE_LENGTH;
+	updatePhases();
+}
+
 void LA32WaveGenerator::generateNextSquareWaveLogSample() {
 	Bit32u logSampleValue;
 	switch (phase) {
@@ -238,6 +241,10 @@ void LA32WaveGenerator::generateNextPCMWaveLogSamples() {
 	} else {
 		secondPCMLogSample = SILENCE;
 	}
+	advancePCMPosition();
+}
+
+void LA32WaveGenerator::advancePCMPosition() {
 	// pcmSampleStep = (Bit32u)EXP2F(pitch / 4096.0f + 3.0f);
 	Bit32u pcmSampleStep = LA32Utilites::interpolateExp(~pitch & 4095);
 	pcmSampleStep <<= pitch >> 12;
@@ -288,13 +295,16 @@ void LA32WaveGenerator::generateNextSample(const Bit32u useAmp, const Bit16u use
 		return;
 	}
 
-	amp = useAmp;
-	pitch = usePitch;
-
 	if (isPCMWave()) {
-		generateNextPCMWaveLogSamples();
-		return;
+		generateNextPCMWaveSample(useAmp, usePitch);
+	} else {
+		generateNextSynthWaveSample(useAmp, usePitch, useCutoffVal);
 	}
+}
+
+void LA32WaveGenerator::generateNextSynthWaveSample(const Bit32u useAmp, const Bit16u usePitch, const Bit32u useCutoffVal) {
+	amp = useAmp;
+	pitch = usePitch;
 
 	// The 240 cutoffVal limit was determined via sample analysis (internal Munt capture IDs: glop3, glop4).
 	// More research is needed to be sure that this is correct, however.
@@ -311,6 +321,29 @@ void LA32WaveGenerator::generateNextSample(const Bit32u useAmp, const Bit16u use
 	advancePosition();
 }
 
+void LA32WaveGenerator::generateNextPCMWaveSample(const Bit32u useAmp, const Bit16u usePitch) {
+	amp = useAmp;
+	pitch = usePitch;
+	generateNextPCMWaveLogSamples();
+}
+
+void LA32WaveGenerator::skipNextSynthWaveSample(const Bit16u usePitch, const Bit32u useCutoffVal) {
+	pitch = usePitch;
+	cutoffVal = (useCutoffVal > MAX_CUTOFF_VALUE) ? MAX_CUTOFF_VALUE : useCutoffVal;
+	wavePosition += getSampleStep();
+	wavePosition %= 4 * SINE_SEGMENT_RELATIVE_LENGTH;
+}
+
+void LA32WaveGenerator::skipNextPCMWaveSample(const Bit16u usePitch) {
+	pitch = usePitch;
+	advancePCMPosition();
+}
+
+void LA32WaveGenerator::resumeSynthWave() {
+	// The phases only depend on the wave position and the cutoff of the last sample.
+	updatePhases();
+}
+
 LogSample LA32WaveGenerator::getOutputLogSample(const bool first) const {
 	if (!isActive()) {
 		return SILENCE;
@@ -370,16 +403,10 @@ Bit16s LA32IntPartialPair::unlogAndMixWGOutput(const LA32WaveGenerator &wg) {
 	if (!wg.isActive()) {
 		return 0;
 	}
-	Bit16s firstSample = LA32Utilites::unlog(wg.getOutputLogSample(true));
-	Bit16s secondSample = LA32Utilites::unlog(wg.getOutputLogSample(false));
 	if (wg.isPCMWave()) {
-		return Bit16s(firstSample + (((Bit32s(secondSample) - Bit32s(firstSample)) * wg.getPCMInterpolationFactor()) >> 7));
+		return wg.unlogAndMixPCMWaveOutput();
 	}
-	return firstSample + secondSample;
-}
-
-static inline Bit16s produceDistortedSample(Bit16s sample) {
-	return ((sample & 0x2000) == 0) ? Bit16s(sample & 0x1fff) : Bit16s(sample | ~0x1fff);
+	return wg.unlogAndMixSynthWaveOutput();
 }
 
 Bit16s LA32IntPartialPair::nextOutSample() {
@@ -396,16 +423,16 @@ Bit16s LA32IntPartialPair::nextOutSample() {
 	 */
 	Bit16s slaveSample = slave.isPCMWave() ? LA32Utilites::unlog(slave.getOutputLogSample(true)) : unlogAndMixWGOutput(slave);
 
-	/* SEMI-CONFIRMED: Ring modulation model derived from sample analysis of specially constructed patches which exploit distortion.
-	 * LA32 ring modulator found to produce distorted output in case if the absolute value of maximal amplitude of one of the input partials exceeds 8191.
-	 * This is easy to reproduce using synth partials with resonance values close to the maximum. It looks like an integer overflow happens in this case.
-	 * As the distortion is strictly bound to the amplitude of the complete mixed square + resonance wave in the linear space,
-	 * it is reasonable to assume the ring modulation is performed also in the linear space by sample multiplication.
-	 * Most probably the overflow is caused by limited precision of the multiplication circuit as the very similar distortion occurs with panning.
-	 */
-	Bit16s ringModulatedSample = Bit16s((Bit32s(produceDistortedSample(masterSample)) * Bit32s(produceDistortedSample(slaveSample))) >> 13);
+	return ringModulate(masterSample, slaveSample, mixed);
+}
 
-	return mixed ? masterSample + ringModulatedSample : ringModulatedSample;
+void LA32IntPartialPair::resumeAfterSkipping() {
+	if (master.isActive() && !master.isPCMWave()) {
+		master.resumeSynthWave();
+	}
+	if (slave.isActive() && !slave.isPCMWave()) {
+		slave.resumeSynthWave();
+	}
 }
 
 void LA32IntPartialPair::deactivate(const PairType useMaster) {
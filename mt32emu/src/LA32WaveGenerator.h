@@ -167,6 +167,7 @@ class LA32WaveGenerator {
 	Bit32u getHighLinearLength(Bit32u effectiveCutoffValue);
 
 	void computePositions(Bit32u highLinearLength, Bit32u lowLinearLength, Bit32u resonanceWaveLengthFactor);
+	void updatePhases();
 	void advancePosition();
 
 	void generateNextSquareWaveLogSample();
@@ -175,6 +176,7 @@ class LA32WaveGenerator {
 
 	void pcmSampleToLogSample(LogSample &logSample, const Bit16s pcmSample) const;
 	void generateNextPCMWaveLogSamples();
+	void advancePCMPosition();
 
 public:
 	// Initialise the WG engine for generation of synth partial samples and set up the invariant parameters
@@ -186,9 +188,37 @@ public:
 	// Update parameters with respect to TVP, TVA and TVF, and generate next sample
 	void generateNextSample(const Bit32u amp, const Bit16u pitch, const Bit32u cutoff);
 
+	// Same as generateNextSample() for an active WG engine known to generate synth or PCM wave samples respectively
+	void generateNextSynthWaveSample(const Bit32u amp, const Bit16u pitch, const Bit32u cutoff);
+	void generateNextPCMWaveSample(const Bit32u amp, const Bit16u pitch);
+
+	// Advance the state of an active WG engine the same way as generateNextSynthWaveSample() or generateNextPCMWaveSample()
+	// respectively, without computing the output sample. Only the wave position is updated for synth wave samples,
+	// so resumeSynthWave() must be called before the next sample is generated.
+	void skipNextSynthWaveSample(const Bit16u pitch, const Bit32u cutoff);
+	void skipNextPCMWaveSample(const Bit16u pitch);
+
+	// Bring the phases of the synth wave in line with the wave position after skipping samples
+	void resumeSynthWave();
+
 	// WG output in the log-space consists of two components which are to be added (or ring modulated) in the linear-space afterwards
 	LogSample getOutputLogSample(const bool first) const;
 
+	// Unlog and mix both components of the output of an active WG engine generating synth or PCM wave samples respectively
+	Bit16s unlogAndMixSynthWaveOutput() const {
+		return LA32Utilites::unlog(squareLogSample) + LA32Utilites::unlog(resonanceLogSample);
+	}
+
+	Bit16s unlogFirstPCMWaveSample() const {
+		return LA32Utilites::unlog(firstPCMLogSample);
+	}
+
+	Bit16s unlogAndMixPCMWaveOutput() const {
+		Bit16s firstSample = LA32Utilites::unlog(firstPCMLogSample);
+		Bit16s secondSample = LA32Utilites::unlog(secondPCMLogSample);
+		return Bit16s(firstSample + (((Bit32s(secondSample) - Bit32s(firstSample)) * pcmInterpolationFactor) >> 7));
+	}
+
 	// Deactivate the WG engine
 	void deactivate();
 
@@ -235,6 +265,22 @@ class LA32IntPartialPair : public LA32PartialPair {
 
 	static Bit16s unlogAndMixWGOutput(const LA32WaveGenerator &wg);
 
+	static Bit16s produceDistortedSample(const Bit16s sample) {
+		return ((sample & 0x2000) == 0) ? Bit16s(sample & 0x1fff) : Bit16s(sample | ~0x1fff);
+	}
+
+	/* SEMI-CONFIRMED: Ring modulation model derived from sample analysis of specially constructed patches which exploit distortion.
+	 * LA32 ring modulator found to produce distorted output in case if the absolute value of maximal amplitude of one of the input partials exceeds 8191.
+	 * This is easy to reproduce using synth partials with resonance values close to the maximum. It looks like an integer overflow happens in this case.
+	 * As the distortion is strictly bound to the amplitude of the complete mixed square + resonance wave in the linear space,
+	 * it is reasonable to assume the ring modulation is performed also in the linear space by sample multiplication.
+	 * Most probably the overflow is caused by limited precision of the multiplication circuit as the very similar distortion occurs with panning.
+	 */
+	static Bit16s ringModulate(const Bit16s masterSample, const Bit16s slaveSample, const bool mixed) {
+		Bit16s ringModulatedSample = Bit16s((Bit32s(produceDistortedSample(masterSample)) * Bit32s(produceDistortedSample(slaveSample))) >> 13);
+		return mixed ? masterSample + ringModulatedSample : ringModulatedSample;
+	}
+
 public:
 	// ringModulated should be set to false for the structures with mixing or stereo output
 	// ringModulated should be set to true for the structures with ring modulation
@@ -254,6 +300,67 @@ public:
 	// Although, LA32 applies panning itself, we assume it is applied in the mixer, not within a pair
 	Bit16s nextOutSample();
 
+	// Same as generateNextSample() for the master or the slave WG engine, which is known to be active
+	// and to generate either PCM or synth wave samples
+	template <bool PCM_WAVE>
+	void generateNextMasterSample(const Bit32u amp, const Bit16u pitch, const Bit32u cutoff) {
+		if (PCM_WAVE) {
+			master.generateNextPCMWaveSample(amp, pitch);
+		} else {
+			master.generateNextSynthWaveSample(amp, pitch, cutoff);
+		}
+	}
+
+	template <bool PCM_WAVE>
+	void generateNextSlaveSample(const Bit32u amp, const Bit16u pitch, const Bit32u cutoff) {
+		if (PCM_WAVE) {
+			slave.generateNextPCMWaveSample(amp, pitch);
+		} else {
+			slave.generateNextSynthWaveSample(amp, pitch, cutoff);
+		}
+	}
+
+	// Same as generateNextMasterSample() and generateNextSlaveSample() respectively, but the output sample is not computed.
+	// resumeAfterSkipping() must be called before the next sample is generated.
+	template <bool PCM_WAVE>
+	void skipNextMasterSample(const Bit16u pitch, const Bit32u cutoff) {
+		if (PCM_WAVE) {
+			master.skipNextPCMWaveSample(pitch);
+		} else {
+			master.skipNextSynthWaveSample(pitch, cutoff);
+		}
+	}
+
+	template <bool PCM_WAVE>
+	void skipNextSlaveSample(const Bit16u pitch, const Bit32u cutoff) {
+		if (PCM_WAVE) {
+			slave.skipNextPCMWaveSample(pitch);
+		} else {
+			slave.skipNextSynthWaveSample(pitch, cutoff);
+		}
+	}
+
+	// Prepare the WG engines for generation of the next sample after skipping samples
+	void resumeAfterSkipping();
+
+	// Same as nextOutSample() specialised for the structure given by the template arguments. The slave WG engine is expected
+	// to be inactive unless ring modulated and active otherwise. Only a PCM wave may deactivate the master WG engine by itself.
+	template <bool RING_MODULATED, bool MIXED, bool MASTER_PCM_WAVE, bool SLAVE_PCM_WAVE>
+	Bit16s nextOutSample() {
+		Bit16s masterSample;
+		if (MASTER_PCM_WAVE) {
+			masterSample = master.isActive() ? master.unlogAndMixPCMWaveOutput() : 0;
+		} else {
+			masterSample = master.unlogAndMixSynthWaveOutput();
+		}
+		if (!RING_MODULATED) {
+			return masterSample;
+		}
+		// The slave PCM partial is not interpolated in the structures with ring modulation, see nextOutSample().
+		Bit16s slaveSample = SLAVE_PCM_WAVE ? slave.unlogFirstPCMWaveSample() : slave.unlogAndMixSynthWaveOutput();
+		return ringModulate(masterSample, slaveSample, MIXED);
+	}
+
 	// Deactivate the WG engine
 	void deactivate(const PairType master);
 
@@ -0,0 +1,64 @@
+/* Copyright (C) 2003, 2004, 2005, 2006, 2008, 2009 Dean Beeler, Jerome Fisher
+ * Copyright (C) 2011-2019 Dean Beeler, Jerome Fisher, Sergey V. Mikayev
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License as published by
+ *  the Free Software Foundation, either version 2.1 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef MT32EMU_MEMORY_FENCES_H
+#define MT32EMU_MEMORY_FENCES_H
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+namespace MT32Emu {
+
+// Memory fences for the data shared between the rendering thread and other threads through volatile counters.
+// A volatile access alone neither keeps the compiler from moving the ordinary accesses around it, nor orders
+// the accesses as seen by other CPU cores on weakly ordered architectures.
+
+// Keeps the loads that precede the fence from being reordered with the loads and stores that follow it.
+static inline void acquireFence() {
+#if defined(__GNUC__) && defined(__ATOMIC_ACQUIRE)
+	__atomic_thread_fence(__ATOMIC_ACQUIRE);
+#elif defined(__GNUC__)
+	__sync_synchronize();
+#elif defined(_MSC_VER) && defined(_M_ARM64)
+	__dmb(_ARM64_BARRIER_ISH);
+#elif defined(_MSC_VER) && defined(_M_ARM)
+	__dmb(_ARM_BARRIER_ISH);
+#elif defined(_MSC_VER)
+	// x86 CPUs don't reorder loads with other loads, nor stores with other stores.
+	_ReadWriteBarrier();
+#endif
+}
+
+// Keeps the loads and stores that precede the fence from being reordered with the stores that follow it.
+static inline void releaseFence() {
+#if defined(__GNUC__) && defined(__ATOMIC_RELEASE)
+	__atomic_thread_fence(__ATOMIC_RELEASE);
+#elif defined(__GNUC__)
+	__sync_synchronize();
+#elif defined(_MSC_VER) && defined(_M_ARM64)
+	__dmb(_ARM64_BARRIER_ISH);
+#elif defined(_MSC_VER) && defined(_M_ARM)
+	__dmb(_ARM_BARRIER_ISH);
+#elif defined(_MSC_VER)
+	_ReadWriteBarrier();
+#endif
+}
+
+} // namespace MT32Emu
+
+#endif // #ifndef MT32EMU_MEMORY_FENCES_H
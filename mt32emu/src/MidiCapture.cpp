@@ -0,0 +1,289 @@
+/* Copyright (C) 2003, 2004, 2005, 2006, 2008, 2009 Dean Beeler, Jerome Fisher
+ * Copyright (C) 2011-2019 Dean Beeler, Jerome Fisher, Sergey V. Mikayev
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License as published by
+ *  the Free Software Foundation, either version 2.1 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <cstdio>
+#include <cstring>
+
+#include "internals.h"
+
+#include "MidiCapture.h"
+
+namespace MT32Emu {
+
+static const char MAGIC[] = "MT32CAP";
+static const Bit8u FORMAT_VERSION = 1;
+
+// Guards the reader against allocating absurd amounts of memory when the file is damaged.
+static const Bit32u MAX_DATA_LENGTH = 16 * 1024 * 1024;
+
+static inline FILE *getFile(void *file) {
+	return static_cast<FILE *>(file);
+}
+
+static bool writeByte(FILE *file, Bit8u value) {
+	return fputc(value, file) != EOF;
+}
+
+static bool writeVarInt(FILE *file, Bit32u value) {
+	while (value >= 0x80) {
+		if (!writeByte(file, Bit8u(value | 0x80))) return false;
+		value >>= 7;
+	}
+	return writeByte(file, Bit8u(value));
+}
+
+// Small negative deltas are typical for the timestamps in the past, zigzag encoding keeps them short.
+static bool writeSignedVarInt(FILE *file, Bit32u value) {
+	return writeVarInt(file, (value << 1) ^ Bit32u(Bit32s(value) >> 31));
+}
+
+static bool writeData(FILE *file, const Bit8u *data, Bit32u length) {
+	return writeVarInt(file, length) && fwrite(data, 1, length, file) == length;
+}
+
+static bool writeString(FILE *file, const char *str) {
+	const Bit8u length = Bit8u(strlen(str));
+	return writeByte(file, length) && fwrite(str, 1, length, file) == length;
+}
+
+static bool readByte(FILE *file, Bit8u &value) {
+	int c = fgetc(file);
+	if (c == EOF) return false;
+	value = Bit8u(c);
+	return true;
+}
+
+static bool readVarInt(FILE *file, Bit32u &value) {
+	value = 0;
+	for (Bit32u shift = 0; shift < 35; shift += 7) {
+		Bit8u c;
+		if (!readByte(file, c)) return false;
+		value |= Bit32u(c & 0x7F) << shift;
+		if (c < 0x80) return true;
+	}
+	return false;
+}
+
+static bool readSignedVarInt(FILE *file, Bit32u &value) {
+	if (!readVarInt(file, value)) return false;
+	value = (value >> 1) ^ (0 - (value & 1));
+	return true;
+}
+
+static bool readString(FILE *file, char *str, size_t size) {
+	Bit8u length;
+	if (!readByte(file, length) || length >= size) return false;
+	if (fread(str, 1, length, file) != length) return false;
+	str[length] = 0;
+	return true;
+}
+
+MidiCaptureWriter::MidiCaptureWriter() : file(NULL), lastSampleCount(0) {}
+
+MidiCaptureWriter::~MidiCaptureWriter() {
+	close();
+}
+
+bool MidiCaptureWriter::open(const char *filename, const MidiCaptureHeader &header) {
+	close();
+	FILE *newFile = fopen(filename, "wb");
+	if (newFile == NULL) return false;
+	file = newFile;
+	lastSampleCount = 0;
+	bool ok = fwrite(MAGIC, 1, sizeof(MAGIC) - 1, newFile) == sizeof(MAGIC) - 1
+		&& writeByte(newFile, FORMAT_VERSION)
+		&& writeString(newFile, header.controlROMSHA1)
+		&& writeString(newFile, header.pcmROMSHA1)
+		&& writeString(newFile, header.controlROMShortName)
+		&& writeString(newFile, header.pcmROMShortName)
+		&& writeVarInt(newFile, header.partialCount)
+		&& writeByte(newFile, Bit8u(header.analogOutputMode))
+		&& writeByte(newFile, Bit8u(header.rendererType))
+		&& writeByte(newFile, Bit8u(header.midiDelayMode))
+		&& writeVarInt(newFile, header.startSampleCount);
+	if (!ok) {
+		close();
+		return false;
+	}
+	return true;
+}
+
+bool MidiCaptureWriter::write(const MidiCaptureRecord &record) {
+	if (file == NULL) return false;
+	FILE *f = getFile(file);
+	if (!writeByte(f, Bit8u(record.type)) || !writeVarInt(f, record.renderedSampleCount - lastSampleCount)) return false;
+	lastSampleCount = record.renderedSampleCount;
+	const Bit32u delay = record.timestamp - record.renderedSampleCount;
+	switch (record.type) {
+	case MidiCaptureRecordType_SHORT_MESSAGE:
+		return writeSignedVarInt(f, delay) && writeVarInt(f, record.data);
+	case MidiCaptureRecordType_SYSEX:
+		return writeSignedVarInt(f, delay) && writeData(f, record.sysexData, record.sysexLength);
+	case MidiCaptureRecordType_SETTING:
+		if (!writeByte(f, Bit8u(record.setting)) || !writeByte(f, record.timed ? 1 : 0)) return false;
+		if (record.timed && !writeSignedVarInt(f, delay)) return false;
+		return writeVarInt(f, record.data);
+	case MidiCaptureRecordType_MEMORY_WRITE:
+		return writeVarInt(f, record.data) && writeData(f, record.sysexData, record.sysexLength);
+	default:
+		return true;
+	}
+}
+
+void MidiCaptureWriter::close() {
+	if (file == NULL) return;
+	fclose(getFile(file));
+	file = NULL;
+}
+
+bool MidiCaptureWriter::isOpen() const {
+	return file != NULL;
+}
+
+MidiCaptureReader::MidiCaptureReader() :
+	file(NULL), lastSampleCount(0), dataBuffer(NULL), dataBufferSize(0), corrupted(false), finished(false)
+{
+	memset(&header, 0, sizeof(header));
+}
+
+MidiCaptureReader::~MidiCaptureReader() {
+	close();
+	delete[] dataBuffer;
+}
+
+bool MidiCaptureReader::open(const char *filename) {
+	close();
+	FILE *newFile = fopen(filename, "rb");
+	if (newFile == NULL) return false;
+	file = newFile;
+	lastSampleCount = 0;
+	corrupted = false;
+	finished = false;
+
+	char magic[sizeof(MAGIC) - 1];
+	Bit8u version, analogOutputMode, rendererType, midiDelayMode;
+	bool ok = fread(magic, 1, sizeof(magic), newFile) == sizeof(magic)
+		&& memcmp(magic, MAGIC, sizeof(magic)) == 0
+		&& readByte(newFile, version) && version == FORMAT_VERSION
+		&& readString(newFile, header.controlROMSHA1, sizeof(header.controlROMSHA1))
+		&& readString(newFile, header.pcmROMSHA1, sizeof(header.pcmROMSHA1))
+		&& readString(newFile, header.controlROMShortName, sizeof(header.controlROMShortName))
+		&& readString(newFile, header.pcmROMShortName, sizeof(header.pcmROMShortName))
+		&& readVarInt(newFile, header.partialCount)
+		&& readByte(newFile, analogOutputMode)
+		&& readByte(newFile, rendererType)
+		&& readByte(newFile, midiDelayMode)
+		&& readVarInt(newFile, header.startSampleCount);
+	if (!ok) {
+		close();
+		return false;
+	}
+	header.analogOutputMode = AnalogOutputMode(analogOutputMode);
+	header.rendererType = RendererType(rendererType);
+	header.midiDelayMode = MIDIDelayMode(midiDelayMode);
+	return true;
+}
+
+const MidiCaptureHeader &MidiCaptureReader::getHeader() const {
+	return header;
+}
+
+bool MidiCaptureReader::read(MidiCaptureRecord &record) {
+	if (file == NULL || finished || corrupted) return false;
+	FILE *f = getFile(file);
+	Bit8u type;
+	if (!readByte(f, type)) {
+		// A capture that lacks the END record is still usable, e.g. when the application crashed.
+		finished = true;
+		return false;
+	}
+	Bit32u sampleCountDelta;
+	if (type > MidiCaptureRecordType_END || !readVarInt(f, sampleCountDelta)) {
+		corrupted = true;
+		return false;
+	}
+	lastSampleCount += sampleCountDelta;
+	record.type = MidiCaptureRecordType(type);
+	record.renderedSampleCount = lastSampleCount;
+	record.timestamp = lastSampleCount;
+	record.timed = false;
+	record.setting = MidiCaptureSetting_REVERB_ENABLED;
+	record.data = 0;
+	record.sysexData = NULL;
+	record.sysexLength = 0;
+
+	Bit32u delay = 0;
+	bool hasData = false;
+	bool ok = true;
+	switch (record.type) {
+	case MidiCaptureRecordType_SHORT_MESSAGE:
+		ok = readSignedVarInt(f, delay) && readVarInt(f, record.data);
+		break;
+	case MidiCaptureRecordType_SYSEX:
+		ok = readSignedVarInt(f, delay);
+		hasData = true;
+		break;
+	case MidiCaptureRecordType_SETTING: {
+		Bit8u setting, timed;
+		ok = readByte(f, setting) && setting <= MidiCaptureSetting_NOTE_RENDER_CACHE_ENABLED && readByte(f, timed);
+		if (ok) {
+			record.setting = MidiCaptureSetting(setting);
+			record.timed = timed != 0;
+			if (record.timed) ok = readSignedVarInt(f, delay);
+			ok = ok && readVarInt(f, record.data);
+		}
+		break;
+	}
+	case MidiCaptureRecordType_MEMORY_WRITE:
+		ok = readVarInt(f, record.data);
+		hasData = true;
+		break;
+	case MidiCaptureRecordType_END:
+		finished = true;
+		break;
+	default:
+		break;
+	}
+	record.timestamp += delay;
+	if (ok && hasData) {
+		ok = readVarInt(f, record.sysexLength) && record.sysexLength <= MAX_DATA_LENGTH;
+		if (ok && record.sysexLength > dataBufferSize) {
+			delete[] dataBuffer;
+			dataBuffer = new Bit8u[record.sysexLength];
+			dataBufferSize = record.sysexLength;
+		}
+		ok = ok && fread(dataBuffer, 1, record.sysexLength, f) == record.sysexLength;
+		record.sysexData = dataBuffer;
+	}
+	if (!ok) {
+		corrupted = true;
+		return false;
+	}
+	return true;
+}
+
+bool MidiCaptureReader::isCorrupted() const {
+	return corrupted;
+}
+
+void MidiCaptureReader::close() {
+	if (file == NULL) return;
+	fclose(getFile(file));
+	file = NULL;
+}
+
+} // namespace MT32Emu
@@ -0,0 +1,156 @@
+/* Copyright (C) 2003, 2004, 2005, 2006, 2008, 2009 Dean Beeler, Jerome Fisher
+ * Copyright (C) 2011-2019 Dean Beeler, Jerome Fisher, Sergey V. Mikayev
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License as published by
+ *  the Free Software Foundation, either version 2.1 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef MT32EMU_MIDI_CAPTURE_H
+#define MT32EMU_MIDI_CAPTURE_H
+
+#include "globals.h"
+#include "Types.h"
+#include "Enumerations.h"
+
+namespace MT32Emu {
+
+// Kinds of records stored in a MIDI capture, see struct MidiCaptureRecord.
+enum MidiCaptureRecordType {
+	// A short MIDI message successfully enqueued with Synth::playMsg().
+	MidiCaptureRecordType_SHORT_MESSAGE,
+	// A SysEx message successfully enqueued with Synth::playSysex().
+	MidiCaptureRecordType_SYSEX,
+	// A change of a runtime setting, see MidiCaptureSetting.
+	MidiCaptureRecordType_SETTING,
+	// A direct write made with Synth::writeMemory().
+	MidiCaptureRecordType_MEMORY_WRITE,
+	// An invocation of Synth::softReset().
+	MidiCaptureRecordType_SOFT_RESET,
+	// Marks the end of the capture, written when the capture is stopped.
+	MidiCaptureRecordType_END
+};
+
+// Runtime settings tracked in a MIDI capture. Boolean settings have value 0 or 1, the gains are stored as the bit pattern
+// of the IEEE 754 single precision value, the enumerated settings keep the value of the respective enumeration
+// and the partial culling parameters are stored as is.
+enum MidiCaptureSetting {
+	MidiCaptureSetting_REVERB_ENABLED,
+	MidiCaptureSetting_REVERB_OVERRIDDEN,
+	MidiCaptureSetting_REVERB_COMPATIBILITY_MODE,
+	MidiCaptureSetting_DAC_INPUT_MODE,
+	MidiCaptureSetting_OUTPUT_GAIN,
+	MidiCaptureSetting_REVERB_OUTPUT_GAIN,
+	MidiCaptureSetting_REVERSED_STEREO_ENABLED,
+	MidiCaptureSetting_NICE_AMP_RAMP_ENABLED,
+	MidiCaptureSetting_NICE_PANNING_ENABLED,
+	MidiCaptureSetting_NICE_PARTIAL_MIXING_ENABLED,
+	MidiCaptureSetting_CONTROLLER_COALESCING_ENABLED,
+	MidiCaptureSetting_PARTIAL_CULLING_ENABLED,
+	MidiCaptureSetting_PARTIAL_CULLING_THRESHOLD,
+	MidiCaptureSetting_PARTIAL_CULLING_HOLD_TIME,
+	MidiCaptureSetting_NOTE_RENDER_CACHE_ENABLED
+};
+
+// Describes the synth configuration a MIDI capture was taken with.
+struct MidiCaptureHeader {
+	// SHA1 digests of the control and PCM ROM images as lowercase hex strings, and the short names of the ROMs if known.
+	char controlROMSHA1[41];
+	char pcmROMSHA1[41];
+	char controlROMShortName[32];
+	char pcmROMShortName[32];
+	// The arguments of Synth::open() and the renderer type selected at that moment.
+	Bit32u partialCount;
+	AnalogOutputMode analogOutputMode;
+	RendererType rendererType;
+	// MIDI delay mode in effect when the capture started. The captured timestamps already include the delay.
+	MIDIDelayMode midiDelayMode;
+	// The internal rendered sample count of the synth when the capture started. Zero means that the capture covers
+	// the whole session since the synth was opened, otherwise the synth state at the start is not recorded.
+	Bit32u startSampleCount;
+};
+
+// A single recorded input of the synth. All the sample counts are measured in samples at the internal sample rate
+// relative to the start of the capture.
+struct MidiCaptureRecord {
+	MidiCaptureRecordType type;
+	// The internal rendered sample count of the synth at the moment the input was recorded.
+	Bit32u renderedSampleCount;
+	// The timestamp the event was enqueued with. For settings, it only matters if the timed variant of the setter was used.
+	Bit32u timestamp;
+	// True if the setting was changed using the timed variant of the setter.
+	bool timed;
+	MidiCaptureSetting setting;
+	// The short message, the value of the setting or the address of the memory write, depending on the type.
+	Bit32u data;
+	// The SysEx message or the data of the memory write. When reading, it remains valid until the next record is read.
+	const Bit8u *sysexData;
+	Bit32u sysexLength;
+};
+
+/* MidiCaptureWriter stores a MIDI capture in a compact binary format. The file starts with the header followed by
+ * the records, the sample counts are delta-encoded as variable-length integers. A capture is normally recorded
+ * with Synth::startMidiCapture(), though a client may also use the writer directly.
+ */
+class MT32EMU_EXPORT MidiCaptureWriter {
+public:
+	MidiCaptureWriter();
+	// Closes the file if open.
+	~MidiCaptureWriter();
+
+	// Creates the file with the given name and writes the header. Returns false if the file cannot be written.
+	bool open(const char *filename, const MidiCaptureHeader &header);
+	// Appends the record to the file. Returns false if the file is not open or a write error occurred.
+	bool write(const MidiCaptureRecord &record);
+	// Closes the file. The END record is not written automatically.
+	void close();
+	// Returns true if the file is open.
+	bool isOpen() const;
+
+private:
+	void *file;
+	Bit32u lastSampleCount;
+}; // class MidiCaptureWriter
+
+// MidiCaptureReader reads the MIDI captures written by MidiCaptureWriter.
+class MT32EMU_EXPORT MidiCaptureReader {
+public:
+	MidiCaptureReader();
+	// Closes the file if open.
+	~MidiCaptureReader();
+
+	// Opens the file with the given name and reads the header. Returns false if the file cannot be read
+	// or it does not contain a MIDI capture of a supported version.
+	bool open(const char *filename);
+	// Returns the header read by open().
+	const MidiCaptureHeader &getHeader() const;
+	// Reads the next record. Returns false when there are no more records or the file is malformed.
+	// After the END record, no further records are read.
+	bool read(MidiCaptureRecord &record);
+	// Returns true if reading stopped because the file is malformed or truncated.
+	bool isCorrupted() const;
+	// Closes the file if open.
+	void close();
+
+private:
+	void *file;
+	MidiCaptureHeader header;
+	Bit32u lastSampleCount;
+	Bit8u *dataBuffer;
+	Bit32u dataBufferSize;
+	bool corrupted;
+	bool finished;
+}; // class MidiCaptureReader
+
+} // namespace MT32Emu
+
+#endif // #ifndef MT32EMU_MIDI_CAPTURE_H
@@ -20,6 +20,7 @@
 
 #include "globals.h"
 #include "Types.h"
+#include "Enumerations.h"
 
 namespace MT32Emu {
 
@@ -61,11 +62,59 @@ public:
 	bool pushShortMessage(Bit32u shortMessageData, Bit32u timestamp);
 	bool pushSysex(const Bit8u *sysexData, Bit32u sysexLength, Bit32u timestamp);
 	const MidiEvent *peekMidiEvent();
+	// Returns the event that follows the next one by the given number of positions, or NULL if there are not so many events.
+	const MidiEvent *peekMidiEvent(Bit32u offset);
 	void dropMidiEvent();
+	Bit32u getEventCount() const;
 	bool isFull() const;
 	bool inline isEmpty() const;
 };
 
+/**
+ * Used to store timestamped changes of the rendering controls which are not part of the MIDI stream
+ * (such as the output gains or the DAC input mode) in a local queue.
+ */
+struct ControlEvent {
+	enum Type {
+		Type_OUTPUT_GAIN,
+		Type_REVERB_OUTPUT_GAIN,
+		Type_REVERB_ENABLED,
+		Type_REVERSED_STEREO_ENABLED,
+		Type_DAC_INPUT_MODE
+	};
+
+	Type type;
+	union {
+		float gain;
+		bool enabled;
+		DACInputMode dacInputMode;
+	};
+	Bit32u timestamp;
+};
+
+/**
+ * Companion of MidiEventQueue which is serviced by the rendering engine alongside the MIDI events. This makes it possible
+ * to change the rendering controls at a precise sample position without synchronising with the rendering thread.
+ * THREAD SAFETY:
+ * The same considerations apply as for MidiEventQueue.
+ */
+class ControlEventQueue {
+private:
+	ControlEvent * const ringBuffer;
+	const Bit32u ringBufferMask;
+	volatile Bit32u startPosition;
+	volatile Bit32u endPosition;
+
+public:
+	ControlEventQueue(Bit32u ringBufferSize); // Must be a power of 2
+	~ControlEventQueue();
+	void reset();
+	bool pushControlEvent(const ControlEvent &controlEvent);
+	const ControlEvent *peekControlEvent();
+	void dropControlEvent();
+	bool isEmpty() const;
+};
+
 } // namespace MT32Emu
 
 #endif // #ifndef MT32EMU_MIDI_EVENT_QUEUE_H
@@ -0,0 +1,215 @@
+/* Copyright (C) 2003, 2004, 2005, 2006, 2008, 2009 Dean Beeler, Jerome Fisher
+ * Copyright (C) 2011-2019 Dean Beeler, Jerome Fisher, Sergey V. Mikayev
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License as published by
+ *  the Free Software Foundation, either version 2.1 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <cstddef>
+
+#include "internals.h"
+
+#include "NoteRenderCache.h"
+
+namespace MT32Emu {
+
+static const Bit32u FNV_OFFSET_BASIS = 2166136261U;
+static const Bit32u FNV_PRIME = 16777619;
+
+static Bit32u hashField(Bit32u hash, Bit32u field) {
+	return (hash ^ field) * FNV_PRIME;
+}
+
+static Bit32u hashWaveGenerator(Bit32u hash, const NoteRecordingKey::WaveGenerator &wg) {
+	hash = hashField(hash, Bit32u(wg.pcmNum));
+	hash = hashField(hash, wg.sawtoothWaveform ? 1 : 0);
+	hash = hashField(hash, wg.pulseWidth);
+	return hashField(hash, wg.resonance);
+}
+
+static bool equalWaveGenerators(const NoteRecordingKey::WaveGenerator &wg1, const NoteRecordingKey::WaveGenerator &wg2) {
+	return wg1.pcmNum == wg2.pcmNum && wg1.sawtoothWaveform == wg2.sawtoothWaveform && wg1.pulseWidth == wg2.pulseWidth && wg1.resonance == wg2.resonance;
+}
+
+Bit32u NoteRecordingKey::getInputCount() const {
+	Bit32u inputCount = master.pcmNum < 0 ? 3 : 2;
+	if (ringModulated) {
+		inputCount += slave.pcmNum < 0 ? 3 : 2;
+	}
+	return inputCount;
+}
+
+Bit32u NoteRecordingKey::hash() const {
+	Bit32u result = hashWaveGenerator(FNV_OFFSET_BASIS, master);
+	result = hashWaveGenerator(result, slave);
+	result = hashField(result, (ringModulated ? 1 : 0) | (mixed ? 2 : 0));
+	result = hashField(result, partNum);
+	result = hashField(result, key);
+	return hashField(result, velocity);
+}
+
+bool NoteRecordingKey::equals(const NoteRecordingKey &other) const {
+	return equalWaveGenerators(master, other.master) && equalWaveGenerators(slave, other.slave) && ringModulated == other.ringModulated
+		&& mixed == other.mixed && partNum == other.partNum && key == other.key && velocity == other.velocity;
+}
+
+NoteRecording::NoteRecording(const NoteRecordingKey &useKey, Bit32u useKeyHash, bool useFloatMode) :
+	key(useKey), keyHash(useKeyHash), inputCount(useKey.getInputCount()), floatMode(useFloatMode), length(0), chunkCount(0),
+	userCount(0), superseded(false), previous(NULL), next(NULL)
+{}
+
+NoteRecording::~NoteRecording() {
+	for (Bit32u i = 0; i < chunkCount; i++) {
+		delete[] inputChunks[i];
+		if (floatMode) {
+			delete[] floatSampleChunks[i];
+		} else {
+			delete[] intSampleChunks[i];
+		}
+	}
+}
+
+Bit32u NoteRecording::getChunkSize() const {
+	const Bit32u sampleSize = floatMode ? sizeof(FloatSample) : sizeof(IntSample);
+	return (inputCount * sizeof(Bit32u) + sampleSize) << CHUNK_LENGTH_BITS;
+}
+
+NoteRenderCache::NoteRenderCache(bool useFloatMode) :
+	floatMode(useFloatMode), memoryUsage(0), mostRecentlyUsed(NULL), leastRecentlyUsed(NULL)
+{}
+
+NoteRenderCache::~NoteRenderCache() {
+	// The partials release the recordings in use before the cache is deleted.
+	while (mostRecentlyUsed != NULL) {
+		discard(mostRecentlyUsed);
+	}
+}
+
+NoteRecording *NoteRenderCache::acquire(const NoteRecordingKey &key, bool &replay) {
+	const Bit32u keyHash = key.hash();
+	for (NoteRecording *recording = mostRecentlyUsed; recording != NULL; recording = recording->next) {
+		if (recording->keyHash == keyHash && recording->key.equals(key)) {
+			unlink(recording);
+			link(recording);
+			recording->userCount++;
+			replay = true;
+			return recording;
+		}
+	}
+	replay = false;
+	return createRecording(key, keyHash);
+}
+
+NoteRecording *NoteRenderCache::rerecord(NoteRecording *recording) {
+	NoteRecording *newRecording = createRecording(recording->key, recording->keyHash);
+	if (!recording->superseded) {
+		unlink(recording);
+		recording->superseded = true;
+	}
+	release(recording);
+	return newRecording;
+}
+
+void NoteRenderCache::release(NoteRecording *recording) {
+	if (--recording->userCount > 0) return;
+	// Empty recordings are useless, as the partial that made it has not rendered anything.
+	if (recording->superseded || recording->length == 0) {
+		discard(recording);
+	}
+}
+
+void NoteRenderCache::clear() {
+	NoteRecording *recording = mostRecentlyUsed;
+	while (recording != NULL) {
+		NoteRecording *nextRecording = recording->next;
+		if (recording->userCount == 0) {
+			discard(recording);
+		} else {
+			// It goes away as soon as released.
+			unlink(recording);
+			recording->superseded = true;
+		}
+		recording = nextRecording;
+	}
+}
+
+NoteRecording *NoteRenderCache::createRecording(const NoteRecordingKey &key, Bit32u keyHash) {
+	// The memory is only taken as the samples are recorded.
+	NoteRecording *recording = new NoteRecording(key, keyHash, floatMode);
+	recording->userCount = 1;
+	link(recording);
+	return recording;
+}
+
+void NoteRenderCache::link(NoteRecording *recording) {
+	recording->previous = NULL;
+	recording->next = mostRecentlyUsed;
+	if (mostRecentlyUsed != NULL) {
+		mostRecentlyUsed->previous = recording;
+	} else {
+		leastRecentlyUsed = recording;
+	}
+	mostRecentlyUsed = recording;
+}
+
+void NoteRenderCache::unlink(NoteRecording *recording) {
+	if (recording->previous != NULL) {
+		recording->previous->next = recording->next;
+	} else {
+		mostRecentlyUsed = recording->next;
+	}
+	if (recording->next != NULL) {
+		recording->next->previous = recording->previous;
+	} else {
+		leastRecentlyUsed = recording->previous;
+	}
+	recording->previous = NULL;
+	recording->next = NULL;
+}
+
+void NoteRenderCache::discard(NoteRecording *recording) {
+	if (!recording->superseded) {
+		unlink(recording);
+	}
+	memoryUsage -= recording->chunkCount * recording->getChunkSize();
+	delete recording;
+}
+
+bool NoteRenderCache::reserveMemory(Bit32u size) {
+	while (memoryUsage + size > MEMORY_LIMIT) {
+		NoteRecording *victim = leastRecentlyUsed;
+		while (victim != NULL && victim->userCount > 0) {
+			victim = victim->previous;
+		}
+		if (victim == NULL) return false;
+		discard(victim);
+	}
+	memoryUsage += size;
+	return true;
+}
+
+// Returns false when the recording cannot grow any longer.
+bool NoteRenderCache::addChunk(NoteRecording *recording) {
+	const Bit32u chunkIx = recording->chunkCount;
+	if (chunkIx == NoteRecording::MAX_CHUNK_COUNT || !reserveMemory(recording->getChunkSize())) return false;
+	recording->inputChunks[chunkIx] = new Bit32u[recording->inputCount << NoteRecording::CHUNK_LENGTH_BITS];
+	if (floatMode) {
+		recording->floatSampleChunks[chunkIx] = new FloatSample[1 << NoteRecording::CHUNK_LENGTH_BITS];
+	} else {
+		recording->intSampleChunks[chunkIx] = new IntSample[1 << NoteRecording::CHUNK_LENGTH_BITS];
+	}
+	recording->chunkCount++;
+	return true;
+}
+
+} // namespace MT32Emu
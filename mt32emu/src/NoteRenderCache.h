@@ -0,0 +1,171 @@
+/* Copyright (C) 2003, 2004, 2005, 2006, 2008, 2009 Dean Beeler, Jerome Fisher
+ * Copyright (C) 2011-2019 Dean Beeler, Jerome Fisher, Sergey V. Mikayev
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License as published by
+ *  the Free Software Foundation, either version 2.1 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef MT32EMU_NOTE_RENDER_CACHE_H
+#define MT32EMU_NOTE_RENDER_CACHE_H
+
+#include "globals.h"
+#include "internals.h"
+#include "Types.h"
+
+namespace MT32Emu {
+
+// Identifies the notes which output may be replayed from a single recording. The configuration of the LA32 wave generators
+// of a partial and its ring modulating slave determines the output completely, given the same inputs from the TVA, TVP and TVF.
+// The note and the part that played it only serve to tell apart the recordings that are likely to get different inputs.
+struct NoteRecordingKey {
+	struct WaveGenerator {
+		// Number of the PCM wave or -1 for synth waves. The remaining parameters are only set for synth waves.
+		int pcmNum;
+		bool sawtoothWaveform;
+		Bit8u pulseWidth;
+		Bit8u resonance;
+	};
+
+	WaveGenerator master;
+	// Only set with the ring modulation
+	WaveGenerator slave;
+	bool ringModulated;
+	bool mixed;
+	Bit8u partNum;
+	Bit8u key;
+	Bit8u velocity;
+
+	// Returns the number of the WG engine inputs recorded for each sample, that is the amp and the pitch for each engine
+	// along with the cutoff for synth waves.
+	Bit32u getInputCount() const;
+	Bit32u hash() const;
+	bool equals(const NoteRecordingKey &other) const;
+};
+
+// Output of a single partial (mixed or ring modulated with its slave) recorded along with the inputs of the WG engines
+// for each sample, so that the notes which feed the same inputs to the WG engines can be sure to produce the same output.
+class NoteRecording {
+friend class NoteRenderCache;
+public:
+	// Returns true if the recorded inputs of the WG engines at the position equal to those given.
+	bool matchInputs(Bit32u position, const Bit32u *inputs) const {
+		if (position >= length) return false;
+		const Bit32u *recordedInputs = inputChunks[position >> CHUNK_LENGTH_BITS] + (position & CHUNK_POSITION_MASK) * inputCount;
+		for (Bit32u i = 0; i < inputCount; i++) {
+			if (recordedInputs[i] != inputs[i]) return false;
+		}
+		return true;
+	}
+
+	void readSample(Bit32u position, IntSample &sample) const {
+		sample = intSampleChunks[position >> CHUNK_LENGTH_BITS][position & CHUNK_POSITION_MASK];
+	}
+
+	void readSample(Bit32u position, FloatSample &sample) const {
+		sample = floatSampleChunks[position >> CHUNK_LENGTH_BITS][position & CHUNK_POSITION_MASK];
+	}
+
+private:
+	// The samples are stored in chunks, so that the recording never needs to be moved while growing.
+	static const Bit32u CHUNK_LENGTH_BITS = 12;
+	static const Bit32u CHUNK_POSITION_MASK = (1 << CHUNK_LENGTH_BITS) - 1;
+	// Limits the recording to about 2 seconds.
+	static const Bit32u MAX_CHUNK_COUNT = 16;
+
+	const NoteRecordingKey key;
+	const Bit32u keyHash;
+	const Bit32u inputCount;
+	const bool floatMode;
+	Bit32u length;
+	Bit32u chunkCount;
+	Bit32u *inputChunks[MAX_CHUNK_COUNT];
+	IntSample *intSampleChunks[MAX_CHUNK_COUNT];
+	FloatSample *floatSampleChunks[MAX_CHUNK_COUNT];
+	// Number of partials replaying or recording this
+	Bit32u userCount;
+	// Set once the recording is replaced by a newer one with the same key, it is deleted as soon as it is unused.
+	bool superseded;
+	// Neighbours in the list of the cache ordered from the most to the least recently used
+	NoteRecording *previous;
+	NoteRecording *next;
+
+	NoteRecording(const NoteRecordingKey &key, Bit32u keyHash, bool floatMode);
+	~NoteRecording();
+
+	Bit32u getChunkSize() const;
+}; // class NoteRecording
+
+// Keeps the recordings of the partial output used by the note render cache, see Synth::setNoteRenderCacheEnabled().
+// The least recently used recordings are discarded when the memory limit is reached. All the methods are only invoked
+// from the rendering thread.
+class NoteRenderCache {
+public:
+	explicit NoteRenderCache(bool floatMode);
+	~NoteRenderCache();
+
+	// Returns the recording with the given key to be replayed, or a new empty recording to be filled in otherwise.
+	// The memory is only taken as the samples are recorded. The recording must be released after use.
+	NoteRecording *acquire(const NoteRecordingKey &key, bool &replay);
+	// Replaces the recording with a new empty one with the same key and releases the former.
+	// This is used when the recording turns out to be unsuitable right from the start.
+	NoteRecording *rerecord(NoteRecording *recording);
+	void release(NoteRecording *recording);
+	// Appends a sample to the recording. Returns false when the recording cannot grow any longer,
+	// the sample is not recorded then.
+	bool record(NoteRecording *recording, const Bit32u *inputs, IntSample sample) {
+		if (!recordInputs(recording, inputs)) return false;
+		recording->intSampleChunks[recording->length >> NoteRecording::CHUNK_LENGTH_BITS][recording->length & NoteRecording::CHUNK_POSITION_MASK] = sample;
+		recording->length++;
+		return true;
+	}
+
+	bool record(NoteRecording *recording, const Bit32u *inputs, FloatSample sample) {
+		if (!recordInputs(recording, inputs)) return false;
+		recording->floatSampleChunks[recording->length >> NoteRecording::CHUNK_LENGTH_BITS][recording->length & NoteRecording::CHUNK_POSITION_MASK] = sample;
+		recording->length++;
+		return true;
+	}
+	// Discards all the recordings that are not in use.
+	void clear();
+
+private:
+	// Total memory to be taken by the recordings
+	static const Bit32u MEMORY_LIMIT = 8 << 20;
+
+	const bool floatMode;
+	Bit32u memoryUsage;
+	NoteRecording *mostRecentlyUsed;
+	NoteRecording *leastRecentlyUsed;
+
+	NoteRecording *createRecording(const NoteRecordingKey &key, Bit32u keyHash);
+	void link(NoteRecording *recording);
+	void unlink(NoteRecording *recording);
+	void discard(NoteRecording *recording);
+	bool reserveMemory(Bit32u size);
+	bool addChunk(NoteRecording *recording);
+
+	// Stores the inputs of the next sample to be recorded, a new chunk is only added once the last one is full.
+	bool recordInputs(NoteRecording *recording, const Bit32u *inputs) {
+		const Bit32u position = recording->length & NoteRecording::CHUNK_POSITION_MASK;
+		if (position == 0 && (recording->length >> NoteRecording::CHUNK_LENGTH_BITS) == recording->chunkCount && !addChunk(recording)) return false;
+		Bit32u *frame = recording->inputChunks[recording->length >> NoteRecording::CHUNK_LENGTH_BITS] + position * recording->inputCount;
+		for (Bit32u i = 0; i < recording->inputCount; i++) {
+			frame[i] = inputs[i];
+		}
+		return true;
+	}
+}; // class NoteRenderCache
+
+} // namespace MT32Emu
+
+#endif // #ifndef MT32EMU_NOTE_RENDER_CACHE_H
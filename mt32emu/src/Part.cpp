@@ -47,7 +47,6 @@ RhythmPart::RhythmPart(Synth *useSynth, unsigned int usePartNum): Part(useSynth,
 Part::Part(Synth *useSynth, unsigned int usePartNum) {
 	synth = useSynth;
 	partNum = usePartNum;
-	patchCache[0].dirty = true;
 	holdpedal = false;
 	patchTemp = &synth->mt32ram.patchTemp[partNum];
 	if (usePartNum == 8) {
@@ -63,7 +62,6 @@ Part::Part(Synth *useSynth, unsigned int usePartNum) {
 	expression = 100;
 	pitchBend = 0;
 	activePartialCount = 0;
-	memset(patchCache, 0, sizeof(patchCache));
 }
 
 Part::~Part() {
@@ -141,30 +139,11 @@ void Part::reset() {
 }
 
 void RhythmPart::refresh() {
-	// (Re-)cache all the mapped timbres ahead of time
-	for (unsigned int drumNum = 0; drumNum < synth->controlROMMap->rhythmSettingsCount; drumNum++) {
-		int drumTimbreNum = rhythmTemp[drumNum].timbre;
-		if (drumTimbreNum >= 127) { // 94 on MT-32
-			continue;
-		}
-		PatchCache *cache = drumCache[drumNum];
-		backupCacheToPartials(cache);
-		for (int t = 0; t < 4; t++) {
-			// Common parameters, stored redundantly
-			cache[t].dirty = true;
-			cache[t].reverb = rhythmTemp[drumNum].reverbSwitch > 0;
-		}
-	}
+	// The drum timbres are cached by the synth as they are played, only invalidated when the timbre memory is written.
 	updatePitchBenderRange();
 }
 
 void Part::refresh() {
-	backupCacheToPartials(patchCache);
-	for (int t = 0; t < 4; t++) {
-		// Common parameters, stored redundantly
-		patchCache[t].dirty = true;
-		patchCache[t].reverb = patchTemp->patch.reverbSwitch > 0;
-	}
 	memcpy(currentInstr, timbreTemp->common.name, 10);
 	synth->newTimbreSet(partNum, patchTemp->patch.timbreGroup, patchTemp->patch.timbreNum, currentInstr);
 	updatePitchBenderRange();
@@ -174,18 +153,14 @@ const char *Part::getCurrentInstr() const {
 	return &currentInstr[0];
 }
 
-void RhythmPart::refreshTimbre(unsigned int absTimbreNum) {
-	for (int m = 0; m < 85; m++) {
-		if (rhythmTemp[m].timbre == absTimbreNum - 128) {
-			drumCache[m][0].dirty = true;
-		}
-	}
+void RhythmPart::refreshTimbre(unsigned int /*absTimbreNum*/) {
+	// Nothing to do, the cached drum timbres are invalidated by the synth when written.
 }
 
 void Part::refreshTimbre(unsigned int absTimbreNum) {
+	// The timbre temp area is not affected by writes to the timbre memory, so the cached timbre remains valid.
 	if (getAbsTimbreNum() == absTimbreNum) {
 		memcpy(currentInstr, timbreTemp->common.name, 10);
-		patchCache[0].dirty = true;
 	}
 }
 
@@ -199,6 +174,7 @@ void RhythmPart::setTimbre(TimbreParam * /*timbre*/) {
 
 void Part::setTimbre(TimbreParam *timbre) {
 	*timbreTemp = *timbre;
+	synth->invalidateTimbreCache(TIMBRE_CACHE_TIMBRE_TEMP_START + partNum, TIMBRE_CACHE_TIMBRE_TEMP_START + partNum);
 }
 
 unsigned int RhythmPart::getAbsTimbreNum() const {
@@ -240,8 +216,20 @@ void Part::backupCacheToPartials(PatchCache cache[4]) {
 	}
 }
 
+// Returns the shared cache entries derived from the timbre, rebuilding them first if the timbre has been written since.
+const PatchCache *Part::getCachedTimbre(unsigned int timbreCacheNum, const TimbreParam *timbre) {
+	PatchCache *cache = synth->getTimbreCache(timbreCacheNum);
+	if (cache[0].dirty) {
+		// Partials of any part may still be playing with the outdated entries.
+		for (unsigned int i = 0; i < 9; i++) {
+			synth->parts[i]->backupCacheToPartials(cache);
+		}
+		cacheTimbre(cache, timbre);
+	}
+	return cache;
+}
+
 void Part::cacheTimbre(PatchCache cache[4], const TimbreParam *timbre) {
-	backupCacheToPartials(cache);
 	int partialCount = 0;
 	for (int t = 0; t < 4; t++) {
 		if (((timbre->common.partialMute >> t) & 0x1) == 1) {
@@ -400,9 +388,7 @@ void RhythmPart::noteOn(unsigned int midiKey, unsigned int velocity) {
 	int absTimbreNum = drumTimbreNum + 128;
 	TimbreParam *timbre = &synth->mt32ram.timbres[absTimbreNum].timbre;
 	memcpy(currentInstr, timbre->common.name, 10);
-	if (drumCache[drumNum][0].dirty) {
-		cacheTimbre(drumCache[drumNum], timbre);
-	}
+	const PatchCache *cache = getCachedTimbre(absTimbreNum, timbre);
 #if MT32EMU_MONITOR_INSTRUMENTS > 0
 	synth->printDebug("%s (%s): Start poly (drum %d, timbre %d): midiKey %u, key %u, velo %u, mod %u, exp %u, bend %u", name, currentInstr, drumNum, absTimbreNum, midiKey, key, velocity, modulation, expression, pitchBend);
 #if MT32EMU_MONITOR_INSTRUMENTS > 1
@@ -412,14 +398,12 @@ void RhythmPart::noteOn(unsigned int midiKey, unsigned int velocity) {
 	synth->printDebug(" RhythmTemp: timbre %u, outputLevel %u, panpot %u, reverbSwitch %u", rhythmTemp[drumNum].timbre, rhythmTemp[drumNum].outputLevel, rhythmTemp[drumNum].panpot, rhythmTemp[drumNum].reverbSwitch);
 #endif
 #endif
-	playPoly(drumCache[drumNum], &rhythmTemp[drumNum], midiKey, key, velocity);
+	playPoly(cache, &rhythmTemp[drumNum], midiKey, key, velocity);
 }
 
 void Part::noteOn(unsigned int midiKey, unsigned int velocity) {
 	unsigned int key = midiKeyToKey(midiKey);
-	if (patchCache[0].dirty) {
-		cacheTimbre(patchCache, timbreTemp);
-	}
+	const PatchCache *cache = getCachedTimbre(TIMBRE_CACHE_TIMBRE_TEMP_START + partNum, timbreTemp);
 #if MT32EMU_MONITOR_INSTRUMENTS > 0
 	synth->printDebug("%s (%s): Start poly: midiKey %u, key %u, velo %u, mod %u, exp %u, bend %u", name, currentInstr, midiKey, key, velocity, modulation, expression, pitchBend);
 #if MT32EMU_MONITOR_INSTRUMENTS > 1
@@ -427,13 +411,13 @@ void Part::noteOn(unsigned int midiKey, unsigned int velocity) {
 	synth->printDebug(" PatchTemp: outputLevel %u, panpot %u", patchTemp->outputLevel, patchTemp->panpot);
 #endif
 #endif
-	playPoly(patchCache, NULL, midiKey, key, velocity);
+	playPoly(cache, NULL, midiKey, key, velocity);
 }
 
 bool Part::abortFirstPoly(unsigned int key) {
 	for (Poly *poly = activePolys.getFirst(); poly != NULL; poly = poly->getNext()) {
 		if (poly->getKey() == key) {
-			return poly->startAbort();
+			return abortPoly(poly);
 		}
 	}
 	return false;
@@ -442,7 +426,7 @@ bool Part::abortFirstPoly(unsigned int key) {
 bool Part::abortFirstPoly(PolyState polyState) {
 	for (Poly *poly = activePolys.getFirst(); poly != NULL; poly = poly->getNext()) {
 		if (poly->getState() == polyState) {
-			return poly->startAbort();
+			return abortPoly(poly);
 		}
 	}
 	return false;
@@ -459,7 +443,15 @@ bool Part::abortFirstPoly() {
 	if (activePolys.isEmpty()) {
 		return false;
 	}
-	return activePolys.getFirst()->startAbort();
+	return abortPoly(activePolys.getFirst());
+}
+
+bool Part::abortPoly(Poly *poly) {
+	if (!poly->startAbort()) {
+		return false;
+	}
+	synth->recordTraceEvent(TraceEventType_POLY_ABORT, partNum, poly->getKey());
+	return true;
 }
 
 void Part::playPoly(const PatchCache cache[4], const MemParams::RhythmTemp *rhythmTemp, unsigned int midiKey, unsigned int key, unsigned int velocity) {
@@ -472,7 +464,9 @@ void Part::playPoly(const PatchCache cache[4], const MemParams::RhythmTemp *rhyt
 
 	if ((patchTemp->patch.assignMode & 2) == 0) {
 		// Single-assign mode
-		abortFirstPoly(key);
+		if (abortFirstPoly(key)) {
+			synth->countAbortedPoly(POLY_ABORT_SAME_KEY, partNum, partNum);
+		}
 		if (synth->isAbortingPoly()) return;
 	}
 
@@ -481,6 +475,8 @@ void Part::playPoly(const PatchCache cache[4], const MemParams::RhythmTemp *rhyt
 		synth->printDebug("%s (%s): Insufficient free partials to play key %d (velocity %d); needed=%d, free=%d, assignMode=%d", name, currentInstr, midiKey, velocity, needPartials, synth->partialManager->getFreePartialCount(), patchTemp->patch.assignMode);
 		synth->printPartialUsage();
 #endif
+		synth->recordTraceEvent(TraceEventType_PARTIAL_ALLOCATION_FAILURE, partNum, needPartials);
+		synth->countRefusedNote();
 		return;
 	}
 	if (synth->isAbortingPoly()) return;
@@ -488,6 +484,8 @@ void Part::playPoly(const PatchCache cache[4], const MemParams::RhythmTemp *rhyt
 	Poly *poly = synth->partialManager->assignPolyToPart(this);
 	if (poly == NULL) {
 		synth->printDebug("%s (%s): No free poly to play key %d (velocity %d)", name, currentInstr, midiKey, velocity);
+		synth->recordTraceEvent(TraceEventType_PARTIAL_ALLOCATION_FAILURE, partNum, needPartials);
+		synth->countRefusedNote();
 		return;
 	}
 	if (patchTemp->patch.assignMode & 1) {
@@ -507,6 +505,8 @@ void Part::playPoly(const PatchCache cache[4], const MemParams::RhythmTemp *rhyt
 		}
 	}
 	poly->reset(key, velocity, cache[0].sustain, partials);
+	synth->recordTraceEvent(TraceEventType_POLY_START, partNum, key | (velocity << 8));
+	synth->countStartedPoly(partNum);
 
 	for (int x = 0; x < 4; x++) {
 		if (partials[x] != NULL) {
@@ -55,13 +55,13 @@ private:
 	bool holdpedal;
 
 	unsigned int activePartialCount;
-	PatchCache patchCache[4];
 	PolyList activePolys;
 
 	void setPatch(const PatchParam *patch);
 	unsigned int midiKeyToKey(unsigned int midiKey);
 
 	bool abortFirstPoly(unsigned int key);
+	bool abortPoly(Poly *poly);
 
 protected:
 	Synth *synth;
@@ -78,6 +78,7 @@ protected:
 
 	void backupCacheToPartials(PatchCache cache[4]);
 	void cacheTimbre(PatchCache cache[4], const TimbreParam *timbre);
+	const PatchCache *getCachedTimbre(unsigned int timbreCacheNum, const TimbreParam *timbre);
 	void playPoly(const PatchCache cache[4], const MemParams::RhythmTemp *rhythmTemp, unsigned int midiKey, unsigned int key, unsigned int velocity);
 	void stopNote(unsigned int key);
 	const char *getName() const;
@@ -134,8 +135,6 @@ class RhythmPart: public Part {
 	// Pointer to the area of the MT-32's memory dedicated to rhythm
 	const MemParams::RhythmTemp *rhythmTemp;
 
-	// This caches the timbres/settings in use by the rhythm part
-	PatchCache drumCache[85][4];
 public:
 	RhythmPart(Synth *synth, unsigned int usePartNum);
 	void refresh();
@@ -20,6 +20,7 @@
 #include "internals.h"
 
 #include "Partial.h"
+#include "DSPKernels.h"
 #include "Part.h"
 #include "PartialManager.h"
 #include "Poly.h"
@@ -34,6 +35,9 @@ namespace MT32Emu {
 static const Bit8u PAN_NUMERATOR_MASTER[] = {0, 0, 0, 0, 0, 0, 0, 0, 1, 2, 3, 4, 5, 6, 7};
 static const Bit8u PAN_NUMERATOR_SLAVE[]  = {0, 1, 2, 3, 4, 5, 6, 7, 7, 7, 7, 7, 7, 7, 7};
 
+// The amp value is the attenuation of the partial, which the amp ramp reduces from this value as the level rises.
+static const Bit32u SILENT_AMP_VALUE = 67117056;
+
 // We assume the pan is applied using the same 13-bit multiplier circuit that is also used for ring modulation
 // because of the observed sample overflow, so the panSetting values are likely mapped in a similar way via a LUT.
 // FIXME: Sample analysis suggests that the use of panSetting is linear, but there are some quirks that still need to be resolved.
@@ -52,7 +56,7 @@ static Bit32s getPanFactor(Bit32s panSetting) {
 }
 
 Partial::Partial(Synth *useSynth, int usePartialIndex) :
-	synth(useSynth), partialIndex(usePartialIndex), sampleNum(0),
+	synth(useSynth), partialIndex(usePartialIndex), sampleNum(0), activationSampleCount(0),
 	floatMode(useSynth->getSelectedRendererType() == RendererType_FLOAT) {
 	// Initialisation of tva, tvp and tvf uses 'this' pointer
 	// and thus should not be in the initializer list to avoid a compiler warning
@@ -62,6 +66,13 @@ Partial::Partial(Synth *useSynth, int usePartialIndex) :
 	ownerPart = -1;
 	poly = NULL;
 	pair = NULL;
+	reverb = false;
+	inaudibleSampleCount = 0;
+	noteRecordingPending = false;
+	noteRenderCache = NULL;
+	noteRecording = NULL;
+	noteRecordingPosition = 0;
+	noteRecordingReplayed = false;
 	switch (synth->getSelectedRendererType()) {
 	case RendererType_BIT16S:
 		la32Pair = new LA32IntPartialPair;
@@ -75,6 +86,7 @@ Partial::Partial(Synth *useSynth, int usePartialIndex) :
 }
 
 Partial::~Partial() {
+	stopNoteRecording();
 	delete la32Pair;
 	delete tva;
 	delete tvp;
@@ -106,6 +118,7 @@ const Poly *Partial::getPoly() const {
 void Partial::activate(int part) {
 	// This just marks the partial as being assigned to a part
 	ownerPart = part;
+	activationSampleCount = synth->renderedSampleCount + sampleNum;
 }
 
 void Partial::deactivate() {
@@ -113,6 +126,8 @@ void Partial::deactivate() {
 		return;
 	}
 	ownerPart = -1;
+	stopNoteRecording();
+	synth->countPartialLifetime(synth->renderedSampleCount + sampleNum - activationSampleCount);
 	synth->partialManager->partialDeactivated(partialIndex);
 	if (poly != NULL) {
 		poly->partialDeactivated(this);
@@ -144,6 +159,7 @@ void Partial::startPartial(const Part *part, Poly *usePoly, const PatchCache *us
 	poly = usePoly;
 	mixType = patchCache->structureMix;
 	structurePosition = patchCache->structurePosition;
+	reverb = (rhythmTemp != NULL ? rhythmTemp->reverbSwitch : part->getPatchTemp()->patch.reverbSwitch) > 0;
 
 	Bit8u panSetting = rhythmTemp != NULL ? rhythmTemp->panpot : part->getPatchTemp()->panpot;
 	if (mixType == 3) {
@@ -209,7 +225,9 @@ void Partial::startPartial(const Part *part, Poly *usePoly, const PatchCache *us
 	}
 
 	pair = pairPartial;
-	alreadyOutputed = false;
+	inaudibleSampleCount = 0;
+	// The configuration of the ring modulating slave is only known once it is started, after the master.
+	noteRecordingPending = true;
 	tva->reset(part, patchCache->partialParam, rhythmTemp);
 	tvp->reset(part, patchCache->partialParam);
 	tvf->reset(patchCache->partialParam, tvp->getBasePitch());
@@ -245,7 +263,7 @@ Bit32u Partial::getAmpValue() {
 	//
 	// Also still partially unconfirmed is the behaviour when ramping between levels, as well as the timing.
 	// TODO: The tests above were performed using the float model, to be refined
-	Bit32u ampRampVal = 67117056 - ampRamp.nextValue();
+	Bit32u ampRampVal = SILENT_AMP_VALUE - ampRamp.nextValue();
 	if (ampRamp.checkInterrupt()) {
 		tva->handleInterrupt();
 	}
@@ -302,7 +320,7 @@ void Partial::backupCache(const PatchCache &cache) {
 }
 
 bool Partial::canProduceOutput() {
-	if (!isActive() || alreadyOutputed || isRingModulatingSlave()) {
+	if (!isActive() || isRingModulatingSlave()) {
 		return false;
 	}
 	if (poly == NULL) {
@@ -312,13 +330,94 @@ bool Partial::canProduceOutput() {
 	return true;
 }
 
+void Partial::describeWaveGenerator(NoteRecordingKey::WaveGenerator &wg) const {
+	if (isPCM()) {
+		wg.pcmNum = pcmNum;
+		wg.sawtoothWaveform = false;
+		wg.pulseWidth = 0;
+		wg.resonance = 0;
+	} else {
+		// Same as the parameters of the WG engine set in startPartial().
+		wg.pcmNum = -1;
+		wg.sawtoothWaveform = (patchCache->waveform & 1) != 0;
+		wg.pulseWidth = Bit8u(pulseWidthVal);
+		wg.resonance = Bit8u(patchCache->srcPartial.tvf.resonance + 1);
+	}
+}
+
+void Partial::startNoteRecording() {
+	noteRecordingPending = false;
+	noteRenderCache = synth->getNoteRenderCache();
+	// A master that has lost its ring modulating slave is left to the generic code, see generateSamples().
+	if (noteRenderCache == NULL || (structurePosition == 0 && mixType == 1 && !hasRingModulatingSlave())) return;
+	NoteRecordingKey key;
+	describeWaveGenerator(key.master);
+	key.ringModulated = hasRingModulatingSlave();
+	if (key.ringModulated) {
+		pair->describeWaveGenerator(key.slave);
+	} else {
+		key.slave.pcmNum = -1;
+		key.slave.sawtoothWaveform = false;
+		key.slave.pulseWidth = 0;
+		key.slave.resonance = 0;
+	}
+	key.mixed = key.ringModulated && mixType == 1;
+	key.partNum = Bit8u(ownerPart);
+	key.key = Bit8u(poly->getKey());
+	key.velocity = Bit8u(poly->getVelocity());
+	noteRecording = noteRenderCache->acquire(key, noteRecordingReplayed);
+	noteRecordingPosition = 0;
+}
+
+void Partial::stopNoteRecording() {
+	if (noteRecording != NULL) {
+		noteRenderCache->release(noteRecording);
+		noteRecording = NULL;
+	}
+	noteRecordingReplayed = false;
+}
+
+// Switches a replaying partial to live rendering. The recording is replaced when it does not match right from the start,
+// it is probably made with another setting of the part then.
+template <class LA32PairImpl>
+void Partial::handOverNoteRecording(LA32PairImpl *la32PairImpl) {
+	if (noteRecordingPosition == 0) {
+		noteRecording = noteRenderCache->rerecord(noteRecording);
+		noteRecordingReplayed = false;
+		return;
+	}
+	la32PairImpl->resumeAfterSkipping();
+	stopNoteRecording();
+}
+
+void Partial::cull() {
+	// The ring modulating slave goes along with the master, and its output cannot be heard without the master anyway.
+	synth->countCulledPartials(hasRingModulatingSlave() ? 2 : 1);
+	deactivate();
+}
+
 template <class LA32PairImpl>
-bool Partial::generateNextSample(LA32PairImpl *la32PairImpl) {
+bool Partial::nextAmpValue(LA32PairImpl *la32PairImpl, const Bit32u cullingLevelThreshold, const Bit32u cullingHoldTime, Bit32u &ampValue) {
 	if (!tva->isPlaying() || !la32PairImpl->isActive(LA32PartialPair::MASTER)) {
 		deactivate();
 		return false;
 	}
-	la32PairImpl->generateNextSample(LA32PartialPair::MASTER, getAmpValue(), tvp->nextPitch(), getCutoffValue());
+	ampValue = getAmpValue();
+	// The amplitude envelope only decays in the release phase, so the partial is not going to become audible again.
+	if (SILENT_AMP_VALUE - ampValue >= cullingLevelThreshold || tva->getPhase() != TVA_PHASE_RELEASE) {
+		inaudibleSampleCount = 0;
+	} else if (++inaudibleSampleCount > cullingHoldTime) {
+		cull();
+		return false;
+	}
+	return true;
+}
+
+template <class LA32PairImpl>
+bool Partial::generateNextSample(LA32PairImpl *la32PairImpl, const Bit32u cullingLevelThreshold, const Bit32u cullingHoldTime) {
+	Bit32u ampValue;
+	if (!nextAmpValue(la32PairImpl, cullingLevelThreshold, cullingHoldTime, ampValue)) return false;
+	la32PairImpl->generateNextSample(LA32PartialPair::MASTER, ampValue, tvp->nextPitch(), getCutoffValue());
 	if (hasRingModulatingSlave()) {
 		la32PairImpl->generateNextSample(LA32PartialPair::SLAVE, pair->getAmpValue(), pair->tvp->nextPitch(), pair->getCutoffValue());
 		if (!pair->tva->isPlaying() || !la32PairImpl->isActive(LA32PartialPair::SLAVE)) {
@@ -332,39 +431,165 @@ bool Partial::generateNextSample(LA32PairImpl *la32PairImpl) {
 	return true;
 }
 
-void Partial::produceAndMixSample(IntSample *&leftBuf, IntSample *&rightBuf, LA32IntPartialPair *la32IntPair) {
-	IntSampleEx sample = la32IntPair->nextOutSample();
+// Renders the samples of a structure that is fixed for the whole loop, so that the configuration of the structure is not
+// rechecked for each sample. Returns false when the partial is deactivated. When the ring modulating slave is lost,
+// the structure changes and the loop returns true before the length is reached.
+template <bool RING_MODULATED, bool MIXED, bool MASTER_PCM_WAVE, bool SLAVE_PCM_WAVE, class Sample, class LA32PairImpl>
+bool Partial::generateStructureSamples(LA32PairImpl *la32PairImpl, Sample *monoBuf, const Bit32u length, const Bit32u cullingLevelThreshold, const Bit32u cullingHoldTime) {
+	for (; sampleNum < length; sampleNum++) {
+		Bit32u ampValue;
+		if (!nextAmpValue(la32PairImpl, cullingLevelThreshold, cullingHoldTime, ampValue)) return false;
+		// PCM partials ignore the cutoff, so the TVF is not even consulted.
+		la32PairImpl->template generateNextMasterSample<MASTER_PCM_WAVE>(ampValue, tvp->nextPitch(), MASTER_PCM_WAVE ? 0 : getCutoffValue());
+		if (RING_MODULATED) {
+			la32PairImpl->template generateNextSlaveSample<SLAVE_PCM_WAVE>(pair->getAmpValue(), pair->tvp->nextPitch(), SLAVE_PCM_WAVE ? 0 : pair->getCutoffValue());
+			if (!pair->tva->isPlaying() || !la32PairImpl->isActive(LA32PartialPair::SLAVE)) {
+				pair->deactivate();
+				if (!MIXED) {
+					deactivate();
+					return false;
+				}
+				monoBuf[sampleNum++] = la32PairImpl->nextOutSample();
+				return true;
+			}
+		}
+		monoBuf[sampleNum] = la32PairImpl->template nextOutSample<RING_MODULATED, MIXED, MASTER_PCM_WAVE, SLAVE_PCM_WAVE>();
+	}
+	return true;
+}
 
+// Same as generateStructureSamples() for a partial that replays or records its output in the note render cache.
+// While replaying, the envelopes keep running and each sample is taken from the recording as long as the inputs of the WG engines
+// equal the recorded ones, so that the WG engines only need to advance their positions. Otherwise, e.g. when a controller,
+// a note-off or an abort takes effect, the partial hands over to live rendering from the same WG state it would have reached
+// by generating the replayed samples. The output is therefore exactly the same as if the recording was never replayed.
+template <bool RING_MODULATED, bool MIXED, bool MASTER_PCM_WAVE, bool SLAVE_PCM_WAVE, class Sample, class LA32PairImpl>
+bool Partial::generateCachedStructureSamples(LA32PairImpl *la32PairImpl, Sample *monoBuf, const Bit32u length, const Bit32u cullingLevelThreshold, const Bit32u cullingHoldTime) {
+	// The amp and the pitch are recorded for each WG engine, followed by the cutoff for synth waves.
+	const Bit32u slaveInputsIx = MASTER_PCM_WAVE ? 2 : 3;
+	Bit32u inputs[6];
+	for (; sampleNum < length; sampleNum++) {
+		if (!nextAmpValue(la32PairImpl, cullingLevelThreshold, cullingHoldTime, inputs[0])) return false;
+		inputs[1] = tvp->nextPitch();
+		if (!MASTER_PCM_WAVE) inputs[2] = getCutoffValue();
+		if (RING_MODULATED) {
+			inputs[slaveInputsIx] = pair->getAmpValue();
+			inputs[slaveInputsIx + 1] = pair->tvp->nextPitch();
+			if (!SLAVE_PCM_WAVE) inputs[slaveInputsIx + 2] = pair->getCutoffValue();
+		}
+		if (noteRecordingReplayed) {
+			// The recording ends before the slave is lost, so the structure is still intact for the recorded samples.
+			if (noteRecording->matchInputs(noteRecordingPosition, inputs) && (!RING_MODULATED || pair->tva->isPlaying())) {
+				la32PairImpl->template skipNextMasterSample<MASTER_PCM_WAVE>(Bit16u(inputs[1]), MASTER_PCM_WAVE ? 0 : inputs[2]);
+				if (RING_MODULATED) {
+					la32PairImpl->template skipNextSlaveSample<SLAVE_PCM_WAVE>(Bit16u(inputs[slaveInputsIx + 1]), SLAVE_PCM_WAVE ? 0 : inputs[slaveInputsIx + 2]);
+				}
+				noteRecording->readSample(noteRecordingPosition++, monoBuf[sampleNum]);
+				continue;
+			}
+			handOverNoteRecording(la32PairImpl);
+		}
+		la32PairImpl->template generateNextMasterSample<MASTER_PCM_WAVE>(inputs[0], Bit16u(inputs[1]), MASTER_PCM_WAVE ? 0 : inputs[2]);
+		if (RING_MODULATED) {
+			la32PairImpl->template generateNextSlaveSample<SLAVE_PCM_WAVE>(inputs[slaveInputsIx], Bit16u(inputs[slaveInputsIx + 1]), SLAVE_PCM_WAVE ? 0 : inputs[slaveInputsIx + 2]);
+			if (!pair->tva->isPlaying() || !la32PairImpl->isActive(LA32PartialPair::SLAVE)) {
+				stopNoteRecording();
+				pair->deactivate();
+				if (!MIXED) {
+					deactivate();
+					return false;
+				}
+				monoBuf[sampleNum++] = la32PairImpl->nextOutSample();
+				return true;
+			}
+		}
+		monoBuf[sampleNum] = la32PairImpl->template nextOutSample<RING_MODULATED, MIXED, MASTER_PCM_WAVE, SLAVE_PCM_WAVE>();
+		if (noteRecording != NULL && !noteRenderCache->record(noteRecording, inputs, monoBuf[sampleNum])) {
+			stopNoteRecording();
+		}
+	}
+	return true;
+}
+
+// Picks the loop that either makes use of the note render cache or not.
+template <bool RING_MODULATED, bool MIXED, bool MASTER_PCM_WAVE, bool SLAVE_PCM_WAVE, class Sample, class LA32PairImpl>
+bool Partial::renderStructureSamples(LA32PairImpl *la32PairImpl, Sample *monoBuf, const Bit32u length, const Bit32u cullingLevelThreshold, const Bit32u cullingHoldTime) {
+	if (noteRecording == NULL) {
+		return generateStructureSamples<RING_MODULATED, MIXED, MASTER_PCM_WAVE, SLAVE_PCM_WAVE>(la32PairImpl, monoBuf, length, cullingLevelThreshold, cullingHoldTime);
+	}
+	return generateCachedStructureSamples<RING_MODULATED, MIXED, MASTER_PCM_WAVE, SLAVE_PCM_WAVE>(la32PairImpl, monoBuf, length, cullingLevelThreshold, cullingHoldTime);
+}
+
+// Picks the loop specialised for the current structure and runs it from sampleNum. Returns false when the partial is deactivated.
+template <class Sample, class LA32PairImpl>
+bool Partial::generateSamples(LA32PairImpl *la32PairImpl, Sample *monoBuf, const Bit32u length, const Bit32u cullingLevelThreshold, const Bit32u cullingHoldTime) {
+	if (hasRingModulatingSlave()) {
+		switch ((mixType == 1 ? 1 : 0) | (isPCM() ? 2 : 0) | (pair->isPCM() ? 4 : 0)) {
+		case 0:
+			return renderStructureSamples<true, false, false, false>(la32PairImpl, monoBuf, length, cullingLevelThreshold, cullingHoldTime);
+		case 1:
+			return renderStructureSamples<true, true, false, false>(la32PairImpl, monoBuf, length, cullingLevelThreshold, cullingHoldTime);
+		case 2:
+			return renderStructureSamples<true, false, true, false>(la32PairImpl, monoBuf, length, cullingLevelThreshold, cullingHoldTime);
+		case 3:
+			return renderStructureSamples<true, true, true, false>(la32PairImpl, monoBuf, length, cullingLevelThreshold, cullingHoldTime);
+		case 4:
+			return renderStructureSamples<true, false, false, true>(la32PairImpl, monoBuf, length, cullingLevelThreshold, cullingHoldTime);
+		case 5:
+			return renderStructureSamples<true, true, false, true>(la32PairImpl, monoBuf, length, cullingLevelThreshold, cullingHoldTime);
+		case 6:
+			return renderStructureSamples<true, false, true, true>(la32PairImpl, monoBuf, length, cullingLevelThreshold, cullingHoldTime);
+		default:
+			return renderStructureSamples<true, true, true, true>(la32PairImpl, monoBuf, length, cullingLevelThreshold, cullingHoldTime);
+		}
+	}
+	if (structurePosition == 0 && mixType == 1) {
+		// The ring modulating slave has been lost, the LA32 pair keeps ring modulating the master with silence.
+		// This is rare enough to be left to the generic code.
+		if (noteRecording != NULL) {
+			if (noteRecordingPosition > 0) {
+				la32PairImpl->resumeAfterSkipping();
+			}
+			stopNoteRecording();
+		}
+		for (; sampleNum < length; sampleNum++) {
+			if (!generateNextSample(la32PairImpl, cullingLevelThreshold, cullingHoldTime)) return false;
+			monoBuf[sampleNum] = la32PairImpl->nextOutSample();
+		}
+		return true;
+	}
+	if (isPCM()) {
+		return renderStructureSamples<false, false, true, false>(la32PairImpl, monoBuf, length, cullingLevelThreshold, cullingHoldTime);
+	}
+	return renderStructureSamples<false, false, false, false>(la32PairImpl, monoBuf, length, cullingLevelThreshold, cullingHoldTime);
+}
+
+void Partial::panAndMix(IntSample *leftBuf, IntSample *rightBuf, const IntSample *monoBuf, Bit32u length) {
 	// FIXME: LA32 may produce distorted sound in case if the absolute value of maximal amplitude of the input exceeds 8191
 	// when the panning value is non-zero. Most probably the distortion occurs in the same way it does with ring modulation,
 	// and it seems to be caused by limited precision of the common multiplication circuit.
 	// From analysis of this overflow, it is obvious that the right channel output is actually found
 	// by subtraction of the left channel output from the input.
 	// Though, it is unknown whether this overflow is exploited somewhere.
-
-	IntSampleEx leftOut = ((sample * leftPanValue) >> 13) + IntSampleEx(*leftBuf);
-	IntSampleEx rightOut = ((sample * rightPanValue) >> 13) + IntSampleEx(*rightBuf);
-	*(leftBuf++) = Synth::clipSampleEx(leftOut);
-	*(rightBuf++) = Synth::clipSampleEx(rightOut);
+	getDSPKernels().panAndMixInt(leftBuf, rightBuf, monoBuf, length, leftPanValue, rightPanValue);
 }
 
-void Partial::produceAndMixSample(FloatSample *&leftBuf, FloatSample *&rightBuf, LA32FloatPartialPair *la32FloatPair) {
-	FloatSample sample = la32FloatPair->nextOutSample();
-	FloatSample leftOut = (sample * leftPanValue) / 14.0f;
-	FloatSample rightOut = (sample * rightPanValue) / 14.0f;
-	*(leftBuf++) += leftOut;
-	*(rightBuf++) += rightOut;
+void Partial::panAndMix(FloatSample *leftBuf, FloatSample *rightBuf, const FloatSample *monoBuf, Bit32u length) {
+	getDSPKernels().panAndMixFloat(leftBuf, rightBuf, monoBuf, length, leftPanValue, rightPanValue);
 }
 
 template <class Sample, class LA32PairImpl>
 bool Partial::doProduceOutput(Sample *leftBuf, Sample *rightBuf, Bit32u length, LA32PairImpl *la32PairImpl) {
 	if (!canProduceOutput()) return false;
-	alreadyOutputed = true;
+	if (noteRecordingPending) startNoteRecording();
 
-	for (sampleNum = 0; sampleNum < length; sampleNum++) {
-		if (!generateNextSample(la32PairImpl)) break;
-		produceAndMixSample(leftBuf, rightBuf, la32PairImpl);
-	}
+	// The mono output is generated first, so that panning and mixing into the shared buffers can be done in one go.
+	Sample monoBuf[MAX_SAMPLES_PER_RUN];
+	Bit32u cullingLevelThreshold, cullingHoldTime;
+	synth->getPartialCullingParameters(cullingLevelThreshold, cullingHoldTime);
+	sampleNum = 0;
+	while (sampleNum < length && generateSamples(la32PairImpl, monoBuf, length, cullingLevelThreshold, cullingHoldTime)) {}
+	panAndMix(leftBuf, rightBuf, monoBuf, sampleNum);
 	sampleNum = 0;
 	return true;
 }
@@ -389,7 +614,7 @@ bool Partial::shouldReverb() {
 	if (!isActive()) {
 		return false;
 	}
-	return patchCache->reverb;
+	return reverb;
 }
 
 void Partial::startAbort() {
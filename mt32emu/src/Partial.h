@@ -25,6 +25,7 @@
 #include "LA32Ramp.h"
 #include "LA32WaveGenerator.h"
 #include "LA32FloatWaveGenerator.h"
+#include "NoteRenderCache.h"
 
 namespace MT32Emu {
 
@@ -44,6 +45,8 @@ private:
 	// Number of the sample currently being rendered by produceOutput(), or 0 if no run is in progress
 	// This is only kept available for debugging purposes.
 	Bit32u sampleNum;
+	// Value of Synth::renderedSampleCount when the partial was activated, used for the polyphony statistics
+	Bit32u activationSampleCount;
 
 	// Actually, LA-32 receives only 3 bits as a pan setting, but we abuse these to emulate
 	// the inverted partial mixing as well. Also we double the values (making them correspond
@@ -79,6 +82,19 @@ private:
 
 	const PatchCache *patchCache;
 	PatchCache cachebackup;
+	// Reverb switch of the part or the drum at the time the partial was started
+	bool reverb;
+	// Number of consecutive samples the partial has been releasing below the culling threshold
+	Bit32u inaudibleSampleCount;
+
+	// Set when the partial is started, until the note render cache is consulted on the first rendering pass
+	bool noteRecordingPending;
+	NoteRenderCache *noteRenderCache;
+	// Recording of the output of this partial in the note render cache that is being replayed or recorded, or NULL
+	NoteRecording *noteRecording;
+	// Number of samples replayed from noteRecording so far
+	Bit32u noteRecordingPosition;
+	bool noteRecordingReplayed;
 
 	Bit32u getAmpValue();
 	Bit32u getCutoffValue();
@@ -86,14 +102,28 @@ private:
 	template <class Sample, class LA32PairImpl>
 	bool doProduceOutput(Sample *leftBuf, Sample *rightBuf, Bit32u length, LA32PairImpl *la32PairImpl);
 	bool canProduceOutput();
+	template <class Sample, class LA32PairImpl>
+	bool generateSamples(LA32PairImpl *la32PairImpl, Sample *monoBuf, const Bit32u length, const Bit32u cullingLevelThreshold, const Bit32u cullingHoldTime);
+	template <bool RING_MODULATED, bool MIXED, bool MASTER_PCM_WAVE, bool SLAVE_PCM_WAVE, class Sample, class LA32PairImpl>
+	bool renderStructureSamples(LA32PairImpl *la32PairImpl, Sample *monoBuf, const Bit32u length, const Bit32u cullingLevelThreshold, const Bit32u cullingHoldTime);
+	template <bool RING_MODULATED, bool MIXED, bool MASTER_PCM_WAVE, bool SLAVE_PCM_WAVE, class Sample, class LA32PairImpl>
+	bool generateStructureSamples(LA32PairImpl *la32PairImpl, Sample *monoBuf, const Bit32u length, const Bit32u cullingLevelThreshold, const Bit32u cullingHoldTime);
+	template <bool RING_MODULATED, bool MIXED, bool MASTER_PCM_WAVE, bool SLAVE_PCM_WAVE, class Sample, class LA32PairImpl>
+	bool generateCachedStructureSamples(LA32PairImpl *la32PairImpl, Sample *monoBuf, const Bit32u length, const Bit32u cullingLevelThreshold, const Bit32u cullingHoldTime);
+	template <class LA32PairImpl>
+	bool generateNextSample(LA32PairImpl *la32PairImpl, const Bit32u cullingLevelThreshold, const Bit32u cullingHoldTime);
 	template <class LA32PairImpl>
-	bool generateNextSample(LA32PairImpl *la32PairImpl);
-	void produceAndMixSample(IntSample *&leftBuf, IntSample *&rightBuf, LA32IntPartialPair *la32IntPair);
-	void produceAndMixSample(FloatSample *&leftBuf, FloatSample *&rightBuf, LA32FloatPartialPair *la32FloatPair);
+	bool nextAmpValue(LA32PairImpl *la32PairImpl, const Bit32u cullingLevelThreshold, const Bit32u cullingHoldTime, Bit32u &ampValue);
+	void cull();
+	void describeWaveGenerator(NoteRecordingKey::WaveGenerator &wg) const;
+	void startNoteRecording();
+	void stopNoteRecording();
+	template <class LA32PairImpl>
+	void handOverNoteRecording(LA32PairImpl *la32PairImpl);
+	void panAndMix(IntSample *leftBuf, IntSample *rightBuf, const IntSample *monoBuf, Bit32u length);
+	void panAndMix(FloatSample *leftBuf, FloatSample *rightBuf, const FloatSample *monoBuf, Bit32u length);
 
 public:
-	bool alreadyOutputed;
-
 	Partial(Synth *synth, int debugPartialNum);
 	~Partial();
 
@@ -34,6 +34,9 @@ PartialManager::PartialManager(Synth *useSynth, Part **useParts) {
 	inactivePartialCount = synth->getPartialCount();
 	partialTable = new Partial *[inactivePartialCount];
 	inactivePartials = new int[inactivePartialCount];
+	activePartials = new int[inactivePartialCount];
+	activePartialCount = 0;
+	hasDeactivatedPartials = false;
 	freePolys = new Poly *[synth->getPartialCount()];
 	firstFreePolyIndex = 0;
 	for (unsigned int i = 0; i < synth->getPartialCount(); i++) {
@@ -50,13 +53,25 @@ PartialManager::~PartialManager(void) {
 	}
 	delete[] partialTable;
 	delete[] inactivePartials;
+	delete[] activePartials;
 	delete[] freePolys;
 }
 
-void PartialManager::clearAlreadyOutputed() {
-	for (unsigned int i = 0; i < synth->getPartialCount(); i++) {
-		partialTable[i]->alreadyOutputed = false;
+void PartialManager::compactActivePartials() {
+	if (!hasDeactivatedPartials) return;
+	Bit32u newCount = 0;
+	for (Bit32u listIndex = 0; listIndex < activePartialCount; listIndex++) {
+		int partialIndex = activePartials[listIndex];
+		if (partialTable[partialIndex]->isActive()) {
+			activePartials[newCount++] = partialIndex;
+		}
 	}
+	activePartialCount = newCount;
+	hasDeactivatedPartials = false;
+}
+
+bool PartialManager::hasActivePartials() const {
+	return inactivePartialCount < synth->getPartialCount();
 }
 
 bool PartialManager::shouldReverb(int i) {
@@ -72,9 +87,10 @@ bool PartialManager::produceOutput(int i, FloatSample *leftBuf, FloatSample *rig
 }
 
 void PartialManager::deactivateAll() {
-	for (unsigned int i = 0; i < synth->getPartialCount(); i++) {
-		partialTable[i]->deactivate();
+	for (Bit32u listIndex = 0; listIndex < activePartialCount; listIndex++) {
+		partialTable[activePartials[listIndex]]->deactivate();
 	}
+	compactActivePartials();
 }
 
 unsigned int PartialManager::setReserve(Bit8u *rset) {
@@ -88,8 +104,17 @@ unsigned int PartialManager::setReserve(Bit8u *rset) {
 
 Partial *PartialManager::allocPartial(int partNum) {
 	if (inactivePartialCount > 0) {
-		Partial *partial = partialTable[inactivePartials[--inactivePartialCount]];
+		int partialIndex = inactivePartials[--inactivePartialCount];
+		Partial *partial = partialTable[partialIndex];
+		// The partial may still be listed if it was deactivated during the last rendered block.
+		// It has to be dropped from the list while it's inactive, or it would be kept and listed twice.
+		compactActivePartials();
 		partial->activate(partNum);
+		Bit32u listIndex = activePartialCount++;
+		for (; listIndex > 0 && activePartials[listIndex - 1] > partialIndex; listIndex--) {
+			activePartials[listIndex] = activePartials[listIndex - 1];
+		}
+		activePartials[listIndex] = partialIndex;
 		return partial;
 	}
 	synth->printDebug("PartialManager Error: No inactive partials to allocate for part %d, current partial state:\n", partNum);
@@ -107,9 +132,10 @@ unsigned int PartialManager::getFreePartialCount() {
 // This function is solely used to gather data for debug output at the moment.
 void PartialManager::getPerPartPartialUsage(unsigned int perPartPartialUsage[9]) {
 	memset(perPartPartialUsage, 0, 9 * sizeof(unsigned int));
-	for (unsigned int i = 0; i < synth->getPartialCount(); i++) {
-		if (partialTable[i]->isActive()) {
-			perPartPartialUsage[partialTable[i]->getOwnerPart()]++;
+	for (Bit32u listIndex = 0; listIndex < activePartialCount; listIndex++) {
+		const Partial *partial = partialTable[activePartials[listIndex]];
+		if (partial->isActive()) {
+			perPartPartialUsage[partial->getOwnerPart()]++;
 		}
 	}
 }
@@ -118,7 +144,7 @@ void PartialManager::getPerPartPartialUsage(unsigned int perPartPartialUsage[9])
 // in POLY_Releasing, then kills its first releasing poly.
 // Parts with higher priority than minPart are not checked.
 // Assumes that getFreePartials() has been called to make numReservedPartialsForPart up-to-date.
-bool PartialManager::abortFirstReleasingPolyWhereReserveExceeded(int minPart) {
+bool PartialManager::abortFirstReleasingPolyWhereReserveExceeded(int minPart, int requestingPartNum) {
 	if (minPart == 8) {
 		// Rhythm is highest priority
 		minPart = -1;
@@ -129,6 +155,7 @@ bool PartialManager::abortFirstReleasingPolyWhereReserveExceeded(int minPart) {
 			// This part has exceeded its reserved partial count.
 			// If it has any releasing polys, kill its first one and we're done.
 			if (parts[usePartNum]->abortFirstPoly(POLY_Releasing)) {
+				synth->countAbortedPoly(POLY_ABORT_RELEASING, usePartNum, requestingPartNum);
 				return true;
 			}
 		}
@@ -140,7 +167,7 @@ bool PartialManager::abortFirstReleasingPolyWhereReserveExceeded(int minPart) {
 // its first poly in POLY_Held - or failing that, its first poly in any state.
 // Parts with higher priority than minPart are not checked.
 // Assumes that getFreePartials() has been called to make numReservedPartialsForPart up-to-date.
-bool PartialManager::abortFirstPolyPreferHeldWhereReserveExceeded(int minPart) {
+bool PartialManager::abortFirstPolyPreferHeldWhereReserveExceeded(int minPart, int requestingPartNum) {
 	if (minPart == 8) {
 		// Rhythm is highest priority
 		minPart = -1;
@@ -151,6 +178,7 @@ bool PartialManager::abortFirstPolyPreferHeldWhereReserveExceeded(int minPart) {
 			// This part has exceeded its reserved partial count.
 			// If it has any polys, kill its first (preferably held) one and we're done.
 			if (parts[usePartNum]->abortFirstPolyPreferHeld()) {
+				synth->countAbortedPoly(POLY_ABORT_RESERVE_EXCEEDED, usePartNum, requestingPartNum);
 				return true;
 			}
 		}
@@ -193,12 +221,12 @@ bool PartialManager::freePartials(unsigned int needed, int partNum) {
 	for (;;) {
 #ifdef MT32EMU_QUIRK_FREE_PARTIALS_MT32
 		// Abort releasing polys in parts that have exceeded their partial reservation (working backwards from part 7, with rhythm last)
-		if (!abortFirstReleasingPolyWhereReserveExceeded(-1)) {
+		if (!abortFirstReleasingPolyWhereReserveExceeded(-1, partNum)) {
 			break;
 		}
 #else
 		// Abort releasing polys in non-rhythm parts that have exceeded their partial reservation (working backwards from part 7)
-		if (!abortFirstReleasingPolyWhereReserveExceeded(0)) {
+		if (!abortFirstReleasingPolyWhereReserveExceeded(0, partNum)) {
 			break;
 		}
 #endif
@@ -216,7 +244,7 @@ bool PartialManager::freePartials(unsigned int needed, int partNum) {
 		// Only abort held polys in the target part and parts that have a lower priority
 		// (higher part number = lower priority, except for rhythm, which has the highest priority).
 		for (;;) {
-			if (!abortFirstPolyPreferHeldWhereReserveExceeded(partNum)) {
+			if (!abortFirstPolyPreferHeldWhereReserveExceeded(partNum, partNum)) {
 				break;
 			}
 			if (synth->isAbortingPoly() || getFreePartialCount() >= needed) {
@@ -232,7 +260,7 @@ bool PartialManager::freePartials(unsigned int needed, int partNum) {
 		// reserve, and abort their polys until until we have enough free partials or they're within
 		// their reserve allocation.
 		for (;;) {
-			if (!abortFirstPolyPreferHeldWhereReserveExceeded(-1)) {
+			if (!abortFirstPolyPreferHeldWhereReserveExceeded(-1, partNum)) {
 				break;
 			}
 			if (synth->isAbortingPoly() || getFreePartialCount() >= needed) {
@@ -246,6 +274,7 @@ bool PartialManager::freePartials(unsigned int needed, int partNum) {
 		if (!parts[partNum]->abortFirstPolyPreferHeld()) {
 			break;
 		}
+		synth->countAbortedPoly(POLY_ABORT_OWN_PART, partNum, partNum);
 		if (synth->isAbortingPoly() || getFreePartialCount() >= needed) {
 			return true;
 		}
@@ -295,6 +324,7 @@ void PartialManager::polyFreed(Poly *poly) {
 void PartialManager::partialDeactivated(int partialIndex) {
 	if (inactivePartialCount < synth->getPartialCount()) {
 		inactivePartials[inactivePartialCount++] = partialIndex;
+		hasDeactivatedPartials = true;
 		return;
 	}
 	synth->printDebug("PartialManager Error: Cannot return deactivated partial %d, current partial state:\n", partialIndex);
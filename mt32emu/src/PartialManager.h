@@ -39,9 +39,14 @@ private:
 	Bit32u firstFreePolyIndex;
 	int *inactivePartials; // Holds indices of inactive Partials in the Partial table
 	Bit32u inactivePartialCount;
+	// Holds indices of active Partials in ascending order, so that they are mixed in the same order as the Partial table.
+	// Partials deactivated while rendering are only removed in compactActivePartials(), to keep the list stable for iteration.
+	int *activePartials;
+	Bit32u activePartialCount;
+	bool hasDeactivatedPartials;
 
-	bool abortFirstReleasingPolyWhereReserveExceeded(int minPart);
-	bool abortFirstPolyPreferHeldWhereReserveExceeded(int minPart);
+	bool abortFirstReleasingPolyWhereReserveExceeded(int minPart, int requestingPartNum);
+	bool abortFirstPolyPreferHeldWhereReserveExceeded(int minPart, int requestingPartNum);
 
 public:
 	PartialManager(Synth *synth, Part **parts);
@@ -55,7 +60,12 @@ public:
 	bool produceOutput(int i, IntSample *leftBuf, IntSample *rightBuf, Bit32u bufferLength);
 	bool produceOutput(int i, FloatSample *leftBuf, FloatSample *rightBuf, Bit32u bufferLength);
 	bool shouldReverb(int i);
-	void clearAlreadyOutputed();
+	// Removes the partials deactivated since the last call from the active partial list. Called by the renderer after each pass.
+	void compactActivePartials();
+	// The active partial list may also contain partials deactivated since the last call to compactActivePartials().
+	Bit32u getActivePartialCount() const { return activePartialCount; }
+	int getActivePartialIndex(Bit32u listIndex) const { return activePartials[listIndex]; }
+	bool hasActivePartials() const;
 	const Partial *getPartial(unsigned int partialNum) const;
 	Poly *assignPolyToPart(Part *part);
 	void polyFreed(Poly *poly);
@@ -38,6 +38,12 @@ static const ROMInfo *getKnownROMInfoFromList(Bit32u index) {
 	static const ROMInfo PCM_MT32 = {524288, "f6b1eebc4b2d200ec6d3d21d51325d5b48c60252", ROMInfo::PCM, "pcm_mt32", "MT-32 PCM ROM", ROMInfo::Full, NULL};
 	static const ROMInfo PCM_CM32L = {1048576, "289cc298ad532b702461bfc738009d9ebe8025ea", ROMInfo::PCM, "pcm_cm32l", "CM-32L/CM-64/LAPC-I PCM ROM", ROMInfo::Full, NULL};
 
+#if MT32EMU_SYNTHETIC_ROMS
+	// Generated by mt32emu_bench, see bench/SyntheticROMs.cpp.
+	static const ROMInfo CTRL_SYNTHETIC = {65536, "3d1f94ba763e74011a77565685c2469725655bcc", ROMInfo::Control, "ctrl_synthetic", "Synthetic Control ROM (for testing only)", ROMInfo::Full, NULL};
+	static const ROMInfo PCM_SYNTHETIC = {1048576, "cec13b2fcadcf7db9256153b9a3e22f8b2713f78", ROMInfo::PCM, "pcm_synthetic", "Synthetic PCM ROM (for testing only)", ROMInfo::Full, NULL};
+#endif
+
 	static const ROMInfo * const ROM_INFOS[] = {
 		&CTRL_MT32_V1_04,
 		&CTRL_MT32_V1_05,
@@ -49,6 +55,10 @@ static const ROMInfo *getKnownROMInfoFromList(Bit32u index) {
 		&CTRL_CM32L_V1_02,
 		&PCM_MT32,
 		&PCM_CM32L,
+#if MT32EMU_SYNTHETIC_ROMS
+		&CTRL_SYNTHETIC,
+		&PCM_SYNTHETIC,
+#endif
 		NULL};
 
 	return ROM_INFOS[index];
@@ -0,0 +1,295 @@
+/* Copyright (C) 2003, 2004, 2005, 2006, 2008, 2009 Dean Beeler, Jerome Fisher
+ * Copyright (C) 2011-2019 Dean Beeler, Jerome Fisher, Sergey V. Mikayev
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License as published by
+ *  the Free Software Foundation, either version 2.1 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <cmath>
+#include <cstddef>
+#include <cstring>
+
+#if defined _WIN32 || defined __CYGWIN__
+#include <windows.h>
+#define MT32EMU_RENDER_THREAD_WIN32 1
+#else
+#include <pthread.h>
+#include <sched.h>
+#include <time.h>
+#define MT32EMU_RENDER_THREAD_WIN32 0
+#endif
+
+#include "internals.h"
+
+#include "RenderThread.h"
+#include "DSPKernels.h"
+#include "MemoryFences.h"
+#include "SampleRateConverter.h"
+#include "Synth.h"
+
+namespace MT32Emu {
+
+static Bit32u getRingBufferSize(Bit32u minFrames) {
+	Bit32u ringBufferSize = 1;
+	while (ringBufferSize < minFrames) ringBufferSize <<= 1;
+	return ringBufferSize;
+}
+
+// Lets the platform-specific thread entry points reach the private RenderThread::run().
+class RenderThreadRunner {
+public:
+	static void run(void *renderThread) {
+		static_cast<RenderThread *>(renderThread)->run();
+	}
+};
+
+#if MT32EMU_RENDER_THREAD_WIN32
+
+static DWORD WINAPI renderThreadProc(LPVOID renderThread) {
+	RenderThreadRunner::run(renderThread);
+	return 0;
+}
+
+static void *startThread(RenderThread *renderThread) {
+	HANDLE handle = CreateThread(NULL, 0, renderThreadProc, renderThread, 0, NULL);
+	if (handle == NULL) return NULL;
+	SetThreadPriority(handle, THREAD_PRIORITY_TIME_CRITICAL);
+	return new HANDLE(handle);
+}
+
+static void joinThread(void *thread) {
+	HANDLE *handle = static_cast<HANDLE *>(thread);
+	WaitForSingleObject(*handle, INFINITE);
+	CloseHandle(*handle);
+	delete handle;
+}
+
+static void sleepMillis(Bit32u millis) {
+	Sleep(millis);
+}
+
+#else // #if MT32EMU_RENDER_THREAD_WIN32
+
+extern "C" {
+static void *renderThreadProc(void *renderThread) {
+	RenderThreadRunner::run(renderThread);
+	return NULL;
+}
+}
+
+static void *startThread(RenderThread *renderThread) {
+	pthread_t *handle = new pthread_t;
+	if (pthread_create(handle, NULL, renderThreadProc, renderThread) != 0) {
+		delete handle;
+		return NULL;
+	}
+	// Similarly to the Windows variant, try to raise the priority above all the normal threads. The lowest real-time priority
+	// suffices for that. Unprivileged processes normally aren't allowed to do so, then the thread keeps the default priority.
+	sched_param param;
+	param.sched_priority = sched_get_priority_min(SCHED_FIFO);
+	pthread_setschedparam(*handle, SCHED_FIFO, &param);
+	return handle;
+}
+
+static void joinThread(void *thread) {
+	pthread_t *handle = static_cast<pthread_t *>(thread);
+	pthread_join(*handle, NULL);
+	delete handle;
+}
+
+static void sleepMillis(Bit32u millis) {
+	timespec delay;
+	delay.tv_sec = millis / 1000;
+	delay.tv_nsec = long(millis % 1000) * 1000000;
+	nanosleep(&delay, NULL);
+}
+
+#endif // #if MT32EMU_RENDER_THREAD_WIN32
+
+static void *createRingBuffer(RendererType outputSampleType, Bit32u frames) {
+	if (outputSampleType == RendererType_FLOAT) return new float[frames << 1];
+	return new Bit16s[frames << 1];
+}
+
+static void copySamples(const Bit16s *inBuffer, Bit16s *outBuffer, Bit32u len) {
+	memcpy(outBuffer, inBuffer, len * sizeof(Bit16s));
+}
+
+static void copySamples(const float *inBuffer, float *outBuffer, Bit32u len) {
+	memcpy(outBuffer, inBuffer, len * sizeof(float));
+}
+
+static void copySamples(const Bit16s *inBuffer, float *outBuffer, Bit32u len) {
+	getDSPKernels().convertIntToFloat(inBuffer, outBuffer, len);
+}
+
+static void copySamples(const float *inBuffer, Bit16s *outBuffer, Bit32u len) {
+	getDSPKernels().convertFloatToInt(inBuffer, outBuffer, len);
+}
+
+// Copies the specified number of frames starting at position from the ring buffer, which may wrap around.
+template <class RingSample, class Sample>
+static void copyFrames(const RingSample *ringBuffer, Bit32u ringBufferMask, Bit32u position, Sample *buffer, Bit32u frames) {
+	Bit32u startIx = position & ringBufferMask;
+	Bit32u firstChunkFrames = frames;
+	if (startIx + firstChunkFrames > ringBufferMask + 1) {
+		firstChunkFrames = ringBufferMask + 1 - startIx;
+	}
+	copySamples(ringBuffer + (startIx << 1), buffer, firstChunkFrames << 1);
+	copySamples(ringBuffer, buffer + (firstChunkFrames << 1), (frames - firstChunkFrames) << 1);
+}
+
+static double getOutputToSynthSampleRatio(const Synth &synth, const SampleRateConverter *converter) {
+	if (converter != NULL) return converter->convertOutputToSynthTimestamp(1.0);
+	return double(SAMPLE_RATE) / synth.getStereoOutputSampleRate();
+}
+
+RenderThread::RenderThread(Synth &useSynth, SampleRateConverter *useConverter, RendererType useOutputSampleType,
+	Bit32u useRenderAheadFrames, Bit32u useBlockFrames) :
+	synth(useSynth),
+	converter(useConverter),
+	outputSampleType(useOutputSampleType),
+	renderAheadFrames(useRenderAheadFrames),
+	blockFrames(useBlockFrames > 0 ? useBlockFrames : 1),
+	ringBufferMask(getRingBufferSize(renderAheadFrames + blockFrames) - 1),
+	ringBuffer(createRingBuffer(useOutputSampleType, ringBufferMask + 1)),
+	outputToSynthSampleRatio(getOutputToSynthSampleRatio(useSynth, useConverter)),
+	// In the worst case, the ring buffer holds almost a whole block in excess of renderAheadFrames.
+	midiLatency(Bit32u(ceil((renderAheadFrames + blockFrames) * outputToSynthSampleRatio))),
+	readPosition(0),
+	writePosition(0),
+	underrunCount(0),
+	readSynthTimestamp(useSynth.getInternalRenderedSampleCount()),
+	stopRequested(false),
+	readSynthPosition(0.0),
+	startSynthTimestamp(useSynth.getInternalRenderedSampleCount()),
+	thread(NULL)
+{}
+
+RenderThread::~RenderThread() {
+	stop();
+	if (outputSampleType == RendererType_FLOAT) {
+		delete[] static_cast<float *>(ringBuffer);
+	} else {
+		delete[] static_cast<Bit16s *>(ringBuffer);
+	}
+}
+
+bool RenderThread::start() {
+	if (thread != NULL) return true;
+	stopRequested = false;
+	thread = startThread(this);
+	return thread != NULL;
+}
+
+void RenderThread::stop() {
+	if (thread == NULL) return;
+	stopRequested = true;
+	joinThread(thread);
+	thread = NULL;
+}
+
+bool RenderThread::isRunning() const {
+	return thread != NULL;
+}
+
+template <class Sample>
+void RenderThread::renderFrames(Sample *buffer, Bit32u length) {
+	if (converter != NULL) {
+		converter->getOutputSamples(buffer, length);
+	} else {
+		synth.render(buffer, length);
+	}
+}
+
+void RenderThread::run() {
+	// Polling is used instead of waiting on a signal so that read() never needs to acquire a lock.
+	Bit32u pollIntervalMillis = Bit32u(250.0 * blockFrames * outputToSynthSampleRatio / SAMPLE_RATE);
+	if (pollIntervalMillis == 0) pollIntervalMillis = 1;
+	while (!stopRequested) {
+		// The ring buffer is large enough to fit one more block while there are fewer than renderAheadFrames buffered.
+		if (renderAheadFrames <= writePosition - readPosition) {
+			sleepMillis(pollIntervalMillis);
+			continue;
+		}
+		// The frames released by read() must be completely copied out before they are overwritten.
+		acquireFence();
+		Bit32u startIx = writePosition & ringBufferMask;
+		Bit32u framesToRender = blockFrames;
+		if (startIx + framesToRender > ringBufferMask + 1) {
+			framesToRender = ringBufferMask + 1 - startIx;
+		}
+		if (outputSampleType == RendererType_FLOAT) {
+			renderFrames(static_cast<float *>(ringBuffer) + (startIx << 1), framesToRender);
+		} else {
+			renderFrames(static_cast<Bit16s *>(ringBuffer) + (startIx << 1), framesToRender);
+		}
+		// The rendered frames must be complete before read() can see them.
+		releaseFence();
+		writePosition += framesToRender;
+	}
+}
+
+template <class Sample>
+Bit32u RenderThread::readRingBuffer(Sample *buffer, Bit32u length) {
+	Bit32u availableFrames = writePosition - readPosition;
+	acquireFence();
+	Bit32u framesToRead = length < availableFrames ? length : availableFrames;
+	if (outputSampleType == RendererType_FLOAT) {
+		copyFrames(static_cast<const float *>(ringBuffer), ringBufferMask, readPosition, buffer, framesToRead);
+	} else {
+		copyFrames(static_cast<const Bit16s *>(ringBuffer), ringBufferMask, readPosition, buffer, framesToRead);
+	}
+	releaseFence();
+	readPosition += framesToRead;
+	if (framesToRead < length) {
+		// The frames rendered meanwhile are left for the next call, so the shortfall is a single gap at the end.
+		Synth::muteSampleBuffer(buffer + (framesToRead << 1), (length - framesToRead) << 1);
+		underrunCount++;
+	}
+
+	// Only the frames actually rendered by the synth advance the timeline, thus keeping MIDI timestamps consistent.
+	readSynthPosition += framesToRead * outputToSynthSampleRatio;
+	readSynthTimestamp = startSynthTimestamp + Bit32u(fmod(readSynthPosition, 4294967296.0));
+	return framesToRead;
+}
+
+Bit32u RenderThread::read(Bit16s *buffer, Bit32u length) {
+	return readRingBuffer(buffer, length);
+}
+
+Bit32u RenderThread::read(float *buffer, Bit32u length) {
+	return readRingBuffer(buffer, length);
+}
+
+Bit32u RenderThread::getAvailableFrameCount() const {
+	return writePosition - readPosition;
+}
+
+Bit32u RenderThread::getUnderrunCount() const {
+	return underrunCount;
+}
+
+Bit32u RenderThread::getMIDITimestamp() const {
+	return readSynthTimestamp + midiLatency;
+}
+
+bool RenderThread::playMsg(Bit32u msg) {
+	return synth.playMsg(msg, getMIDITimestamp());
+}
+
+bool RenderThread::playSysex(const Bit8u *sysex, Bit32u len) {
+	return synth.playSysex(sysex, len, getMIDITimestamp());
+}
+
+} // namespace MT32Emu
@@ -0,0 +1,116 @@
+/* Copyright (C) 2003, 2004, 2005, 2006, 2008, 2009 Dean Beeler, Jerome Fisher
+ * Copyright (C) 2011-2019 Dean Beeler, Jerome Fisher, Sergey V. Mikayev
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License as published by
+ *  the Free Software Foundation, either version 2.1 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef MT32EMU_RENDER_THREAD_H
+#define MT32EMU_RENDER_THREAD_H
+
+#include "globals.h"
+#include "Types.h"
+#include "Enumerations.h"
+
+namespace MT32Emu {
+
+class Synth;
+class SampleRateConverter;
+
+/* RenderThread class runs rendering of the synthesiser output on a dedicated thread. The output is rendered ahead
+ * by a configurable number of frames into a lock-free ring buffer, which the client retrieves using a non-blocking call.
+ * This allows to feed fragile audio callbacks that may not tolerate occasional heavy rendering blocks.
+ * The rendering thread runs with the time-critical priority on Windows. Elsewhere, it attempts to use the SCHED_FIFO
+ * real-time scheduling policy, which commonly requires privileges, and keeps the default priority if that fails.
+ * THREAD SAFETY:
+ * Method read() is intended to be invoked from a single thread, typically the one that runs the audio callback.
+ * Methods playMsg() and playSysex() enqueue MIDI events into the synth's MIDI event queue, so the same considerations
+ * apply as for the timestamped methods of Synth. Besides, once the rendering thread is started, the synth must not be
+ * reconfigured other than via the methods that need no synchronisation with the rendering thread (such as the timestamped
+ * variants of setOutputGain()) until the rendering thread is stopped.
+ */
+class MT32EMU_EXPORT RenderThread {
+public:
+	// Creates a RenderThread instance that renders stereo output of the synth which must be open.
+	// When converter is not NULL, the output is retrieved via SampleRateConverter, otherwise at the synth output sample rate.
+	// The output is buffered in the sample format specified by outputSampleType, so that the variant of read()
+	// for the same format retrieves the frames with no conversion. RendererType_BIT16S stands for Bit16s samples here,
+	// and RendererType_FLOAT for float samples.
+	// The rendering thread keeps at least renderAheadFrames frames buffered by rendering blocks of blockFrames frames.
+	RenderThread(Synth &synth, SampleRateConverter *converter, RendererType outputSampleType, Bit32u renderAheadFrames, Bit32u blockFrames = 256);
+	// Stops the rendering thread if running.
+	~RenderThread();
+
+	// Starts the rendering thread. Returns false if the thread could not be started.
+	bool start();
+	// Stops the rendering thread and waits until it exits. The rendered frames that aren't yet retrieved are kept.
+	void stop();
+	// Returns true if the rendering thread is running.
+	bool isRunning() const;
+
+	// Fills the provided buffer with the rendered frames, never blocks. The length is in frames.
+	// If there aren't enough frames rendered so far, the rest of the buffer is filled with silence.
+	// Returns the number of frames actually retrieved from the ring buffer.
+	// The samples are converted on the fly if the buffered output is in the float format.
+	Bit32u read(Bit16s *buffer, Bit32u length);
+	// Same as above but outputs to a float stereo stream.
+	// The samples are converted on the fly if the buffered output is in the Bit16s format.
+	Bit32u read(float *buffer, Bit32u length);
+
+	// Returns the number of rendered frames that can be retrieved immediately.
+	Bit32u getAvailableFrameCount() const;
+	// Returns the number of calls to read() that could not be fully satisfied since the rendering thread was created.
+	Bit32u getUnderrunCount() const;
+
+	// Returns the timestamp to use with the timestamped MIDI methods of Synth for an event received right now.
+	// The timestamp corresponds to the position of the frames being currently retrieved with read() shifted by
+	// the constant latency of the ring buffer, so that the MIDI events are rendered with no jitter.
+	Bit32u getMIDITimestamp() const;
+	// Enqueues a single short MIDI message to play with the timestamp returned by getMIDITimestamp().
+	bool playMsg(Bit32u msg);
+	// Enqueues a single well formed System Exclusive MIDI message to play with the timestamp returned by getMIDITimestamp().
+	bool playSysex(const Bit8u *sysex, Bit32u len);
+
+private:
+friend class RenderThreadRunner;
+
+	Synth &synth;
+	SampleRateConverter * const converter;
+	const RendererType outputSampleType;
+	const Bit32u renderAheadFrames;
+	const Bit32u blockFrames;
+	const Bit32u ringBufferMask;
+	// Holds either Bit16s or float samples, according to outputSampleType.
+	void * const ringBuffer;
+	const double outputToSynthSampleRatio;
+	const Bit32u midiLatency;
+	volatile Bit32u readPosition;
+	volatile Bit32u writePosition;
+	volatile Bit32u underrunCount;
+	volatile Bit32u readSynthTimestamp;
+	volatile bool stopRequested;
+	double readSynthPosition;
+	Bit32u startSynthTimestamp;
+	void *thread;
+
+	// Entry point of the rendering thread.
+	void run();
+	template <class Sample>
+	void renderFrames(Sample *buffer, Bit32u length);
+	template <class Sample>
+	Bit32u readRingBuffer(Sample *buffer, Bit32u length);
+}; // class RenderThread
+
+} // namespace MT32Emu
+
+#endif // #ifndef MT32EMU_RENDER_THREAD_H
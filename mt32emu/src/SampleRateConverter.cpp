@@ -26,6 +26,7 @@
 #include "srchelper/InternalResampler.h"
 #endif
 
+#include "DSPKernels.h"
 #include "Synth.h"
 
 using namespace MT32Emu;
@@ -108,11 +109,8 @@ void SampleRateConverter::getOutputSamples(Bit16s *outBuffer, unsigned int lengt
 	while (length > 0) {
 		const unsigned int size = MAX_SAMPLES_PER_RUN < length ? MAX_SAMPLES_PER_RUN : length;
 		getOutputSamples(floatBuffer, size);
-		float *outs = floatBuffer;
-		float *ends = floatBuffer + CHANNEL_COUNT * size;
-		while (outs < ends) {
-			*(outBuffer++) = Synth::convertSample(*(outs++));
-		}
+		getDSPKernels().convertFloatToInt(floatBuffer, outBuffer, CHANNEL_COUNT * size);
+		outBuffer += CHANNEL_COUNT * size;
 		length -= size;
 	}
 }
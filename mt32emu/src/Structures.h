@@ -252,7 +252,6 @@ struct PatchCache {
 	bool dirty;
 	Bit32u partialCount;
 	bool sustain;
-	bool reverb;
 
 	TimbreParam::PartialParam srcPartial;
 
@@ -260,6 +259,11 @@ struct PatchCache {
 	const TimbreParam::PartialParam *partialParam;
 };
 
+// The PatchCache entries derived from the timbres are shared by all the parts, see Synth::getTimbreCache().
+// The entries of the timbre memory come first, followed by those of the timbre temp area of each melodic part.
+const unsigned int TIMBRE_CACHE_TIMBRE_TEMP_START = 64 + 64 + 64 + 64;
+const unsigned int TIMBRE_CACHE_SIZE = TIMBRE_CACHE_TIMBRE_TEMP_START + 8;
+
 } // namespace MT32Emu
 
 #endif // #ifndef MT32EMU_STRUCTURES_H
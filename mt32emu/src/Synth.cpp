@@ -22,9 +22,14 @@
 #include "Synth.h"
 #include "Analog.h"
 #include "BReverbModel.h"
+#include "Clock.h"
+#include "DeferredReportHandler.h"
+#include "DSPKernels.h"
 #include "File.h"
+#include "MemoryFences.h"
 #include "MemoryRegion.h"
 #include "MidiEventQueue.h"
+#include "NoteRenderCache.h"
 #include "Part.h"
 #include "Partial.h"
 #include "PartialManager.h"
@@ -41,6 +46,19 @@ namespace MT32Emu {
 // MIDI interface data transfer rate in samples. Used to simulate the transfer delay.
 static const double MIDI_DATA_TRANSFER_RATE = double(SAMPLE_RATE) / 31250.0 * 8.0;
 
+// Size of the queue which holds timestamped changes of the rendering controls. Must be a power of 2.
+static const Bit32u CONTROL_EVENT_QUEUE_SIZE = 256;
+
+// Number of the most recent trace events kept in the trace buffer. Must be a power of 2.
+static const Bit32u TRACE_BUFFER_SIZE = 8192;
+
+// Upper bound of the first bucket of the partial lifetime histogram in samples (20 ms), the following buckets are twice as wide.
+static const Bit32u POLYPHONY_HISTOGRAM_BASE_LIFETIME = SAMPLE_RATE / 100;
+static const Bit32u POLYPHONY_HISTOGRAM_BUCKET_COUNT = 12; // Must match the size of PolyphonyStatistics::partialLifetimeHistogram
+// Minimum number of samples rendered between publications of the polyphony statistics, so that tiny rendered blocks
+// don't pay for copying the whole structure each time.
+static const Bit32u POLYPHONY_PUBLISHING_INTERVAL = SAMPLE_RATE / 125;
+
 // FIXME: there should be more specific feature sets for various MT-32 control ROM versions
 static const ControlROMFeatureSet OLD_MT32_COMPATIBLE = {
 	true, // quirkBasePitchOverflow
@@ -65,7 +83,7 @@ static const ControlROMFeatureSet CM32L_COMPATIBLE = {
 	false // oldMT32AnalogLPF
 };
 
-static const ControlROMMap ControlROMMaps[8] = {
+static const ControlROMMap ControlROMMaps[] = {
 	//     ID                Features        PCMmap  PCMc  tmbrA  tmbrAO, tmbrAC tmbrB   tmbrBO  tmbrBC tmbrR   trC rhythm rhyC  rsrv   panpot   prog   rhyMax  patMax  sysMax  timMax  sndGrp sGC
 	{ "ctrl_mt32_1_04", OLD_MT32_COMPATIBLE, 0x3000, 128, 0x8000, 0x0000, false, 0xC000, 0x4000, false, 0x3200, 30, 0x73A6, 85, 0x57C7, 0x57E2, 0x57D0, 0x5252, 0x525E, 0x526E, 0x520A, 0x7064, 19 },
 	{ "ctrl_mt32_1_05", OLD_MT32_COMPATIBLE, 0x3000, 128, 0x8000, 0x0000, false, 0xC000, 0x4000, false, 0x3200, 30, 0x7414, 85, 0x57C7, 0x57E2, 0x57D0, 0x5252, 0x525E, 0x526E, 0x520A, 0x70CA, 19 },
@@ -74,7 +92,10 @@ static const ControlROMMap ControlROMMaps[8] = {
 	{"ctrl_mt32_bluer", OLD_MT32_COMPATIBLE, 0x3000, 128, 0x8000, 0x0000, false, 0xC000, 0x4000, false, 0x3200, 30, 0x741C, 85, 0x57E5, 0x5800, 0x57EE, 0x5270, 0x527C, 0x528C, 0x5228, 0x70CE, 19 }, // MT-32 Blue Ridge mod
 	{"ctrl_mt32_2_04",   CM32L_COMPATIBLE,   0x8100, 128, 0x8000, 0x8000, true,  0x8080, 0x8000, true,  0x8500, 30, 0x8580, 85, 0x4F5D, 0x4F78, 0x4F66, 0x4899, 0x489D, 0x48B6, 0x48CD, 0x5A58, 19 },
 	{"ctrl_cm32l_1_00",  CM32L_COMPATIBLE,   0x8100, 256, 0x8000, 0x8000, true,  0x8080, 0x8000, true,  0x8500, 64, 0x8580, 85, 0x4F65, 0x4F80, 0x4F6E, 0x48A1, 0x48A5, 0x48BE, 0x48D5, 0x5A6C, 19 },
-	{"ctrl_cm32l_1_02",  CM32L_COMPATIBLE,   0x8100, 256, 0x8000, 0x8000, true,  0x8080, 0x8000, true,  0x8500, 64, 0x8580, 85, 0x4F93, 0x4FAE, 0x4F9C, 0x48CB, 0x48CF, 0x48E8, 0x48FF, 0x5A96, 19 }  // CM-32L
+	{"ctrl_cm32l_1_02",  CM32L_COMPATIBLE,   0x8100, 256, 0x8000, 0x8000, true,  0x8080, 0x8000, true,  0x8500, 64, 0x8580, 85, 0x4F93, 0x4FAE, 0x4F9C, 0x48CB, 0x48CF, 0x48E8, 0x48FF, 0x5A96, 19 }, // CM-32L
+#if MT32EMU_SYNTHETIC_ROMS
+	{"ctrl_synthetic",   CM32L_COMPATIBLE,   0x0100, 256, 0x0500, 0x0000, true,  0x0580, 0x0000, true,  0x0600, 64, 0x0700, 85, 0x0860, 0x0870, 0x0880, 0x0890, 0x08A0, 0x08B0, 0x08D0, 0x0A80, 8 }   // Synthetic ROM for testing, see bench/SyntheticROMs.cpp
+#endif
 	// (Note that old MT-32 ROMs actually have 86 entries for rhythmTemp)
 };
 
@@ -98,6 +119,18 @@ static inline void convertSampleFormat(const I *inBuffer, O *outBuffer, const Bi
 	}
 }
 
+static inline void convertSampleFormat(const FloatSample *inBuffer, IntSample *outBuffer, const Bit32u len) {
+	if (inBuffer == NULL || outBuffer == NULL) return;
+	getDSPKernels().convertFloatToInt(inBuffer, outBuffer, len);
+}
+
+static inline void convertSampleFormat(const IntSample *inBuffer, FloatSample *outBuffer, const Bit32u len) {
+	if (inBuffer == NULL || outBuffer == NULL) return;
+	getDSPKernels().convertIntToFloat(inBuffer, outBuffer, len);
+}
+
+class RenderStatisticsCollector;
+
 class Renderer {
 protected:
 	Synth &synth;
@@ -122,6 +155,19 @@ protected:
 		return *synth.midiQueue;
 	}
 
+	// Applies all the enqueued control events which are due and returns the number of samples to the next one.
+	Bit32u applyDueControlEvents();
+
+	// Returns true if the next MIDI event is a controller message that is superseded within the same control tick
+	// and can be dropped, provided that controller coalescing is enabled.
+	bool isNextMidiEventSuperseded();
+
+	RenderStatisticsCollector &getRenderStatistics();
+
+	void recordTraceEvent(TraceEventType type, Bit32u data1, Bit32u data2) {
+		synth.recordTraceEvent(type, data1, data2);
+	}
+
 	PartialManager &getPartialManager() {
 		return *synth.partialManager;
 	}
@@ -138,6 +184,14 @@ protected:
 		synth.renderedSampleCount += count;
 	}
 
+	void deferRefreshes() {
+		synth.deferRefreshes();
+	}
+
+	void applyDeferredRefreshes() {
+		synth.applyDeferredRefreshes();
+	}
+
 public:
 	Renderer(Synth &useSynth) : synth(useSynth) {}
 
@@ -147,6 +201,8 @@ public:
 	virtual void render(FloatSample *stereoStream, Bit32u len) = 0;
 	virtual void renderStreams(const DACOutputStreams<IntSample> &streams, Bit32u len) = 0;
 	virtual void renderStreams(const DACOutputStreams<FloatSample> &streams, Bit32u len) = 0;
+	virtual void renderPartStreams(const PartOutputStreams<IntSample> &streams, Bit32u len) = 0;
+	virtual void renderPartStreams(const PartOutputStreams<FloatSample> &streams, Bit32u len) = 0;
 };
 
 template <class Sample>
@@ -156,6 +212,12 @@ class RendererImpl : public Renderer {
 	Sample tmpNonReverbLeft[MAX_SAMPLES_PER_RUN], tmpNonReverbRight[MAX_SAMPLES_PER_RUN];
 	Sample tmpReverbDryLeft[MAX_SAMPLES_PER_RUN], tmpReverbDryRight[MAX_SAMPLES_PER_RUN];
 	Sample tmpReverbWetLeft[MAX_SAMPLES_PER_RUN], tmpReverbWetRight[MAX_SAMPLES_PER_RUN];
+	// Holds the stereo output to be converted to the requested sample format. Like the buffers above, it is not allocated
+	// on the stack, as large stack frames may require probing of each page upon every call, even when rendering tiny blocks.
+	Sample tmpStereoBuffer[MAX_SAMPLES_PER_RUN << 1];
+	// Part streams to be converted to the requested sample format, 18 buffers of MAX_SAMPLES_PER_RUN samples.
+	// As these are rarely needed, they are only allocated upon the first use.
+	Sample *tmpPartBuffers;
 
 	const DACOutputStreams<Sample> tmpBuffers;
 	DACOutputStreams<Sample> createTmpBuffers() {
@@ -170,13 +232,20 @@ class RendererImpl : public Renderer {
 public:
 	RendererImpl(Synth &useSynth) :
 		Renderer(useSynth),
+		tmpPartBuffers(NULL),
 		tmpBuffers(createTmpBuffers())
 	{}
 
+	~RendererImpl() {
+		delete[] tmpPartBuffers;
+	}
+
 	void render(IntSample *stereoStream, Bit32u len);
 	void render(FloatSample *stereoStream, Bit32u len);
 	void renderStreams(const DACOutputStreams<IntSample> &streams, Bit32u len);
 	void renderStreams(const DACOutputStreams<FloatSample> &streams, Bit32u len);
+	void renderPartStreams(const PartOutputStreams<IntSample> &streams, Bit32u len);
+	void renderPartStreams(const PartOutputStreams<FloatSample> &streams, Bit32u len);
 
 	template <class O>
 	void doRenderAndConvert(O *stereoStream, Bit32u len);
@@ -184,10 +253,492 @@ public:
 
 	template <class O>
 	void doRenderAndConvertStreams(const DACOutputStreams<O> &streams, Bit32u len);
-	void doRenderStreams(const DACOutputStreams<Sample> &streams, Bit32u len);
+	template <class O>
+	void doRenderAndConvertPartStreams(const PartOutputStreams<O> &streams, Bit32u len);
+	template <class Streams>
+	void doRenderStreams(const Streams &streams, Bit32u len);
 	void produceLA32Output(Sample *buffer, Bit32u len);
 	void convertSamplesToOutput(Sample *buffer, Bit32u len);
-	void produceStreams(const DACOutputStreams<Sample> &streams, Bit32u len);
+	Bit32u produceStreams(const DACOutputStreams<Sample> &streams, Bit32u len);
+	Bit32u produceStreams(const PartOutputStreams<Sample> &streams, Bit32u len);
+	Bit32u producePartialOutput(Sample *nonReverbLeft, Sample *nonReverbRight, Sample *reverbDryLeft, Sample *reverbDryRight, Bit32u len);
+	Bit32u producePartialOutput(Sample * const partLeft[], Sample * const partRight[], Bit32u len);
+};
+
+// Holds a pair of copies of a structure, one of which is stable and available for readers while the other one is being updated
+// by the rendering thread. The counter of published copies indicates which one is stable and also lets the readers detect
+// an update that has occurred while copying. The readers retry in this case, so reading is lock-free but not wait-free.
+template <class T>
+class PublishingBuffer {
+private:
+	T copies[2];
+	volatile Bit32u publishedCount;
+
+	struct AssigningCopier {
+		void operator()(const T &stableCopy, T &copy) const {
+			copy = stableCopy;
+		}
+	};
+
+public:
+	PublishingBuffer() : publishedCount(0) {}
+
+	void reset() {
+		publishedCount = 0;
+	}
+
+	// Provides access to either copy regardless of which one is stable, intended for initialisation only.
+	T &getCopy(Bit32u index) {
+		return copies[index];
+	}
+
+	T &getUpdatingCopy() {
+		return copies[(publishedCount + 1) & 1];
+	}
+
+	void publish() {
+		// The updated copy must be complete before it is seen as stable, and the writes to the other copy
+		// that follow must not be seen before the readers can tell that it is no longer stable.
+		releaseFence();
+		publishedCount++;
+		releaseFence();
+	}
+
+	bool read(T &copy) const {
+		return read(copy, AssigningCopier());
+	}
+
+	// Same as above, but the copying is done by the provided functor, e.g. when T refers to arrays owned by each copy.
+	template <class Copier>
+	bool read(T &copy, const Copier &copier) const {
+		for (;;) {
+			Bit32u stableCount = publishedCount;
+			if (stableCount == 0) return false;
+			acquireFence();
+			copier(copies[stableCount & 1], copy);
+			// The writer only starts updating the copy we've just made after publishing the other one.
+			acquireFence();
+			if (stableCount == publishedCount) return true;
+		}
+	}
+};
+
+// Copies a stable state snapshot into the one provided by the client, which owns the arrays of partial data.
+class StateSnapshotCopier {
+private:
+	const Bit32u partialCount;
+
+public:
+	StateSnapshotCopier(Bit32u usePartialCount) : partialCount(usePartialCount) {}
+
+	void operator()(const StateSnapshot &stableSnapshot, StateSnapshot &snapshot) const {
+		snapshot.renderedSampleCount = stableSnapshot.renderedSampleCount;
+		snapshot.partStates = stableSnapshot.partStates;
+		memcpy(snapshot.patchNames, stableSnapshot.patchNames, sizeof(snapshot.patchNames));
+		memcpy(snapshot.playingNoteCounts, stableSnapshot.playingNoteCounts, sizeof(snapshot.playingNoteCounts));
+		snapshot.masterVolume = stableSnapshot.masterVolume;
+		snapshot.reverbEnabled = stableSnapshot.reverbEnabled;
+		snapshot.reverbMode = stableSnapshot.reverbMode;
+		snapshot.reverbTime = stableSnapshot.reverbTime;
+		snapshot.reverbLevel = stableSnapshot.reverbLevel;
+		if (snapshot.partialStates != NULL) {
+			memcpy(snapshot.partialStates, stableSnapshot.partialStates, partialCount * sizeof(PartialState));
+		}
+		if (snapshot.keys != NULL) {
+			memcpy(snapshot.keys, stableSnapshot.keys, partialCount);
+		}
+		if (snapshot.velocities != NULL) {
+			memcpy(snapshot.velocities, stableSnapshot.velocities, partialCount);
+		}
+	}
+};
+
+// Publishes the state snapshots via PublishingBuffer and owns the arrays of partial data of both copies.
+class StateSnapshotBuffer {
+private:
+	PublishingBuffer<StateSnapshot> snapshots;
+
+public:
+	StateSnapshotBuffer(Bit32u partialCount) {
+		for (Bit32u i = 0; i < 2; i++) {
+			StateSnapshot &snapshot = snapshots.getCopy(i);
+			snapshot.partialStates = new PartialState[partialCount];
+			snapshot.keys = new Bit8u[partialCount];
+			snapshot.velocities = new Bit8u[partialCount];
+		}
+	}
+
+	~StateSnapshotBuffer() {
+		for (Bit32u i = 0; i < 2; i++) {
+			StateSnapshot &snapshot = snapshots.getCopy(i);
+			delete[] snapshot.partialStates;
+			delete[] snapshot.keys;
+			delete[] snapshot.velocities;
+		}
+	}
+
+	StateSnapshot &getUpdatingSnapshot() {
+		return snapshots.getUpdatingCopy();
+	}
+
+	void publish() {
+		snapshots.publish();
+	}
+
+	bool read(StateSnapshot &snapshot, Bit32u partialCount) const {
+		return snapshots.read(snapshot, StateSnapshotCopier(partialCount));
+	}
+};
+
+// Accumulates the render statistics on the rendering thread and publishes a consistent copy at the end
+// of each rendered block. The enabled state is captured at the start of each block, so that it can be
+// toggled from any thread.
+class RenderStatisticsCollector {
+public:
+	enum Stage {
+		// Includes the reverb stage, as the latter is nested.
+		Stage_PRODUCE_STREAMS,
+		Stage_REVERB,
+		Stage_ANALOG,
+		Stage_MIDI,
+		Stage_COUNT
+	};
+
+private:
+	RenderStatistics accumulated;
+	PublishingBuffer<RenderStatistics> published;
+
+	double stageNanos[Stage_COUNT];
+	double activePartialSum;
+	double blockStartNanos;
+	Bit32u blockStartSampleCount;
+	bool blockTimed;
+
+	double resamplingStartNanos;
+	double resamplingStartTotalNanos;
+	Bit32u resamplingStartResetCount;
+	bool resamplingTimed;
+
+	volatile bool enabled;
+	volatile Bit32u resetRequestCount;
+	Bit32u resetServedCount;
+
+	void clear() {
+		memset(&accumulated, 0, sizeof accumulated);
+		for (int stage = 0; stage < Stage_COUNT; stage++) {
+			stageNanos[stage] = 0;
+		}
+		activePartialSum = 0;
+	}
+
+	void publish() {
+		RenderStatistics &updating = published.getUpdatingCopy();
+		updating = accumulated;
+		updating.partialNanos = stageNanos[Stage_PRODUCE_STREAMS] - stageNanos[Stage_REVERB];
+		updating.reverbNanos = stageNanos[Stage_REVERB];
+		updating.analogNanos = stageNanos[Stage_ANALOG];
+		updating.midiNanos = stageNanos[Stage_MIDI];
+		updating.averageActivePartials = activePartialSum / accumulated.blockCount;
+		published.publish();
+	}
+
+public:
+	RenderStatisticsCollector() : blockTimed(false), resamplingTimed(false), enabled(false), resetRequestCount(0), resetServedCount(0) {
+		clear();
+	}
+
+	// Drops everything accumulated and published. Must be synchronised with the readers and the rendering thread.
+	void reset() {
+		clear();
+		published.reset();
+		resetServedCount = resetRequestCount;
+	}
+
+	void setEnabled(bool newEnabled) {
+		enabled = newEnabled;
+	}
+
+	bool isEnabled() const {
+		return MT32EMU_RENDER_STATISTICS && enabled;
+	}
+
+	void requestReset() {
+		resetRequestCount++;
+	}
+
+	bool isBlockTimed() const {
+		return MT32EMU_RENDER_STATISTICS && blockTimed;
+	}
+
+	void startBlock(Bit32u renderedSampleCount) {
+		blockTimed = isEnabled();
+		if (!isBlockTimed()) return;
+		if (resetServedCount != resetRequestCount) {
+			resetServedCount = resetRequestCount;
+			clear();
+		}
+		blockStartSampleCount = renderedSampleCount;
+		blockStartNanos = Clock::getNanoseconds();
+	}
+
+	void finishBlock(Bit32u renderedSampleCount, Bit32u activePartialCount) {
+		const double blockNanos = Clock::getNanoseconds() - blockStartNanos;
+		const Bit32u blockSampleCount = renderedSampleCount - blockStartSampleCount;
+		accumulated.blockCount++;
+		accumulated.sampleCount += blockSampleCount;
+		accumulated.totalNanos += blockNanos;
+		if (accumulated.worstBlockNanos < blockNanos) {
+			accumulated.worstBlockNanos = blockNanos;
+			accumulated.worstBlockSampleCount = blockSampleCount;
+		}
+		activePartialSum += activePartialCount;
+		if (accumulated.peakActivePartials < activePartialCount) {
+			accumulated.peakActivePartials = activePartialCount;
+		}
+		publish();
+	}
+
+	double startStage() const {
+		return isBlockTimed() ? Clock::getNanoseconds() : 0;
+	}
+
+	void finishStage(Stage stage, double startNanos) {
+		if (isBlockTimed()) {
+			stageNanos[stage] += Clock::getNanoseconds() - startNanos;
+		}
+	}
+
+	void countMidiEvent(bool sysex) {
+		if (!isBlockTimed()) return;
+		if (sysex) {
+			accumulated.sysexMessageCount++;
+		} else {
+			accumulated.midiMessageCount++;
+		}
+	}
+
+	// The resampler pulls the synth output on demand, so the nested rendered blocks are subtracted.
+	// The result is published along with the next rendered block.
+	void startResampling() {
+		resamplingTimed = isEnabled();
+		if (!resamplingTimed) return;
+		resamplingStartResetCount = resetServedCount;
+		resamplingStartTotalNanos = accumulated.totalNanos;
+		resamplingStartNanos = Clock::getNanoseconds();
+	}
+
+	void finishResampling() {
+		if (!resamplingTimed || resamplingStartResetCount != resetServedCount) return;
+		const double renderingNanos = accumulated.totalNanos - resamplingStartTotalNanos;
+		accumulated.resamplerNanos += Clock::getNanoseconds() - resamplingStartNanos - renderingNanos;
+	}
+
+	bool read(RenderStatistics &statistics) const {
+		return published.read(statistics);
+	}
+};
+
+// Gathers the polyphony and partial allocation figures on the rendering thread and publishes them at the end of a rendered block
+// once POLYPHONY_PUBLISHING_INTERVAL samples have been rendered since the previous publication, or once the last active
+// partial is gone, so that the final figures don't wait for the interval which may never elapse if the rendering stops.
+// The counters are cheap enough to be maintained all the time.
+class PolyphonyStatisticsCollector {
+private:
+	PolyphonyStatistics accumulated;
+	PublishingBuffer<PolyphonyStatistics> published;
+
+	double activePartialSum;
+	double partPartialSums[9];
+	Bit32u midiQueueOverflowCountAtReset;
+	Bit32u unpublishedSampleCount;
+	Bit32u lastActivePartialCount;
+
+	volatile Bit32u resetRequestCount;
+	Bit32u resetServedCount;
+
+	void clear() {
+		memset(&accumulated, 0, sizeof accumulated);
+		activePartialSum = 0;
+		for (int partNum = 0; partNum < 9; partNum++) {
+			partPartialSums[partNum] = 0;
+		}
+		// The cleared figures are published with the next block.
+		unpublishedSampleCount = POLYPHONY_PUBLISHING_INTERVAL;
+	}
+
+public:
+	PolyphonyStatisticsCollector() : midiQueueOverflowCountAtReset(0), lastActivePartialCount(0), resetRequestCount(0), resetServedCount(0) {
+		clear();
+	}
+
+	PolyphonyStatistics &getAccumulated() {
+		return accumulated;
+	}
+
+	// Drops everything accumulated and published. Must be synchronised with the readers and the rendering thread.
+	void reset(Bit32u midiQueueOverflowCount) {
+		clear();
+		published.reset();
+		midiQueueOverflowCountAtReset = midiQueueOverflowCount;
+		resetServedCount = resetRequestCount;
+	}
+
+	void requestReset() {
+		resetRequestCount++;
+	}
+
+	// Returns true if a reset request has been served.
+	bool serveResetRequest(Bit32u midiQueueOverflowCount) {
+		if (resetServedCount == resetRequestCount) return false;
+		resetServedCount = resetRequestCount;
+		clear();
+		midiQueueOverflowCountAtReset = midiQueueOverflowCount;
+		return true;
+	}
+
+	void countAbortedPoly(unsigned int reason, bool stolen) {
+		switch (reason) {
+		case POLY_ABORT_SAME_KEY:
+			accumulated.sameKeyAbortCount++;
+			break;
+		case POLY_ABORT_RELEASING:
+			accumulated.releasingAbortCount++;
+			break;
+		case POLY_ABORT_RESERVE_EXCEEDED:
+			accumulated.reserveExceededAbortCount++;
+			break;
+		case POLY_ABORT_OWN_PART:
+			accumulated.ownPartAbortCount++;
+			break;
+		}
+		if (stolen) {
+			accumulated.stolenPolyCount++;
+		}
+	}
+
+	void updatePeaks(Bit32u activePartialCount, unsigned int partNum, Bit32u partPartialCount) {
+		if (accumulated.peakActivePartials < activePartialCount) {
+			accumulated.peakActivePartials = activePartialCount;
+		}
+		if (accumulated.peakPartPartials[partNum] < partPartialCount) {
+			accumulated.peakPartPartials[partNum] = partPartialCount;
+		}
+	}
+
+	void countPartialLifetime(Bit32u lifetime) {
+		Bit32u bucket = 0;
+		for (Bit32u limit = 2 * POLYPHONY_HISTOGRAM_BASE_LIFETIME; lifetime >= limit && bucket < POLYPHONY_HISTOGRAM_BUCKET_COUNT - 1; limit <<= 1) {
+			bucket++;
+		}
+		accumulated.partialLifetimeHistogram[bucket]++;
+	}
+
+	void finishBlock(Bit32u blockSampleCount, Bit32u activePartialCount, const Bit32u partPartialCounts[9], Bit32u midiQueueHighWaterMark, Bit32u midiQueueOverflowCount) {
+		accumulated.sampleCount += blockSampleCount;
+		activePartialSum += double(activePartialCount) * blockSampleCount;
+		for (int partNum = 0; partNum < 9; partNum++) {
+			partPartialSums[partNum] += double(partPartialCounts[partNum]) * blockSampleCount;
+		}
+		unpublishedSampleCount += blockSampleCount;
+		const bool becameIdle = activePartialCount == 0 && lastActivePartialCount != 0;
+		lastActivePartialCount = activePartialCount;
+		if (unpublishedSampleCount < POLYPHONY_PUBLISHING_INTERVAL && !becameIdle) return;
+		publish(midiQueueHighWaterMark, midiQueueOverflowCount);
+	}
+
+	// Publishes the figures accumulated so far regardless of the interval. Must be invoked on the rendering thread.
+	void publish(Bit32u midiQueueHighWaterMark, Bit32u midiQueueOverflowCount) {
+		unpublishedSampleCount = 0;
+		PolyphonyStatistics &updating = published.getUpdatingCopy();
+		updating = accumulated;
+		if (accumulated.sampleCount > 0) {
+			updating.averageActivePartials = activePartialSum / accumulated.sampleCount;
+			for (int partNum = 0; partNum < 9; partNum++) {
+				updating.averagePartPartials[partNum] = partPartialSums[partNum] / accumulated.sampleCount;
+			}
+		}
+		updating.midiQueueHighWaterMark = midiQueueHighWaterMark;
+		updating.midiQueueOverflowCount = midiQueueOverflowCount - midiQueueOverflowCountAtReset;
+		published.publish();
+	}
+
+	bool read(PolyphonyStatistics &statistics) const {
+		return published.read(statistics);
+	}
+};
+
+// Ring buffer of trace events with a single writer (the rendering thread) and a single reader. The writer never waits
+// and overwrites the oldest events. The reader detects the events overwritten while copying by re-checking the write counter.
+class TraceBuffer {
+private:
+	TraceEvent * const events;
+	volatile Bit32u writeCount;
+	Bit32u readCount;
+
+public:
+	TraceBuffer() : events(new TraceEvent[TRACE_BUFFER_SIZE]), writeCount(0), readCount(0) {}
+
+	~TraceBuffer() {
+		delete[] events;
+	}
+
+	void record(TraceEventType type, Bit32u renderedSampleCount, Bit32u data1, Bit32u data2) {
+		TraceEvent &event = events[writeCount & (TRACE_BUFFER_SIZE - 1)];
+		event.timeNanos = Clock::getNanoseconds();
+		event.renderedSampleCount = renderedSampleCount;
+		event.type = type;
+		event.data1 = data1;
+		event.data2 = data2;
+		// As in PublishingBuffer, the event must be complete before it is counted, and the next event
+		// must not be seen before the readers can tell that its slot is being overwritten.
+		releaseFence();
+		writeCount++;
+		releaseFence();
+	}
+
+	Bit32u read(TraceEvent *output, Bit32u maxCount) {
+		if (maxCount < 2) return 0;
+		Bit32u startCount = readCount;
+		const Bit32u endCount = writeCount;
+		acquireFence();
+		if (endCount - startCount > TRACE_BUFFER_SIZE) {
+			startCount = endCount - TRACE_BUFFER_SIZE;
+		}
+		// The first entry is reserved for the notification about lost events.
+		Bit32u copyCount = endCount - startCount;
+		if (copyCount > maxCount - 1) {
+			copyCount = maxCount - 1;
+		}
+		for (Bit32u i = 0; i < copyCount; i++) {
+			output[i + 1] = events[(startCount + i) & (TRACE_BUFFER_SIZE - 1)];
+		}
+		// The writer may have overwritten some events while we were copying, and it may be updating one more slot right now.
+		acquireFence();
+		const Bit32u currentWriteCount = writeCount;
+		Bit32u overwrittenCount = 0;
+		if (currentWriteCount - startCount >= TRACE_BUFFER_SIZE) {
+			overwrittenCount = currentWriteCount - startCount - TRACE_BUFFER_SIZE + 1;
+			if (overwrittenCount > copyCount) {
+				overwrittenCount = copyCount;
+			}
+		}
+		const Bit32u validCount = copyCount - overwrittenCount;
+		const Bit32u lostCount = startCount - readCount + overwrittenCount;
+		readCount = startCount + copyCount;
+		if (lostCount == 0) {
+			memmove(output, output + 1, validCount * sizeof(TraceEvent));
+			return validCount;
+		}
+		if (overwrittenCount > 0) {
+			memmove(output + 1, output + 1 + overwrittenCount, validCount * sizeof(TraceEvent));
+		}
+		output[0].timeNanos = validCount > 0 ? output[1].timeNanos : Clock::getNanoseconds();
+		output[0].renderedSampleCount = validCount > 0 ? output[1].renderedSampleCount : 0;
+		output[0].type = TraceEventType_EVENTS_LOST;
+		output[0].data1 = lostCount;
+		output[0].data2 = 0;
+		return validCount + 1;
+	}
 };
 
 class Extensions {
@@ -197,6 +748,12 @@ public:
 	bool niceAmpRamp;
 	bool nicePanning;
 	bool nicePartialMixing;
+	bool controllerCoalescing;
+	bool partialCulling;
+	Bit32u partialCullingThreshold;
+	Bit32u partialCullingHoldTime;
+	bool noteRenderCacheEnabled;
+	NoteRenderCache *noteRenderCache;
 
 	// Here we keep the reverse mapping of assigned parts per MIDI channel.
 	// NOTE: value above 8 means that the channel is not assigned
@@ -204,8 +761,59 @@ public:
 
 	// This stores the index of Part in chantable that failed to play and required partial abortion.
 	Bit32u abortingPartIx;
+
+	ControlEventQueue *controlQueue;
+
+	bool stateSnapshotEnabled;
+	StateSnapshotBuffer *stateSnapshotBuffer;
+
+	DeferredReportHandler *deferredReportHandler;
+
+	RenderStatisticsCollector renderStatistics;
+
+	bool traceEnabled;
+	TraceBuffer *traceBuffer;
+	// Incremented by the MIDI input thread upon each failed attempt to enqueue a MIDI event.
+	volatile Bit32u midiQueueOverflowCount;
+	// The number of overflows already reported in the trace, only accessed by the rendering thread.
+	Bit32u tracedMidiQueueOverflowCount;
+	Bit32u traceBlockStartSampleCount;
+
+	PolyphonyStatisticsCollector polyphonyStatistics;
+	// Updated by the MIDI input thread after enqueuing each MIDI event.
+	volatile Bit32u midiQueueHighWaterMark;
+	Bit32u polyphonyBlockStartSampleCount;
+
+	// The configuration the synth was opened with, this is only needed for the MIDI capture header.
+	const ROMInfo *controlROMInfo;
+	const ROMInfo *pcmROMInfo;
+	AnalogOutputMode analogOutputMode;
+	RendererType openedRendererType;
+	// Not NULL while the input is being captured.
+	MidiCaptureWriter *midiCaptureWriter;
+	Bit32u midiCaptureStartSampleCount;
+	// Set while settings are changed on behalf of another recorded call, so that the change is only recorded once.
+	bool midiCaptureSuppressed;
+
+	// PatchCache entries derived from the timbres, shared by all the parts. See TIMBRE_CACHE_SIZE for the numbering.
+	PatchCache timbreCache[TIMBRE_CACHE_SIZE][4];
+
+	// Set while the renderer plays a run of queued SysEx messages. The part refreshes caused by memory writes
+	// don't affect the sound being rendered, so they are postponed and applied once the run ends.
+	bool refreshesDeferred;
+	// Bit i is set when parts[i] awaits a refresh.
+	Bit32u deferredPartRefreshMask;
+	// Range of the written timbres that await refreshing of the parts, empty when first > last.
+	unsigned int deferredTimbreRefreshFirst;
+	unsigned int deferredTimbreRefreshLast;
 };
 
+static inline Bit32u floatToBits(float value) {
+	Bit32u bits;
+	memcpy(&bits, &value, sizeof(bits));
+	return bits;
+}
+
 Bit32u Synth::getLibraryVersionInt() {
 	return (MT32EMU_VERSION_MAJOR << 16) | (MT32EMU_VERSION_MINOR << 8) | (MT32EMU_VERSION_PATCH);
 }
@@ -253,6 +861,15 @@ Synth::Synth(ReportHandler *useReportHandler) :
 	reverbModel = NULL;
 	analog = NULL;
 	renderer = NULL;
+	extensions.controlROMInfo = NULL;
+	extensions.pcmROMInfo = NULL;
+	extensions.midiCaptureWriter = NULL;
+	extensions.midiCaptureStartSampleCount = 0;
+	extensions.midiCaptureSuppressed = false;
+	extensions.refreshesDeferred = false;
+	extensions.deferredPartRefreshMask = 0;
+	extensions.deferredTimbreRefreshFirst = 1;
+	extensions.deferredTimbreRefreshLast = 0;
 	setDACInputMode(DACInputMode_NICE);
 	setMIDIDelayMode(MIDIDelayMode_DELAY_SHORT_MESSAGES_ONLY);
 	setOutputGain(1.0f);
@@ -261,6 +878,11 @@ Synth::Synth(ReportHandler *useReportHandler) :
 	setNiceAmpRampEnabled(true);
 	setNicePanningEnabled(false);
 	setNicePartialMixingEnabled(false);
+	setControllerCoalescingEnabled(false);
+	setPartialCullingEnabled(false);
+	setPartialCullingThreshold(8192);
+	setPartialCullingHoldTime(320);
+	setNoteRenderCacheEnabled(false);
 	selectRendererType(RendererType_BIT16S);
 
 	patchTempMemoryRegion = NULL;
@@ -278,6 +900,17 @@ Synth::Synth(ReportHandler *useReportHandler) :
 	pcmROMData = NULL;
 	soundGroupNames = NULL;
 	midiQueue = NULL;
+	extensions.controlQueue = NULL;
+	extensions.stateSnapshotEnabled = false;
+	extensions.stateSnapshotBuffer = NULL;
+	extensions.noteRenderCache = NULL;
+	extensions.deferredReportHandler = NULL;
+	extensions.traceEnabled = false;
+	extensions.traceBuffer = NULL;
+	extensions.midiQueueOverflowCount = 0;
+	extensions.tracedMidiQueueOverflowCount = 0;
+	extensions.midiQueueHighWaterMark = 0;
+	extensions.polyphonyBlockStartSampleCount = 0;
 	lastReceivedMIDIEventTimestamp = 0;
 	memset(parts, 0, sizeof(parts));
 	renderedSampleCount = 0;
@@ -285,6 +918,11 @@ Synth::Synth(ReportHandler *useReportHandler) :
 
 Synth::~Synth() {
 	close(); // Make sure we're closed and everything is freed
+	if (extensions.deferredReportHandler != NULL) {
+		reportHandler = &extensions.deferredReportHandler->getReportHandler();
+		delete extensions.deferredReportHandler;
+	}
+	delete extensions.traceBuffer;
 	if (isDefaultReportHandler) {
 		delete reportHandler;
 	}
@@ -347,6 +985,7 @@ void Synth::printDebug(const char *fmt, ...) {
 
 void Synth::setReverbEnabled(bool newReverbEnabled) {
 	if (!opened) return;
+	captureSetting(MidiCaptureSetting_REVERB_ENABLED, newReverbEnabled ? 1 : 0);
 	if (isReverbEnabled() == newReverbEnabled) return;
 	if (newReverbEnabled) {
 		bool oldReverbOverridden = reverbOverridden;
@@ -366,6 +1005,7 @@ bool Synth::isReverbEnabled() const {
 }
 
 void Synth::setReverbOverridden(bool newReverbOverridden) {
+	captureSetting(MidiCaptureSetting_REVERB_OVERRIDDEN, newReverbOverridden ? 1 : 0);
 	reverbOverridden = newReverbOverridden;
 }
 
@@ -375,6 +1015,9 @@ bool Synth::isReverbOverridden() const {
 
 void Synth::setReverbCompatibilityMode(bool mt32CompatibleMode) {
 	if (!opened || (isMT32ReverbCompatibilityMode() == mt32CompatibleMode)) return;
+	captureSetting(MidiCaptureSetting_REVERB_COMPATIBILITY_MODE, mt32CompatibleMode ? 1 : 0);
+	const bool oldMidiCaptureSuppressed = extensions.midiCaptureSuppressed;
+	extensions.midiCaptureSuppressed = true;
 	bool oldReverbEnabled = isReverbEnabled();
 	setReverbEnabled(false);
 	for (int i = 0; i < 4; i++) {
@@ -383,6 +1026,7 @@ void Synth::setReverbCompatibilityMode(bool mt32CompatibleMode) {
 	initReverbModels(mt32CompatibleMode);
 	setReverbEnabled(oldReverbEnabled);
 	setReverbOutputGain(reverbOutputGain);
+	extensions.midiCaptureSuppressed = oldMidiCaptureSuppressed;
 }
 
 bool Synth::isMT32ReverbCompatibilityMode() const {
@@ -394,6 +1038,7 @@ bool Synth::isDefaultReverbMT32Compatible() const {
 }
 
 void Synth::setDACInputMode(DACInputMode mode) {
+	captureSetting(MidiCaptureSetting_DAC_INPUT_MODE, Bit32u(mode));
 	dacInputMode = mode;
 }
 
@@ -411,6 +1056,7 @@ MIDIDelayMode Synth::getMIDIDelayMode() const {
 
 void Synth::setOutputGain(float newOutputGain) {
 	if (newOutputGain < 0.0f) newOutputGain = -newOutputGain;
+	captureSetting(MidiCaptureSetting_OUTPUT_GAIN, floatToBits(newOutputGain));
 	outputGain = newOutputGain;
 	if (analog != NULL) analog->setSynthOutputGain(newOutputGain);
 }
@@ -421,6 +1067,7 @@ float Synth::getOutputGain() const {
 
 void Synth::setReverbOutputGain(float newReverbOutputGain) {
 	if (newReverbOutputGain < 0.0f) newReverbOutputGain = -newReverbOutputGain;
+	captureSetting(MidiCaptureSetting_REVERB_OUTPUT_GAIN, floatToBits(newReverbOutputGain));
 	reverbOutputGain = newReverbOutputGain;
 	if (analog != NULL) analog->setReverbOutputGain(newReverbOutputGain, isMT32ReverbCompatibilityMode());
 }
@@ -430,6 +1077,7 @@ float Synth::getReverbOutputGain() const {
 }
 
 void Synth::setReversedStereoEnabled(bool enabled) {
+	captureSetting(MidiCaptureSetting_REVERSED_STEREO_ENABLED, enabled ? 1 : 0);
 	reversedStereoEnabled = enabled;
 }
 
@@ -437,7 +1085,85 @@ bool Synth::isReversedStereoEnabled() const {
 	return reversedStereoEnabled;
 }
 
+bool Synth::pushControlEvent(ControlEvent &controlEvent, Bit32u timestamp) {
+	if (extensions.controlQueue == NULL) {
+		// Nothing is being rendered, so there is no reason to defer the change.
+		applyControlEvent(controlEvent);
+		return true;
+	}
+	controlEvent.timestamp = timestamp;
+	return extensions.controlQueue->pushControlEvent(controlEvent);
+}
+
+void Synth::applyControlEvent(const ControlEvent &controlEvent) {
+	extensions.midiCaptureSuppressed = true;
+	switch (controlEvent.type) {
+	case ControlEvent::Type_OUTPUT_GAIN:
+		setOutputGain(controlEvent.gain);
+		break;
+	case ControlEvent::Type_REVERB_OUTPUT_GAIN:
+		setReverbOutputGain(controlEvent.gain);
+		break;
+	case ControlEvent::Type_REVERB_ENABLED:
+		setReverbEnabled(controlEvent.enabled);
+		break;
+	case ControlEvent::Type_REVERSED_STEREO_ENABLED:
+		setReversedStereoEnabled(controlEvent.enabled);
+		break;
+	case ControlEvent::Type_DAC_INPUT_MODE:
+		setDACInputMode(controlEvent.dacInputMode);
+		break;
+	}
+	extensions.midiCaptureSuppressed = false;
+}
+
+bool Synth::setReverbEnabled(bool newReverbEnabled, Bit32u timestamp) {
+	ControlEvent controlEvent;
+	controlEvent.type = ControlEvent::Type_REVERB_ENABLED;
+	controlEvent.enabled = newReverbEnabled;
+	if (!pushControlEvent(controlEvent, timestamp)) return false;
+	captureTimedSetting(MidiCaptureSetting_REVERB_ENABLED, newReverbEnabled ? 1 : 0, timestamp);
+	return true;
+}
+
+bool Synth::setDACInputMode(DACInputMode mode, Bit32u timestamp) {
+	ControlEvent controlEvent;
+	controlEvent.type = ControlEvent::Type_DAC_INPUT_MODE;
+	controlEvent.dacInputMode = mode;
+	if (!pushControlEvent(controlEvent, timestamp)) return false;
+	captureTimedSetting(MidiCaptureSetting_DAC_INPUT_MODE, Bit32u(mode), timestamp);
+	return true;
+}
+
+bool Synth::setOutputGain(float newOutputGain, Bit32u timestamp) {
+	ControlEvent controlEvent;
+	controlEvent.type = ControlEvent::Type_OUTPUT_GAIN;
+	controlEvent.gain = newOutputGain;
+	if (!pushControlEvent(controlEvent, timestamp)) return false;
+	captureTimedSetting(MidiCaptureSetting_OUTPUT_GAIN, floatToBits(newOutputGain), timestamp);
+	return true;
+}
+
+bool Synth::setReverbOutputGain(float newReverbOutputGain, Bit32u timestamp) {
+	ControlEvent controlEvent;
+	controlEvent.type = ControlEvent::Type_REVERB_OUTPUT_GAIN;
+	controlEvent.gain = newReverbOutputGain;
+	if (!pushControlEvent(controlEvent, timestamp)) return false;
+	captureTimedSetting(MidiCaptureSetting_REVERB_OUTPUT_GAIN, floatToBits(newReverbOutputGain), timestamp);
+	return true;
+}
+
+bool Synth::setReversedStereoEnabled(bool enabled, Bit32u timestamp) {
+	ControlEvent controlEvent;
+	controlEvent.type = ControlEvent::Type_REVERSED_STEREO_ENABLED;
+	controlEvent.enabled = enabled;
+	if (!pushControlEvent(controlEvent, timestamp)) return false;
+	captureTimedSetting(MidiCaptureSetting_REVERSED_STEREO_ENABLED, enabled ? 1 : 0, timestamp);
+	return true;
+}
+
 void Synth::setNiceAmpRampEnabled(bool enabled) {
+	captureSetting(MidiCaptureSetting_NICE_AMP_RAMP_ENABLED, enabled ? 1 : 0);
 	extensions.niceAmpRamp = enabled;
 }
 
@@ -446,6 +1172,7 @@ bool Synth::isNiceAmpRampEnabled() const {
 }
 
 void Synth::setNicePanningEnabled(bool enabled) {
+	captureSetting(MidiCaptureSetting_NICE_PANNING_ENABLED, enabled ? 1 : 0);
 	extensions.nicePanning = enabled;
 }
 
@@ -454,6 +1181,7 @@ bool Synth::isNicePanningEnabled() const {
 }
 
 void Synth::setNicePartialMixingEnabled(bool enabled) {
+	captureSetting(MidiCaptureSetting_NICE_PARTIAL_MIXING_ENABLED, enabled ? 1 : 0);
 	extensions.nicePartialMixing = enabled;
 }
 
@@ -461,6 +1189,53 @@ bool Synth::isNicePartialMixingEnabled() const {
 	return extensions.nicePartialMixing;
 }
 
+void Synth::setControllerCoalescingEnabled(bool enabled) {
+	captureSetting(MidiCaptureSetting_CONTROLLER_COALESCING_ENABLED, enabled ? 1 : 0);
+	extensions.controllerCoalescing = enabled;
+}
+
+bool Synth::isControllerCoalescingEnabled() const {
+	return extensions.controllerCoalescing;
+}
+
+void Synth::setPartialCullingEnabled(bool enabled) {
+	captureSetting(MidiCaptureSetting_PARTIAL_CULLING_ENABLED, enabled ? 1 : 0);
+	extensions.partialCulling = enabled;
+}
+
+bool Synth::isPartialCullingEnabled() const {
+	return extensions.partialCulling;
+}
+
+void Synth::setPartialCullingThreshold(Bit32u level) {
+	if (level > 65535) level = 65535;
+	captureSetting(MidiCaptureSetting_PARTIAL_CULLING_THRESHOLD, level);
+	extensions.partialCullingThreshold = level;
+}
+
+Bit32u Synth::getPartialCullingThreshold() const {
+	return extensions.partialCullingThreshold;
+}
+
+void Synth::setPartialCullingHoldTime(Bit32u holdTime) {
+	captureSetting(MidiCaptureSetting_PARTIAL_CULLING_HOLD_TIME, holdTime);
+	extensions.partialCullingHoldTime = holdTime;
+}
+
+Bit32u Synth::getPartialCullingHoldTime() const {
+	return extensions.partialCullingHoldTime;
+}
+
+void Synth::setNoteRenderCacheEnabled(bool enabled) {
+	captureSetting(MidiCaptureSetting_NOTE_RENDER_CACHE_ENABLED, enabled ? 1 : 0);
+	// The recordings are discarded by the rendering thread, see startRendering().
+	extensions.noteRenderCacheEnabled = enabled;
+}
+
+bool Synth::isNoteRenderCacheEnabled() const {
+	return extensions.noteRenderCacheEnabled;
+}
+
 bool Synth::loadControlROM(const ROMImage &controlROMImage) {
 	File *file = controlROMImage.getFile();
 	const ROMInfo *controlROMInfo = controlROMImage.getROMInfo();
@@ -472,6 +1247,7 @@ bool Synth::loadControlROM(const ROMImage &controlROMImage) {
 #endif
 		return false;
 	}
+	extensions.controlROMInfo = controlROMInfo;
 
 #if MT32EMU_MONITOR_INIT
 	printDebug("Found Control ROM: %s, %s", controlROMInfo->shortName, controlROMInfo->description);
@@ -503,6 +1279,7 @@ bool Synth::loadPCMROM(const ROMImage &pcmROMImage) {
 			|| (pcmROMInfo->pairType != ROMInfo::Full)) {
 		return false;
 	}
+	extensions.pcmROMInfo = pcmROMInfo;
 #if MT32EMU_MONITOR_INIT
 	printDebug("Found PCM ROM: %s, %s", pcmROMInfo->shortName, pcmROMInfo->description);
 #endif
@@ -705,6 +1482,7 @@ bool Synth::open(const ROMImage &controlROMImage, const ROMImage &pcmROMImage, B
 	memset(&mt32ram.timbres[128], 0, sizeof(mt32ram.timbres[128]) * 64);
 
 	partialManager = new PartialManager(this, parts);
+	extensions.noteRenderCache = new NoteRenderCache(getSelectedRendererType() == RendererType_FLOAT);
 
 	pcmWaves = new PCMWaveEntry[controlROMMap->pcmCount];
 
@@ -761,6 +1539,7 @@ bool Synth::open(const ROMImage &controlROMImage, const ROMImage &pcmROMImage, B
 	soundGroupNames = writableSoundGroupNames;
 	initSoundGroups(writableSoundGroupNames);
 
+	invalidateTimbreCache(0, TIMBRE_CACHE_SIZE - 1);
 	for (int i = 0; i < 9; i++) {
 		MemParams::PatchTemp *patchTemp = &mt32ram.patchTemp[i];
 
@@ -791,8 +1570,15 @@ bool Synth::open(const ROMImage &controlROMImage, const ROMImage &pcmROMImage, B
 	mt32default = mt32ram;
 
 	midiQueue = new MidiEventQueue();
+	extensions.controlQueue = new ControlEventQueue(CONTROL_EVENT_QUEUE_SIZE);
+	extensions.stateSnapshotBuffer = new StateSnapshotBuffer(partialCount);
+	extensions.renderStatistics.reset();
+	extensions.polyphonyStatistics.reset(extensions.midiQueueOverflowCount);
+	extensions.midiQueueHighWaterMark = 0;
 
 	analog = Analog::createAnalog(analogOutputMode, controlROMFeatures->oldMT32AnalogLPF, getSelectedRendererType());
+	extensions.analogOutputMode = analogOutputMode;
+	extensions.openedRendererType = getSelectedRendererType();
 #if MT32EMU_MONITOR_INIT
 	static const char *ANALOG_OUTPUT_MODES[] = { "Digital only", "Coarse", "Accurate", "Oversampled2x" };
 	printDebug("Using Analog output mode %s", ANALOG_OUTPUT_MODES[analogOutputMode]);
@@ -821,6 +1607,8 @@ bool Synth::open(const ROMImage &controlROMImage, const ROMImage &pcmROMImage, B
 
 	opened = true;
 	activated = false;
+	// Lets the monitoring clients see the initial state before anything is rendered.
+	publishStateSnapshot();
 
 #if MT32EMU_MONITOR_INIT
 	printDebug("*** Initialisation complete ***");
@@ -829,20 +1617,31 @@ bool Synth::open(const ROMImage &controlROMImage, const ROMImage &pcmROMImage, B
 }
 
 void Synth::dispose() {
+	stopMidiCapture();
 	opened = false;
 
 	delete midiQueue;
 	midiQueue = NULL;
 
+	delete extensions.controlQueue;
+	extensions.controlQueue = NULL;
+
+	delete extensions.stateSnapshotBuffer;
+	extensions.stateSnapshotBuffer = NULL;
+
 	delete renderer;
 	renderer = NULL;
 
 	delete analog;
 	analog = NULL;
 
+	// The partials release the recordings they use.
 	delete partialManager;
 	partialManager = NULL;
 
+	delete extensions.noteRenderCache;
+	extensions.noteRenderCache = NULL;
+
 	for (int i = 0; i < 9; i++) {
 		delete parts[i];
 		parts[i] = NULL;
@@ -892,6 +1691,17 @@ void Synth::flushMIDIQueue() {
 		}
 		lastReceivedMIDIEventTimestamp = renderedSampleCount;
 	}
+	if (extensions.controlQueue != NULL) {
+		for (;;) {
+			const ControlEvent *controlEvent = extensions.controlQueue->peekControlEvent();
+			if (controlEvent == NULL) break;
+			applyControlEvent(*controlEvent);
+			extensions.controlQueue->dropControlEvent();
+		}
+	}
+	if (opened) {
+		extensions.polyphonyStatistics.publish(extensions.midiQueueHighWaterMark, extensions.midiQueueOverflowCount);
+	}
 }
 
 Bit32u Synth::setMIDIEventQueueSize(Bit32u useSize) {
@@ -960,7 +1770,12 @@ bool Synth::playMsg(Bit32u msg, Bit32u timestamp) {
 	}
 	if (!activated) activated = true;
 	do {
-		if (midiQueue->pushShortMessage(msg, timestamp)) return true;
+		if (midiQueue->pushShortMessage(msg, timestamp)) {
+			updateMidiQueueHighWaterMark();
+			captureInput(MidiCaptureRecordType_SHORT_MESSAGE, msg, NULL, 0, timestamp);
+			return true;
+		}
+		extensions.midiQueueOverflowCount++;
 	} while (reportHandler->onMIDIQueueOverflow());
 	return false;
 }
@@ -976,7 +1791,12 @@ bool Synth::playSysex(const Bit8u *sysex, Bit32u len, Bit32u timestamp) {
 	}
 	if (!activated) activated = true;
 	do {
-		if (midiQueue->pushSysex(sysex, len, timestamp)) return true;
+		if (midiQueue->pushSysex(sysex, len, timestamp)) {
+			updateMidiQueueHighWaterMark();
+			captureInput(MidiCaptureRecordType_SYSEX, 0, sysex, len, timestamp);
+			return true;
+		}
+		extensions.midiQueueOverflowCount++;
 	} while (reportHandler->onMIDIQueueOverflow());
 	return false;
 }
@@ -1336,6 +2156,7 @@ void Synth::readMemory(Bit32u addr, Bit32u len, Bit8u *data) {
 }
 
 void Synth::writeMemory(Bit32u addr, Bit32u len, const Bit8u *data) {
+	captureInput(MidiCaptureRecordType_MEMORY_WRITE, addr, data, len, renderedSampleCount);
 	const MemoryRegion *region = findMemoryRegion(addr);
 	if (region != NULL) {
 		writeMemoryRegion(region, addr, len, data);
@@ -1456,7 +2277,7 @@ void Synth::writeMemoryRegion(const MemoryRegion *region, Bit32u addr, Bit32u le
 						parts[i]->setTimbre(&mt32ram.timbres[parts[i]->getAbsTimbreNum()].timbre);
 					}
 				}
-				parts[i]->refresh();
+				refreshPart(i);
 			}
 		}
 		break;
@@ -1476,11 +2297,12 @@ void Synth::writeMemoryRegion(const MemoryRegion *region, Bit32u addr, Bit32u le
 #endif
 		}
 		if (parts[8] != NULL) {
-			parts[8]->refresh();
+			refreshPart(8);
 		}
 		break;
 	case MR_TimbreTemp:
 		region->write(first, off, data, len);
+		invalidateTimbreCache(TIMBRE_CACHE_TIMBRE_TEMP_START + first, TIMBRE_CACHE_TIMBRE_TEMP_START + last);
 		for (unsigned int i = first; i <= last; i++) {
 			char instrumentName[11];
 			memcpy(instrumentName, mt32ram.timbreTemp[i].common.name, 10);
@@ -1489,7 +2311,7 @@ void Synth::writeMemoryRegion(const MemoryRegion *region, Bit32u addr, Bit32u le
 			printDebug("WRITE-PARTTIMBRE (%d-%d@%d..%d): timbre=%d (%s)", first, last, off, off + len, i, instrumentName);
 #endif
 			if (parts[i] != NULL) {
-				parts[i]->refresh();
+				refreshPart(i);
 			}
 		}
 		break;
@@ -1512,6 +2334,7 @@ void Synth::writeMemoryRegion(const MemoryRegion *region, Bit32u addr, Bit32u le
 		// first += 128;
 		// last += 128;
 		region->write(first, off, data, len);
+		invalidateTimbreCache(first, last);
 		for (unsigned int i = first; i <= last; i++) {
 #if MT32EMU_MONITOR_TIMBRES >= 1
 			TimbreParam *timbre = &mt32ram.timbres[i].timbre;
@@ -1594,14 +2417,10 @@ void Synth::writeMemoryRegion(const MemoryRegion *region, Bit32u addr, Bit32u le
 #undef DT
 #endif
 #endif
-			// FIXME:KG: Not sure if the stuff below should be done (for rhythm and/or parts)...
-			// Does the real MT-32 automatically do this?
-			for (unsigned int part = 0; part < 9; part++) {
-				if (parts[part] != NULL) {
-					parts[part]->refreshTimbre(i);
-				}
-			}
 		}
+		// FIXME:KG: Not sure if the stuff below should be done (for rhythm and/or parts)...
+		// Does the real MT-32 automatically do this?
+		refreshPartTimbres(first, last);
 		break;
 	case MR_System:
 		region->write(0, off, data, len);
@@ -1677,6 +2496,7 @@ void Synth::refreshSystemReverbParameters() {
 	reportHandler->onNewReverbMode(mt32ram.system.reverbMode);
 	reportHandler->onNewReverbTime(mt32ram.system.reverbTime);
 	reportHandler->onNewReverbLevel(mt32ram.system.reverbLevel);
+	recordTraceEvent(TraceEventType_REVERB_MODE_CHANGE, mt32ram.system.reverbMode, mt32ram.system.reverbTime | (mt32ram.system.reverbLevel << 8));
 
 	BReverbModel *oldReverbModel = reverbModel;
 	if (mt32ram.system.reverbTime == 0 && mt32ram.system.reverbLevel == 0) {
@@ -1755,6 +2575,54 @@ void Synth::refreshSystem() {
 	refreshSystemMasterVol();
 }
 
+void Synth::refreshPart(unsigned int partNum) {
+	if (extensions.refreshesDeferred) {
+		extensions.deferredPartRefreshMask |= 1 << partNum;
+	} else {
+		parts[partNum]->refresh();
+	}
+}
+
+void Synth::refreshPartTimbres(unsigned int firstAbsTimbreNum, unsigned int lastAbsTimbreNum) {
+	if (extensions.refreshesDeferred) {
+		if (extensions.deferredTimbreRefreshFirst > extensions.deferredTimbreRefreshLast) {
+			extensions.deferredTimbreRefreshFirst = firstAbsTimbreNum;
+			extensions.deferredTimbreRefreshLast = lastAbsTimbreNum;
+		} else {
+			if (extensions.deferredTimbreRefreshFirst > firstAbsTimbreNum) extensions.deferredTimbreRefreshFirst = firstAbsTimbreNum;
+			if (extensions.deferredTimbreRefreshLast < lastAbsTimbreNum) extensions.deferredTimbreRefreshLast = lastAbsTimbreNum;
+		}
+		return;
+	}
+	for (unsigned int absTimbreNum = firstAbsTimbreNum; absTimbreNum <= lastAbsTimbreNum; absTimbreNum++) {
+		for (unsigned int part = 0; part < 9; part++) {
+			if (parts[part] != NULL) {
+				parts[part]->refreshTimbre(absTimbreNum);
+			}
+		}
+	}
+}
+
+void Synth::deferRefreshes() {
+	extensions.refreshesDeferred = true;
+}
+
+void Synth::applyDeferredRefreshes() {
+	if (!extensions.refreshesDeferred) return;
+	extensions.refreshesDeferred = false;
+	if (extensions.deferredTimbreRefreshFirst <= extensions.deferredTimbreRefreshLast) {
+		refreshPartTimbres(extensions.deferredTimbreRefreshFirst, extensions.deferredTimbreRefreshLast);
+		extensions.deferredTimbreRefreshFirst = 1;
+		extensions.deferredTimbreRefreshLast = 0;
+	}
+	for (unsigned int partNum = 0; extensions.deferredPartRefreshMask != 0; partNum++) {
+		if ((extensions.deferredPartRefreshMask & 1) != 0 && parts[partNum] != NULL) {
+			parts[partNum]->refresh();
+		}
+		extensions.deferredPartRefreshMask >>= 1;
+	}
+}
+
 void Synth::reset() {
 	if (!opened) return;
 #if MT32EMU_MONITOR_SYSEX > 0
@@ -1763,6 +2631,11 @@ void Synth::reset() {
 	reportHandler->onDeviceReset();
 	partialManager->deactivateAll();
 	mt32ram = mt32default;
+	invalidateTimbreCache(0, TIMBRE_CACHE_SIZE - 1);
+	// All the parts are refreshed below anyway.
+	extensions.deferredPartRefreshMask = 0;
+	extensions.deferredTimbreRefreshFirst = 1;
+	extensions.deferredTimbreRefreshLast = 0;
 	for (int i = 0; i < 9; i++) {
 		parts[i]->reset();
 		if (i != 8) {
@@ -1855,6 +2728,10 @@ const MidiEvent *MidiEventQueue::peekMidiEvent() {
 	return isEmpty() ? NULL : &ringBuffer[startPosition];
 }
 
+const MidiEvent *MidiEventQueue::peekMidiEvent(Bit32u offset) {
+	return offset < getEventCount() ? &ringBuffer[(startPosition + offset) & ringBufferMask] : NULL;
+}
+
 void MidiEventQueue::dropMidiEvent() {
 	// Is ring buffer empty?
 	if (startPosition != endPosition) {
@@ -1862,6 +2739,10 @@ void MidiEventQueue::dropMidiEvent() {
 	}
 }
 
+Bit32u MidiEventQueue::getEventCount() const {
+	return (endPosition - startPosition) & ringBufferMask;
+}
+
 bool MidiEventQueue::isFull() const {
 	return startPosition == ((endPosition + 1) & ringBufferMask);
 }
@@ -1870,38 +2751,168 @@ bool MidiEventQueue::isEmpty() const {
 	return startPosition == endPosition;
 }
 
-void Synth::selectRendererType(RendererType newRendererType) {
-	extensions.selectedRendererType = newRendererType;
+ControlEventQueue::ControlEventQueue(Bit32u useRingBufferSize) : ringBuffer(new ControlEvent[useRingBufferSize]), ringBufferMask(useRingBufferSize - 1) {
+	reset();
 }
 
-RendererType Synth::getSelectedRendererType() const {
-	return extensions.selectedRendererType;
+ControlEventQueue::~ControlEventQueue() {
+	delete[] ringBuffer;
 }
 
-Bit32u Synth::getStereoOutputSampleRate() const {
-	return (analog == NULL) ? SAMPLE_RATE : analog->getOutputSampleRate();
+void ControlEventQueue::reset() {
+	startPosition = 0;
+	endPosition = 0;
+}
+
+bool ControlEventQueue::pushControlEvent(const ControlEvent &controlEvent) {
+	Bit32u newEndPosition = (endPosition + 1) & ringBufferMask;
+	// Is ring buffer full?
+	if (startPosition == newEndPosition) return false;
+	// The threads only share the indices, so the slot may be overwritten once the consumer has dropped the event in it,
+	// and the new event must be complete before it is published.
+	acquireFence();
+	ringBuffer[endPosition] = controlEvent;
+	releaseFence();
+	endPosition = newEndPosition;
+	return true;
+}
+
+const ControlEvent *ControlEventQueue::peekControlEvent() {
+	return isEmpty() ? NULL : &ringBuffer[startPosition];
+}
+
+void ControlEventQueue::dropControlEvent() {
+	// Is ring buffer empty?
+	if (startPosition != endPosition) {
+		// The slot must be read completely before the producer is allowed to reuse it.
+		releaseFence();
+		startPosition = (startPosition + 1) & ringBufferMask;
+	}
+}
+
+bool ControlEventQueue::isEmpty() const {
+	const bool empty = startPosition == endPosition;
+	acquireFence();
+	return empty;
+}
+
+RenderStatisticsCollector &Renderer::getRenderStatistics() {
+	return synth.extensions.renderStatistics;
+}
+
+// Pitch bend, modulation, volume and expression messages only set a value of the part, which the partials pick up later.
+static bool isCoalescableController(Bit32u shortMessageData) {
+	switch (shortMessageData & 0xF0) {
+	case 0xE0:
+		return true;
+	case 0xB0:
+		switch ((shortMessageData >> 8) & 0x7F) {
+		case 0x01:
+		case 0x07:
+		case 0x0B:
+			return true;
+		}
+		return false;
+	}
+	return false;
+}
+
+bool Renderer::isNextMidiEventSuperseded() {
+	// The pitch is updated by TVP at 4 kHz nominally, which is the finest control resolution that matters.
+	// Note, the control ticks are aligned to the global renderedSampleCount rather than to the TVP timers. Each partial
+	// runs its own timer, which starts along with the partial and fires with a jittered period (see TVP::nextPitch()).
+	// So, a partial may still pick up the value of a dropped message within the tick, and the output deviates.
+	static const Bit32u CONTROL_TICK_SAMPLES = SAMPLE_RATE / 4000;
+	// Limits the search in a long run of the controller messages of other kinds.
+	static const Bit32u MAX_LOOKAHEAD = 16;
+
+	if (!synth.extensions.controllerCoalescing) return false;
+	MidiEventQueue &midiQueue = getMidiQueue();
+	const MidiEvent *midiEvent = midiQueue.peekMidiEvent();
+	if (midiEvent->sysexData != NULL || !isCoalescableController(midiEvent->shortMessageData)) return false;
+	// Pitch bend messages are matched by the status byte, control changes also by the controller number.
+	const Bit32u keyMask = (midiEvent->shortMessageData & 0xF0) == 0xE0 ? 0xFF : 0xFFFF;
+	const Bit32u key = midiEvent->shortMessageData & keyMask;
+	// The event is due, so it would be played now. The superseding event has to land before the current control tick ends.
+	// Each event is played at its timestamp or a sample after the preceding one, whichever is later.
+	const Bit32s samplesToTickEnd = Bit32s(CONTROL_TICK_SAMPLES - getRenderedSampleCount() % CONTROL_TICK_SAMPLES);
+	Bit32s samplesToLanding = 0;
+	for (Bit32u offset = 1; offset <= MAX_LOOKAHEAD; offset++) {
+		const MidiEvent *laterEvent = midiQueue.peekMidiEvent(offset);
+		if (laterEvent == NULL || laterEvent->sysexData != NULL) return false;
+		const Bit32s samplesToLaterEvent = Bit32s(laterEvent->timestamp - getRenderedSampleCount());
+		samplesToLanding = samplesToLaterEvent > samplesToLanding ? samplesToLaterEvent : samplesToLanding + 1;
+		if (samplesToLanding >= samplesToTickEnd) return false;
+		if (!isCoalescableController(laterEvent->shortMessageData)) return false;
+		if ((laterEvent->shortMessageData & keyMask) == key) return true;
+	}
+	return false;
+}
+
+Bit32u Renderer::applyDueControlEvents() {
+	ControlEventQueue &controlQueue = *synth.extensions.controlQueue;
+	for (;;) {
+		const ControlEvent *controlEvent = controlQueue.peekControlEvent();
+		if (controlEvent == NULL) return MAX_SAMPLES_PER_RUN;
+		Bit32s samplesToNextControlEvent = Bit32s(controlEvent->timestamp - getRenderedSampleCount());
+		if (samplesToNextControlEvent > 0) return Bit32u(samplesToNextControlEvent);
+		synth.applyControlEvent(*controlEvent);
+		controlQueue.dropControlEvent();
+	}
+}
+
+void Synth::selectRendererType(RendererType newRendererType) {
+	extensions.selectedRendererType = newRendererType;
+}
+
+RendererType Synth::getSelectedRendererType() const {
+	return extensions.selectedRendererType;
+}
+
+Bit32u Synth::getStereoOutputSampleRate() const {
+	return (analog == NULL) ? SAMPLE_RATE : analog->getOutputSampleRate();
 }
 
 template <class Sample>
 void RendererImpl<Sample>::doRender(Sample *stereoStream, Bit32u len) {
 	if (!isActivated()) {
-		incRenderedSampleCount(getAnalog().getDACStreamsLength(len));
-		if (!getAnalog().process(NULL, NULL, NULL, NULL, NULL, NULL, stereoStream, len)) {
-			printDebug("RendererImpl: Invalid call to Analog::process()!\n");
+		// Though the output is silent, the control events still take effect at their timestamps, same as in the active state.
+		while (len > 0) {
+			Bit32u thisPassLen = len;
+			Bit32u samplesToNextControlEvent = applyDueControlEvents();
+			if (samplesToNextControlEvent < getAnalog().getDACStreamsLength(thisPassLen)) {
+				Bit32u passLenToNextControlEvent = samplesToNextControlEvent * getAnalog().getOutputSampleRate() / SAMPLE_RATE;
+				thisPassLen = passLenToNextControlEvent > 0 ? passLenToNextControlEvent : 1;
+			}
+			incRenderedSampleCount(getAnalog().getDACStreamsLength(thisPassLen));
+			if (!getAnalog().process(NULL, NULL, NULL, NULL, NULL, NULL, stereoStream, thisPassLen)) {
+				printDebug("RendererImpl: Invalid call to Analog::process()!\n");
+			}
+			Synth::muteSampleBuffer(stereoStream, thisPassLen << 1);
+			stereoStream += thisPassLen << 1;
+			len -= thisPassLen;
 		}
-		Synth::muteSampleBuffer(stereoStream, len << 1);
 		return;
 	}
 
 	while (len > 0) {
 		// As in AnalogOutputMode_ACCURATE mode output is upsampled, MAX_SAMPLES_PER_RUN is more than enough for the temp buffers.
 		Bit32u thisPassLen = len > MAX_SAMPLES_PER_RUN ? MAX_SAMPLES_PER_RUN : len;
+		// The output gains are applied in the analog circuitry emulation at once for the whole pass,
+		// so we break it at the next enqueued control event.
+		Bit32u samplesToNextControlEvent = applyDueControlEvents();
+		if (samplesToNextControlEvent < getAnalog().getDACStreamsLength(thisPassLen)) {
+			Bit32u passLenToNextControlEvent = samplesToNextControlEvent * getAnalog().getOutputSampleRate() / SAMPLE_RATE;
+			thisPassLen = passLenToNextControlEvent > 0 ? passLenToNextControlEvent : 1;
+		}
 		doRenderStreams(tmpBuffers, getAnalog().getDACStreamsLength(thisPassLen));
+		const double analogStartNanos = getRenderStatistics().startStage();
 		if (!getAnalog().process(stereoStream, tmpNonReverbLeft, tmpNonReverbRight, tmpReverbDryLeft, tmpReverbDryRight, tmpReverbWetLeft, tmpReverbWetRight, thisPassLen)) {
 			printDebug("RendererImpl: Invalid call to Analog::process()!\n");
 			Synth::muteSampleBuffer(stereoStream, len << 1);
 			return;
 		}
+		getRenderStatistics().finishStage(RenderStatisticsCollector::Stage_ANALOG, analogStartNanos);
 		stereoStream += thisPassLen << 1;
 		len -= thisPassLen;
 	}
@@ -1910,11 +2921,10 @@ void RendererImpl<Sample>::doRender(Sample *stereoStream, Bit32u len) {
 template <class Sample>
 template <class O>
 void RendererImpl<Sample>::doRenderAndConvert(O *stereoStream, Bit32u len) {
-	Sample renderingBuffer[MAX_SAMPLES_PER_RUN << 1];
 	while (len > 0) {
 		Bit32u thisPassLen = len > MAX_SAMPLES_PER_RUN ? MAX_SAMPLES_PER_RUN : len;
-		doRender(renderingBuffer, thisPassLen);
-		convertSampleFormat(renderingBuffer, stereoStream, thisPassLen << 1);
+		doRender(tmpStereoBuffer, thisPassLen);
+		convertSampleFormat(tmpStereoBuffer, stereoStream, thisPassLen << 1);
 		stereoStream += thisPassLen << 1;
 		len -= thisPassLen;
 	}
@@ -1950,11 +2960,15 @@ static inline void renderStereo(bool opened, Renderer *renderer, S *stream, Bit3
 }
 
 void Synth::render(Bit16s *stream, Bit32u len) {
+	startRendering(len);
 	renderStereo(opened, renderer, stream, len);
+	finishRendering();
 }
 
 void Synth::render(float *stream, Bit32u len) {
+	startRendering(len);
 	renderStereo(opened, renderer, stream, len);
+	finishRendering();
 }
 
 template <class Sample>
@@ -1995,55 +3009,139 @@ static inline void convertStreamsFormat(const DACOutputStreams<I> &inStreams, co
 }
 
 template <class Sample>
-void RendererImpl<Sample>::doRenderStreams(const DACOutputStreams<Sample> &streams, Bit32u len)
+static inline void advanceStreams(PartOutputStreams<Sample> &streams, Bit32u len) {
+	for (int partNum = 0; partNum < 9; partNum++) {
+		advanceStream(streams.partLeft[partNum], len);
+		advanceStream(streams.partRight[partNum], len);
+	}
+	advanceStream(streams.reverbWetLeft, len);
+	advanceStream(streams.reverbWetRight, len);
+}
+
+template <class Sample>
+static inline void muteStreams(const PartOutputStreams<Sample> &streams, Bit32u len) {
+	for (int partNum = 0; partNum < 9; partNum++) {
+		Synth::muteSampleBuffer(streams.partLeft[partNum], len);
+		Synth::muteSampleBuffer(streams.partRight[partNum], len);
+	}
+	Synth::muteSampleBuffer(streams.reverbWetLeft, len);
+	Synth::muteSampleBuffer(streams.reverbWetRight, len);
+}
+
+template <class I, class O>
+static inline void convertStreamsFormat(const PartOutputStreams<I> &inStreams, const PartOutputStreams<O> &outStreams, Bit32u len) {
+	for (int partNum = 0; partNum < 9; partNum++) {
+		convertSampleFormat(inStreams.partLeft[partNum], outStreams.partLeft[partNum], len);
+		convertSampleFormat(inStreams.partRight[partNum], outStreams.partRight[partNum], len);
+	}
+	convertSampleFormat(inStreams.reverbWetLeft, outStreams.reverbWetLeft, len);
+	convertSampleFormat(inStreams.reverbWetRight, outStreams.reverbWetRight, len);
+}
+
+static inline void mixSampleBuffer(IntSample *buffer, const IntSample *addend, Bit32u len) {
+	getDSPKernels().mixInt(buffer, addend, len);
+}
+
+static inline void mixSampleBuffer(FloatSample *buffer, const FloatSample *addend, Bit32u len) {
+	getDSPKernels().mixFloat(buffer, addend, len);
+}
+
+template <class Sample>
+template <class Streams>
+void RendererImpl<Sample>::doRenderStreams(const Streams &streams, Bit32u len)
 {
-	DACOutputStreams<Sample> tmpStreams = streams;
+	Streams tmpStreams = streams;
 	while (len > 0) {
+		// Control events don't require a delay, so they are applied right away when due.
+		Bit32u samplesToNextControlEvent = applyDueControlEvents();
 		// We need to ensure zero-duration notes will play so add minimum 1-sample delay.
 		Bit32u thisLen = 1;
+		Bit32u maxLen = len > MAX_SAMPLES_PER_RUN ? MAX_SAMPLES_PER_RUN : len;
+		if (maxLen > samplesToNextControlEvent) {
+			maxLen = samplesToNextControlEvent;
+		}
 		if (!isAbortingPoly()) {
 			const MidiEvent *nextEvent = getMidiQueue().peekMidiEvent();
 			Bit32s samplesToNextEvent = (nextEvent != NULL) ? Bit32s(nextEvent->timestamp - getRenderedSampleCount()) : MAX_SAMPLES_PER_RUN;
 			if (samplesToNextEvent > 0) {
-				thisLen = len > MAX_SAMPLES_PER_RUN ? MAX_SAMPLES_PER_RUN : len;
-				if (thisLen > Bit32u(samplesToNextEvent)) {
-					thisLen = samplesToNextEvent;
-				}
+				thisLen = maxLen > Bit32u(samplesToNextEvent) ? Bit32u(samplesToNextEvent) : maxLen;
 			} else {
+				const double midiStartNanos = getRenderStatistics().startStage();
+				if (isNextMidiEventSuperseded()) {
+					// The dropped message doesn't need the minimum delay, so proceed to the next event right away.
+					getMidiQueue().dropMidiEvent();
+					getRenderStatistics().countMidiEvent(false);
+					getRenderStatistics().finishStage(RenderStatisticsCollector::Stage_MIDI, midiStartNanos);
+					continue;
+				}
 				if (nextEvent->sysexData == NULL) {
+					applyDeferredRefreshes();
 					synth.playMsgNow(nextEvent->shortMessageData);
 					// If a poly is aborting we don't drop the event from the queue.
 					// Instead, we'll return to it again when the abortion is done.
 					if (!isAbortingPoly()) {
+						recordTraceEvent(TraceEventType_MIDI_MESSAGE, nextEvent->shortMessageData, getRenderedSampleCount() - nextEvent->timestamp);
 						getMidiQueue().dropMidiEvent();
+						getRenderStatistics().countMidiEvent(false);
 					}
 				} else {
+					// SysEx messages tend to come in bulk dumps, so the resulting refreshes are applied once the dump ends.
+					deferRefreshes();
 					synth.playSysexNow(nextEvent->sysexData, nextEvent->sysexLength);
+					recordTraceEvent(TraceEventType_SYSEX_MESSAGE, nextEvent->sysexLength, getRenderedSampleCount() - nextEvent->timestamp);
 					getMidiQueue().dropMidiEvent();
+					getRenderStatistics().countMidiEvent(true);
 				}
+				getRenderStatistics().finishStage(RenderStatisticsCollector::Stage_MIDI, midiStartNanos);
 			}
 		}
-		produceStreams(tmpStreams, thisLen);
+		if (isAbortingPoly()) {
+			// The partials are rendered sample by sample and the pass ends as soon as the abortion is done,
+			// so that the held back event is played exactly when it would be with one-sample passes.
+			thisLen = maxLen;
+		}
+		const double produceStartNanos = getRenderStatistics().startStage();
+		thisLen = produceStreams(tmpStreams, thisLen);
+		getRenderStatistics().finishStage(RenderStatisticsCollector::Stage_PRODUCE_STREAMS, produceStartNanos);
 		advanceStreams(tmpStreams, thisLen);
 		len -= thisLen;
 	}
+	applyDeferredRefreshes();
 }
 
 template <class Sample>
 template <class O>
 void RendererImpl<Sample>::doRenderAndConvertStreams(const DACOutputStreams<O> &streams, Bit32u len) {
-	Sample cnvNonReverbLeft[MAX_SAMPLES_PER_RUN], cnvNonReverbRight[MAX_SAMPLES_PER_RUN];
-	Sample cnvReverbDryLeft[MAX_SAMPLES_PER_RUN], cnvReverbDryRight[MAX_SAMPLES_PER_RUN];
-	Sample cnvReverbWetLeft[MAX_SAMPLES_PER_RUN], cnvReverbWetRight[MAX_SAMPLES_PER_RUN];
-
-	const DACOutputStreams<Sample> cnvStreams = {
-		cnvNonReverbLeft, cnvNonReverbRight,
-		cnvReverbDryLeft, cnvReverbDryRight,
-		cnvReverbWetLeft, cnvReverbWetRight
-	};
-
+	// All the streams are rendered to the temp buffers, like in doRender(), and converted from there.
 	DACOutputStreams<O> tmpStreams = streams;
 
+	while (len > 0) {
+		Bit32u thisPassLen = len > MAX_SAMPLES_PER_RUN ? MAX_SAMPLES_PER_RUN : len;
+		doRenderStreams(tmpBuffers, thisPassLen);
+		convertStreamsFormat(tmpBuffers, tmpStreams, thisPassLen);
+		advanceStreams(tmpStreams, thisPassLen);
+		len -= thisPassLen;
+	}
+}
+
+template <class Sample>
+template <class O>
+void RendererImpl<Sample>::doRenderAndConvertPartStreams(const PartOutputStreams<O> &streams, Bit32u len) {
+	// The passes are as long as in doRenderAndConvertStreams(), so that the output matches the DAC streams exactly.
+	// The reverb wet streams are rendered to the stereo buffer, as it is unused otherwise.
+	if (tmpPartBuffers == NULL) {
+		tmpPartBuffers = new Sample[18 * MAX_SAMPLES_PER_RUN];
+	}
+	PartOutputStreams<Sample> cnvStreams;
+	for (int partNum = 0; partNum < 9; partNum++) {
+		cnvStreams.partLeft[partNum] = streams.partLeft[partNum] == NULL ? NULL : tmpPartBuffers + 2 * partNum * MAX_SAMPLES_PER_RUN;
+		cnvStreams.partRight[partNum] = streams.partRight[partNum] == NULL ? NULL : tmpPartBuffers + (2 * partNum + 1) * MAX_SAMPLES_PER_RUN;
+	}
+	cnvStreams.reverbWetLeft = streams.reverbWetLeft == NULL ? NULL : tmpStereoBuffer;
+	cnvStreams.reverbWetRight = streams.reverbWetRight == NULL ? NULL : tmpStereoBuffer + MAX_SAMPLES_PER_RUN;
+
+	PartOutputStreams<O> tmpStreams = streams;
+
 	while (len > 0) {
 		Bit32u thisPassLen = len > MAX_SAMPLES_PER_RUN ? MAX_SAMPLES_PER_RUN : len;
 		doRenderStreams(cnvStreams, thisPassLen);
@@ -2073,6 +3171,26 @@ void RendererImpl<FloatSample>::renderStreams(const DACOutputStreams<FloatSample
 	doRenderStreams(streams, len);
 }
 
+template<>
+void RendererImpl<IntSample>::renderPartStreams(const PartOutputStreams<IntSample> &streams, Bit32u len) {
+	doRenderStreams(streams, len);
+}
+
+template<>
+void RendererImpl<IntSample>::renderPartStreams(const PartOutputStreams<FloatSample> &streams, Bit32u len) {
+	doRenderAndConvertPartStreams(streams, len);
+}
+
+template<>
+void RendererImpl<FloatSample>::renderPartStreams(const PartOutputStreams<IntSample> &streams, Bit32u len) {
+	doRenderAndConvertPartStreams(streams, len);
+}
+
+template<>
+void RendererImpl<FloatSample>::renderPartStreams(const PartOutputStreams<FloatSample> &streams, Bit32u len) {
+	doRenderStreams(streams, len);
+}
+
 template <class S>
 static inline void renderStreams(bool opened, Renderer *renderer, const DACOutputStreams<S> &streams, Bit32u len) {
 	if (opened) {
@@ -2083,11 +3201,36 @@ static inline void renderStreams(bool opened, Renderer *renderer, const DACOutpu
 }
 
 void Synth::renderStreams(const DACOutputStreams<Bit16s> &streams, Bit32u len) {
+	startRendering(len);
 	MT32Emu::renderStreams(opened, renderer, streams, len);
+	finishRendering();
 }
 
 void Synth::renderStreams(const DACOutputStreams<float> &streams, Bit32u len) {
+	startRendering(len);
 	MT32Emu::renderStreams(opened, renderer, streams, len);
+	finishRendering();
+}
+
+template <class S>
+static inline void renderPartStreams(bool opened, Renderer *renderer, const PartOutputStreams<S> &streams, Bit32u len) {
+	if (opened) {
+		renderer->renderPartStreams(streams, len);
+	} else {
+		muteStreams(streams, len);
+	}
+}
+
+void Synth::renderPartStreams(const PartOutputStreams<Bit16s> &streams, Bit32u len) {
+	startRendering(len);
+	MT32Emu::renderPartStreams(opened, renderer, streams, len);
+	finishRendering();
+}
+
+void Synth::renderPartStreams(const PartOutputStreams<float> &streams, Bit32u len) {
+	startRendering(len);
+	MT32Emu::renderPartStreams(opened, renderer, streams, len);
+	finishRendering();
 }
 
 void Synth::renderStreams(
@@ -2124,16 +3267,10 @@ template <>
 void RendererImpl<IntSample>::produceLA32Output(IntSample *buffer, Bit32u len) {
 	switch (synth.getDACInputMode()) {
 		case DACInputMode_GENERATION2:
-			while (len--) {
-				*buffer = (*buffer & 0x8000) | ((*buffer << 1) & 0x7FFE) | ((*buffer >> 14) & 0x0001);
-				++buffer;
-			}
+			getDSPKernels().shiftGeneration2Int(buffer, len);
 			break;
 		case DACInputMode_NICE:
-			while (len--) {
-				*buffer = Synth::clipSampleEx(IntSampleEx(*buffer) << 1);
-				++buffer;
-			}
+			getDSPKernels().amplifyInt(buffer, len);
 			break;
 		default:
 			break;
@@ -2143,10 +3280,7 @@ void RendererImpl<IntSample>::produceLA32Output(IntSample *buffer, Bit32u len) {
 template <>
 void RendererImpl<IntSample>::convertSamplesToOutput(IntSample *buffer, Bit32u len) {
 	if (synth.getDACInputMode() == DACInputMode_GENERATION1) {
-		while (len--) {
-			*buffer = IntSample((*buffer & 0x8000) | ((*buffer << 1) & 0x7FFE));
-			++buffer;
-		}
+		getDSPKernels().shiftGeneration1Int(buffer, len);
 	}
 }
 
@@ -2193,8 +3327,65 @@ void RendererImpl<FloatSample>::convertSamplesToOutput(FloatSample *buffer, Bit3
 	}
 }
 
+// Renders the active partials and advances the rendered sample count. While a poly is being aborted, the partials are
+// rendered one sample at a time until the abortion completes. Returns the number of samples rendered.
+template <class Sample>
+Bit32u RendererImpl<Sample>::producePartialOutput(Sample *nonReverbLeft, Sample *nonReverbRight, Sample *reverbDryLeft, Sample *reverbDryRight, Bit32u len) {
+	PartialManager &partialManager = getPartialManager();
+	Bit32u renderedLen = 0;
+	do {
+		const Bit32u stepLen = isAbortingPoly() ? 1 : len - renderedLen;
+		for (Bit32u listIndex = 0; listIndex < partialManager.getActivePartialCount(); listIndex++) {
+			int i = partialManager.getActivePartialIndex(listIndex);
+			if (partialManager.shouldReverb(i)) {
+				partialManager.produceOutput(i, reverbDryLeft + renderedLen, reverbDryRight + renderedLen, stepLen);
+			} else {
+				partialManager.produceOutput(i, nonReverbLeft + renderedLen, nonReverbRight + renderedLen, stepLen);
+			}
+		}
+		partialManager.compactActivePartials();
+		incRenderedSampleCount(stepLen);
+		renderedLen += stepLen;
+	} while (renderedLen < len && isAbortingPoly());
+	return renderedLen;
+}
+
+template <class Sample>
+Bit32u RendererImpl<Sample>::producePartialOutput(Sample * const partLeft[], Sample * const partRight[], Bit32u len) {
+	// Partials sent to the reverb are rendered separately, so that they can be mixed into both the part and the reverb input.
+	// Reverb wet temp buffers are unused otherwise, as the reverb model outputs to the streams directly.
+	Sample *partialLeft = tmpReverbWetLeft;
+	Sample *partialRight = tmpReverbWetRight;
+	PartialManager &partialManager = getPartialManager();
+	Bit32u renderedLen = 0;
+	do {
+		const Bit32u stepLen = isAbortingPoly() ? 1 : len - renderedLen;
+		for (Bit32u listIndex = 0; listIndex < partialManager.getActivePartialCount(); listIndex++) {
+			int i = partialManager.getActivePartialIndex(listIndex);
+			int ownerPart = partialManager.getPartial(i)->getOwnerPart();
+			if (ownerPart < 0) continue;
+			if (partialManager.shouldReverb(i)) {
+				Synth::muteSampleBuffer(partialLeft, stepLen);
+				Synth::muteSampleBuffer(partialRight, stepLen);
+				if (partialManager.produceOutput(i, partialLeft, partialRight, stepLen)) {
+					mixSampleBuffer(partLeft[ownerPart] + renderedLen, partialLeft, stepLen);
+					mixSampleBuffer(partRight[ownerPart] + renderedLen, partialRight, stepLen);
+					mixSampleBuffer(tmpReverbDryLeft + renderedLen, partialLeft, stepLen);
+					mixSampleBuffer(tmpReverbDryRight + renderedLen, partialRight, stepLen);
+				}
+			} else {
+				partialManager.produceOutput(i, partLeft[ownerPart] + renderedLen, partRight[ownerPart] + renderedLen, stepLen);
+			}
+		}
+		partialManager.compactActivePartials();
+		incRenderedSampleCount(stepLen);
+		renderedLen += stepLen;
+	} while (renderedLen < len && isAbortingPoly());
+	return renderedLen;
+}
+
 template <class Sample>
-void RendererImpl<Sample>::produceStreams(const DACOutputStreams<Sample> &streams, Bit32u len) {
+Bit32u RendererImpl<Sample>::produceStreams(const DACOutputStreams<Sample> &streams, Bit32u len) {
 	if (isActivated()) {
 		// Even if LA32 output isn't desired, we proceed anyway with temp buffers
 		Sample *nonReverbLeft = streams.nonReverbLeft == NULL ? tmpNonReverbLeft : streams.nonReverbLeft;
@@ -2207,21 +3398,17 @@ void RendererImpl<Sample>::produceStreams(const DACOutputStreams<Sample> &stream
 		Synth::muteSampleBuffer(reverbDryLeft, len);
 		Synth::muteSampleBuffer(reverbDryRight, len);
 
-		for (unsigned int i = 0; i < synth.getPartialCount(); i++) {
-			if (getPartialManager().shouldReverb(i)) {
-				getPartialManager().produceOutput(i, reverbDryLeft, reverbDryRight, len);
-			} else {
-				getPartialManager().produceOutput(i, nonReverbLeft, nonReverbRight, len);
-			}
-		}
+		len = producePartialOutput(nonReverbLeft, nonReverbRight, reverbDryLeft, reverbDryRight, len);
 
 		produceLA32Output(reverbDryLeft, len);
 		produceLA32Output(reverbDryRight, len);
 
 		if (synth.isReverbEnabled()) {
+			const double reverbStartNanos = getRenderStatistics().startStage();
 			if (!getReverbModel().process(reverbDryLeft, reverbDryRight, streams.reverbWetLeft, streams.reverbWetRight, len)) {
 				printDebug("RendererImpl: Invalid call to BReverbModel::process()!\n");
 			}
+			getRenderStatistics().finishStage(RenderStatisticsCollector::Stage_REVERB, reverbStartNanos);
 			if (streams.reverbWetLeft != NULL) convertSamplesToOutput(streams.reverbWetLeft, len);
 			if (streams.reverbWetRight != NULL) convertSamplesToOutput(streams.reverbWetRight, len);
 		} else {
@@ -2242,10 +3429,70 @@ void RendererImpl<Sample>::produceStreams(const DACOutputStreams<Sample> &stream
 		if (streams.reverbDryRight != NULL) convertSamplesToOutput(reverbDryRight, len);
 	} else {
 		muteStreams(streams, len);
+		getPartialManager().compactActivePartials();
+		incRenderedSampleCount(len);
 	}
+	return len;
+}
 
-	getPartialManager().clearAlreadyOutputed();
-	incRenderedSampleCount(len);
+template <class Sample>
+Bit32u RendererImpl<Sample>::produceStreams(const PartOutputStreams<Sample> &streams, Bit32u len) {
+	if (isActivated()) {
+		// The part streams that aren't desired are still rendered to temp buffers to keep the partials going.
+		Sample *partLeft[9], *partRight[9];
+		for (int partNum = 0; partNum < 9; partNum++) {
+			partLeft[partNum] = streams.partLeft[partNum] == NULL ? tmpNonReverbLeft : streams.partLeft[partNum];
+			partRight[partNum] = streams.partRight[partNum] == NULL ? tmpNonReverbRight : streams.partRight[partNum];
+			Synth::muteSampleBuffer(partLeft[partNum], len);
+			Synth::muteSampleBuffer(partRight[partNum], len);
+		}
+		Synth::muteSampleBuffer(tmpReverbDryLeft, len);
+		Synth::muteSampleBuffer(tmpReverbDryRight, len);
+
+		len = producePartialOutput(partLeft, partRight, len);
+
+		produceLA32Output(tmpReverbDryLeft, len);
+		produceLA32Output(tmpReverbDryRight, len);
+
+		if (synth.isReverbEnabled()) {
+			const double reverbStartNanos = getRenderStatistics().startStage();
+			if (!getReverbModel().process(tmpReverbDryLeft, tmpReverbDryRight, streams.reverbWetLeft, streams.reverbWetRight, len)) {
+				printDebug("RendererImpl: Invalid call to BReverbModel::process()!\n");
+			}
+			getRenderStatistics().finishStage(RenderStatisticsCollector::Stage_REVERB, reverbStartNanos);
+			if (streams.reverbWetLeft != NULL) convertSamplesToOutput(streams.reverbWetLeft, len);
+			if (streams.reverbWetRight != NULL) convertSamplesToOutput(streams.reverbWetRight, len);
+		} else {
+			Synth::muteSampleBuffer(streams.reverbWetLeft, len);
+			Synth::muteSampleBuffer(streams.reverbWetRight, len);
+		}
+
+		for (int partNum = 0; partNum < 9; partNum++) {
+			if (streams.partLeft[partNum] != NULL) {
+				produceLA32Output(partLeft[partNum], len);
+				convertSamplesToOutput(partLeft[partNum], len);
+			}
+			if (streams.partRight[partNum] != NULL) {
+				produceLA32Output(partRight[partNum], len);
+				convertSamplesToOutput(partRight[partNum], len);
+			}
+		}
+	} else {
+		muteStreams(streams, len);
+		getPartialManager().compactActivePartials();
+		incRenderedSampleCount(len);
+	}
+	return len;
+}
+
+PatchCache *Synth::getTimbreCache(unsigned int timbreCacheNum) {
+	return extensions.timbreCache[timbreCacheNum];
+}
+
+void Synth::invalidateTimbreCache(unsigned int firstTimbreCacheNum, unsigned int lastTimbreCacheNum) {
+	for (unsigned int i = firstTimbreCacheNum; i <= lastTimbreCacheNum; i++) {
+		extensions.timbreCache[i][0].dirty = true;
+	}
 }
 
 void Synth::printPartialUsage(Bit32u sampleOffset) {
@@ -2262,12 +3509,7 @@ bool Synth::hasActivePartials() const {
 	if (!opened) {
 		return false;
 	}
-	for (unsigned int partialNum = 0; partialNum < getPartialCount(); partialNum++) {
-		if (partialManager->getPartial(partialNum)->isActive()) {
-			return true;
-		}
-	}
-	return false;
+	return partialManager->hasActivePartials();
 }
 
 bool Synth::isActive() {
@@ -2356,6 +3598,307 @@ const char *Synth::getPatchName(Bit8u partNumber) const {
 	return (!opened || partNumber > 8) ? NULL : parts[partNumber]->getCurrentInstr();
 }
 
+void Synth::setStateSnapshotEnabled(bool enabled) {
+	extensions.stateSnapshotEnabled = enabled;
+}
+
+bool Synth::isStateSnapshotEnabled() const {
+	return extensions.stateSnapshotEnabled;
+}
+
+bool Synth::getStateSnapshot(StateSnapshot &snapshot) const {
+	if (!opened) return false;
+	return extensions.stateSnapshotBuffer->read(snapshot, partialCount);
+}
+
+void Synth::setDeferredReportingEnabled(bool enabled) {
+	DeferredReportHandler *deferredReportHandler = extensions.deferredReportHandler;
+	if ((deferredReportHandler != NULL) == enabled) return;
+	if (enabled) {
+		deferredReportHandler = new DeferredReportHandler(*reportHandler);
+		extensions.deferredReportHandler = deferredReportHandler;
+		reportHandler = deferredReportHandler;
+		return;
+	}
+	reportHandler = &deferredReportHandler->getReportHandler();
+	extensions.deferredReportHandler = NULL;
+	deferredReportHandler->deliverReports();
+	deferredReportHandler->commitReports();
+	deferredReportHandler->deliverReports();
+	delete deferredReportHandler;
+}
+
+bool Synth::isDeferredReportingEnabled() const {
+	return extensions.deferredReportHandler != NULL;
+}
+
+void Synth::deliverDeferredReports() {
+	if (extensions.deferredReportHandler != NULL) {
+		extensions.deferredReportHandler->deliverReports();
+	}
+}
+
+void Synth::setRenderStatisticsEnabled(bool enabled) {
+	extensions.renderStatistics.setEnabled(enabled);
+}
+
+bool Synth::isRenderStatisticsEnabled() const {
+	return extensions.renderStatistics.isEnabled();
+}
+
+bool Synth::getRenderStatistics(RenderStatistics &statistics) const {
+	return MT32EMU_RENDER_STATISTICS && extensions.renderStatistics.read(statistics);
+}
+
+void Synth::resetRenderStatistics() {
+	extensions.renderStatistics.requestReset();
+}
+
+void Synth::setTraceEnabled(bool enabled) {
+	if (enabled && extensions.traceBuffer == NULL) {
+		extensions.traceBuffer = new TraceBuffer;
+	}
+	extensions.traceEnabled = enabled;
+}
+
+bool Synth::isTraceEnabled() const {
+	return extensions.traceEnabled;
+}
+
+Bit32u Synth::readTraceEvents(TraceEvent *events, Bit32u maxCount) {
+	if (extensions.traceBuffer == NULL) return 0;
+	return extensions.traceBuffer->read(events, maxCount);
+}
+
+void Synth::recordTraceEvent(TraceEventType type, Bit32u data1, Bit32u data2) {
+	if (extensions.traceEnabled) {
+		extensions.traceBuffer->record(type, renderedSampleCount, data1, data2);
+	}
+}
+
+bool Synth::getPolyphonyStatistics(PolyphonyStatistics &statistics) const {
+	return extensions.polyphonyStatistics.read(statistics);
+}
+
+void Synth::resetPolyphonyStatistics() {
+	extensions.polyphonyStatistics.requestReset();
+}
+
+bool Synth::startMidiCapture(const char *filename) {
+	stopMidiCapture();
+	if (!opened) return false;
+
+	MidiCaptureHeader header;
+	memset(&header, 0, sizeof(header));
+	strncpy(header.controlROMSHA1, extensions.controlROMInfo->sha1Digest, sizeof(header.controlROMSHA1) - 1);
+	strncpy(header.pcmROMSHA1, extensions.pcmROMInfo->sha1Digest, sizeof(header.pcmROMSHA1) - 1);
+	strncpy(header.controlROMShortName, extensions.controlROMInfo->shortName, sizeof(header.controlROMShortName) - 1);
+	strncpy(header.pcmROMShortName, extensions.pcmROMInfo->shortName, sizeof(header.pcmROMShortName) - 1);
+	header.partialCount = partialCount;
+	header.analogOutputMode = extensions.analogOutputMode;
+	header.rendererType = extensions.openedRendererType;
+	header.midiDelayMode = midiDelayMode;
+	header.startSampleCount = renderedSampleCount;
+
+	MidiCaptureWriter *writer = new MidiCaptureWriter;
+	if (!writer->open(filename, header)) {
+		delete writer;
+		return false;
+	}
+	extensions.midiCaptureWriter = writer;
+	extensions.midiCaptureStartSampleCount = renderedSampleCount;
+
+	// The current settings go first, so that the replay starts in the same configuration.
+	captureSetting(MidiCaptureSetting_REVERB_OVERRIDDEN, reverbOverridden ? 1 : 0);
+	captureSetting(MidiCaptureSetting_REVERB_COMPATIBILITY_MODE, isMT32ReverbCompatibilityMode() ? 1 : 0);
+	captureSetting(MidiCaptureSetting_REVERB_ENABLED, isReverbEnabled() ? 1 : 0);
+	captureSetting(MidiCaptureSetting_DAC_INPUT_MODE, Bit32u(dacInputMode));
+	captureSetting(MidiCaptureSetting_OUTPUT_GAIN, floatToBits(outputGain));
+	captureSetting(MidiCaptureSetting_REVERB_OUTPUT_GAIN, floatToBits(reverbOutputGain));
+	captureSetting(MidiCaptureSetting_REVERSED_STEREO_ENABLED, reversedStereoEnabled ? 1 : 0);
+	captureSetting(MidiCaptureSetting_NICE_AMP_RAMP_ENABLED, extensions.niceAmpRamp ? 1 : 0);
+	captureSetting(MidiCaptureSetting_NICE_PANNING_ENABLED, extensions.nicePanning ? 1 : 0);
+	captureSetting(MidiCaptureSetting_NICE_PARTIAL_MIXING_ENABLED, extensions.nicePartialMixing ? 1 : 0);
+	captureSetting(MidiCaptureSetting_CONTROLLER_COALESCING_ENABLED, extensions.controllerCoalescing ? 1 : 0);
+	captureSetting(MidiCaptureSetting_PARTIAL_CULLING_ENABLED, extensions.partialCulling ? 1 : 0);
+	captureSetting(MidiCaptureSetting_PARTIAL_CULLING_THRESHOLD, extensions.partialCullingThreshold);
+	captureSetting(MidiCaptureSetting_PARTIAL_CULLING_HOLD_TIME, extensions.partialCullingHoldTime);
+	captureSetting(MidiCaptureSetting_NOTE_RENDER_CACHE_ENABLED, extensions.noteRenderCacheEnabled ? 1 : 0);
+	return extensions.midiCaptureWriter != NULL;
+}
+
+void Synth::stopMidiCapture() {
+	if (extensions.midiCaptureWriter == NULL) return;
+	captureInput(MidiCaptureRecordType_END, 0, NULL, 0, renderedSampleCount);
+	// NOTE: The writer is already deleted here if writing the END record failed.
+	delete extensions.midiCaptureWriter;
+	extensions.midiCaptureWriter = NULL;
+}
+
+bool Synth::isMidiCaptureActive() const {
+	return extensions.midiCaptureWriter != NULL;
+}
+
+static void initMidiCaptureRecord(MidiCaptureRecord &record, MidiCaptureRecordType type, Bit32u data, Bit32u timestamp) {
+	record.type = type;
+	record.timestamp = timestamp;
+	record.timed = false;
+	record.setting = MidiCaptureSetting_REVERB_ENABLED;
+	record.data = data;
+	record.sysexData = NULL;
+	record.sysexLength = 0;
+}
+
+void Synth::captureInput(MidiCaptureRecordType type, Bit32u data, const Bit8u *sysexData, Bit32u sysexLength, Bit32u timestamp) {
+	if (extensions.midiCaptureWriter == NULL) return;
+	MidiCaptureRecord record;
+	initMidiCaptureRecord(record, type, data, timestamp);
+	record.sysexData = sysexData;
+	record.sysexLength = sysexLength;
+	writeMidiCaptureRecord(record);
+}
+
+void Synth::captureSetting(MidiCaptureSetting setting, Bit32u value) {
+	if (extensions.midiCaptureWriter == NULL || extensions.midiCaptureSuppressed) return;
+	MidiCaptureRecord record;
+	initMidiCaptureRecord(record, MidiCaptureRecordType_SETTING, value, renderedSampleCount);
+	record.setting = setting;
+	writeMidiCaptureRecord(record);
+}
+
+void Synth::captureTimedSetting(MidiCaptureSetting setting, Bit32u value, Bit32u timestamp) {
+	if (extensions.midiCaptureWriter == NULL || extensions.midiCaptureSuppressed) return;
+	MidiCaptureRecord record;
+	initMidiCaptureRecord(record, MidiCaptureRecordType_SETTING, value, timestamp);
+	record.setting = setting;
+	record.timed = true;
+	writeMidiCaptureRecord(record);
+}
+
+void Synth::writeMidiCaptureRecord(MidiCaptureRecord &record) {
+	// Sample counts are stored relative to the start of the capture, so that the replay may start from a freshly opened synth.
+	record.renderedSampleCount = renderedSampleCount - extensions.midiCaptureStartSampleCount;
+	record.timestamp -= extensions.midiCaptureStartSampleCount;
+	if (!extensions.midiCaptureWriter->write(record)) {
+		printDebug("MIDI capture stopped due to a write error\n");
+		delete extensions.midiCaptureWriter;
+		extensions.midiCaptureWriter = NULL;
+	}
+}
+
+void Synth::updateMidiQueueHighWaterMark() {
+	const Bit32u eventCount = midiQueue->getEventCount();
+	if (extensions.midiQueueHighWaterMark < eventCount) {
+		extensions.midiQueueHighWaterMark = eventCount;
+	}
+}
+
+void Synth::countStartedPoly(unsigned int partNum) {
+	PolyphonyStatisticsCollector &polyphonyStatistics = extensions.polyphonyStatistics;
+	polyphonyStatistics.getAccumulated().startedPolyCount++;
+	polyphonyStatistics.updatePeaks(partialCount - partialManager->getFreePartialCount(), partNum, parts[partNum]->getActivePartialCount());
+}
+
+void Synth::countAbortedPoly(unsigned int reason, unsigned int abortedPartNum, unsigned int requestingPartNum) {
+	extensions.polyphonyStatistics.countAbortedPoly(reason, abortedPartNum != requestingPartNum);
+}
+
+void Synth::countRefusedNote() {
+	extensions.polyphonyStatistics.getAccumulated().refusedNoteCount++;
+}
+
+void Synth::countPartialLifetime(Bit32u lifetime) {
+	extensions.polyphonyStatistics.countPartialLifetime(lifetime);
+}
+
+void Synth::countCulledPartials(Bit32u count) {
+	extensions.polyphonyStatistics.getAccumulated().culledPartialCount += count;
+}
+
+void Synth::getPartialCullingParameters(Bit32u &levelThreshold, Bit32u &holdTime) const {
+	// The levels never drop below zero, so nothing is culled while culling is disabled.
+	levelThreshold = extensions.partialCulling ? extensions.partialCullingThreshold << 10 : 0;
+	holdTime = extensions.partialCullingHoldTime;
+}
+
+NoteRenderCache *Synth::getNoteRenderCache() const {
+	return extensions.noteRenderCacheEnabled ? extensions.noteRenderCache : NULL;
+}
+
+void Synth::startRendering(Bit32u len) {
+	extensions.renderStatistics.startBlock(renderedSampleCount);
+	if (extensions.polyphonyStatistics.serveResetRequest(extensions.midiQueueOverflowCount)) {
+		// This may race with the MIDI input thread, though the worst outcome is a stale high-water mark.
+		extensions.midiQueueHighWaterMark = 0;
+	}
+	extensions.polyphonyBlockStartSampleCount = renderedSampleCount;
+	if (!extensions.noteRenderCacheEnabled && extensions.noteRenderCache != NULL) {
+		extensions.noteRenderCache->clear();
+	}
+	if (extensions.traceEnabled) {
+		const Bit32u midiQueueOverflowCount = extensions.midiQueueOverflowCount;
+		if (extensions.tracedMidiQueueOverflowCount != midiQueueOverflowCount) {
+			recordTraceEvent(TraceEventType_MIDI_QUEUE_OVERFLOW, midiQueueOverflowCount - extensions.tracedMidiQueueOverflowCount);
+			extensions.tracedMidiQueueOverflowCount = midiQueueOverflowCount;
+		}
+		extensions.traceBlockStartSampleCount = renderedSampleCount;
+		recordTraceEvent(TraceEventType_BLOCK_START, len);
+	}
+}
+
+void Synth::finishRendering() {
+	RenderStatisticsCollector &renderStatistics = extensions.renderStatistics;
+	if (renderStatistics.isBlockTimed()) {
+		renderStatistics.finishBlock(renderedSampleCount, opened ? partialCount - partialManager->getFreePartialCount() : 0);
+	}
+	if (extensions.traceEnabled) {
+		recordTraceEvent(TraceEventType_BLOCK_END, renderedSampleCount - extensions.traceBlockStartSampleCount);
+	}
+	if (opened) {
+		Bit32u partPartialCounts[9];
+		for (int partNum = 0; partNum < 9; partNum++) {
+			partPartialCounts[partNum] = parts[partNum]->getActivePartialCount();
+		}
+		extensions.polyphonyStatistics.finishBlock(renderedSampleCount - extensions.polyphonyBlockStartSampleCount, partialCount - partialManager->getFreePartialCount(),
+			partPartialCounts, extensions.midiQueueHighWaterMark, extensions.midiQueueOverflowCount);
+	}
+	publishStateSnapshot();
+	if (extensions.deferredReportHandler != NULL) {
+		extensions.deferredReportHandler->commitReports();
+	}
+}
+
+void Synth::startResampling() {
+	extensions.renderStatistics.startResampling();
+}
+
+void Synth::finishResampling() {
+	extensions.renderStatistics.finishResampling();
+}
+
+void Synth::publishStateSnapshot() {
+	if (!opened || !extensions.stateSnapshotEnabled) return;
+	StateSnapshot &snapshot = extensions.stateSnapshotBuffer->getUpdatingSnapshot();
+	snapshot.renderedSampleCount = renderedSampleCount;
+	snapshot.partStates = getPartStates();
+	getPartialStates(snapshot.partialStates);
+	// As each playing note occupies at least one partial, the total number of notes never exceeds partialCount.
+	Bit32u totalNoteCount = 0;
+	for (Bit8u partNumber = 0; partNumber < 9; partNumber++) {
+		Bit32u noteCount = getPlayingNotes(partNumber, snapshot.keys + totalNoteCount, snapshot.velocities + totalNoteCount);
+		snapshot.playingNoteCounts[partNumber] = noteCount;
+		totalNoteCount += noteCount;
+		strncpy(snapshot.patchNames[partNumber], getPatchName(partNumber), sizeof(snapshot.patchNames[partNumber]) - 1);
+		snapshot.patchNames[partNumber][sizeof(snapshot.patchNames[partNumber]) - 1] = 0;
+	}
+	snapshot.masterVolume = mt32ram.system.masterVol;
+	snapshot.reverbEnabled = isReverbEnabled();
+	snapshot.reverbMode = mt32ram.system.reverbMode;
+	snapshot.reverbTime = mt32ram.system.reverbTime;
+	snapshot.reverbLevel = mt32ram.system.reverbLevel;
+	extensions.stateSnapshotBuffer->publish();
+}
+
 const Part *Synth::getPart(Bit8u partNum) const {
 	if (partNum > 8) {
 		return NULL;
@@ -2413,9 +3956,12 @@ void MemoryRegion::write(unsigned int entry, unsigned int off, const Bit8u *src,
 		return;
 	}
 
+	// Track the offset within the entry rather than taking it modulo entrySize for each byte.
+	unsigned int entryOff = off % entrySize;
 	for (unsigned int i = 0; i < len; i++) {
 		Bit8u desiredValue = src[i];
-		Bit8u maxValue = getMaxValue(memOff);
+		Bit8u maxValue = maxTable == NULL ? 0xFF : maxTable[entryOff];
+		if (++entryOff == entrySize) entryOff = 0;
 		// maxValue == 0 means write-protected unless called from initialisation code, in which case it really means the maximum value is 0.
 		if (maxValue != 0 || init) {
 			if (desiredValue > maxValue) {
@@ -2436,6 +3982,7 @@ void MemoryRegion::write(unsigned int entry, unsigned int off, const Bit8u *src,
 }
 
 void Synth::softReset() {
+	captureInput(MidiCaptureRecordType_SOFT_RESET, 0, NULL, 0, renderedSampleCount);
 	partialManager->deactivateAll();
 	for (int i = 0; i < 9; i++) {
 		parts[i]->reset();
@@ -25,6 +25,7 @@
 #include "globals.h"
 #include "Types.h"
 #include "Enumerations.h"
+#include "MidiCapture.h"
 
 namespace MT32Emu {
 
@@ -33,6 +34,7 @@ class BReverbModel;
 class Extensions;
 class MemoryRegion;
 class MidiEventQueue;
+class NoteRenderCache;
 class Part;
 class Poly;
 class Partial;
@@ -49,9 +51,11 @@ class SystemMemoryRegion;
 class DisplayMemoryRegion;
 class ResetMemoryRegion;
 
+struct ControlEvent;
 struct ControlROMFeatureSet;
 struct ControlROMMap;
 struct PCMWaveEntry;
+struct PatchCache;
 struct MemParams;
 
 const Bit8u SYSEX_MANUFACTURER_ROLAND = 0x41;
@@ -82,6 +86,122 @@ struct DACOutputStreams {
 	T *reverbWetRight;
 };
 
+// Set of per-part output streams taken at the DAC entrance, see Synth::renderPartStreams().
+template <class T>
+struct PartOutputStreams {
+	// Dry signal of each part, the rhythm part goes last.
+	T *partLeft[9];
+	T *partRight[9];
+	// Shared output of the reverb model fed by all the parts.
+	T *reverbWetLeft;
+	T *reverbWetRight;
+};
+
+// Consistent copy of the synth state intended for monitoring purposes. It is published by the renderer once per rendered block.
+// See Synth::getStateSnapshot().
+struct StateSnapshot {
+	// Value of the global rendered sample counter at the moment the snapshot was published.
+	Bit32u renderedSampleCount;
+	// States of all the parts as a bit set, see Synth::getPartStates().
+	Bit32u partStates;
+	// Names of the patches set on the parts, see Synth::getPatchName().
+	char patchNames[9][11];
+	// Numbers of currently playing notes on the parts.
+	Bit32u playingNoteCounts[9];
+	// Current master volume setting, 0-100.
+	Bit8u masterVolume;
+	// Current reverb settings.
+	bool reverbEnabled;
+	Bit8u reverbMode;
+	Bit8u reverbTime;
+	Bit8u reverbLevel;
+	// Arrays provided by the client, each must be large enough to accommodate getPartialCount() entries.
+	// Any of them may be NULL to skip it. The keys and velocities of the playing notes are grouped by part
+	// in ascending order, so that the notes of part N immediately follow those of part N - 1.
+	PartialState *partialStates;
+	Bit8u *keys;
+	Bit8u *velocities;
+};
+
+// Accumulated timing and load figures of the rendering engine, see Synth::getRenderStatistics().
+// A rendered block corresponds to a single call to render(), renderStreams() or renderPartStreams().
+// Times are measured with a monotonic system clock and expressed in nanoseconds.
+struct RenderStatistics {
+	// Number of rendered blocks accounted.
+	Bit32u blockCount;
+	// Number of samples produced at the internal synth sample rate (32000 Hz).
+	double sampleCount;
+	// Total time spent in rendering blocks, which comprises the stages below.
+	double totalNanos;
+	// Time spent in producing the output of partials, mixing it and converting to the DAC input format.
+	double partialNanos;
+	// Time spent in the reverb model.
+	double reverbNanos;
+	// Time spent in the analogue circuit emulation.
+	double analogNanos;
+	// Time spent in processing of the MIDI events retrieved from the MIDI event queue.
+	double midiNanos;
+	// Time spent in sample rate conversion by SampleRateConverter, not included in totalNanos.
+	double resamplerNanos;
+	// Numbers of short MIDI messages and SysEx messages retrieved from the MIDI event queue.
+	Bit32u midiMessageCount;
+	Bit32u sysexMessageCount;
+	// Average and maximum number of active partials sampled at the end of each block.
+	double averageActivePartials;
+	Bit32u peakActivePartials;
+	// Duration of the slowest block and the number of samples produced in it at the internal synth sample rate.
+	double worstBlockNanos;
+	Bit32u worstBlockSampleCount;
+};
+
+// Cumulative figures of polyphony and partial allocation intended for capacity planning, see Synth::getPolyphonyStatistics().
+struct PolyphonyStatistics {
+	// Number of samples rendered at the internal synth sample rate since the statistics were reset.
+	double sampleCount;
+	// Time-weighted average number of active partials sampled at the end of each rendered block and the peak number.
+	double averageActivePartials;
+	Bit32u peakActivePartials;
+	// Same as above for each part, the rhythm part goes last.
+	double averagePartPartials[9];
+	Bit32u peakPartPartials[9];
+	// Number of polys started.
+	Bit32u startedPolyCount;
+	// Numbers of polys aborted in order to free partials for a new poly, by reason:
+	// the same key retriggered on a part in single-assign mode;
+	Bit32u sameKeyAbortCount;
+	// a releasing poly on a part that has exceeded its partial reserve;
+	Bit32u releasingAbortCount;
+	// a held or playing poly on a part that has exceeded its partial reserve;
+	Bit32u reserveExceededAbortCount;
+	// a poly on the part that needs partials when nothing else can be freed.
+	Bit32u ownPartAbortCount;
+	// Number of the aborted polys that belonged to a part other than the one that needed partials.
+	Bit32u stolenPolyCount;
+	// Number of notes not played due to lack of free partials or polys.
+	Bit32u refusedNoteCount;
+	// Histogram of lifetimes of the deactivated partials. The first bucket counts the partials that played for less than 20 ms,
+	// the upper bound of each next bucket doubles, and the last bucket counts the partials that played for 20.48 s or longer.
+	Bit32u partialLifetimeHistogram[12];
+	// Maximum number of events held in the MIDI event queue.
+	Bit32u midiQueueHighWaterMark;
+	// Number of failed attempts to enqueue a MIDI event because the MIDI event queue was full.
+	Bit32u midiQueueOverflowCount;
+	// Number of partials deactivated early as inaudible, see Synth::setPartialCullingEnabled().
+	Bit32u culledPartialCount;
+};
+
+// Binary record of a notable event that occurred in the rendering engine, see Synth::readTraceEvents().
+struct TraceEvent {
+	// Reading of a monotonic system clock in nanoseconds when the event was recorded. The starting point is unspecified.
+	double timeNanos;
+	// Value of the global rendered sample counter when the event was recorded.
+	Bit32u renderedSampleCount;
+	TraceEventType type;
+	// Event-specific data, see TraceEventType.
+	Bit32u data1;
+	Bit32u data2;
+};
+
 // Class for the client to supply callbacks for reporting various errors and information
 class MT32EMU_EXPORT ReportHandler {
 public:
@@ -115,6 +235,7 @@ public:
 
 class Synth {
 friend class DefaultMidiStreamParser;
+friend class InternalResampler;
 friend class MemoryRegion;
 friend class Part;
 friend class Partial;
@@ -197,7 +318,31 @@ private:
 	// **************************** Implementation methods **************************
 
 	Bit32u addMIDIInterfaceDelay(Bit32u len, Bit32u timestamp);
+	bool pushControlEvent(ControlEvent &controlEvent, Bit32u timestamp);
+	void applyControlEvent(const ControlEvent &controlEvent);
+	void publishStateSnapshot();
+	void startRendering(Bit32u len);
+	void finishRendering();
+	void startResampling();
+	void finishResampling();
+	void recordTraceEvent(TraceEventType type, Bit32u data1 = 0, Bit32u data2 = 0);
+	void updateMidiQueueHighWaterMark();
+	void countStartedPoly(unsigned int partNum);
+	void countAbortedPoly(unsigned int reason, unsigned int abortedPartNum, unsigned int requestingPartNum); // reason is one of PolyAbortReason
+	void countRefusedNote();
+	void countPartialLifetime(Bit32u lifetime);
+	void countCulledPartials(Bit32u count);
+	void getPartialCullingParameters(Bit32u &levelThreshold, Bit32u &holdTime) const;
+	// Returns NULL unless the note render cache is enabled.
+	NoteRenderCache *getNoteRenderCache() const;
+	void captureInput(MidiCaptureRecordType type, Bit32u data, const Bit8u *sysexData, Bit32u sysexLength, Bit32u timestamp);
+	void captureSetting(MidiCaptureSetting setting, Bit32u value);
+	void captureTimedSetting(MidiCaptureSetting setting, Bit32u value, Bit32u timestamp);
+	void writeMidiCaptureRecord(MidiCaptureRecord &record);
 	bool isAbortingPoly() const { return abortingPoly != NULL; }
+	// Returns the shared PatchCache entries of the timbre, see TIMBRE_CACHE_SIZE. These are rebuilt by Part when marked dirty.
+	PatchCache *getTimbreCache(unsigned int timbreCacheNum);
+	void invalidateTimbreCache(unsigned int firstTimbreCacheNum, unsigned int lastTimbreCacheNum);
 
 	void writeSysexGlobal(Bit32u addr, const Bit8u *sysex, Bit32u len);
 	void readSysex(Bit8u channel, const Bit8u *sysex, Bit32u len) const;
@@ -222,6 +367,10 @@ private:
 	void refreshSystemChanAssign(Bit8u firstPart, Bit8u lastPart);
 	void refreshSystemMasterVol();
 	void refreshSystem();
+	void refreshPart(unsigned int partNum);
+	void refreshPartTimbres(unsigned int firstAbsTimbreNum, unsigned int lastAbsTimbreNum);
+	void deferRefreshes();
+	void applyDeferredRefreshes();
 	void reset();
 	void dispose();
 
@@ -306,7 +455,7 @@ public:
 	// Returns true if the synth is in completely initialized state, otherwise returns false.
 	MT32EMU_EXPORT bool isOpen() const;
 
-	// All the enqueued events are processed by the synth immediately.
+	// All the enqueued events are processed by the synth immediately. The pending polyphony statistics are published as well.
 	MT32EMU_EXPORT void flushMIDIQueue();
 
 	// Sets size of the internal MIDI event queue. The queue size is set to the minimum power of 2 that is greater or equal to the size specified.
@@ -413,6 +562,25 @@ public:
 	// Returns whether left and right output channels are swapped.
 	MT32EMU_EXPORT bool isReversedStereoEnabled() const;
 
+	// Enqueues a change of a rendering control to take effect not before the specified timestamp.
+	// The timestamp has the same meaning as for the MIDI events enqueued via playMsg(). The queued changes are applied
+	// by the rendering engine sample-accurately, so no synchronisation is required with the rendering thread.
+	// Calls from multiple threads must be synchronised. If the synth is not open, the change is applied immediately.
+	// Note, the output gains are applied within the analog circuitry emulation, and in case AnalogOutputMode_ACCURATE
+	// or AnalogOutputMode_OVERSAMPLED is used, the actual change may be shifted by the fraction of an output sample.
+	// The methods return false if the control event queue is full and the change cannot be enqueued.
+
+	// Enqueues a change of the reverb wet output state. See setReverbEnabled(bool).
+	MT32EMU_EXPORT bool setReverbEnabled(bool reverbEnabled, Bit32u timestamp);
+	// Enqueues a change of the DAC input mode. See setDACInputMode(DACInputMode).
+	MT32EMU_EXPORT bool setDACInputMode(DACInputMode mode, Bit32u timestamp);
+	// Enqueues a change of the output gain factor for synth output channels. See setOutputGain(float).
+	MT32EMU_EXPORT bool setOutputGain(float gain, Bit32u timestamp);
+	// Enqueues a change of the output gain factor for the reverb wet output channels. See setReverbOutputGain(float).
+	MT32EMU_EXPORT bool setReverbOutputGain(float gain, Bit32u timestamp);
+	// Enqueues a change of the reversed stereo mode. See setReversedStereoEnabled(bool).
+	MT32EMU_EXPORT bool setReversedStereoEnabled(bool enabled, Bit32u timestamp);
+
 	// Allows to toggle the NiceAmpRamp mode.
 	// In this mode, we want to ensure that amp ramp never jumps to the target
 	// value and always gradually increases or decreases. It seems that real units
@@ -446,6 +614,58 @@ public:
 	// Returns whether NicePartialMixing mode is enabled.
 	MT32EMU_EXPORT bool isNicePartialMixingEnabled() const;
 
+	// Allows to toggle coalescing of dense controller messages. When enabled, a pitch bend, modulation, volume
+	// or expression message taken from the MIDI queue while rendering is dropped if a subsequent message of the same
+	// kind on the same MIDI channel lands within the same control tick (the emulated MCU updates the pitch at 4 kHz)
+	// and only such controller messages come in between. This saves the processing of the dropped messages, including
+	// the one-sample rendering pass that follows each message played late. The messages are never reordered, though
+	// an intermediate value may be skipped that a playing partial could have picked up, so the output may deviate slightly.
+	// Since the emulated MIDI interface delay spreads the short messages over several control ticks, coalescing only takes
+	// effect in MIDIDelayMode_IMMEDIATE. This mode is disabled by default.
+	MT32EMU_EXPORT void setControllerCoalescingEnabled(bool enabled);
+	// Returns whether coalescing of dense controller messages is enabled.
+	MT32EMU_EXPORT bool isControllerCoalescingEnabled() const;
+
+	// Allows to toggle culling of inaudible partials. When enabled, a partial in the release phase of its amplitude envelope
+	// is deactivated and returned to the pool of free partials as soon as its amplitude has stayed below the culling threshold
+	// for the culling hold time. Since the envelope only decays in the release phase, the partial cannot become audible again.
+	// This reduces the number of active partials with long release envelopes, at the cost of the emulation accuracy, since
+	// the partials are freed earlier than on the hardware. This may affect the partial allocation of subsequent notes,
+	// including the phase their partial pairs are mixed in unless the NicePartialMixing mode is enabled.
+	// The number of culled partials is reported in PolyphonyStatistics::culledPartialCount.
+	// This mode is disabled by default.
+	MT32EMU_EXPORT void setPartialCullingEnabled(bool enabled);
+	// Returns whether culling of inaudible partials is enabled.
+	MT32EMU_EXPORT bool isPartialCullingEnabled() const;
+	// Sets the amplitude threshold for culling of inaudible partials. It is expressed as the level of the partial
+	// in the logarithmic domain of the LA32 chip, where each 4096 units double the amplitude. The level is counted up
+	// from the maximum attenuation of 65544 units, and the threshold is clamped to 65535. Below the level of 8192
+	// (14 octaves below the full scale), a partial renders nothing but zero samples in the integer mode, so that the culled
+	// partials themselves cannot be missed. This is the default. Higher values allow culling partials that are still
+	// faintly audible, e.g. below the level of 28672 (9 octaves below the full scale), the output of a partial is limited
+	// to about 50 units of the LA32 output. With the threshold of 0, no partial is ever culled.
+	MT32EMU_EXPORT void setPartialCullingThreshold(Bit32u level);
+	// Returns the amplitude threshold for culling of inaudible partials.
+	MT32EMU_EXPORT Bit32u getPartialCullingThreshold() const;
+	// Sets the time, in samples at the internal synth sample rate, a partial must stay below the culling threshold
+	// before it is deactivated. By default, it is 320 samples (10 ms).
+	MT32EMU_EXPORT void setPartialCullingHoldTime(Bit32u holdTime);
+	// Returns the time a partial must stay below the culling threshold before it is deactivated.
+	MT32EMU_EXPORT Bit32u getPartialCullingHoldTime() const;
+
+	// Allows to toggle the note render cache. When enabled, the output of each partial is recorded along with the inputs
+	// the LA32 wave generators receive from the TVA, TVP and TVF for every sample. Later notes played on the same part
+	// with the same key, velocity and wave generator configuration replay the recorded output instead of synthesising
+	// the waveform, while the envelopes keep running as usual. As soon as the envelopes deviate from the recording,
+	// e.g. due to a controller change, a note-off or a partial being aborted, the note continues with live rendering
+	// seamlessly. Hence, the output is exactly the same as with the cache disabled. This mostly helps with drum parts
+	// and repetitive music. The cache takes up to 8 MiB of memory while the synth is open, the recordings are limited
+	// to about 2 seconds of each note. The recordings are discarded when the cache is disabled.
+	// This mode is disabled by default.
+	MT32EMU_EXPORT void setNoteRenderCacheEnabled(bool enabled);
+	// Returns whether the note render cache is enabled.
+	MT32EMU_EXPORT bool isNoteRenderCacheEnabled() const;
+
 	// Selects new type of the wave generator and renderer to be used during subsequent calls to open().
 	// By default, RendererType_BIT16S is selected.
 	// See RendererType for details.
@@ -477,6 +697,16 @@ public:
 	MT32EMU_EXPORT void renderStreams(float *nonReverbLeft, float *nonReverbRight, float *reverbDryLeft, float *reverbDryRight, float *reverbWetLeft, float *reverbWetRight, Bit32u len);
 	MT32EMU_EXPORT void renderStreams(const DACOutputStreams<float> &streams, Bit32u len);
 
+	// Renders the dry signal of each part to a separate pair of streams along with the shared reverb return in a single pass.
+	// The signal is taken at the DAC entrance, the same way as in renderStreams(). Partials that are sent to the reverb
+	// are also mixed into the dry stream of the owning part, so that the part streams cover both the non-reverb and
+	// the reverb-dry streams. Due to clipping, the integer part streams may not sum up to the mix exactly.
+	// NULL may be specified in place of any or all of the stream buffers to skip it.
+	// The length is in samples, not bytes. Uses NATIVE byte ordering.
+	MT32EMU_EXPORT void renderPartStreams(const PartOutputStreams<Bit16s> &streams, Bit32u len);
+	// Same as above but outputs to float streams.
+	MT32EMU_EXPORT void renderPartStreams(const PartOutputStreams<float> &streams, Bit32u len);
+
 	// Returns true when there is at least one active partial, otherwise false.
 	MT32EMU_EXPORT bool hasActivePartials() const;
 
@@ -522,6 +752,91 @@ public:
 
 	// Stores internal state of emulated synth into an array provided (as it would be acquired from hardware).
 	MT32EMU_EXPORT void readMemory(Bit32u addr, Bit32u len, Bit8u *data);
+
+	// Allows to toggle publishing of the state snapshots. When enabled, the renderer takes a snapshot of the synth state
+	// at the end of each call to render() or renderStreams(), which can be retrieved with getStateSnapshot().
+	// This mode is disabled by default.
+	MT32EMU_EXPORT void setStateSnapshotEnabled(bool enabled);
+	// Returns whether publishing of the state snapshots is enabled.
+	MT32EMU_EXPORT bool isStateSnapshotEnabled() const;
+	// Fills in the most recently published state snapshot. Unlike the methods above that query the live state,
+	// no synchronisation with the rendering thread is required, and the rendering thread is never blocked.
+	// In the unlikely event that a new snapshot is published while copying, the copying is simply retried,
+	// so the call is lock-free but not wait-free.
+	// Calls must be synchronised with open() and close() though.
+	// The first snapshot is published by open() when this mode is enabled beforehand.
+	// Returns false if the synth is not open or no snapshot has been published yet.
+	MT32EMU_EXPORT bool getStateSnapshot(StateSnapshot &snapshot) const;
+
+	// Allows to toggle the deferred reporting mode. In this mode, the notifications about playing MIDI messages,
+	// changes of poly states, programs, reverb settings, LCD messages and device resets are not delivered to the ReportHandler
+	// synchronously while processing MIDI events. Instead, they are gathered during each call to render() or renderStreams(),
+	// and repeated notifications of the same kind are coalesced. The gathered notifications are delivered on invocation of
+	// deliverDeferredReports(). Other callbacks are still invoked immediately.
+	// When the mode is turned off, the pending notifications are delivered right away.
+	// This mode is disabled by default. The calls must be synchronised with the rendering thread.
+	MT32EMU_EXPORT void setDeferredReportingEnabled(bool enabled);
+	// Returns whether the deferred reporting mode is enabled.
+	MT32EMU_EXPORT bool isDeferredReportingEnabled() const;
+	// Delivers the notifications gathered in the deferred reporting mode to the ReportHandler.
+	// It can be invoked either by the rendering thread once per rendered block or by another single thread,
+	// in the latter case no synchronisation with the rendering thread is required.
+	MT32EMU_EXPORT void deliverDeferredReports();
+
+	// Allows to toggle collecting of the render statistics, see struct RenderStatistics. When enabled, the renderer measures
+	// the time spent in each rendering stage and publishes the accumulated figures at the end of each rendered block.
+	// This mode is disabled by default. It can be toggled from any thread, the change takes effect with the next rendered block.
+	// Has no effect if support for the render statistics is not compiled in (see build option libmt32emu_WITH_RENDER_STATISTICS).
+	MT32EMU_EXPORT void setRenderStatisticsEnabled(bool enabled);
+	// Returns whether collecting of the render statistics is enabled.
+	MT32EMU_EXPORT bool isRenderStatisticsEnabled() const;
+	// Fills in the most recently published render statistics. No synchronisation with the rendering thread is required,
+	// the rendering thread is never blocked. Returns false if nothing has been published since the synth was opened.
+	MT32EMU_EXPORT bool getRenderStatistics(RenderStatistics &statistics) const;
+	// Requests clearing of the accumulated render statistics. It is carried out by the renderer at the start
+	// of the next rendered block, thus the figures published before that remain available till the block completes.
+	// Can be invoked from any single thread.
+	MT32EMU_EXPORT void resetRenderStatistics();
+
+	// Allows to toggle recording of the trace events, see struct TraceEvent. When enabled, the rendering engine records
+	// the start and the end of each rendered block, processing of MIDI events, starting and aborting polys, partial allocation
+	// failures, MIDI event queue overflows and changes of the reverb settings into a fixed-size ring buffer that keeps
+	// the most recent 8192 events. Recording never blocks and takes little time, so it may be left enabled for diagnostics.
+	// This mode is disabled by default. The trace buffer is allocated when it is enabled for the first time.
+	// Calls must be synchronised with the rendering thread.
+	MT32EMU_EXPORT void setTraceEnabled(bool enabled);
+	// Returns whether recording of the trace events is enabled.
+	MT32EMU_EXPORT bool isTraceEnabled() const;
+	// Retrieves up to maxCount trace events recorded since the previous call, oldest first. Returns the number of events filled in.
+	// If some events were overwritten before being retrieved, an event of type TraceEventType_EVENTS_LOST precedes the rest,
+	// thus maxCount must be at least 2 for a retrieval to progress.
+	// This method can be invoked by a single thread at a time, no synchronisation with the rendering thread is required.
+	// ChromeTraceWriter may be used to save the retrieved events in a format suitable for visualisation.
+	MT32EMU_EXPORT Bit32u readTraceEvents(TraceEvent *events, Bit32u maxCount);
+
+	// Starts recording the input of the synth to a file with the given name in the compact binary format of MidiCaptureWriter.
+	// The messages accepted by playMsg() and playSysex() are recorded along with their timestamps and the internal rendered
+	// sample count at the moment of the call. The parameters of open(), the current runtime settings and their subsequent changes,
+	// memory writes via writeMemory() and soft resets are recorded as well, so that the capture can be replayed deterministically,
+	// e.g. with the replay mode of mt32emu_bench. To cover the whole session, the capture should be started right after open().
+	// Recording takes place in the calling thread, thus the recorded methods must not be invoked concurrently while capturing.
+	// The capture is stopped when the synth is closed. Returns false if the synth is not open or the file cannot be created.
+	MT32EMU_EXPORT bool startMidiCapture(const char *filename);
+	// Completes the capture and closes the file. Does nothing if no capture is active.
+	MT32EMU_EXPORT void stopMidiCapture();
+	// Returns whether the input is being captured.
+	MT32EMU_EXPORT bool isMidiCaptureActive() const;
+
+	// Fills in the most recently published polyphony statistics, see struct PolyphonyStatistics. The statistics are gathered
+	// all the time while the synth is open and published at the end of a rendered block, at most every 8 ms of the rendered
+	// output, so that rendering in tiny blocks stays cheap. The figures are also published as soon as the last active partial
+	// is gone and on flushMIDIQueue(), so that they are complete once the synth goes idle or the rendering stops.
+	// No synchronisation with the rendering thread is required. Returns false if nothing has been published since the synth
+	// was opened.
+	MT32EMU_EXPORT bool getPolyphonyStatistics(PolyphonyStatistics &statistics) const;
+	// Requests clearing of the polyphony statistics. It is carried out by the renderer at the start of the next rendered block.
+	// Can be invoked from any single thread.
+	MT32EMU_EXPORT void resetPolyphonyStatistics();
 }; // class Synth
 
 } // namespace MT32Emu
@@ -23,6 +23,7 @@
 #include "../Synth.h"
 #include "../MidiStreamParser.h"
 #include "../SampleRateConverter.h"
+#include "../ChromeTraceWriter.h"
 
 #include "c_types.h"
 #include "c_interface.h"
@@ -41,7 +42,7 @@ static mt32emu_service_version getSynthVersionID(mt32emu_service_i) {
 	return MT32EMU_SERVICE_VERSION_CURRENT;
 }
 
-static const mt32emu_service_i_v3 SERVICE_VTABLE = {
+static const mt32emu_service_i_v4 SERVICE_VTABLE = {
 	getSynthVersionID,
 	mt32emu_get_supported_report_handler_version,
 	mt32emu_get_supported_midi_receiver_version,
@@ -116,7 +117,31 @@ static const mt32emu_service_i_v3 SERVICE_VTABLE = {
 	mt32emu_set_nice_panning_enabled,
 	mt32emu_is_nice_panning_enabled,
 	mt32emu_set_nice_partial_mixing_enabled,
-	mt32emu_is_nice_partial_mixing_enabled
+	mt32emu_is_nice_partial_mixing_enabled,
+	mt32emu_render_bit16s_part_streams,
+	mt32emu_render_float_part_streams,
+	mt32emu_set_render_statistics_enabled,
+	mt32emu_is_render_statistics_enabled,
+	mt32emu_get_render_statistics,
+	mt32emu_reset_render_statistics,
+	mt32emu_set_trace_enabled,
+	mt32emu_is_trace_enabled,
+	mt32emu_read_trace_events,
+	mt32emu_write_chrome_trace,
+	mt32emu_get_polyphony_statistics,
+	mt32emu_reset_polyphony_statistics,
+	mt32emu_start_midi_capture,
+	mt32emu_stop_midi_capture,
+	mt32emu_set_controller_coalescing_enabled,
+	mt32emu_is_controller_coalescing_enabled,
+	mt32emu_set_partial_culling_enabled,
+	mt32emu_is_partial_culling_enabled,
+	mt32emu_set_partial_culling_threshold,
+	mt32emu_get_partial_culling_threshold,
+	mt32emu_set_partial_culling_hold_time,
+	mt32emu_get_partial_culling_hold_time,
+	mt32emu_set_note_render_cache_enabled,
+	mt32emu_is_note_render_cache_enabled
 };
 
 } // namespace MT32Emu
@@ -327,7 +352,7 @@ extern "C" {
 
 mt32emu_service_i mt32emu_get_service_i() {
 	mt32emu_service_i i;
-	i.v3 = &SERVICE_VTABLE;
+	i.v4 = &SERVICE_VTABLE;
 	return i;
 }
 
@@ -702,6 +727,14 @@ void mt32emu_render_float_streams(mt32emu_const_context context, const mt32emu_d
 	context->synth->renderStreams(*reinterpret_cast<const DACOutputStreams<float> *>(streams), len);
 }
 
+void mt32emu_render_bit16s_part_streams(mt32emu_const_context context, const mt32emu_part_output_bit16s_streams *streams, mt32emu_bit32u len) {
+	context->synth->renderPartStreams(*reinterpret_cast<const PartOutputStreams<Bit16s> *>(streams), len);
+}
+
+void mt32emu_render_float_part_streams(mt32emu_const_context context, const mt32emu_part_output_float_streams *streams, mt32emu_bit32u len) {
+	context->synth->renderPartStreams(*reinterpret_cast<const PartOutputStreams<float> *>(streams), len);
+}
+
 mt32emu_boolean mt32emu_has_active_partials(mt32emu_const_context context) {
 	return context->synth->hasActivePartials() ? MT32EMU_BOOL_TRUE : MT32EMU_BOOL_FALSE;
 }
@@ -734,4 +767,96 @@ void mt32emu_read_memory(mt32emu_const_context context, mt32emu_bit32u addr, mt3
 	context->synth->readMemory(addr, len, data);
 }
 
+void mt32emu_set_render_statistics_enabled(mt32emu_const_context context, const mt32emu_boolean enabled) {
+	context->synth->setRenderStatisticsEnabled(enabled != MT32EMU_BOOL_FALSE);
+}
+
+mt32emu_boolean mt32emu_is_render_statistics_enabled(mt32emu_const_context context) {
+	return context->synth->isRenderStatisticsEnabled() ? MT32EMU_BOOL_TRUE : MT32EMU_BOOL_FALSE;
+}
+
+mt32emu_boolean mt32emu_get_render_statistics(mt32emu_const_context context, mt32emu_render_statistics *statistics) {
+	return context->synth->getRenderStatistics(*reinterpret_cast<RenderStatistics *>(statistics)) ? MT32EMU_BOOL_TRUE : MT32EMU_BOOL_FALSE;
+}
+
+void mt32emu_reset_render_statistics(mt32emu_const_context context) {
+	context->synth->resetRenderStatistics();
+}
+
+void mt32emu_set_trace_enabled(mt32emu_const_context context, const mt32emu_boolean enabled) {
+	context->synth->setTraceEnabled(enabled != MT32EMU_BOOL_FALSE);
+}
+
+mt32emu_boolean mt32emu_is_trace_enabled(mt32emu_const_context context) {
+	return context->synth->isTraceEnabled() ? MT32EMU_BOOL_TRUE : MT32EMU_BOOL_FALSE;
+}
+
+mt32emu_bit32u mt32emu_read_trace_events(mt32emu_const_context context, mt32emu_trace_event *events, mt32emu_bit32u max_count) {
+	return context->synth->readTraceEvents(reinterpret_cast<TraceEvent *>(events), max_count);
+}
+
+mt32emu_return_code mt32emu_write_chrome_trace(const char *filename, const mt32emu_trace_event *events, mt32emu_bit32u count) {
+	ChromeTraceWriter writer;
+	if (!writer.open(filename)) return MT32EMU_RC_FAILED;
+	if (!writer.write(reinterpret_cast<const TraceEvent *>(events), count)) return MT32EMU_RC_FAILED;
+	return MT32EMU_RC_OK;
+}
+
+mt32emu_boolean mt32emu_get_polyphony_statistics(mt32emu_const_context context, mt32emu_polyphony_statistics *statistics) {
+	return context->synth->getPolyphonyStatistics(*reinterpret_cast<PolyphonyStatistics *>(statistics)) ? MT32EMU_BOOL_TRUE : MT32EMU_BOOL_FALSE;
+}
+
+void mt32emu_reset_polyphony_statistics(mt32emu_const_context context) {
+	context->synth->resetPolyphonyStatistics();
+}
+
+mt32emu_return_code mt32emu_start_midi_capture(mt32emu_const_context context, const char *filename) {
+	if (!context->synth->isOpen()) return MT32EMU_RC_NOT_OPENED;
+	return context->synth->startMidiCapture(filename) ? MT32EMU_RC_OK : MT32EMU_RC_FAILED;
+}
+
+void mt32emu_stop_midi_capture(mt32emu_const_context context) {
+	context->synth->stopMidiCapture();
+}
+
+void mt32emu_set_controller_coalescing_enabled(mt32emu_const_context context, const mt32emu_boolean enabled) {
+	context->synth->setControllerCoalescingEnabled(enabled != MT32EMU_BOOL_FALSE);
+}
+
+mt32emu_boolean mt32emu_is_controller_coalescing_enabled(mt32emu_const_context context) {
+	return context->synth->isControllerCoalescingEnabled() ? MT32EMU_BOOL_TRUE : MT32EMU_BOOL_FALSE;
+}
+
+void mt32emu_set_partial_culling_enabled(mt32emu_const_context context, const mt32emu_boolean enabled) {
+	context->synth->setPartialCullingEnabled(enabled != MT32EMU_BOOL_FALSE);
+}
+
+mt32emu_boolean mt32emu_is_partial_culling_enabled(mt32emu_const_context context) {
+	return context->synth->isPartialCullingEnabled() ? MT32EMU_BOOL_TRUE : MT32EMU_BOOL_FALSE;
+}
+
+void mt32emu_set_partial_culling_threshold(mt32emu_const_context context, const mt32emu_bit32u level) {
+	context->synth->setPartialCullingThreshold(level);
+}
+
+mt32emu_bit32u mt32emu_get_partial_culling_threshold(mt32emu_const_context context) {
+	return context->synth->getPartialCullingThreshold();
+}
+
+void mt32emu_set_partial_culling_hold_time(mt32emu_const_context context, const mt32emu_bit32u hold_time) {
+	context->synth->setPartialCullingHoldTime(hold_time);
+}
+
+mt32emu_bit32u mt32emu_get_partial_culling_hold_time(mt32emu_const_context context) {
+	return context->synth->getPartialCullingHoldTime();
+}
+
+void mt32emu_set_note_render_cache_enabled(mt32emu_const_context context, const mt32emu_boolean enabled) {
+	context->synth->setNoteRenderCacheEnabled(enabled != MT32EMU_BOOL_FALSE);
+}
+
+mt32emu_boolean mt32emu_is_note_render_cache_enabled(mt32emu_const_context context) {
+	return context->synth->isNoteRenderCacheEnabled() ? MT32EMU_BOOL_TRUE : MT32EMU_BOOL_FALSE;
+}
+
 } // extern "C"
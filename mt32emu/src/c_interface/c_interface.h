@@ -413,6 +413,17 @@ MT32EMU_EXPORT void mt32emu_render_bit16s_streams(mt32emu_const_context context,
 /** Same as above but outputs to float streams. */
 MT32EMU_EXPORT void mt32emu_render_float_streams(mt32emu_const_context context, const mt32emu_dac_output_float_streams *streams, mt32emu_bit32u len);
 
+/**
+ * Renders the dry signal of each part to a separate pair of streams along with the shared reverb return in a single pass.
+ * The signal is taken at the DAC entrance like in mt32emu_render_bit16s_streams(). Partials sent to the reverb
+ * are also mixed into the dry stream of the owning part.
+ * NULL may be specified in place of any or all of the stream buffers to skip it.
+ * The length is in samples, not bytes. Uses NATIVE byte ordering.
+ */
+MT32EMU_EXPORT void mt32emu_render_bit16s_part_streams(mt32emu_const_context context, const mt32emu_part_output_bit16s_streams *streams, mt32emu_bit32u len);
+/** Same as above but outputs to float streams. */
+MT32EMU_EXPORT void mt32emu_render_float_part_streams(mt32emu_const_context context, const mt32emu_part_output_float_streams *streams, mt32emu_bit32u len);
+
 /** Returns true when there is at least one active partial, otherwise false. */
 MT32EMU_EXPORT mt32emu_boolean mt32emu_has_active_partials(mt32emu_const_context context);
 
@@ -454,6 +465,104 @@ MT32EMU_EXPORT const char *mt32emu_get_patch_name(mt32emu_const_context context,
 /** Stores internal state of emulated synth into an array provided (as it would be acquired from hardware). */
 MT32EMU_EXPORT void mt32emu_read_memory(mt32emu_const_context context, mt32emu_bit32u addr, mt32emu_bit32u len, mt32emu_bit8u *data);
 
+/**
+ * Allows to toggle collecting of the render statistics. When enabled, the renderer measures the time spent in each rendering stage
+ * and publishes the accumulated figures at the end of each rendered block. This mode is disabled by default.
+ * It can be toggled from any thread, the change takes effect with the next rendered block.
+ */
+MT32EMU_EXPORT void mt32emu_set_render_statistics_enabled(mt32emu_const_context context, const mt32emu_boolean enabled);
+/** Returns whether collecting of the render statistics is enabled. */
+MT32EMU_EXPORT mt32emu_boolean mt32emu_is_render_statistics_enabled(mt32emu_const_context context);
+/**
+ * Fills in the most recently published render statistics. No synchronisation with the rendering thread is required.
+ * Returns false if nothing has been published since the synth was opened or the support is not compiled in.
+ */
+MT32EMU_EXPORT mt32emu_boolean mt32emu_get_render_statistics(mt32emu_const_context context, mt32emu_render_statistics *statistics);
+/** Requests clearing of the accumulated render statistics, which is carried out at the start of the next rendered block. */
+MT32EMU_EXPORT void mt32emu_reset_render_statistics(mt32emu_const_context context);
+
+/**
+ * Allows to toggle recording of the trace events into a fixed-size ring buffer that keeps the most recent events.
+ * This mode is disabled by default. Calls must be synchronised with the rendering thread.
+ */
+MT32EMU_EXPORT void mt32emu_set_trace_enabled(mt32emu_const_context context, const mt32emu_boolean enabled);
+/** Returns whether recording of the trace events is enabled. */
+MT32EMU_EXPORT mt32emu_boolean mt32emu_is_trace_enabled(mt32emu_const_context context);
+/**
+ * Retrieves up to max_count trace events recorded since the previous call, oldest first. Returns the number of events filled in.
+ * If some events were lost, an event of type MT32EMU_TET_EVENTS_LOST precedes the rest, so max_count must be at least 2.
+ * Can be invoked by a single thread at a time, no synchronisation with the rendering thread is required.
+ */
+MT32EMU_EXPORT mt32emu_bit32u mt32emu_read_trace_events(mt32emu_const_context context, mt32emu_trace_event *events, mt32emu_bit32u max_count);
+/**
+ * Saves the trace events to a file with the given name in the JSON format of the Chrome trace event profiling tool.
+ * Returns MT32EMU_RC_OK upon success or MT32EMU_RC_FAILED if the file cannot be written.
+ */
+MT32EMU_EXPORT mt32emu_return_code mt32emu_write_chrome_trace(const char *filename, const mt32emu_trace_event *events, mt32emu_bit32u count);
+
+/**
+ * Fills in the most recently published polyphony statistics. These are gathered all the time while the synth is open
+ * and published at the end of a rendered block, at most every 8 ms of the rendered output. No synchronisation with
+ * the rendering thread is required.
+ * Returns false if nothing has been published since the synth was opened.
+ */
+MT32EMU_EXPORT mt32emu_boolean mt32emu_get_polyphony_statistics(mt32emu_const_context context, mt32emu_polyphony_statistics *statistics);
+/** Requests clearing of the polyphony statistics, which is carried out at the start of the next rendered block. */
+MT32EMU_EXPORT void mt32emu_reset_polyphony_statistics(mt32emu_const_context context);
+
+/**
+ * Starts recording the input of the synth to a file with the given name in a compact binary format, that can be replayed
+ * deterministically. The accepted MIDI messages, the parameters of the synth and changes of the runtime settings are recorded.
+ * The capture should be started right after the synth is opened, it is stopped when the synth is closed.
+ * Returns MT32EMU_RC_OK upon success, MT32EMU_RC_NOT_OPENED if the synth is not open or MT32EMU_RC_FAILED if the file cannot be created.
+ */
+MT32EMU_EXPORT mt32emu_return_code mt32emu_start_midi_capture(mt32emu_const_context context, const char *filename);
+/** Completes the capture and closes the file. */
+MT32EMU_EXPORT void mt32emu_stop_midi_capture(mt32emu_const_context context);
+
+/**
+ * Allows to toggle coalescing of dense controller messages taken from the MIDI queue while rendering.
+ * A pitch bend, modulation, volume or expression message is dropped when it is superseded by a message of the same kind
+ * on the same channel within the same control tick. Only takes effect in the immediate MIDI delay mode.
+ * This mode is disabled by default. See Synth::setControllerCoalescingEnabled().
+ */
+MT32EMU_EXPORT void mt32emu_set_controller_coalescing_enabled(mt32emu_const_context context, const mt32emu_boolean enabled);
+/** Returns whether coalescing of dense controller messages is enabled. */
+MT32EMU_EXPORT mt32emu_boolean mt32emu_is_controller_coalescing_enabled(mt32emu_const_context context);
+
+/**
+ * Allows to toggle culling of inaudible partials. A releasing partial is deactivated once its amplitude has stayed
+ * below the culling threshold for the culling hold time. The number of culled partials is reported in the polyphony statistics.
+ * This mode is disabled by default. See Synth::setPartialCullingEnabled().
+ */
+MT32EMU_EXPORT void mt32emu_set_partial_culling_enabled(mt32emu_const_context context, const mt32emu_boolean enabled);
+/** Returns whether culling of inaudible partials is enabled. */
+MT32EMU_EXPORT mt32emu_boolean mt32emu_is_partial_culling_enabled(mt32emu_const_context context);
+/**
+ * Sets the amplitude threshold for culling of inaudible partials as the level in the LA32 logarithmic domain,
+ * where each 4096 units double the amplitude. The default is 8192, and 0 disables culling effectively.
+ * See Synth::setPartialCullingThreshold().
+ */
+MT32EMU_EXPORT void mt32emu_set_partial_culling_threshold(mt32emu_const_context context, const mt32emu_bit32u level);
+/** Returns the amplitude threshold for culling of inaudible partials. */
+MT32EMU_EXPORT mt32emu_bit32u mt32emu_get_partial_culling_threshold(mt32emu_const_context context);
+/**
+ * Sets the time, in samples at the internal synth sample rate, a partial must stay below the culling threshold
+ * before it is deactivated. The default is 320 samples.
+ */
+MT32EMU_EXPORT void mt32emu_set_partial_culling_hold_time(mt32emu_const_context context, const mt32emu_bit32u hold_time);
+/** Returns the time a partial must stay below the culling threshold before it is deactivated. */
+MT32EMU_EXPORT mt32emu_bit32u mt32emu_get_partial_culling_hold_time(mt32emu_const_context context);
+
+/**
+ * Allows to toggle the note render cache. Notes which repeat on a part with the same key and velocity replay the recorded
+ * output of the wave generators as long as their envelopes follow the recording, the output stays exactly the same.
+ * This mode is disabled by default. See Synth::setNoteRenderCacheEnabled().
+ */
+MT32EMU_EXPORT void mt32emu_set_note_render_cache_enabled(mt32emu_const_context context, const mt32emu_boolean enabled);
+/** Returns whether the note render cache is enabled. */
+MT32EMU_EXPORT mt32emu_boolean mt32emu_is_note_render_cache_enabled(mt32emu_const_context context);
+
 #ifdef __cplusplus
 } // extern "C"
 #endif
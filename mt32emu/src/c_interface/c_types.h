@@ -102,6 +102,72 @@ typedef struct {
 	float *reverbWetRight;
 } mt32emu_dac_output_float_streams;
 
+/** Set of per-part output bit16s streams appeared at the DAC entrance. The rhythm part goes last. */
+typedef struct {
+	mt32emu_bit16s *partLeft[9];
+	mt32emu_bit16s *partRight[9];
+	mt32emu_bit16s *reverbWetLeft;
+	mt32emu_bit16s *reverbWetRight;
+} mt32emu_part_output_bit16s_streams;
+
+/** Set of per-part output float streams appeared at the DAC entrance. The rhythm part goes last. */
+typedef struct {
+	float *partLeft[9];
+	float *partRight[9];
+	float *reverbWetLeft;
+	float *reverbWetRight;
+} mt32emu_part_output_float_streams;
+
+/**
+ * Accumulated timing and load figures of the rendering engine. A rendered block corresponds to a single call to a render function.
+ * Times are measured with a monotonic system clock and expressed in nanoseconds. See Synth::getRenderStatistics() for details.
+ */
+typedef struct {
+	mt32emu_bit32u blockCount;
+	double sampleCount;
+	double totalNanos;
+	double partialNanos;
+	double reverbNanos;
+	double analogNanos;
+	double midiNanos;
+	double resamplerNanos;
+	mt32emu_bit32u midiMessageCount;
+	mt32emu_bit32u sysexMessageCount;
+	double averageActivePartials;
+	mt32emu_bit32u peakActivePartials;
+	double worstBlockNanos;
+	mt32emu_bit32u worstBlockSampleCount;
+} mt32emu_render_statistics;
+
+/** Cumulative figures of polyphony and partial allocation. See Synth::getPolyphonyStatistics() for details. */
+typedef struct {
+	double sampleCount;
+	double averageActivePartials;
+	mt32emu_bit32u peakActivePartials;
+	double averagePartPartials[9];
+	mt32emu_bit32u peakPartPartials[9];
+	mt32emu_bit32u startedPolyCount;
+	mt32emu_bit32u sameKeyAbortCount;
+	mt32emu_bit32u releasingAbortCount;
+	mt32emu_bit32u reserveExceededAbortCount;
+	mt32emu_bit32u ownPartAbortCount;
+	mt32emu_bit32u stolenPolyCount;
+	mt32emu_bit32u refusedNoteCount;
+	mt32emu_bit32u partialLifetimeHistogram[12];
+	mt32emu_bit32u midiQueueHighWaterMark;
+	mt32emu_bit32u midiQueueOverflowCount;
+	mt32emu_bit32u culledPartialCount;
+} mt32emu_polyphony_statistics;
+
+/** Binary record of a notable event that occurred in the rendering engine. See Synth::readTraceEvents() for details. */
+typedef struct {
+	double timeNanos;
+	mt32emu_bit32u renderedSampleCount;
+	mt32emu_trace_event_type type;
+	mt32emu_bit32u data1;
+	mt32emu_bit32u data2;
+} mt32emu_trace_event;
+
 /* === Interface handling === */
 
 /** Report handler interface versions */
@@ -122,7 +188,8 @@ typedef enum {
 	MT32EMU_SERVICE_VERSION_1 = 1,
 	MT32EMU_SERVICE_VERSION_2 = 2,
 	MT32EMU_SERVICE_VERSION_3 = 3,
-	MT32EMU_SERVICE_VERSION_CURRENT = MT32EMU_SERVICE_VERSION_3
+	MT32EMU_SERVICE_VERSION_4 = 4,
+	MT32EMU_SERVICE_VERSION_CURRENT = MT32EMU_SERVICE_VERSION_4
 } mt32emu_service_version;
 
 /* === Report Handler Interface === */
@@ -310,6 +377,32 @@ typedef union mt32emu_service_i mt32emu_service_i;
 	void (*setNicePartialMixingEnabled)(mt32emu_const_context context, const mt32emu_boolean enabled); \
 	mt32emu_boolean (*isNicePartialMixingEnabled)(mt32emu_const_context context);
 
+#define MT32EMU_SERVICE_I_V4 \
+	void (*renderBit16sPartStreams)(mt32emu_const_context context, const mt32emu_part_output_bit16s_streams *streams, mt32emu_bit32u len); \
+	void (*renderFloatPartStreams)(mt32emu_const_context context, const mt32emu_part_output_float_streams *streams, mt32emu_bit32u len); \
+	void (*setRenderStatisticsEnabled)(mt32emu_const_context context, const mt32emu_boolean enabled); \
+	mt32emu_boolean (*isRenderStatisticsEnabled)(mt32emu_const_context context); \
+	mt32emu_boolean (*getRenderStatistics)(mt32emu_const_context context, mt32emu_render_statistics *statistics); \
+	void (*resetRenderStatistics)(mt32emu_const_context context); \
+	void (*setTraceEnabled)(mt32emu_const_context context, const mt32emu_boolean enabled); \
+	mt32emu_boolean (*isTraceEnabled)(mt32emu_const_context context); \
+	mt32emu_bit32u (*readTraceEvents)(mt32emu_const_context context, mt32emu_trace_event *events, mt32emu_bit32u max_count); \
+	mt32emu_return_code (*writeChromeTrace)(const char *filename, const mt32emu_trace_event *events, mt32emu_bit32u count); \
+	mt32emu_boolean (*getPolyphonyStatistics)(mt32emu_const_context context, mt32emu_polyphony_statistics *statistics); \
+	void (*resetPolyphonyStatistics)(mt32emu_const_context context); \
+	mt32emu_return_code (*startMidiCapture)(mt32emu_const_context context, const char *filename); \
+	void (*stopMidiCapture)(mt32emu_const_context context); \
+	void (*setControllerCoalescingEnabled)(mt32emu_const_context context, const mt32emu_boolean enabled); \
+	mt32emu_boolean (*isControllerCoalescingEnabled)(mt32emu_const_context context); \
+	void (*setPartialCullingEnabled)(mt32emu_const_context context, const mt32emu_boolean enabled); \
+	mt32emu_boolean (*isPartialCullingEnabled)(mt32emu_const_context context); \
+	void (*setPartialCullingThreshold)(mt32emu_const_context context, const mt32emu_bit32u level); \
+	mt32emu_bit32u (*getPartialCullingThreshold)(mt32emu_const_context context); \
+	void (*setPartialCullingHoldTime)(mt32emu_const_context context, const mt32emu_bit32u hold_time); \
+	mt32emu_bit32u (*getPartialCullingHoldTime)(mt32emu_const_context context); \
+	void (*setNoteRenderCacheEnabled)(mt32emu_const_context context, const mt32emu_boolean enabled); \
+	mt32emu_boolean (*isNoteRenderCacheEnabled)(mt32emu_const_context context);
+
 typedef struct {
 	MT32EMU_SERVICE_I_V0
 } mt32emu_service_i_v0;
@@ -332,6 +425,14 @@ typedef struct {
 	MT32EMU_SERVICE_I_V3
 } mt32emu_service_i_v3;
 
+typedef struct {
+	MT32EMU_SERVICE_I_V0
+	MT32EMU_SERVICE_I_V1
+	MT32EMU_SERVICE_I_V2
+	MT32EMU_SERVICE_I_V3
+	MT32EMU_SERVICE_I_V4
+} mt32emu_service_i_v4;
+
 /**
  * Extensible interface for all the library services.
  * Union intended to view an interface of any subsequent version as any parent interface not requiring a cast.
@@ -342,11 +443,13 @@ union mt32emu_service_i {
 	const mt32emu_service_i_v1 *v1;
 	const mt32emu_service_i_v2 *v2;
 	const mt32emu_service_i_v3 *v3;
+	const mt32emu_service_i_v4 *v4;
 };
 
 #undef MT32EMU_SERVICE_I_V0
 #undef MT32EMU_SERVICE_I_V1
 #undef MT32EMU_SERVICE_I_V2
 #undef MT32EMU_SERVICE_I_V3
+#undef MT32EMU_SERVICE_I_V4
 
 #endif /* #ifndef MT32EMU_C_TYPES_H */
@@ -101,6 +101,8 @@ mt32emu_service_i mt32emu_get_service_i();
 #define mt32emu_render_float i.v0->renderFloat
 #define mt32emu_render_bit16s_streams i.v0->renderBit16sStreams
 #define mt32emu_render_float_streams i.v0->renderFloatStreams
+#define mt32emu_render_bit16s_part_streams iV4()->renderBit16sPartStreams
+#define mt32emu_render_float_part_streams iV4()->renderFloatPartStreams
 #define mt32emu_has_active_partials i.v0->hasActivePartials
 #define mt32emu_is_active i.v0->isActive
 #define mt32emu_get_partial_count i.v0->getPartialCount
@@ -109,6 +111,28 @@ mt32emu_service_i mt32emu_get_service_i();
 #define mt32emu_get_playing_notes i.v0->getPlayingNotes
 #define mt32emu_get_patch_name i.v0->getPatchName
 #define mt32emu_read_memory i.v0->readMemory
+#define mt32emu_set_render_statistics_enabled iV4()->setRenderStatisticsEnabled
+#define mt32emu_is_render_statistics_enabled iV4()->isRenderStatisticsEnabled
+#define mt32emu_get_render_statistics iV4()->getRenderStatistics
+#define mt32emu_reset_render_statistics iV4()->resetRenderStatistics
+#define mt32emu_set_trace_enabled iV4()->setTraceEnabled
+#define mt32emu_is_trace_enabled iV4()->isTraceEnabled
+#define mt32emu_read_trace_events iV4()->readTraceEvents
+#define mt32emu_write_chrome_trace iV4()->writeChromeTrace
+#define mt32emu_get_polyphony_statistics iV4()->getPolyphonyStatistics
+#define mt32emu_reset_polyphony_statistics iV4()->resetPolyphonyStatistics
+#define mt32emu_start_midi_capture iV4()->startMidiCapture
+#define mt32emu_stop_midi_capture iV4()->stopMidiCapture
+#define mt32emu_set_controller_coalescing_enabled iV4()->setControllerCoalescingEnabled
+#define mt32emu_is_controller_coalescing_enabled iV4()->isControllerCoalescingEnabled
+#define mt32emu_set_partial_culling_enabled iV4()->setPartialCullingEnabled
+#define mt32emu_is_partial_culling_enabled iV4()->isPartialCullingEnabled
+#define mt32emu_set_partial_culling_threshold iV4()->setPartialCullingThreshold
+#define mt32emu_get_partial_culling_threshold iV4()->getPartialCullingThreshold
+#define mt32emu_set_partial_culling_hold_time iV4()->setPartialCullingHoldTime
+#define mt32emu_get_partial_culling_hold_time iV4()->getPartialCullingHoldTime
+#define mt32emu_set_note_render_cache_enabled iV4()->setNoteRenderCacheEnabled
+#define mt32emu_is_note_render_cache_enabled iV4()->isNoteRenderCacheEnabled
 
 #else // #if MT32EMU_API_TYPE == 2
 
@@ -270,6 +294,8 @@ public:
 	void renderFloat(float *stream, Bit32u len) { mt32emu_render_float(c, stream, len); }
 	void renderBit16sStreams(const mt32emu_dac_output_bit16s_streams *streams, Bit32u len) { mt32emu_render_bit16s_streams(c, streams, len); }
 	void renderFloatStreams(const mt32emu_dac_output_float_streams *streams, Bit32u len) { mt32emu_render_float_streams(c, streams, len); }
+	void renderBit16sPartStreams(const mt32emu_part_output_bit16s_streams *streams, Bit32u len) { mt32emu_render_bit16s_part_streams(c, streams, len); }
+	void renderFloatPartStreams(const mt32emu_part_output_float_streams *streams, Bit32u len) { mt32emu_render_float_part_streams(c, streams, len); }
 
 	bool hasActivePartials() { return mt32emu_has_active_partials(c) != MT32EMU_BOOL_FALSE; }
 	bool isActive() { return mt32emu_is_active(c) != MT32EMU_BOOL_FALSE; }
@@ -280,6 +306,35 @@ public:
 	const char *getPatchName(Bit8u part_number) { return mt32emu_get_patch_name(c, part_number); }
 	void readMemory(Bit32u addr, Bit32u len, Bit8u *data) { mt32emu_read_memory(c, addr, len, data); }
 
+	void setRenderStatisticsEnabled(const bool enabled) { mt32emu_set_render_statistics_enabled(c, enabled ? MT32EMU_BOOL_TRUE : MT32EMU_BOOL_FALSE); }
+	bool isRenderStatisticsEnabled() { return mt32emu_is_render_statistics_enabled(c) != MT32EMU_BOOL_FALSE; }
+	bool getRenderStatistics(mt32emu_render_statistics *statistics) { return mt32emu_get_render_statistics(c, statistics) != MT32EMU_BOOL_FALSE; }
+	void resetRenderStatistics() { mt32emu_reset_render_statistics(c); }
+
+	void setTraceEnabled(const bool enabled) { mt32emu_set_trace_enabled(c, enabled ? MT32EMU_BOOL_TRUE : MT32EMU_BOOL_FALSE); }
+	bool isTraceEnabled() { return mt32emu_is_trace_enabled(c) != MT32EMU_BOOL_FALSE; }
+	Bit32u readTraceEvents(mt32emu_trace_event *events, Bit32u max_count) { return mt32emu_read_trace_events(c, events, max_count); }
+	mt32emu_return_code writeChromeTrace(const char *filename, const mt32emu_trace_event *events, Bit32u count) { return mt32emu_write_chrome_trace(filename, events, count); }
+
+	bool getPolyphonyStatistics(mt32emu_polyphony_statistics *statistics) { return mt32emu_get_polyphony_statistics(c, statistics) != MT32EMU_BOOL_FALSE; }
+	void resetPolyphonyStatistics() { mt32emu_reset_polyphony_statistics(c); }
+
+	mt32emu_return_code startMidiCapture(const char *filename) { return mt32emu_start_midi_capture(c, filename); }
+	void stopMidiCapture() { mt32emu_stop_midi_capture(c); }
+
+	void setControllerCoalescingEnabled(const bool enabled) { mt32emu_set_controller_coalescing_enabled(c, enabled ? MT32EMU_BOOL_TRUE : MT32EMU_BOOL_FALSE); }
+	bool isControllerCoalescingEnabled() { return mt32emu_is_controller_coalescing_enabled(c) != MT32EMU_BOOL_FALSE; }
+
+	void setPartialCullingEnabled(const bool enabled) { mt32emu_set_partial_culling_enabled(c, enabled ? MT32EMU_BOOL_TRUE : MT32EMU_BOOL_FALSE); }
+	bool isPartialCullingEnabled() { return mt32emu_is_partial_culling_enabled(c) != MT32EMU_BOOL_FALSE; }
+	void setPartialCullingThreshold(const Bit32u level) { mt32emu_set_partial_culling_threshold(c, level); }
+	Bit32u getPartialCullingThreshold() { return mt32emu_get_partial_culling_threshold(c); }
+	void setPartialCullingHoldTime(const Bit32u holdTime) { mt32emu_set_partial_culling_hold_time(c, holdTime); }
+	Bit32u getPartialCullingHoldTime() { return mt32emu_get_partial_culling_hold_time(c); }
+
+	void setNoteRenderCacheEnabled(const bool enabled) { mt32emu_set_note_render_cache_enabled(c, enabled ? MT32EMU_BOOL_TRUE : MT32EMU_BOOL_FALSE); }
+	bool isNoteRenderCacheEnabled() { return mt32emu_is_note_render_cache_enabled(c) != MT32EMU_BOOL_FALSE; }
+
 private:
 #if MT32EMU_API_TYPE == 2
 	const mt32emu_service_i i;
@@ -290,6 +345,7 @@ private:
 	const mt32emu_service_i_v1 *iV1() { return (getVersionID() < MT32EMU_SERVICE_VERSION_1) ? NULL : i.v1; }
 	const mt32emu_service_i_v2 *iV2() { return (getVersionID() < MT32EMU_SERVICE_VERSION_2) ? NULL : i.v2; }
 	const mt32emu_service_i_v3 *iV3() { return (getVersionID() < MT32EMU_SERVICE_VERSION_3) ? NULL : i.v3; }
+	const mt32emu_service_i_v4 *iV4() { return (getVersionID() < MT32EMU_SERVICE_VERSION_4) ? NULL : i.v4; }
 #endif
 };
 
@@ -480,6 +536,8 @@ static mt32emu_midi_receiver_i getMidiReceiverThunk() {
 #undef mt32emu_render_float
 #undef mt32emu_render_bit16s_streams
 #undef mt32emu_render_float_streams
+#undef mt32emu_render_bit16s_part_streams
+#undef mt32emu_render_float_part_streams
 #undef mt32emu_has_active_partials
 #undef mt32emu_is_active
 #undef mt32emu_get_partial_count
@@ -488,6 +546,28 @@ static mt32emu_midi_receiver_i getMidiReceiverThunk() {
 #undef mt32emu_get_playing_notes
 #undef mt32emu_get_patch_name
 #undef mt32emu_read_memory
+#undef mt32emu_set_render_statistics_enabled
+#undef mt32emu_is_render_statistics_enabled
+#undef mt32emu_get_render_statistics
+#undef mt32emu_reset_render_statistics
+#undef mt32emu_set_trace_enabled
+#undef mt32emu_is_trace_enabled
+#undef mt32emu_read_trace_events
+#undef mt32emu_write_chrome_trace
+#undef mt32emu_get_polyphony_statistics
+#undef mt32emu_reset_polyphony_statistics
+#undef mt32emu_start_midi_capture
+#undef mt32emu_stop_midi_capture
+#undef mt32emu_set_controller_coalescing_enabled
+#undef mt32emu_is_controller_coalescing_enabled
+#undef mt32emu_set_partial_culling_enabled
+#undef mt32emu_is_partial_culling_enabled
+#undef mt32emu_set_partial_culling_threshold
+#undef mt32emu_get_partial_culling_threshold
+#undef mt32emu_set_partial_culling_hold_time
+#undef mt32emu_get_partial_culling_hold_time
+#undef mt32emu_set_note_render_cache_enabled
+#undef mt32emu_is_note_render_cache_enabled
 
 #endif // #if MT32EMU_API_TYPE == 2
 
@@ -93,6 +93,27 @@
 #define MT32EMU_BOSS_REVERB_PRECISE_MODE 0
 #endif
 
+// 0: Render statistics are not collected, Synth::getRenderStatistics() always fails.
+// 1: Render statistics are collected when enabled with Synth::setRenderStatisticsEnabled(),
+//    at the cost of a few clock readings per rendering run.
+#ifndef MT32EMU_RENDER_STATISTICS
+#define MT32EMU_RENDER_STATISTICS 1
+#endif
+
+// 0: Only the portable scalar implementation of the DSP kernels is compiled in.
+// 1: Variants of the DSP kernels optimised for the SIMD instruction set extensions are compiled in as well.
+//    The best variant supported by the CPU is selected at runtime, see CPUFeatures.
+#ifndef MT32EMU_SIMD_KERNELS
+#define MT32EMU_SIMD_KERNELS 1
+#endif
+
+// 0: Only the original ROMs are recognised.
+// 1: The synthetic pair of ROM images generated by mt32emu_bench is recognised as well. Only intended for the builds
+//    of mt32emu_bench and mt32emu_golden_test, see bench/SyntheticROMs.cpp.
+#ifndef MT32EMU_SYNTHETIC_ROMS
+#define MT32EMU_SYNTHETIC_ROMS 0
+#endif
+
 namespace MT32Emu {
 
 typedef Bit16s IntSample;
@@ -106,6 +127,14 @@ enum PolyState {
 	POLY_Inactive
 };
 
+// Reasons for aborting a poly in order to free partials for a new one.
+enum PolyAbortReason {
+	POLY_ABORT_SAME_KEY, // The same key is retriggered on a part in single-assign mode
+	POLY_ABORT_RELEASING, // Releasing poly on a part that has exceeded its partial reserve
+	POLY_ABORT_RESERVE_EXCEEDED, // Held or playing poly on a part that has exceeded its partial reserve
+	POLY_ABORT_OWN_PART // Poly on the part that needs partials when nothing else can be freed
+};
+
 enum ReverbMode {
 	REVERB_MODE_ROOM,
 	REVERB_MODE_HALL,
@@ -76,8 +76,13 @@
 #include "FileStream.h"
 #include "ROMInfo.h"
 #include "Synth.h"
+#include "MidiCapture.h"
 #include "MidiStreamParser.h"
 #include "SampleRateConverter.h"
+#if MT32EMU_WITH_RENDER_THREAD
+#include "RenderThread.h"
+#endif
+#include "ChromeTraceWriter.h"
 
 #endif /* #if !defined(__cplusplus) || MT32EMU_API_TYPE == 1 */
 
@@ -59,9 +59,10 @@ static FloatSampleProvider &createModel(Synth &synth, SRCTools::FloatSampleProvi
 
 using namespace MT32Emu;
 
-InternalResampler::InternalResampler(Synth &synth, double targetSampleRate, SamplerateConversionQuality quality) :
-	synthSource(*new SynthWrapper(synth)),
-	model(createModel(synth, synthSource, targetSampleRate, quality))
+InternalResampler::InternalResampler(Synth &useSynth, double targetSampleRate, SamplerateConversionQuality quality) :
+	synth(useSynth),
+	synthSource(*new SynthWrapper(useSynth)),
+	model(createModel(useSynth, synthSource, targetSampleRate, quality))
 {}
 
 InternalResampler::~InternalResampler() {
@@ -70,5 +71,7 @@ InternalResampler::~InternalResampler() {
 }
 
 void InternalResampler::getOutputSamples(float *buffer, unsigned int length) {
+	synth.startResampling();
 	model.getOutputSamples(buffer, length);
+	synth.finishResampling();
 }
@@ -33,6 +33,7 @@ public:
 	void getOutputSamples(float *buffer, unsigned int length);
 
 private:
+	Synth &synth;
 	SRCTools::FloatSampleProvider &synthSource;
 	SRCTools::FloatSampleProvider &model;
 };
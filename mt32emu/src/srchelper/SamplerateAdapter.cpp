@@ -73,6 +73,7 @@ void SamplerateAdapter::getOutputSamples(float *buffer, unsigned int length) {
 		Synth::muteSampleBuffer(buffer, CHANNEL_COUNT * length);
 		return;
 	}
+	synth.startResampling();
 	while (length > 0) {
 		inBufferSize = static_cast<unsigned int>(length * inputToOutputRatio + 0.5);
 		long gotFrames = src_callback_read(resampler, outputToInputRatio, long(length), buffer);
@@ -86,6 +87,7 @@ void SamplerateAdapter::getOutputSamples(float *buffer, unsigned int length) {
 				resampler = NULL;
 				Synth::muteSampleBuffer(buffer, CHANNEL_COUNT * length);
 				synth.printDebug("SamplerateAdapter: Samplerate disabled\n");
+				synth.finishResampling();
 				return;
 			}
 			continue;
@@ -96,4 +98,5 @@ void SamplerateAdapter::getOutputSamples(float *buffer, unsigned int length) {
 		buffer += CHANNEL_COUNT * gotFrames;
 		length -= gotFrames;
 	}
+	synth.finishResampling();
 }
@@ -81,6 +81,7 @@ void SoxrAdapter::getOutputSamples(float *buffer, unsigned int length) {
 		Synth::muteSampleBuffer(buffer, CHANNEL_COUNT * length);
 		return;
 	}
+	synth.startResampling();
 	while (length > 0) {
 		size_t gotFrames = soxr_output(resampler, buffer, size_t(length));
 		soxr_error_t error = soxr_error(resampler);
@@ -93,6 +94,7 @@ void SoxrAdapter::getOutputSamples(float *buffer, unsigned int length) {
 				resampler = NULL;
 				Synth::muteSampleBuffer(buffer, CHANNEL_COUNT * length);
 				synth.printDebug("SoxrAdapter: SOXR disabled\n");
+				synth.finishResampling();
 				return;
 			}
 			continue;
@@ -103,4 +105,5 @@ void SoxrAdapter::getOutputSamples(float *buffer, unsigned int length) {
 		buffer += CHANNEL_COUNT * gotFrames;
 		length -= static_cast<unsigned int>(gotFrames);
 	}
+	synth.finishResampling();
 }
@@ -0,0 +1,585 @@
+/* Copyright (C) 2003, 2004, 2005, 2006, 2008, 2009 Dean Beeler, Jerome Fisher
+ * Copyright (C) 2011-2019 Dean Beeler, Jerome Fisher, Sergey V. Mikayev
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License as published by
+ *  the Free Software Foundation, either version 2.1 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+// Renders the benchmark corpus with the synthetic ROMs and compares rolling digests of the intermediate streams
+// against the golden values, so that optimisations can be checked for bit-exactness. The integer renderer is used
+// unless the variant specifies otherwise.
+// Stages are checked in the order of the signal path: the LA32 output that bypasses reverb, the reverb input (dry),
+// the reverb output (wet), the analogue circuit output and the sample rate converter output. Each digest is
+// recorded after every CHUNK_LENGTH frames, so a divergence can be located within a chunk from the digests alone.
+// To find the exact sample, save the streams with a known good build and compare against them.
+
+#include <algorithm>
+#include <cstdarg>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <map>
+#include <string>
+#include <vector>
+
+#include "internals.h"
+
+#include "BenchmarkCorpus.h"
+#include "CPUFeatures.h"
+#include "SampleRateConverter.h"
+#include "Synth.h"
+#include "SyntheticROMs.h"
+
+using namespace MT32Emu;
+
+static const Bit32u BLOCK_SIZE = 512;
+static const Bit32u CHUNK_LENGTH = 8192;
+static const Bit32u CHANNEL_COUNT = 2;
+static const double CONVERTED_SAMPLE_RATE = 44100.0;
+
+static const Bit32u FNV_OFFSET_BASIS = 2166136261U;
+static const Bit32u FNV_PRIME = 16777619;
+
+enum Stage {
+	Stage_NON_REVERB,
+	Stage_REVERB_DRY,
+	Stage_REVERB_WET,
+	Stage_ANALOG,
+	Stage_SRC,
+	Stage_COUNT
+};
+
+static const char * const STAGE_NAMES[] = {"non-reverb", "reverb-dry", "reverb-wet", "analog", "src"};
+
+enum Variant {
+	Variant_DEFAULT,
+	Variant_NICE,
+	Variant_MT32_REVERB,
+	Variant_NOTE_RENDER_CACHE,
+	Variant_REVERB_DISABLED,
+	Variant_DAC_PURE,
+	Variant_DAC_GENERATION1,
+	Variant_DAC_GENERATION2,
+	Variant_MIDI_IMMEDIATE,
+	Variant_CONTROLLER_COALESCING,
+	Variant_FLOAT,
+	Variant_FLOAT_NOTE_RENDER_CACHE,
+	Variant_COUNT
+};
+
+static const char * const VARIANT_NAMES[] = {"default", "nice", "mt32-reverb", "note-cache", "reverb-disabled", "dac-pure",
+	"dac-generation1", "dac-generation2", "midi-immediate",
+	"controller-coalescing", "float", "float-note-cache"};
+
+class QuietReportHandler : public ReportHandler {
+public:
+	void printDebug(const char *, va_list) {}
+	void showLCDMessage(const char *) {}
+};
+
+// Computes FNV-1a digest of a stream of interleaved stereo frames and records the intermediate values at the end
+// of each chunk. Optionally, saves the stream to a file or compares it against a previously saved one.
+class StreamChecker {
+public:
+	explicit StreamChecker(const std::string &useName) :
+		name(useName), digest(FNV_OFFSET_BASIS), frameCount(0), saveFile(NULL), referenceFile(NULL), firstMismatchFrame(-1)
+	{}
+
+	~StreamChecker() {
+		if (saveFile != NULL) fclose(saveFile);
+		if (referenceFile != NULL) fclose(referenceFile);
+	}
+
+	const std::string &getName() const {
+		return name;
+	}
+
+	bool openSaveFile(const std::string &fileName) {
+		saveFile = fopen(fileName.c_str(), "wb");
+		return saveFile != NULL;
+	}
+
+	bool openReferenceFile(const std::string &fileName) {
+		referenceFile = fopen(fileName.c_str(), "rb");
+		return referenceFile != NULL;
+	}
+
+	// The samples are digested as little-endian bit patterns, 16-bit integer or 32-bit float.
+	template <class Sample>
+	void process(const Sample *frames, Bit32u length) {
+		for (Bit32u i = 0; i < length; i++) {
+			for (Bit32u channel = 0; channel < CHANNEL_COUNT; channel++) {
+				const Bit32u sample = getSampleBits(frames[i * CHANNEL_COUNT + channel]);
+				for (Bit32u byte = 0; byte < sizeof(Sample); byte++) {
+					digest = (digest ^ ((sample >> (8 * byte)) & 0xFF)) * FNV_PRIME;
+				}
+			}
+			if (++frameCount % CHUNK_LENGTH == 0) checkpoints.push_back(digest);
+		}
+		if (saveFile != NULL) writeFrames(frames, length);
+		if (referenceFile != NULL && firstMismatchFrame < 0) compareFrames(frames, length);
+	}
+
+	void finish() {
+		if (frameCount % CHUNK_LENGTH != 0) checkpoints.push_back(digest);
+		// The reference stream is longer.
+		if (referenceFile != NULL && firstMismatchFrame < 0 && fgetc(referenceFile) != EOF) firstMismatchFrame = Bit32s(frameCount);
+	}
+
+	Bit32u getFrameCount() const {
+		return frameCount;
+	}
+
+	const std::vector<Bit32u> &getCheckpoints() const {
+		return checkpoints;
+	}
+
+	// Returns the index of the first frame that differs from the reference stream, or -1 if there is none.
+	Bit32s getFirstMismatchFrame() const {
+		return firstMismatchFrame;
+	}
+
+private:
+	const std::string name;
+	Bit32u digest;
+	Bit32u frameCount;
+	std::vector<Bit32u> checkpoints;
+	FILE *saveFile;
+	FILE *referenceFile;
+	Bit32s firstMismatchFrame;
+
+	static Bit32u getSampleBits(Bit16s sample) {
+		return Bit16u(sample);
+	}
+
+	static Bit32u getSampleBits(float sample) {
+		Bit32u bits;
+		memcpy(&bits, &sample, sizeof(bits));
+		return bits;
+	}
+
+	// Streams are stored as little-endian interleaved stereo, regardless of the host byte order.
+	template <class Sample>
+	void writeFrames(const Sample *frames, Bit32u length) {
+		for (Bit32u i = 0; i < length * CHANNEL_COUNT; i++) {
+			const Bit32u sample = getSampleBits(frames[i]);
+			for (Bit32u byte = 0; byte < sizeof(Sample); byte++) {
+				fputc((sample >> (8 * byte)) & 0xFF, saveFile);
+			}
+		}
+	}
+
+	template <class Sample>
+	void compareFrames(const Sample *frames, Bit32u length) {
+		const Bit32u startFrame = frameCount - length;
+		for (Bit32u i = 0; i < length * CHANNEL_COUNT; i++) {
+			Bit32u sample = 0;
+			for (Bit32u byte = 0; byte < sizeof(Sample); byte++) {
+				const int c = fgetc(referenceFile);
+				if (c == EOF) {
+					firstMismatchFrame = Bit32s(startFrame + i / CHANNEL_COUNT);
+					return;
+				}
+				sample |= Bit32u(c) << (8 * byte);
+			}
+			if (sample != getSampleBits(frames[i])) {
+				firstMismatchFrame = Bit32s(startFrame + i / CHANNEL_COUNT);
+				return;
+			}
+		}
+	}
+};
+
+struct Options {
+	bool update;
+	const char *saveDirName;
+	const char *referenceDirName;
+	const char *filter;
+	const char *cpuLevelName;
+	const char *digestFileName;
+};
+
+static void configureSynth(Synth &synth, Variant variant) {
+	switch (variant) {
+	case Variant_DEFAULT:
+		break;
+	case Variant_NICE:
+		synth.setNiceAmpRampEnabled(true);
+		synth.setNicePanningEnabled(true);
+		synth.setNicePartialMixingEnabled(true);
+		break;
+	case Variant_MT32_REVERB:
+		synth.setReverbCompatibilityMode(true);
+		break;
+	case Variant_NOTE_RENDER_CACHE:
+		// The replayed notes must sound exactly the same as rendered live, so the digests equal those of the default variant.
+		synth.setNoteRenderCacheEnabled(true);
+		break;
+	case Variant_REVERB_DISABLED:
+		synth.setReverbEnabled(false);
+		break;
+	case Variant_DAC_PURE:
+		synth.setDACInputMode(DACInputMode_PURE);
+		break;
+	case Variant_DAC_GENERATION1:
+		synth.setDACInputMode(DACInputMode_GENERATION1);
+		break;
+	case Variant_DAC_GENERATION2:
+		synth.setDACInputMode(DACInputMode_GENERATION2);
+		break;
+	case Variant_MIDI_IMMEDIATE:
+		synth.setMIDIDelayMode(MIDIDelayMode_IMMEDIATE);
+		break;
+	case Variant_CONTROLLER_COALESCING:
+		// The emulated MIDI interface delay would spread the messages over several control ticks.
+		synth.setMIDIDelayMode(MIDIDelayMode_IMMEDIATE);
+		synth.setControllerCoalescingEnabled(true);
+		break;
+	case Variant_FLOAT_NOTE_RENDER_CACHE:
+		// Exercises recording and replaying of the float samples, the digests equal those of the float variant.
+		synth.setNoteRenderCacheEnabled(true);
+		break;
+	case Variant_FLOAT:
+	case Variant_COUNT:
+		break;
+	}
+}
+
+static bool isFloatVariant(Variant variant) {
+	return variant == Variant_FLOAT || variant == Variant_FLOAT_NOTE_RENDER_CACHE;
+}
+
+static bool isRelevantVariant(Variant variant, const CorpusSequence &sequence) {
+	switch (variant) {
+	case Variant_MT32_REVERB:
+		// The alternative reverb model only makes difference for the sequence that exercises all the reverb modes.
+		return sequence.getName() == "reverb-modes";
+	case Variant_REVERB_DISABLED:
+	case Variant_DAC_PURE:
+	case Variant_DAC_GENERATION1:
+	case Variant_DAC_GENERATION2:
+		// Only this sequence produces output that both bypasses reverb and goes through it.
+		return sequence.getName() == "reverb-switch";
+	case Variant_MIDI_IMMEDIATE:
+	case Variant_CONTROLLER_COALESCING:
+		// Other sequences have no controller messages to coalesce. Without coalescing, the output is the same
+		// as before the feature was introduced.
+		return sequence.getName() == "dense-controllers";
+	default:
+		return true;
+	}
+}
+
+static bool openSynth(Synth &synth, const SyntheticROMs &roms, Variant variant, AnalogOutputMode analogOutputMode) {
+	// TVP emulates the jitter of the pitch timer using rand(), so the output of each synth instance only depends
+	// on the input if the sequence of the pseudo-random numbers is restarted.
+	srand(1);
+	// The renderer type can only be selected before opening.
+	synth.selectRendererType(isFloatVariant(variant) ? RendererType_FLOAT : RendererType_BIT16S);
+	if (!synth.open(roms.getControlROMImage(), roms.getPCMROMImage(), analogOutputMode)) {
+		fprintf(stderr, "Unable to open synth with the synthetic ROMs\n");
+		return false;
+	}
+	configureSynth(synth, variant);
+	return true;
+}
+
+template <class Sample>
+static void interleave(Sample *frames, const Sample *left, const Sample *right, Bit32u length) {
+	for (Bit32u i = 0; i < length; i++) {
+		frames[2 * i] = left[i];
+		frames[2 * i + 1] = right[i];
+	}
+}
+
+// The DAC streams are produced at the internal sample rate, so the rendering ends exactly at the end of the sequence.
+template <class Sample>
+static bool renderDACStreams(const SyntheticROMs &roms, Variant variant, const CorpusSequence &sequence, StreamChecker **checkers) {
+	QuietReportHandler reportHandler;
+	Synth synth(&reportHandler);
+	if (!openSynth(synth, roms, variant, AnalogOutputMode_DIGITAL_ONLY)) return false;
+	CorpusPlayer player(synth, sequence, false);
+	Sample streams[6][BLOCK_SIZE];
+	Sample frames[CHANNEL_COUNT * BLOCK_SIZE];
+	for (Bit32u renderedLength = 0; renderedLength < sequence.getLength();) {
+		const Bit32u length = std::min(BLOCK_SIZE, sequence.getLength() - renderedLength);
+		player.enqueueEvents(length);
+		synth.renderStreams(streams[0], streams[1], streams[2], streams[3], streams[4], streams[5], length);
+		for (int stage = Stage_NON_REVERB; stage <= Stage_REVERB_WET; stage++) {
+			interleave(frames, streams[2 * stage], streams[2 * stage + 1], length);
+			checkers[stage]->process(frames, length);
+		}
+		renderedLength += length;
+	}
+	synth.close();
+	return true;
+}
+
+// The output sample rate differs from the internal one, so whole blocks are rendered until the internal sample count
+// reaches the end of the sequence.
+template <class Sample>
+static bool renderOutput(const SyntheticROMs &roms, Variant variant, const CorpusSequence &sequence, StreamChecker &checker, bool convertSampleRate) {
+	QuietReportHandler reportHandler;
+	Synth synth(&reportHandler);
+	if (!openSynth(synth, roms, variant, convertSampleRate ? AnalogOutputMode_COARSE : AnalogOutputMode_ACCURATE)) return false;
+	SampleRateConverter *sampleRateConverter = convertSampleRate ? new SampleRateConverter(synth, CONVERTED_SAMPLE_RATE, SamplerateConversionQuality_GOOD) : NULL;
+	CorpusPlayer player(synth, sequence, false);
+	const Bit32u startSampleCount = synth.getInternalRenderedSampleCount();
+	Sample frames[CHANNEL_COUNT * BLOCK_SIZE];
+	while (synth.getInternalRenderedSampleCount() - startSampleCount < sequence.getLength()) {
+		player.enqueueEvents(BLOCK_SIZE);
+		if (sampleRateConverter != NULL) {
+			sampleRateConverter->getOutputSamples(frames, BLOCK_SIZE);
+		} else {
+			synth.render(frames, BLOCK_SIZE);
+		}
+		checker.process(frames, BLOCK_SIZE);
+	}
+	delete sampleRateConverter;
+	synth.close();
+	return true;
+}
+
+static std::string formatDigests(const StreamChecker &checker) {
+	std::string line = checker.getName();
+	char buffer[16];
+	sprintf(buffer, " %u", checker.getFrameCount());
+	line += buffer;
+	const std::vector<Bit32u> &checkpoints = checker.getCheckpoints();
+	for (size_t i = 0; i < checkpoints.size(); i++) {
+		sprintf(buffer, " %08x", checkpoints[i]);
+		line += buffer;
+	}
+	return line;
+}
+
+static bool loadDigests(const char *fileName, std::map<std::string, std::string> &digests) {
+	FILE *file = fopen(fileName, "r");
+	if (file == NULL) return false;
+	std::string line;
+	for (int c = fgetc(file); c != EOF; c = fgetc(file)) {
+		if (c != '\n') {
+			line += char(c);
+			continue;
+		}
+		if (!line.empty() && line[0] != '#') {
+			digests[line.substr(0, line.find(' '))] = line;
+		}
+		line.clear();
+	}
+	fclose(file);
+	return true;
+}
+
+static bool saveDigests(const char *fileName, const std::vector<std::string> &lines) {
+	FILE *file = fopen(fileName, "w");
+	if (file == NULL) return false;
+	fprintf(file,
+		"# Golden digests of the streams rendered by mt32emu_golden_test using the synthetic ROMs.\n"
+		"# The integer renderer is used in all variants but float ones, whose samples are digested as 32-bit patterns.\n"
+		"# Only regenerate with --update when a change of the output is intended, and explain the reason in the commit.\n"
+		"# Format: <variant>/<sequence>/<stage> <frame count> <rolling FNV-1a digest after each %u frames>...\n", CHUNK_LENGTH);
+	for (size_t i = 0; i < lines.size(); i++) {
+		fprintf(file, "%s\n", lines[i].c_str());
+	}
+	fclose(file);
+	return true;
+}
+
+// Returns the number of the first chunk which digest differs, or -1 if the lines match.
+static int findFirstDivergingChunk(const std::string &expected, const std::string &actual) {
+	size_t expectedPos = expected.find(' ');
+	size_t actualPos = actual.find(' ');
+	// The first field after the name is the frame count, the digests follow.
+	for (int field = -1;; field++) {
+		const size_t expectedEnd = expected.find(' ', expectedPos + 1);
+		const size_t actualEnd = actual.find(' ', actualPos + 1);
+		if (expected.compare(expectedPos, expectedEnd - expectedPos, actual, actualPos, actualEnd - actualPos) != 0) {
+			return field < 0 ? 0 : field;
+		}
+		if (expectedEnd == std::string::npos || actualEnd == std::string::npos) {
+			return expectedEnd == actualEnd ? -1 : field + 1;
+		}
+		expectedPos = expectedEnd;
+		actualPos = actualEnd;
+	}
+}
+
+static void printUsage(const char *programName) {
+	fprintf(stderr,
+		"Usage: %s [options] <digest file>\n"
+		"Renders the test corpus and verifies that the intermediate streams match the golden digests bit-exactly.\n\n"
+		"  -u, --update             Write the digests of the current build to the digest file instead\n"
+		"  -f, --filter <text>      Only check streams which names contain the text\n"
+		"  -s, --save-streams <dir> Save the rendered streams to the directory\n"
+		"  -c, --compare <dir>      Compare the rendered streams to those saved in the directory to find the exact\n"
+		"                           diverging sample\n"
+		"  -l, --cpu-level <name>   Bind the DSP kernels to the given level: scalar, sse2, sse4.1, avx2, avx512 or neon\n"
+		"  -h, --help               Show this help\n",
+		programName);
+}
+
+static bool isOption(const char *arg, const char *shortName, const char *longName) {
+	return strcmp(arg, shortName) == 0 || strcmp(arg, longName) == 0;
+}
+
+static bool parseOptions(int argc, char *argv[], Options &options) {
+	memset(&options, 0, sizeof(options));
+	for (int i = 1; i < argc; i++) {
+		const char *arg = argv[i];
+		const bool hasValue = i + 1 < argc;
+		if (isOption(arg, "-u", "--update")) {
+			options.update = true;
+		} else if (isOption(arg, "-f", "--filter") && hasValue) {
+			options.filter = argv[++i];
+		} else if (isOption(arg, "-s", "--save-streams") && hasValue) {
+			options.saveDirName = argv[++i];
+		} else if (isOption(arg, "-c", "--compare") && hasValue) {
+			options.referenceDirName = argv[++i];
+		} else if (isOption(arg, "-l", "--cpu-level") && hasValue) {
+			options.cpuLevelName = argv[++i];
+		} else if (arg[0] != '-' && options.digestFileName == NULL) {
+			options.digestFileName = arg;
+		} else {
+			return false;
+		}
+	}
+	// Digests of a subset of the streams must not replace the complete file.
+	return options.digestFileName != NULL && !(options.update && options.filter != NULL);
+}
+
+static bool openStreamFiles(const Options &options, StreamChecker &checker) {
+	std::string fileName = checker.getName();
+	for (size_t i = 0; i < fileName.size(); i++) {
+		if (fileName[i] == '/') fileName[i] = '-';
+	}
+	fileName += ".raw";
+	if (options.saveDirName != NULL && !checker.openSaveFile(std::string(options.saveDirName) + "/" + fileName)) {
+		fprintf(stderr, "Unable to create %s in %s\n", fileName.c_str(), options.saveDirName);
+		return false;
+	}
+	if (options.referenceDirName != NULL && !checker.openReferenceFile(std::string(options.referenceDirName) + "/" + fileName)) {
+		fprintf(stderr, "Unable to open %s in %s\n", fileName.c_str(), options.referenceDirName);
+		return false;
+	}
+	return true;
+}
+
+// Checks the streams of a single variant and sequence, reports divergences and appends the digest lines.
+// Returns the number of diverging streams, or -1 on error.
+static int checkSequence(const Options &options, const SyntheticROMs &roms, Variant variant, const CorpusSequence &sequence,
+	const std::map<std::string, std::string> &goldenDigests, std::vector<std::string> &digestLines)
+{
+	std::vector<StreamChecker *> checkers;
+	for (int stage = 0; stage < Stage_COUNT; stage++) {
+		checkers.push_back(new StreamChecker(std::string(VARIANT_NAMES[variant]) + "/" + sequence.getName() + "/" + STAGE_NAMES[stage]));
+	}
+	bool selected = options.filter == NULL;
+	for (int stage = 0; stage < Stage_COUNT && !selected; stage++) {
+		selected = checkers[stage]->getName().find(options.filter) != std::string::npos;
+	}
+	bool ok = true;
+	for (int stage = 0; stage < Stage_COUNT && selected && ok; stage++) {
+		ok = openStreamFiles(options, *checkers[stage]);
+	}
+	if (ok && selected && isFloatVariant(variant)) {
+		ok = renderDACStreams<float>(roms, variant, sequence, &checkers[0])
+			&& renderOutput<float>(roms, variant, sequence, *checkers[Stage_ANALOG], false)
+			&& renderOutput<float>(roms, variant, sequence, *checkers[Stage_SRC], true);
+	} else if (ok && selected) {
+		ok = renderDACStreams<Bit16s>(roms, variant, sequence, &checkers[0])
+			&& renderOutput<Bit16s>(roms, variant, sequence, *checkers[Stage_ANALOG], false)
+			&& renderOutput<Bit16s>(roms, variant, sequence, *checkers[Stage_SRC], true);
+	}
+
+	int divergingCount = 0;
+	for (int stage = 0; stage < Stage_COUNT && selected && ok; stage++) {
+		StreamChecker &checker = *checkers[stage];
+		checker.finish();
+		const std::string digestLine = formatDigests(checker);
+		digestLines.push_back(digestLine);
+		if (options.update) continue;
+		std::map<std::string, std::string>::const_iterator golden = goldenDigests.find(checker.getName());
+		if (golden == goldenDigests.end()) {
+			printf("%s: no golden digest\n", checker.getName().c_str());
+			divergingCount++;
+			continue;
+		}
+		const int chunk = findFirstDivergingChunk(golden->second, digestLine);
+		if (chunk < 0) {
+			printf("%s: OK\n", checker.getName().c_str());
+			continue;
+		}
+		// Streams of later stages are expected to diverge as well, the earliest one is the most relevant.
+		printf("%s: DIVERGED%s within frames %u..%u", checker.getName().c_str(), divergingCount == 0 ? " FIRST" : "", chunk * CHUNK_LENGTH, (chunk + 1) * CHUNK_LENGTH - 1);
+		if (checker.getFirstMismatchFrame() >= 0) {
+			printf(", first diverging frame %d", checker.getFirstMismatchFrame());
+		}
+		printf("\n");
+		divergingCount++;
+	}
+	for (size_t i = 0; i < checkers.size(); i++) {
+		delete checkers[i];
+	}
+	return ok ? divergingCount : -1;
+}
+
+int main(int argc, char *argv[]) {
+	Options options;
+	if (!parseOptions(argc, argv, options)) {
+		printUsage(argv[0]);
+		return (argc == 2 && isOption(argv[1], "-h", "--help")) ? 0 : 1;
+	}
+	if (options.cpuLevelName != NULL) {
+		CPUFeatureLevel level;
+		if (!CPUFeatures::findLevel(options.cpuLevelName, level) || !CPUFeatures::forceLevel(level)) {
+			fprintf(stderr, "CPU feature level %s is not supported\n", options.cpuLevelName);
+			return 1;
+		}
+	}
+	printf("DSP kernels: %s\n", CPUFeatures::getLevelName(CPUFeatures::getActiveLevel()));
+	std::map<std::string, std::string> goldenDigests;
+	if (!options.update && !loadDigests(options.digestFileName, goldenDigests)) {
+		fprintf(stderr, "Unable to read golden digests from %s\n", options.digestFileName);
+		return 1;
+	}
+
+	const SyntheticROMs roms;
+	std::vector<CorpusSequence> corpus;
+	makeBenchmarkCorpus(corpus);
+	std::vector<std::string> digestLines;
+	int divergingCount = 0;
+	for (int variant = 0; variant < Variant_COUNT; variant++) {
+		for (size_t i = 0; i < corpus.size(); i++) {
+			if (!isRelevantVariant(Variant(variant), corpus[i])) continue;
+			const int result = checkSequence(options, roms, Variant(variant), corpus[i], goldenDigests, digestLines);
+			if (result < 0) return 1;
+			divergingCount += result;
+		}
+	}
+
+	if (options.update) {
+		if (!saveDigests(options.digestFileName, digestLines)) {
+			fprintf(stderr, "Unable to write golden digests to %s\n", options.digestFileName);
+			return 1;
+		}
+		printf("Written %u digest lines to %s\n", Bit32u(digestLines.size()), options.digestFileName);
+		return 0;
+	}
+	if (divergingCount > 0) {
+		printf("%d stream(s) diverged from the golden digests\n", divergingCount);
+		return 1;
+	}
+	printf("All %u streams match the golden digests\n", Bit32u(digestLines.size()));
+	return 0;
+}
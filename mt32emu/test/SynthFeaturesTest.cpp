@@ -0,0 +1,532 @@
+/* Copyright (C) 2003, 2004, 2005, 2006, 2008, 2009 Dean Beeler, Jerome Fisher
+ * Copyright (C) 2011-2019 Dean Beeler, Jerome Fisher, Sergey V. Mikayev
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License as published by
+ *  the Free Software Foundation, either version 2.1 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+// Checks the optional features of the synth which may legitimately change the output, so the golden digests only pin
+// their current behaviour. Instead, each test renders the synthetic ROMs with a feature enabled and compares the output
+// against the rendering of an equivalent input, or against the output with the feature disabled.
+
+#include <algorithm>
+#include <cstdarg>
+#include <cstddef>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "internals.h"
+
+#include "BenchmarkCorpus.h"
+#include "CaptureReplay.h"
+#include "Structures.h"
+#include "Synth.h"
+#include "SyntheticROMs.h"
+
+using namespace MT32Emu;
+
+static const Bit32u BLOCK_SIZE = 512;
+// The activity of the partials is checked this often.
+static const Bit32u ACTIVITY_CHECK_PERIOD = 32;
+static const Bit32u CHANNEL_COUNT = 2;
+// Controller coalescing works within control ticks of this length aligned to the rendered sample count.
+static const Bit32u CONTROL_TICK_SAMPLES = SAMPLE_RATE / 4000;
+static const Bit8u CHANNEL = 1;
+// Spans several internal rendering passes, which may be split differently for the part streams.
+static const Bit32u PART_STREAMS_BLOCK_SIZE = 10000;
+
+class QuietReportHandler : public ReportHandler {
+public:
+	void printDebug(const char *, va_list) {}
+	void showLCDMessage(const char *) {}
+};
+
+struct RenderSettings {
+	bool controllerCoalescing;
+	bool partialCulling;
+	Bit32u partialCullingThreshold;
+
+	RenderSettings() : controllerCoalescing(false), partialCulling(false), partialCullingThreshold(8192) {}
+};
+
+struct RenderResult {
+	std::vector<Bit16s> output;
+	// Frame at which no partial was found active anymore.
+	Bit32u partialsEndFrame;
+	PolyphonyStatistics polyphonyStatistics;
+};
+
+static bool renderSequence(const SyntheticROMs &roms, const CorpusSequence &sequence, const RenderSettings &settings, RenderResult &result) {
+	QuietReportHandler reportHandler;
+	Synth synth(&reportHandler);
+	// TVP emulates the jitter of the pitch timer using rand(), so the output of each synth instance only depends
+	// on the input if the sequence of the pseudo-random numbers is restarted.
+	srand(1);
+	if (!synth.open(roms.getControlROMImage(), roms.getPCMROMImage(), AnalogOutputMode_DIGITAL_ONLY)) {
+		fprintf(stderr, "Unable to open synth with the synthetic ROMs\n");
+		return false;
+	}
+	if (synth.getInternalRenderedSampleCount() % CONTROL_TICK_SAMPLES != 0) {
+		fprintf(stderr, "The sequence doesn't start at the beginning of a control tick\n");
+		synth.close();
+		return false;
+	}
+	// Otherwise, the emulated MIDI interface delay spreads the short messages over several control ticks.
+	synth.setMIDIDelayMode(MIDIDelayMode_IMMEDIATE);
+	synth.setControllerCoalescingEnabled(settings.controllerCoalescing);
+	synth.setPartialCullingEnabled(settings.partialCulling);
+	synth.setPartialCullingThreshold(settings.partialCullingThreshold);
+	CorpusPlayer player(synth, sequence, false);
+	result.output.assign(CHANNEL_COUNT * sequence.getLength(), 0);
+	result.partialsEndFrame = 0;
+	for (Bit32u renderedLength = 0; renderedLength < sequence.getLength();) {
+		const Bit32u length = std::min(BLOCK_SIZE, sequence.getLength() - renderedLength);
+		player.enqueueEvents(length);
+		for (Bit32u checkedLength = 0; checkedLength < length; checkedLength += ACTIVITY_CHECK_PERIOD) {
+			const Bit32u checkLength = std::min(ACTIVITY_CHECK_PERIOD, length - checkedLength);
+			synth.render(&result.output[CHANNEL_COUNT * (renderedLength + checkedLength)], checkLength);
+			if (synth.hasActivePartials()) result.partialsEndFrame = renderedLength + checkedLength + checkLength;
+		}
+		renderedLength += length;
+	}
+	const bool statisticsPublished = synth.getPolyphonyStatistics(result.polyphonyStatistics);
+	synth.close();
+	if (!statisticsPublished) {
+		fprintf(stderr, "No polyphony statistics published\n");
+		return false;
+	}
+	return true;
+}
+
+// Reports the first differing frame unless the difference is expected.
+static Bit32u findFirstMismatchFrame(const std::vector<Bit16s> &output, const std::vector<Bit16s> &expectedOutput) {
+	const std::pair<std::vector<Bit16s>::const_iterator, std::vector<Bit16s>::const_iterator> mismatch
+		= std::mismatch(output.begin(), output.end(), expectedOutput.begin());
+	return Bit32u(mismatch.first - output.begin()) / CHANNEL_COUNT;
+}
+
+static bool compareOutput(const std::vector<Bit16s> &output, const std::vector<Bit16s> &expectedOutput, const char *description) {
+	const Bit32u mismatchFrame = findFirstMismatchFrame(output, expectedOutput);
+	if (mismatchFrame == output.size() / CHANNEL_COUNT) return true;
+	fprintf(stderr, "%s: output differs at frame %u\n", description, mismatchFrame);
+	return false;
+}
+
+static bool renderAndCompare(const SyntheticROMs &roms, const CorpusSequence &sequence, const RenderSettings &settings,
+	const CorpusSequence &expectedSequence, const RenderSettings &expectedSettings, const char *description, RenderResult *renderResult = NULL)
+{
+	RenderResult localResult;
+	RenderResult &result = renderResult != NULL ? *renderResult : localResult;
+	RenderResult expectedResult;
+	return renderSequence(roms, sequence, settings, result)
+		&& renderSequence(roms, expectedSequence, expectedSettings, expectedResult)
+		&& compareOutput(result.output, expectedResult.output, description);
+}
+
+static void addBenderRangeWrite(CorpusSequence &sequence, Bit32u timestamp, Bit8u partNum, Bit8u benderRange) {
+	const Bit32u address = MT32EMU_SYSEXMEMADDR(MT32EMU_MEMADDR(0x030000) + partNum * sizeof(MemParams::PatchTemp)
+		+ offsetof(PatchParam, benderRange));
+	sequence.addMemoryWrite(timestamp, address, &benderRange, 1);
+}
+
+// Adds the same sustained notes to both sequences.
+static void addBackgroundNotes(CorpusSequence &sequence, Bit32u length) {
+	sequence.addProgramChange(0, CHANNEL, 7);
+	sequence.addProgramChange(0, CHANNEL + 1, 23);
+	sequence.addNote(0, length, CHANNEL, 60, 100);
+	sequence.addNote(0, length, CHANNEL + 1, 67, 100);
+}
+
+// Renders bursts of controller messages with coalescing enabled, and the same bursts without the superseded messages
+// with coalescing disabled. The outputs match only if exactly the superseded messages are dropped and the rest are
+// played at the same samples.
+static bool testCoalescingDropsOnlySupersededMessages(const SyntheticROMs &roms) {
+	static const Bit32u BURST_COUNT = 16;
+	static const Bit32u BURST_PERIOD = 200 * CONTROL_TICK_SAMPLES;
+	CorpusSequence input("superseded");
+	CorpusSequence expected("superseded-dropped");
+	addBackgroundNotes(input, BURST_COUNT * BURST_PERIOD);
+	addBackgroundNotes(expected, BURST_COUNT * BURST_PERIOD);
+	for (Bit32u burst = 0; burst < BURST_COUNT; burst++) {
+		// Each burst starts at the beginning of a control tick, and each message occupies a sample as it is played late.
+		const Bit32u burstStart = (burst + 1) * BURST_PERIOD;
+		// Superseded by a pitch bend on the same channel.
+		input.addPitchBend(burstStart, CHANNEL, 16383 - 1000 * burst);
+		// A single message of the kind on the channel.
+		input.addControlChange(burstStart, CHANNEL + 1, 7, Bit8u(127 - 5 * burst));
+		expected.addControlChange(burstStart, CHANNEL + 1, 7, Bit8u(127 - 5 * burst));
+		// Superseded by an expression message on the same channel, while a modulation message is in between.
+		input.addControlChange(burstStart, CHANNEL, 11, Bit8u(7 * burst));
+		input.addControlChange(burstStart, CHANNEL, 1, Bit8u(8 * burst));
+		expected.addControlChange(burstStart, CHANNEL, 1, Bit8u(8 * burst));
+		input.addPitchBend(burstStart, CHANNEL, 8192 + 500 * burst);
+		expected.addPitchBend(burstStart, CHANNEL, 8192 + 500 * burst);
+		input.addControlChange(burstStart, CHANNEL, 11, Bit8u(127 - 3 * burst));
+		expected.addControlChange(burstStart, CHANNEL, 11, Bit8u(127 - 3 * burst));
+		// The later message lands in the next control tick, so neither is dropped.
+		for (Bit32u i = 0; i < 2; i++) {
+			input.addPitchBend(burstStart + CONTROL_TICK_SAMPLES - 1, CHANNEL + 1, 4096 * (i + 1) + 100 * burst);
+			expected.addPitchBend(burstStart + CONTROL_TICK_SAMPLES - 1, CHANNEL + 1, 4096 * (i + 1) + 100 * burst);
+		}
+	}
+	input.finish();
+	expected.finish();
+	RenderSettings coalescing;
+	coalescing.controllerCoalescing = true;
+	return renderAndCompare(roms, input, coalescing, expected, RenderSettings(), "superseded messages dropped");
+}
+
+enum Barrier {
+	Barrier_NOTE_ON,
+	Barrier_NOTE_OFF,
+	Barrier_SYSEX
+};
+
+// Surrounds a message of the given kind with pitch bends on the same channel within a control tick.
+static void makeBarrierSequence(CorpusSequence &sequence, Barrier barrier, bool withFirstPitchBend) {
+	static const Bit32u BURST_COUNT = 8;
+	static const Bit32u BURST_PERIOD = 400 * CONTROL_TICK_SAMPLES;
+	addBackgroundNotes(sequence, (BURST_COUNT + 1) * BURST_PERIOD);
+	for (Bit32u burst = 0; burst < BURST_COUNT; burst++) {
+		const Bit32u burstStart = (burst + 1) * BURST_PERIOD;
+		const Bit8u key = Bit8u(64 + burst);
+		if (withFirstPitchBend) sequence.addPitchBend(burstStart, CHANNEL, burst % 2 == 0 ? 16383 : 0);
+		switch (barrier) {
+		case Barrier_NOTE_ON:
+			sequence.addNote(burstStart, BURST_PERIOD / 2, CHANNEL, key, 110);
+			break;
+		case Barrier_NOTE_OFF:
+			sequence.addNote(burstStart - BURST_PERIOD / 2, BURST_PERIOD / 2, CHANNEL, key, 110);
+			break;
+		case Barrier_SYSEX:
+			addBenderRangeWrite(sequence, burstStart, 0, Bit8u(2 + burst));
+			break;
+		}
+		sequence.addPitchBend(burstStart, CHANNEL, 8192);
+	}
+	sequence.finish();
+}
+
+// A pitch bend followed by a note or a SysEx message and a superseding pitch bend within the same control tick must not
+// be dropped, so the output equals the output with coalescing disabled.
+static bool testCoalescingStopsAtNotesAndSysex(const SyntheticROMs &roms) {
+	static const char * const BARRIER_NAMES[] = {"note-on", "note-off", "sysex"};
+	RenderSettings coalescing;
+	coalescing.controllerCoalescing = true;
+	bool ok = true;
+	for (int barrier = Barrier_NOTE_ON; barrier <= Barrier_SYSEX; barrier++) {
+		CorpusSequence sequence(BARRIER_NAMES[barrier]);
+		makeBarrierSequence(sequence, Barrier(barrier), true);
+		ok = renderAndCompare(roms, sequence, coalescing, sequence, RenderSettings(), BARRIER_NAMES[barrier]) && ok;
+	}
+	// Make sure that the dropping of the first pitch bend would be noticed. A new note takes the pitch bend into account
+	// immediately.
+	CorpusSequence sequence("note-on");
+	makeBarrierSequence(sequence, Barrier_NOTE_ON, true);
+	CorpusSequence reducedSequence("note-on-reduced");
+	makeBarrierSequence(reducedSequence, Barrier_NOTE_ON, false);
+	RenderResult result;
+	RenderResult reducedResult;
+	if (!renderSequence(roms, sequence, RenderSettings(), result) || !renderSequence(roms, reducedSequence, RenderSettings(), reducedResult)) return false;
+	if (result.output == reducedResult.output) {
+		fprintf(stderr, "note-on: dropping the first pitch bend doesn't change the output\n");
+		ok = false;
+	}
+	return ok;
+}
+
+// A single note with a long release.
+static void makeReleasingNoteSequence(CorpusSequence &sequence, Bit32u noteLength) {
+	sequence.addProgramChange(0, CHANNEL, 0);
+	sequence.addNote(0, noteLength, CHANNEL, 60, 100);
+	sequence.finish();
+}
+
+// With the default threshold, a releasing partial is deactivated well before its amplitude envelope ends, though it only
+// renders zero samples by then, so the output stays the same.
+static bool testCullingFreesDecayedPartials(const SyntheticROMs &roms) {
+	CorpusSequence sequence("releasing-note");
+	makeReleasingNoteSequence(sequence, SAMPLE_RATE / 5);
+	RenderSettings culling;
+	culling.partialCulling = true;
+	RenderResult result;
+	RenderResult unculledResult;
+	if (!renderSequence(roms, sequence, culling, result) || !renderSequence(roms, sequence, RenderSettings(), unculledResult)) return false;
+	bool ok = compareOutput(result.output, unculledResult.output, "culled below the default threshold");
+	if (unculledResult.partialsEndFrame >= sequence.getLength()) {
+		fprintf(stderr, "The release doesn't end within the sequence\n");
+		ok = false;
+	}
+	if (result.partialsEndFrame >= unculledResult.partialsEndFrame) {
+		fprintf(stderr, "Partials active until frame %u, without culling until frame %u\n", result.partialsEndFrame, unculledResult.partialsEndFrame);
+		ok = false;
+	}
+	if (result.polyphonyStatistics.culledPartialCount == 0 || unculledResult.polyphonyStatistics.culledPartialCount != 0) {
+		fprintf(stderr, "Reported %u culled partials, without culling %u\n", result.polyphonyStatistics.culledPartialCount,
+			unculledResult.polyphonyStatistics.culledPartialCount);
+		ok = false;
+	}
+	return ok;
+}
+
+// Only releasing partials are culled, even though the threshold is above the level of any partial.
+static bool testCullingKeepsHeldPartials(const SyntheticROMs &roms) {
+	CorpusSequence sequence("held-note");
+	makeReleasingNoteSequence(sequence, 2 * SAMPLE_RATE);
+	RenderSettings culling;
+	culling.partialCulling = true;
+	culling.partialCullingThreshold = 65535;
+	RenderResult result;
+	RenderResult unculledResult;
+	if (!renderSequence(roms, sequence, culling, result) || !renderSequence(roms, sequence, RenderSettings(), unculledResult)) return false;
+	// The partials are culled as soon as they start releasing, after the hold time.
+	const Bit32u mismatchFrame = findFirstMismatchFrame(result.output, unculledResult.output);
+	if (mismatchFrame < 2 * SAMPLE_RATE) {
+		fprintf(stderr, "Held note output differs at frame %u\n", mismatchFrame);
+		return false;
+	}
+	if (result.polyphonyStatistics.culledPartialCount == 0) {
+		fprintf(stderr, "No partials culled after the note is released\n");
+		return false;
+	}
+	return true;
+}
+
+// The levels of the partials never drop below zero, so culling with the threshold of 0 is bit-exact.
+static bool testCullingThresholdZeroIsBitExact(const SyntheticROMs &roms) {
+	std::vector<CorpusSequence> corpus;
+	makeBenchmarkCorpus(corpus);
+	RenderSettings culling;
+	culling.partialCulling = true;
+	culling.partialCullingThreshold = 0;
+	bool ok = true;
+	for (size_t i = 0; i < corpus.size(); i++) {
+		RenderResult result;
+		if (!renderAndCompare(roms, corpus[i], culling, corpus[i], RenderSettings(), corpus[i].getName().c_str(), &result)) {
+			ok = false;
+		} else if (result.polyphonyStatistics.culledPartialCount != 0) {
+			fprintf(stderr, "%s: reported %u culled partials\n", corpus[i].getName().c_str(), result.polyphonyStatistics.culledPartialCount);
+			ok = false;
+		}
+	}
+	return ok;
+}
+
+// Float streams of a sequence, where dry is either the sum of the non-reverb and the reverb-dry streams
+// or the sum of all the part streams.
+struct StreamsResult {
+	std::vector<float> dryLeft;
+	std::vector<float> dryRight;
+	std::vector<float> wetLeft;
+	std::vector<float> wetRight;
+};
+
+static bool renderDryAndWetStreams(const SyntheticROMs &roms, const CorpusSequence &sequence, RendererType rendererType, bool partStreams, StreamsResult &result) {
+	QuietReportHandler reportHandler;
+	Synth synth(&reportHandler);
+	srand(1);
+	synth.selectRendererType(rendererType);
+	if (!synth.open(roms.getControlROMImage(), roms.getPCMROMImage(), AnalogOutputMode_DIGITAL_ONLY)) {
+		fprintf(stderr, "Unable to open synth with the synthetic ROMs\n");
+		return false;
+	}
+	CorpusPlayer player(synth, sequence, false);
+	const Bit32u sequenceLength = sequence.getLength();
+	result.dryLeft.assign(sequenceLength, 0.0f);
+	result.dryRight.assign(sequenceLength, 0.0f);
+	result.wetLeft.assign(sequenceLength, 0.0f);
+	result.wetRight.assign(sequenceLength, 0.0f);
+	std::vector<float> buffers[18];
+	for (int i = 0; i < 18; i++) {
+		buffers[i].resize(PART_STREAMS_BLOCK_SIZE);
+	}
+	for (Bit32u renderedLength = 0; renderedLength < sequenceLength;) {
+		const Bit32u length = std::min(PART_STREAMS_BLOCK_SIZE, sequenceLength - renderedLength);
+		player.enqueueEvents(length);
+		Bit32u streamCount;
+		if (partStreams) {
+			PartOutputStreams<float> streams;
+			for (int part = 0; part < 9; part++) {
+				streams.partLeft[part] = &buffers[2 * part][0];
+				streams.partRight[part] = &buffers[2 * part + 1][0];
+			}
+			streams.reverbWetLeft = &result.wetLeft[renderedLength];
+			streams.reverbWetRight = &result.wetRight[renderedLength];
+			synth.renderPartStreams(streams, length);
+			streamCount = 9;
+		} else {
+			const DACOutputStreams<float> streams = {
+				&buffers[0][0], &buffers[1][0], &buffers[2][0], &buffers[3][0], &result.wetLeft[renderedLength], &result.wetRight[renderedLength]
+			};
+			synth.renderStreams(streams, length);
+			streamCount = 2;
+		}
+		for (Bit32u stream = 0; stream < streamCount; stream++) {
+			for (Bit32u i = 0; i < length; i++) {
+				result.dryLeft[renderedLength + i] += buffers[2 * stream][i];
+				result.dryRight[renderedLength + i] += buffers[2 * stream + 1][i];
+			}
+		}
+		renderedLength += length;
+	}
+	synth.close();
+	return true;
+}
+
+static bool compareFloatStream(const std::vector<float> &stream, const std::vector<float> &expectedStream, float tolerance, const std::string &description) {
+	for (size_t i = 0; i < stream.size(); i++) {
+		const float difference = stream[i] - expectedStream[i];
+		if (difference > tolerance || difference < -tolerance) {
+			fprintf(stderr, "%s: stream differs at frame %u by %g\n", description.c_str(), Bit32u(i), difference);
+			return false;
+		}
+	}
+	return true;
+}
+
+// The part streams must sum up to the non-reverb and the reverb-dry streams up to the rounding errors of the float mixing,
+// while the reverb return must be identical. The integer renderer is checked as well, as its output is converted to float
+// in separate passes.
+static bool testPartStreamsSumUpToMix(const SyntheticROMs &roms) {
+	static const float DRY_TOLERANCE = 1e-6f;
+	static const RendererType RENDERER_TYPES[] = {RendererType_BIT16S, RendererType_FLOAT};
+	static const char * const RENDERER_NAMES[] = {"int", "float"};
+	std::vector<CorpusSequence> corpus;
+	makeBenchmarkCorpus(corpus);
+	bool ok = true;
+	for (int rendererIx = 0; rendererIx < 2; rendererIx++) {
+		for (size_t i = 0; i < corpus.size(); i++) {
+			const std::string name = corpus[i].getName() + " (" + RENDERER_NAMES[rendererIx] + ")";
+			StreamsResult partResult;
+			StreamsResult mixResult;
+			if (!renderDryAndWetStreams(roms, corpus[i], RENDERER_TYPES[rendererIx], true, partResult)
+				|| !renderDryAndWetStreams(roms, corpus[i], RENDERER_TYPES[rendererIx], false, mixResult)) return false;
+			ok = compareFloatStream(partResult.dryLeft, mixResult.dryLeft, DRY_TOLERANCE, name + " dry left") && ok;
+			ok = compareFloatStream(partResult.dryRight, mixResult.dryRight, DRY_TOLERANCE, name + " dry right") && ok;
+			ok = compareFloatStream(partResult.wetLeft, mixResult.wetLeft, 0.0f, name + " wet left") && ok;
+			ok = compareFloatStream(partResult.wetRight, mixResult.wetRight, 0.0f, name + " wet right") && ok;
+		}
+	}
+	return ok;
+}
+
+static bool readRawOutput(const char *fileName, std::vector<Bit16s> &output) {
+	FILE *file = fopen(fileName, "rb");
+	if (file == NULL) return false;
+	Bit16s buffer[CHANNEL_COUNT * BLOCK_SIZE];
+	for (;;) {
+		const size_t readCount = fread(buffer, sizeof(Bit16s), CHANNEL_COUNT * BLOCK_SIZE, file);
+		output.insert(output.end(), buffer, buffer + readCount);
+		if (readCount < CHANNEL_COUNT * BLOCK_SIZE) break;
+	}
+	fclose(file);
+	return true;
+}
+
+// Captures the input of a synth that plays a corpus sequence with the default MIDI delay and changes a couple
+// of settings on the way. The replay feeds the records read back with MidiCaptureReader at the same points,
+// rendering in blocks of the same lengths, so the output must be bit-exact.
+static bool testMidiCaptureRoundTrip(const SyntheticROMs &roms) {
+	static const char CAPTURE_FILE_NAME[] = "mt32emu_features_test.capture";
+	static const char OUTPUT_FILE_NAME[] = "mt32emu_features_test.raw";
+	std::vector<CorpusSequence> corpus;
+	makeBenchmarkCorpus(corpus);
+	const CorpusSequence *sequence = NULL;
+	for (size_t i = 0; i < corpus.size(); i++) {
+		if (corpus[i].getName() == "reverb-switch") sequence = &corpus[i];
+	}
+	if (sequence == NULL) {
+		fprintf(stderr, "No reverb-switch sequence in the corpus\n");
+		return false;
+	}
+
+	QuietReportHandler reportHandler;
+	Synth synth(&reportHandler);
+	srand(1);
+	if (!synth.open(roms.getControlROMImage(), roms.getPCMROMImage(), AnalogOutputMode_DIGITAL_ONLY)) {
+		fprintf(stderr, "Unable to open synth with the synthetic ROMs\n");
+		return false;
+	}
+	if (!synth.startMidiCapture(CAPTURE_FILE_NAME)) {
+		fprintf(stderr, "Unable to start MIDI capture to %s\n", CAPTURE_FILE_NAME);
+		synth.close();
+		return false;
+	}
+	CorpusPlayer player(synth, *sequence, false);
+	std::vector<Bit16s> output(CHANNEL_COUNT * sequence->getLength(), 0);
+	for (Bit32u renderedLength = 0; renderedLength < sequence->getLength();) {
+		const Bit32u length = std::min(BLOCK_SIZE, sequence->getLength() - renderedLength);
+		if (renderedLength == 8 * BLOCK_SIZE) synth.setOutputGain(0.75f);
+		if (renderedLength == 16 * BLOCK_SIZE) synth.setReverbOutputGain(1.5f, synth.getInternalRenderedSampleCount() + 100);
+		player.enqueueEvents(length);
+		synth.render(&output[CHANNEL_COUNT * renderedLength], length);
+		renderedLength += length;
+	}
+	synth.stopMidiCapture();
+	synth.close();
+
+	CaptureReplayOptions options;
+	options.captureFileName = CAPTURE_FILE_NAME;
+	options.controlROMFileName = NULL;
+	options.pcmROMFileName = NULL;
+	options.outputFileName = OUTPUT_FILE_NAME;
+	options.repetitionCount = 1;
+	FILE *report = tmpfile();
+	const int exitCode = replayCapture(options, report != NULL ? report : stderr);
+	if (report != NULL) fclose(report);
+	std::vector<Bit16s> replayedOutput;
+	const bool outputRead = exitCode == 0 && readRawOutput(OUTPUT_FILE_NAME, replayedOutput);
+	remove(CAPTURE_FILE_NAME);
+	remove(OUTPUT_FILE_NAME);
+	if (!outputRead) {
+		fprintf(stderr, "Unable to replay the MIDI capture\n");
+		return false;
+	}
+	if (replayedOutput.size() != output.size()) {
+		fprintf(stderr, "Replayed %u frames, captured %u frames\n", Bit32u(replayedOutput.size() / CHANNEL_COUNT), Bit32u(output.size() / CHANNEL_COUNT));
+		return false;
+	}
+	return compareOutput(replayedOutput, output, "replayed capture");
+}
+
+struct TestCase {
+	const char *name;
+	bool (*run)(const SyntheticROMs &roms);
+};
+
+static const TestCase TEST_CASES[] = {
+	{"coalescing-drops-only-superseded-messages", testCoalescingDropsOnlySupersededMessages},
+	{"coalescing-stops-at-notes-and-sysex", testCoalescingStopsAtNotesAndSysex},
+	{"culling-frees-decayed-partials", testCullingFreesDecayedPartials},
+	{"culling-keeps-held-partials", testCullingKeepsHeldPartials},
+	{"culling-threshold-zero-is-bit-exact", testCullingThresholdZeroIsBitExact},
+	{"midi-capture-round-trip", testMidiCaptureRoundTrip},
+	{"part-streams-sum-up-to-mix", testPartStreamsSumUpToMix}
+};
+
+int main(int argc, char *argv[]) {
+	const char *filter = argc > 1 ? argv[1] : NULL;
+	const SyntheticROMs roms;
+	bool ok = true;
+	for (size_t i = 0; i < sizeof(TEST_CASES) / sizeof(TEST_CASES[0]); i++) {
+		const TestCase &testCase = TEST_CASES[i];
+		if (filter != NULL && std::string(testCase.name).find(filter) == std::string::npos) continue;
+		const bool passed = testCase.run(roms);
+		printf("%s: %s\n", testCase.name, passed ? "OK" : "FAILED");
+		ok = passed && ok;
+	}
+	return ok ? 0 : 1;
+}
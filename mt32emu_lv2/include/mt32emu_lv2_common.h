@@ -65,9 +65,16 @@ enum PortIndex: uint32_t
     REVERB_TIME = 7,
     REVERB_LEVEL = 8,
     OUTPUT_GAIN = 9,
-    REVERB_OUTPUT_GAIN = 10
+    REVERB_OUTPUT_GAIN = 10,
+    /** Left and right outputs of parts 1-8 and the rhythm part, interleaved */
+    PART_OUT_FIRST = 11,
+    REVERB_OUT_L = 29,
+    REVERB_OUT_R = 30
 };
 
+/** Number of per-part output ports */
+const uint32_t PART_OUT_COUNT = PortIndex::REVERB_OUT_L - PortIndex::PART_OUT_FIRST;
+
 bool getSysExInfo(const uint8_t *evdata, uint32_t size, uint32_t *addr_out, uint32_t *len_out)
 {
     if (size > 10)
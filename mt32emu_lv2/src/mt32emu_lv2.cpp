@@ -133,6 +133,8 @@ private:
         float *reverb_level;
         float *output_gain;
         float *reverb_output_gain;
+        float *part_out[PART_OUT_COUNT];
+        float *reverb_out[2];
     } m_ports;
     struct PortValues
     {
@@ -156,6 +158,8 @@ private:
     /// Ratio scaling from real samples to MT32 samples
     double m_rateRatio;
     MT32Emu::SampleRateConverter *m_converter;
+    /// Scratch buffers for per-part streams followed by the reverb return
+    float *m_partBuffers;
     LV2_Atom_Forge m_forge;
     LV2_Atom_Forge_Frame m_notify_frame;
 
@@ -163,6 +167,10 @@ private:
     void deinitSynth();
     /** Detect changes to parameter ports and apply them */
     void handleParameterChanges();
+    /** Return true if any of the per-part or reverb return output ports is connected */
+    bool hasPartOutputs() const;
+    /** Render per-part streams in a single pass, and mix the main output from them */
+    void renderPartOutputs(uint32_t sample_count);
 };
 
 const char *MuntPlugin::URI = MUNT_URI;
@@ -336,7 +344,7 @@ MuntPlugin::MuntPlugin(const LV2_Descriptor* /*descriptor*/, double rate, const
     const Features &features):
     m_features(features), m_uris(features.map),
     m_rate(rate), m_reportHandler(0), m_synth(0), m_controlROMImage(0), m_pcmROMImage(0),
-    m_timestamp(0), m_rateRatio(0), m_converter(0)
+    m_timestamp(0), m_rateRatio(0), m_converter(0), m_partBuffers(0)
 {
     memset(&m_ports, 0, sizeof(m_ports));
     // Fill port_values with invalid values, so that a change will be detected initially
@@ -391,6 +399,16 @@ void MuntPlugin::connect_port(uint32_t port, void* data)
     case PortIndex::REVERB_OUTPUT_GAIN:
         m_ports.reverb_output_gain = static_cast<float*>(data);
         break;
+    case PortIndex::REVERB_OUT_L:
+        m_ports.reverb_out[0] = static_cast<float*>(data);
+        break;
+    case PortIndex::REVERB_OUT_R:
+        m_ports.reverb_out[1] = static_cast<float*>(data);
+        break;
+    default:
+        if (port >= PortIndex::PART_OUT_FIRST && port < PortIndex::PART_OUT_FIRST + PART_OUT_COUNT)
+            m_ports.part_out[port - PortIndex::PART_OUT_FIRST] = static_cast<float*>(data);
+        break;
     }
 }
 
@@ -451,11 +469,14 @@ void MuntPlugin::initSynth()
         fflush(stdout);
     }
     m_rateRatio = MT32Emu::SAMPLE_RATE / m_rate;
+    if (!m_converter)
+        m_partBuffers = new float[(PART_OUT_COUNT + 2) * MT32Emu::MAX_SAMPLES_PER_RUN];
 }
 
 void MuntPlugin::deinitSynth()
 {
     delete m_converter; m_converter = 0;
+    delete[] m_partBuffers; m_partBuffers = 0;
     if (m_synth)
         m_synth->close();
     delete m_synth; m_synth = 0;
@@ -521,6 +542,57 @@ void MuntPlugin::handleParameterChanges()
     }
 }
 
+bool MuntPlugin::hasPartOutputs() const
+{
+    for (unsigned stream=0; stream<PART_OUT_COUNT; ++stream)
+        if (m_ports.part_out[stream])
+            return true;
+    return m_ports.reverb_out[0] || m_ports.reverb_out[1];
+}
+
+void MuntPlugin::renderPartOutputs(uint32_t sample_count)
+{
+    const uint32_t bufferSize = MT32Emu::MAX_SAMPLES_PER_RUN;
+    const float *reverbBuffers[2] = {m_partBuffers + PART_OUT_COUNT * bufferSize, m_partBuffers + (PART_OUT_COUNT + 1) * bufferSize};
+    // Same as the digital only analogue output mode. The float streams are normalised to 32768,
+    // while the main output in run() is scaled from the integer samples by 1/10240.
+    const float levelScale = 32768.0f / 10240.0f;
+    const float outputGain = m_synth->getOutputGain() * levelScale;
+    const float reverbOutputGain = m_synth->getReverbOutputGain() * levelScale;
+    uint32_t offset = 0;
+    while(offset < sample_count) {
+        uint32_t framesToRender = std::min(sample_count - offset, bufferSize);
+
+        MT32Emu::PartOutputStreams<float> streams;
+        for (unsigned part=0; part<9; ++part) {
+            streams.partLeft[part] = m_partBuffers + (2 * part) * bufferSize;
+            streams.partRight[part] = m_partBuffers + (2 * part + 1) * bufferSize;
+        }
+        streams.reverbWetLeft = m_partBuffers + PART_OUT_COUNT * bufferSize;
+        streams.reverbWetRight = m_partBuffers + (PART_OUT_COUNT + 1) * bufferSize;
+        m_synth->renderPartStreams(streams, framesToRender);
+
+        for(unsigned x=0; x<framesToRender; ++x) {
+            float mix[2];
+            for (unsigned channel=0; channel<2; ++channel) {
+                float sample = reverbBuffers[channel][x] * reverbOutputGain;
+                if (m_ports.reverb_out[channel])
+                    m_ports.reverb_out[channel][offset] = sample;
+                mix[channel] = sample;
+            }
+            for (unsigned stream=0; stream<PART_OUT_COUNT; ++stream) {
+                float sample = m_partBuffers[stream * bufferSize + x] * outputGain;
+                if (m_ports.part_out[stream])
+                    m_ports.part_out[stream][offset] = sample;
+                mix[stream & 1] += sample;
+            }
+            m_ports.out[0][offset] = mix[0];
+            m_ports.out[1][offset] = mix[1];
+            offset += 1;
+        }
+    }
+}
+
 void MuntPlugin::run(uint32_t sample_count)
 {
     if (!m_ports.control || !m_ports.notify || !m_ports.out[0] || !m_ports.out[1] || !m_synth)
@@ -581,6 +653,20 @@ void MuntPlugin::run(uint32_t sample_count)
         }
     }
 
+    if (m_partBuffers && hasPartOutputs()) {
+        renderPartOutputs(sample_count);
+        m_timestamp += sample_count;
+        return;
+    }
+
+    // Per-part streams are not resampled, so these outputs are silent unless running at the native sample rate
+    for (unsigned stream=0; stream<PART_OUT_COUNT; ++stream)
+        if (m_ports.part_out[stream])
+            memset(m_ports.part_out[stream], 0, sample_count * sizeof(float));
+    for (unsigned channel=0; channel<2; ++channel)
+        if (m_ports.reverb_out[channel])
+            memset(m_ports.reverb_out[channel], 0, sample_count * sizeof(float));
+
     MT32Emu::Bit16s samples[MT32Emu::MAX_SAMPLES_PER_RUN*2];
     uint32_t offset = 0;
     while(offset < sample_count) {
@@ -0,0 +1,238 @@
+/* Copyright (C) 2011-2019 Jerome Fisher, Sergey V. Mikayev
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+
+#include "LatencyTester.h"
+
+#include "Master.h"
+#include "MasterClock.h"
+#include "SynthRoute.h"
+
+using namespace MT32Emu;
+
+static const uint DEFAULT_DURATION_SECONDS = 10;
+static const uint DEFAULT_INTERVAL_MILLIS = 250;
+// The rendered stream must stay below QUIET_LEVEL for QUIET_MILLIS before an onset can be detected again.
+static const int ONSET_LEVEL = 2048;
+static const int QUIET_LEVEL = 256;
+static const uint QUIET_MILLIS = 20;
+// Notes which onsets are not detected within this time are considered lost.
+static const MasterClockNanos MAX_LATENCY_NANOS = MasterClock::NANOS_PER_SECOND;
+
+static void showUsage() {
+	QString appName = QFileInfo(QCoreApplication::arguments().at(0)).fileName();
+	fprintf(stderr, "%s",
+		QString(
+			"Usage: " + appName + " latency_test [option...] [<chunk>/<audio latency>/<MIDI latency>/<advanced timing>...]\n"
+			"Measures MIDI in to audio out latency with the null audio driver for the given audio settings (in ms,\n"
+			"MIDI latency 0 means auto, advanced timing is 0 or 1), or for a sweep of typical settings by default.\n"
+			"\n"
+			"Options:\n"
+			"-help\n"
+			"	show this message and exit.\n"
+			"-duration <seconds>\n"
+			"	time to measure each configuration, default 10.\n"
+			"-interval <ms>\n"
+			"	average interval between the probe notes, default 250.\n"
+			"-samplerate <Hz>\n"
+			"	output sample rate, default is the native sample rate of the synth.\n"
+		).toLocal8Bit().constData());
+}
+
+static bool parseSettings(const QString &arg, AudioDriverSettings &settings) {
+	QStringList values = arg.split('/');
+	if (values.size() != 4) return false;
+	bool ok[4];
+	settings.chunkLen = values.at(0).toUInt(&ok[0]);
+	settings.audioLatency = values.at(1).toUInt(&ok[1]);
+	settings.midiLatency = values.at(2).toUInt(&ok[2]);
+	settings.advancedTiming = values.at(3).toUInt(&ok[3]) != 0;
+	return ok[0] && ok[1] && ok[2] && ok[3];
+}
+
+static void addDefaultSettings(QList<AudioDriverSettings> &settingsList, const AudioDriverSettings &baseSettings) {
+	static const uint CHUNK_LENGTHS[] = {5, 10, 20};
+	static const uint LATENCY_FACTORS[] = {2, 4, 8};
+	AudioDriverSettings settings = baseSettings;
+	settings.midiLatency = 0;
+	for (uint chunkIx = 0; chunkIx < sizeof(CHUNK_LENGTHS) / sizeof(CHUNK_LENGTHS[0]); chunkIx++) {
+		for (uint factorIx = 0; factorIx < sizeof(LATENCY_FACTORS) / sizeof(LATENCY_FACTORS[0]); factorIx++) {
+			settings.chunkLen = CHUNK_LENGTHS[chunkIx];
+			settings.audioLatency = CHUNK_LENGTHS[chunkIx] * LATENCY_FACTORS[factorIx];
+			settings.advancedTiming = true;
+			settingsList.append(settings);
+			settings.advancedTiming = false;
+			settingsList.append(settings);
+		}
+	}
+}
+
+static void printResult(const LatencyTestResult &result) {
+	printf("%5u %5u %5u %3s %6u %6u %8.2f %8.2f %8.2f %8.2f %8.2f %8.2f %6u %6u\n",
+		result.settings.chunkLen, result.settings.audioLatency, result.settings.midiLatency,
+		result.settings.advancedTiming ? "on" : "off", result.sentCount, result.detectedCount,
+		result.min, result.median, result.mean, result.p99, result.max, result.jitter,
+		result.underrunCount, result.lateMIDIEventCount);
+	fflush(stdout);
+}
+
+int LatencyTester::run(Master &master, const QStringList &args) {
+	MasterClockNanos durationNanos = DEFAULT_DURATION_SECONDS * MasterClock::NANOS_PER_SECOND;
+	MasterClockNanos intervalNanos = DEFAULT_INTERVAL_MILLIS * MasterClock::NANOS_PER_MILLISECOND;
+	AudioDriverSettings baseSettings;
+	baseSettings.sampleRate = 0;
+	baseSettings.srcQuality = SamplerateConversionQuality_GOOD;
+	QList<AudioDriverSettings> settingsList;
+	for (int argIx = 0; argIx < args.size(); argIx++) {
+		const QString &arg = args.at(argIx);
+		const bool hasValue = argIx + 1 < args.size();
+		if (QString::compare(arg, "-help", Qt::CaseInsensitive) == 0 || QString::compare(arg, "--help", Qt::CaseInsensitive) == 0
+			|| QString::compare(arg, "-h", Qt::CaseInsensitive) == 0) {
+			showUsage();
+			return 0;
+		} else if (QString::compare(arg, "-duration", Qt::CaseInsensitive) == 0 && hasValue) {
+			durationNanos = args.at(++argIx).toUInt() * MasterClock::NANOS_PER_SECOND;
+		} else if (QString::compare(arg, "-interval", Qt::CaseInsensitive) == 0 && hasValue) {
+			intervalNanos = args.at(++argIx).toUInt() * MasterClock::NANOS_PER_MILLISECOND;
+		} else if (QString::compare(arg, "-samplerate", Qt::CaseInsensitive) == 0 && hasValue) {
+			baseSettings.sampleRate = args.at(++argIx).toUInt();
+		} else {
+			AudioDriverSettings settings = baseSettings;
+			if (!parseSettings(arg, settings)) {
+				showUsage();
+				return 1;
+			}
+			settingsList.append(settings);
+		}
+	}
+	if (durationNanos <= 0 || intervalNanos <= 0) {
+		showUsage();
+		return 1;
+	}
+	// The sample rate may follow the explicit settings in the command line.
+	for (int i = 0; i < settingsList.size(); i++) {
+		settingsList[i].sampleRate = baseSettings.sampleRate;
+	}
+	if (settingsList.isEmpty()) addDefaultSettings(settingsList, baseSettings);
+
+	printf("Latencies in ms from note-on sent to onset played\n");
+	printf("chunk audio  midi adv   sent  found      min   median     mean      p99      max   jitter  xruns   late\n");
+	for (int i = 0; i < settingsList.size(); i++) {
+		LatencyTester tester;
+		LatencyTestResult result;
+		if (!tester.measure(master, settingsList.at(i), durationNanos, intervalNanos, result)) {
+			fprintf(stderr, "Failed to open synth, check the ROM configuration of the default synth profile\n");
+			return 1;
+		}
+		printResult(result);
+	}
+	return 0;
+}
+
+LatencyTester::LatencyTester() : quietFrameCount(0), requiredQuietFrameCount(0), underrunCount(0), lateMIDIEventCount(0) {}
+
+bool LatencyTester::measure(Master &master, const AudioDriverSettings &settings, MasterClockNanos durationNanos, MasterClockNanos intervalNanos, LatencyTestResult &result) {
+	NullAudioDriver audioDriver(settings, this);
+	const QList<const AudioDevice *> audioDevices = audioDriver.createDeviceList();
+	SynthRoute synthRoute;
+	synthRoute.setAudioDevice(audioDevices.first());
+	if (!synthRoute.open()) {
+		qDeleteAll(audioDevices);
+		return false;
+	}
+	// Reverb tail would mask the subsequent onsets.
+	synthRoute.setReverbEnabled(false);
+	synthRoute.setReverbOverridden(true);
+
+	TestMidiDriver midiDriver(&master, &synthRoute, this, intervalNanos);
+	midiDriver.start();
+	const MasterClockNanos endNanos = MasterClock::getClockNanos() + durationNanos;
+	while (MasterClock::getClockNanos() < endNanos) {
+		// Synth notifications are delivered via the event loop.
+		QCoreApplication::processEvents();
+		MasterClock::sleepForNanos(10 * MasterClock::NANOS_PER_MILLISECOND);
+	}
+	midiDriver.stop();
+	// Let the onsets of the last notes reach the output.
+	MasterClock::sleepForNanos(MAX_LATENCY_NANOS);
+	synthRoute.close();
+	qDeleteAll(audioDevices);
+
+	result.settings = audioDriver.getAudioSettings();
+	computeResult(result);
+	return true;
+}
+
+void LatencyTester::computeResult(LatencyTestResult &result) {
+	QMutexLocker locker(&mutex);
+	QVector<double> latencies;
+	int sentIx = 0;
+	for (int onsetIx = 0; onsetIx < detectedOnsets.size(); onsetIx++) {
+		const MasterClockNanos onsetNanos = detectedOnsets.at(onsetIx);
+		// Skip the notes which onsets were not detected.
+		while (sentIx < sentNotes.size() && onsetNanos - sentNotes.at(sentIx) > MAX_LATENCY_NANOS) sentIx++;
+		if (sentIx == sentNotes.size()) break;
+		// An onset not caused by a probe note.
+		if (onsetNanos < sentNotes.at(sentIx)) continue;
+		latencies.append(double(onsetNanos - sentNotes.at(sentIx++)) / MasterClock::NANOS_PER_MILLISECOND);
+	}
+	std::sort(latencies.begin(), latencies.end());
+
+	result.sentCount = sentNotes.size();
+	result.detectedCount = latencies.size();
+	result.underrunCount = underrunCount;
+	result.lateMIDIEventCount = lateMIDIEventCount;
+	result.min = result.median = result.mean = result.p99 = result.max = result.jitter = 0.0;
+	if (latencies.isEmpty()) return;
+	double sum = 0.0;
+	for (int i = 0; i < latencies.size(); i++) {
+		sum += latencies.at(i);
+	}
+	result.mean = sum / latencies.size();
+	double squaredDeviationSum = 0.0;
+	for (int i = 0; i < latencies.size(); i++) {
+		squaredDeviationSum += (latencies.at(i) - result.mean) * (latencies.at(i) - result.mean);
+	}
+	result.jitter = sqrt(squaredDeviationSum / latencies.size());
+	result.min = latencies.first();
+	result.median = latencies.at(latencies.size() / 2);
+	result.p99 = latencies.at(qMin(latencies.size() - 1, (latencies.size() * 99) / 100));
+	result.max = latencies.last();
+}
+
+void LatencyTester::onProbeNoteSent(MasterClockNanos sentNanos) {
+	QMutexLocker locker(&mutex);
+	sentNotes.append(sentNanos);
+}
+
+void LatencyTester::onAudioRendered(const NullAudioStream &stream, const Bit16s *buffer, const uint frameCount, const MasterClockNanos playbackNanos) {
+	const quint32 sampleRate = stream.getSampleRate();
+	requiredQuietFrameCount = QUIET_MILLIS * sampleRate / MasterClock::MILLIS_PER_SECOND;
+	underrunCount = stream.getUnderrunCount();
+	lateMIDIEventCount = stream.getLateMIDIEventCount();
+	for (uint frameIx = 0; frameIx < frameCount; frameIx++) {
+		const int level = qMax(qAbs(int(buffer[2 * frameIx])), qAbs(int(buffer[2 * frameIx + 1])));
+		if (quietFrameCount >= requiredQuietFrameCount && level >= ONSET_LEVEL) {
+			QMutexLocker locker(&mutex);
+			detectedOnsets.append(playbackNanos + MasterClockNanos(frameIx) * MasterClock::NANOS_PER_SECOND / sampleRate);
+		}
+		quietFrameCount = level < QUIET_LEVEL ? quietFrameCount + 1 : 0;
+	}
+}
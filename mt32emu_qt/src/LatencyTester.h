@@ -0,0 +1,55 @@
+#ifndef LATENCY_TESTER_H
+#define LATENCY_TESTER_H
+
+#include <QtCore>
+
+#include "audiodrv/NullAudioDriver.h"
+#include "mididrv/TestDriver.h"
+
+class Master;
+
+struct LatencyTestResult {
+	AudioDriverSettings settings;
+	uint sentCount;
+	uint detectedCount;
+	// Statistics of the MIDI in to audio out latency in milliseconds
+	double min;
+	double median;
+	double mean;
+	double p99;
+	double max;
+	double jitter;
+	quint32 underrunCount;
+	quint32 lateMIDIEventCount;
+};
+
+// Headless harness that measures the delay between injecting a note-on with the current MasterClock time
+// (as a MIDI driver would) and the moment its onset is played by a simulated audio device, for a set
+// of audio driver configurations. The notes are sent by TestMidiDriver in the latency probe mode and
+// rendered using NullAudioDriver, the onsets are detected in the rendered stream.
+class LatencyTester : public LatencyProbeListener, public NullAudioMonitor {
+public:
+	// Runs the measurements configured by the command line arguments and prints the report to stdout.
+	// Returns the exit code of the application.
+	static int run(Master &master, const QStringList &args);
+
+private:
+	QMutex mutex;
+	QList<MasterClockNanos> sentNotes;
+	QList<MasterClockNanos> detectedOnsets;
+
+	// State of the onset detector, only accessed in the audio processing thread
+	uint quietFrameCount;
+	uint requiredQuietFrameCount;
+	volatile quint32 underrunCount;
+	volatile quint32 lateMIDIEventCount;
+
+	LatencyTester();
+	bool measure(Master &master, const AudioDriverSettings &settings, MasterClockNanos durationNanos, MasterClockNanos intervalNanos, LatencyTestResult &result);
+	void computeResult(LatencyTestResult &result);
+
+	void onProbeNoteSent(MasterClockNanos sentNanos);
+	void onAudioRendered(const NullAudioStream &stream, const MT32Emu::Bit16s *buffer, const uint frameCount, const MasterClockNanos playbackNanos);
+};
+
+#endif
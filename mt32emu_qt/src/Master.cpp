@@ -45,6 +45,7 @@
 #endif
 
 #include "audiodrv/AudioFileWriterDriver.h"
+#include "audiodrv/NullAudioDriver.h"
 
 #ifdef WITH_WIN32_MIDI_DRIVER
 #include "mididrv/Win32Driver.h"
@@ -169,6 +170,7 @@ void Master::initAudioDrivers() {
 	audioDrivers.append(new QtAudioDriver(this));
 #endif
 	audioDrivers.append(new AudioFileWriterDriver(this));
+	audioDrivers.append(new NullAudioDriver(this));
 }
 
 void Master::initMidiDrivers() {
@@ -213,6 +215,10 @@ void Master::showCommandLineHelp() {
 		"convert <output file> <SMF file...>\n"
 		"	convert specified standard MIDI files to a WAV/RAW wave\n"
 		"	output file and exit.\n"
+		"latency_test [option...] [<audio settings>...]\n"
+		"	measure MIDI in to audio out latency for the given audio\n"
+		"	settings without showing any windows, print the report and exit.\n"
+		"	Must be the first argument, see \"latency_test -help\".\n"
 	);
 }
 
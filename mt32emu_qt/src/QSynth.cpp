@@ -19,10 +19,14 @@
  *
  * Thread safety:
  * pushMIDIShortMessage() and pushMIDISysex() can be called by any number of threads safely.
+ * render() is invoked by the audio thread and never blocks. Changes made by the other threads reach the synth
+ * either via the timestamped control events or via the synth command queue serviced by render().
+ * Opening and closing the synth take the render guard, so render() outputs silence meanwhile.
  * All other functions may only be called by a single thread.
  */
 
 #include <QtGlobal>
+#include <QApplication>
 #include <QMessageBox>
 
 #include "QSynth.h"
@@ -34,6 +38,33 @@ using namespace MT32Emu;
 
 const int MIN_PARTIAL_COUNT = 8;
 const int MAX_PARTIAL_COUNT = 256;
+const int DEFERRED_REPORTS_DELIVERY_INTERVAL_MILLIS = 20;
+// Must be a power of 2.
+const uint SYNTH_COMMAND_QUEUE_SIZE = 1024;
+
+enum RenderGuardState {
+	RenderGuardState_FREE,
+	RenderGuardState_RENDERING,
+	RenderGuardState_LOCKED
+};
+
+// The command queue indices are published with release semantics and read with acquire semantics. This way, a command
+// is complete when the consumer sees the new end index, and the consumer is done with it when the slot is reused.
+static inline uint loadAcquire(QAtomicInt &index) {
+#if (QT_VERSION < QT_VERSION_CHECK(5, 0, 0))
+	return uint(index.fetchAndAddAcquire(0));
+#else
+	return uint(index.loadAcquire());
+#endif
+}
+
+static inline void storeRelease(QAtomicInt &index, uint newValue) {
+#if (QT_VERSION < QT_VERSION_CHECK(5, 0, 0))
+	index.fetchAndStoreRelease(int(newValue));
+#else
+	index.storeRelease(int(newValue));
+#endif
+}
 
 static const ROMImage *makeROMImage(const QDir &romDir, QString romFileName) {
 	FileStream *file = new FileStream;
@@ -43,6 +74,19 @@ static const ROMImage *makeROMImage(const QDir &romDir, QString romFileName) {
 	return NULL;
 }
 
+static void showROMError(const QString &message) {
+	qDebug() << "QSynth:" << message;
+	// The headless latency_test mode runs without QApplication, so no message box can be shown.
+	if (qobject_cast<QApplication *>(QCoreApplication::instance()) == NULL) return;
+	QMessageBox::critical(NULL, "Cannot open Synth", message);
+}
+
+static void closeAudioRecorder(AudioFileWriter *audioRecorder) {
+	if (audioRecorder == NULL) return;
+	audioRecorder->close();
+	delete audioRecorder;
+}
+
 QReportHandler::QReportHandler(QObject *parent) : QObject(parent) {
 	connect(this, SIGNAL(balloonMessageAppeared(const QString &, const QString &)), Master::getInstance(), SLOT(showBalloon(const QString &, const QString &)));
 }
@@ -60,11 +104,11 @@ void QReportHandler::showLCDMessage(const char *message) {
 }
 
 void QReportHandler::onErrorControlROM() {
-	QMessageBox::critical(NULL, "Cannot open Synth", "Control ROM file cannot be opened.");
+	showROMError("Control ROM file cannot be opened.");
 }
 
 void QReportHandler::onErrorPCMROM() {
-	QMessageBox::critical(NULL, "Cannot open Synth", "PCM ROM file cannot be opened.");
+	showROMError("PCM ROM file cannot be opened.");
 }
 
 void QReportHandler::onMIDIMessagePlayed() {
@@ -72,10 +116,11 @@ void QReportHandler::onMIDIMessagePlayed() {
 }
 
 void QReportHandler::onDeviceReconfig() {
-	QSynth *qsynth = (QSynth *)parent();
-	Bit8u currentMasterVolume = 0;
-	qsynth->synth->readMemory(0x40016, 1, &currentMasterVolume);
-	int masterVolume = currentMasterVolume;
+	// This is delivered in the GUI thread while the synth may be rendering, so the live synth memory isn't read here.
+	// The snapshot is published before the deferred reports are committed, so it already reflects the change.
+	StateSnapshot snapshot = StateSnapshot();
+	if (!((QSynth *)parent())->getStateSnapshot(snapshot)) return;
+	int masterVolume = snapshot.masterVolume;
 	emit masterVolumeChanged(masterVolume);
 }
 
@@ -107,11 +152,16 @@ void QReportHandler::onProgramChanged(Bit8u partNum, const char soundGroupName[]
 }
 
 QSynth::QSynth(QObject *parent) :
-	QObject(parent), state(SynthState_CLOSED), midiMutex(QMutex::Recursive),
-	controlROMImage(NULL), pcmROMImage(NULL), reportHandler(this), sampleRateConverter(NULL), audioRecorder(NULL)
+	QObject(parent), state(SynthState_CLOSED), midiMutex(QMutex::Recursive), renderGuard(RenderGuardState_FREE),
+	synthCommandQueue(new SynthCommand[SYNTH_COMMAND_QUEUE_SIZE]), synthCommandQueueStart(0), synthCommandQueueEnd(0),
+	controlROMImage(NULL), pcmROMImage(NULL),
+	emuDACInputMode(DACInputMode_NICE), midiDelayMode(MIDIDelayMode_DELAY_SHORT_MESSAGES_ONLY), outputGain(1.0f), reverbOutputGain(1.0f),
+	reverbEnabled(true), reverbOverridden(false), reversedStereoEnabled(false), niceAmpRamp(true),
+	reportHandler(this), sampleRateConverter(NULL), audioRecorder(NULL)
 {
-	synthMutex = new QMutex(QMutex::Recursive);
 	synth = new Synth(&reportHandler);
+	connect(&deferredReportsTimer, SIGNAL(timeout()), SLOT(deliverDeferredReports()));
+	deferredReportsTimer.start(DEFERRED_REPORTS_DELIVERY_INTERVAL_MILLIS);
 }
 
 QSynth::~QSynth() {
@@ -119,40 +169,123 @@ QSynth::~QSynth() {
 	delete audioRecorder;
 	delete sampleRateConverter;
 	delete synth;
-	delete synthMutex;
+	delete[] synthCommandQueue;
 }
 
 bool QSynth::isOpen() const {
 	return state == SynthState_OPEN;
 }
 
+void QSynth::lockSynth() {
+	// The renderer only holds the guard for a single block, so spinning here is cheap enough.
+	while (!renderGuard.testAndSetOrdered(RenderGuardState_FREE, RenderGuardState_LOCKED)) {
+		QThread::yieldCurrentThread();
+	}
+}
+
+void QSynth::unlockSynth() {
+	renderGuard.fetchAndStoreOrdered(RenderGuardState_FREE);
+}
+
+// Producers are serialised with midiMutex, the consumer is the thread that holds the render guard.
+void QSynth::pushSynthCommand(SynthCommand::Type type, Bit32u param, const QByteArray &data) {
+	midiMutex.lock();
+	if (!isOpen()) {
+		midiMutex.unlock();
+		return;
+	}
+	const uint end = loadAcquire(synthCommandQueueEnd);
+	const uint newEnd = (end + 1) & (SYNTH_COMMAND_QUEUE_SIZE - 1);
+	if (newEnd == loadAcquire(synthCommandQueueStart)) {
+		// The renderer isn't keeping up or isn't running at all, so apply the pending commands right here.
+		lockSynth();
+		processSynthCommands();
+		unlockSynth();
+	}
+	SynthCommand &command = synthCommandQueue[end];
+	command.type = type;
+	command.param = param;
+	// Any previous payload is released here rather than in the rendering thread.
+	command.data = data;
+	storeRelease(synthCommandQueueEnd, newEnd);
+	midiMutex.unlock();
+}
+
+void QSynth::processSynthCommands() {
+	uint start = loadAcquire(synthCommandQueueStart);
+	const uint end = loadAcquire(synthCommandQueueEnd);
+	while (start != end) {
+		executeSynthCommand(synthCommandQueue[start]);
+		start = (start + 1) & (SYNTH_COMMAND_QUEUE_SIZE - 1);
+		storeRelease(synthCommandQueueStart, start);
+	}
+}
+
+// The control event queue only overflows when the renderer isn't keeping up or isn't running at all. Like in pushSynthCommand(),
+// the pending changes are applied right here then, so that the new setting isn't overridden by stale control events later.
+// Must be called with midiMutex locked, returns with the synth locked.
+void QSynth::lockSynthForImmediateChange() {
+	lockSynth();
+	processSynthCommands();
+	synth->flushMIDIQueue();
+}
+
+void QSynth::executeSynthCommand(const SynthCommand &command) {
+	const Bit8u *data = (const Bit8u *)command.data.constData();
+	Bit32u dataLen = Bit32u(command.data.size());
+	switch (command.type) {
+	case SynthCommand::Type_PLAY_MSG_NOW:
+		synth->playMsgNow(command.param);
+		break;
+	case SynthCommand::Type_PLAY_SYSEX_NOW:
+		synth->playSysexNow(data, dataLen);
+		break;
+	case SynthCommand::Type_WRITE_SYSEX:
+		synth->writeSysex((Bit8u)command.param, data, dataLen);
+		break;
+	case SynthCommand::Type_OVERRIDE_REVERB_SETTINGS:
+		synth->setReverbOverridden(false);
+		synth->writeSysex(16, data, dataLen);
+		synth->setReverbOverridden(true);
+		break;
+	case SynthCommand::Type_SET_REVERB_OVERRIDDEN:
+		synth->setReverbOverridden(command.param != 0);
+		break;
+	case SynthCommand::Type_SET_REVERB_COMPATIBILITY_MODE: {
+		bool mt32CompatibleReverb;
+		if (command.param == ReverbCompatibilityMode_DEFAULT) {
+			mt32CompatibleReverb = synth->isDefaultReverbMT32Compatible();
+		} else {
+			mt32CompatibleReverb = command.param == ReverbCompatibilityMode_MT32;
+		}
+		synth->setReverbCompatibilityMode(mt32CompatibleReverb);
+		break;
+	}
+	case SynthCommand::Type_SET_MIDI_DELAY_MODE:
+		synth->setMIDIDelayMode((MIDIDelayMode)command.param);
+		break;
+	case SynthCommand::Type_SET_NICE_AMP_RAMP_ENABLED:
+		synth->setNiceAmpRampEnabled(command.param != 0);
+		break;
+	}
+}
+
 void QSynth::flushMIDIQueue() {
 	midiMutex.lock();
-	synthMutex->lock();
+	lockSynth();
+	processSynthCommands();
 	// Drain synth's queue first
 	synth->flushMIDIQueue();
-	synthMutex->unlock();
+	unlockSynth();
 	midiMutex.unlock();
 }
 
 void QSynth::playMIDIShortMessageNow(Bit32u msg) {
-	synthMutex->lock();
-	if (!isOpen()) {
-		synthMutex->unlock();
-		return;
-	}
-	synth->playMsgNow(msg);
-	synthMutex->unlock();
+	pushSynthCommand(SynthCommand::Type_PLAY_MSG_NOW, msg);
 }
 
 void QSynth::playMIDISysexNow(const Bit8u *sysex, Bit32u sysexLen) {
-	synthMutex->lock();
-	if (!isOpen()) {
-		synthMutex->unlock();
-		return;
-	}
-	synth->playSysexNow(sysex, sysexLen);
-	synthMutex->unlock();
+	pushSynthCommand(SynthCommand::Type_PLAY_SYSEX_NOW, 0, QByteArray((const char *)sysex, sysexLen));
 }
 
 bool QSynth::playMIDIShortMessage(Bit32u msg, quint64 timestamp) {
@@ -181,21 +314,35 @@ Bit32u QSynth::convertOutputToSynthTimestamp(quint64 timestamp) {
 	return Bit32u(sampleRateConverter->convertOutputToSynthTimestamp(timestamp));
 }
 
+// Control events timestamped this way apply at the start of the next rendering pass.
+Bit32u QSynth::getControlTimestamp() const {
+	return synth->getInternalRenderedSampleCount();
+}
+
 void QSynth::render(Bit16s *buffer, uint length) {
-	synthMutex->lock();
+	// Never wait for the synth to open or close in the audio thread.
+	if (!renderGuard.testAndSetOrdered(RenderGuardState_FREE, RenderGuardState_RENDERING)) {
+		memset(buffer, 0, length << 2);
+		emit audioBlockRendered();
+		return;
+	}
 	if (!isOpen()) {
-		synthMutex->unlock();
+		unlockSynth();
 
 		// Synth is closed, simply erase buffer content
 		memset(buffer, 0, length << 2);
 		emit audioBlockRendered();
 		return;
 	}
+	processSynthCommands();
 	sampleRateConverter->getOutputSamples(buffer, length);
 	if (isRecordingAudio()) {
-		if (!audioRecorder->write(buffer, length)) stopRecordingAudio();
+		if (!audioRecorder->write(buffer, length)) {
+			closeAudioRecorder(audioRecorder);
+			audioRecorder = NULL;
+		}
 	}
-	synthMutex->unlock();
+	unlockSynth();
 	emit audioBlockRendered();
 }
 
@@ -230,70 +377,71 @@ bool QSynth::open(uint &targetSampleRate, SamplerateConversionQuality srcQuality
 
 	targetSampleRate = SampleRateConverter::getSupportedOutputSampleRate(targetSampleRate);
 
-	if (synth->open(*controlROMImage, *pcmROMImage, Bit32u(synthProfile.partialCount), actualAnalogOutputMode)) {
-		setState(SynthState_OPEN);
-		reportHandler.onDeviceReconfig();
-		setSynthProfile(synthProfile, synthProfileName);
-		if (engageChannel1OnOpen) resetMIDIChannelsAssignment(true);
+	// The state monitor relies on snapshots published by the renderer, so that it doesn't contend with the audio thread.
+	synth->setStateSnapshotEnabled(true);
+	// Similarly, avoid emitting lots of queued signals from the audio thread with dense MIDI input.
+	synth->setDeferredReportingEnabled(true);
+	lockSynth();
+	bool synthOpened = synth->open(*controlROMImage, *pcmROMImage, Bit32u(synthProfile.partialCount), actualAnalogOutputMode);
+	if (synthOpened) {
 		if (targetSampleRate == 0) targetSampleRate = getSynthSampleRate();
 		sampleRateConverter = new SampleRateConverter(*synth, targetSampleRate, srcQuality);
-		return true;
+		storeRelease(synthCommandQueueStart, 0);
+		storeRelease(synthCommandQueueEnd, 0);
+	} else {
+		delete synth;
+		synth = new Synth(&reportHandler);
 	}
-	delete synth;
-	synth = new Synth(&reportHandler);
-	return false;
+	unlockSynth();
+	if (!synthOpened) return false;
+	setState(SynthState_OPEN);
+	reportHandler.onDeviceReconfig();
+	setSynthProfile(synthProfile, synthProfileName);
+	if (engageChannel1OnOpen) resetMIDIChannelsAssignment(true);
+	return true;
 }
 
 void QSynth::setMasterVolume(int masterVolume) {
 	Bit8u sysex[] = {0x10, 0x00, 0x16, (Bit8u)masterVolume};
-
-	synthMutex->lock();
-	if (!isOpen()) {
-		synthMutex->unlock();
-		return;
-	}
-	synth->writeSysex(16, sysex, 4);
-	synthMutex->unlock();
+	pushSynthCommand(SynthCommand::Type_WRITE_SYSEX, 16, QByteArray((const char *)sysex, sizeof(sysex)));
 }
 
-void QSynth::setOutputGain(float outputGain) {
-	synthMutex->lock();
-	if (!isOpen()) {
-		synthMutex->unlock();
-		return;
+void QSynth::setOutputGain(float newOutputGain) {
+	outputGain = newOutputGain;
+	midiMutex.lock();
+	if (isOpen() && !synth->setOutputGain(outputGain, getControlTimestamp())) {
+		lockSynthForImmediateChange();
+		synth->setOutputGain(outputGain);
+		unlockSynth();
 	}
-	synth->setOutputGain(outputGain);
-	synthMutex->unlock();
+	midiMutex.unlock();
 }
 
-void QSynth::setReverbOutputGain(float reverbOutputGain) {
-	synthMutex->lock();
-	if (!isOpen()) {
-		synthMutex->unlock();
-		return;
+void QSynth::setReverbOutputGain(float newReverbOutputGain) {
+	reverbOutputGain = newReverbOutputGain;
+	midiMutex.lock();
+	if (isOpen() && !synth->setReverbOutputGain(reverbOutputGain, getControlTimestamp())) {
+		lockSynthForImmediateChange();
+		synth->setReverbOutputGain(reverbOutputGain);
+		unlockSynth();
 	}
-	synth->setReverbOutputGain(reverbOutputGain);
-	synthMutex->unlock();
+	midiMutex.unlock();
 }
 
-void QSynth::setReverbEnabled(bool reverbEnabled) {
-	synthMutex->lock();
-	if (!isOpen()) {
-		synthMutex->unlock();
-		return;
+void QSynth::setReverbEnabled(bool newReverbEnabled) {
+	reverbEnabled = newReverbEnabled;
+	midiMutex.lock();
+	if (isOpen() && !synth->setReverbEnabled(reverbEnabled, getControlTimestamp())) {
+		lockSynthForImmediateChange();
+		synth->setReverbEnabled(reverbEnabled);
+		unlockSynth();
 	}
-	synth->setReverbEnabled(reverbEnabled);
-	synthMutex->unlock();
+	midiMutex.unlock();
 }
 
-void QSynth::setReverbOverridden(bool reverbOverridden) {
-	synthMutex->lock();
-	if (!isOpen()) {
-		synthMutex->unlock();
-		return;
-	}
-	synth->setReverbOverridden(reverbOverridden);
-	synthMutex->unlock();
+void QSynth::setReverbOverridden(bool newReverbOverridden) {
+	reverbOverridden = newReverbOverridden;
+	pushSynthCommand(SynthCommand::Type_SET_REVERB_OVERRIDDEN, reverbOverridden);
 }
 
 void QSynth::setReverbSettings(int reverbMode, int reverbTime, int reverbLevel) {
@@ -301,48 +449,31 @@ void QSynth::setReverbSettings(int reverbMode, int reverbTime, int reverbLevel)
 	this->reverbTime = reverbTime;
 	this->reverbLevel = reverbLevel;
 	Bit8u sysex[] = {0x10, 0x00, 0x01, (Bit8u)reverbMode, (Bit8u)reverbTime, (Bit8u)reverbLevel};
-
-	synthMutex->lock();
-	if (!isOpen()) {
-		synthMutex->unlock();
-		return;
-	}
-	synth->setReverbOverridden(false);
-	synth->writeSysex(16, sysex, 6);
-	synth->setReverbOverridden(true);
-	synthMutex->unlock();
+	reverbOverridden = true;
+	pushSynthCommand(SynthCommand::Type_OVERRIDE_REVERB_SETTINGS, 0, QByteArray((const char *)sysex, sizeof(sysex)));
 }
 
 void QSynth::setReversedStereoEnabled(bool enabled) {
-	synthMutex->lock();
-	if (!isOpen()) {
-		synthMutex->unlock();
-		return;
+	reversedStereoEnabled = enabled;
+	midiMutex.lock();
+	if (isOpen() && !synth->setReversedStereoEnabled(enabled, getControlTimestamp())) {
+		lockSynthForImmediateChange();
+		synth->setReversedStereoEnabled(enabled);
+		unlockSynth();
 	}
-	synth->setReversedStereoEnabled(enabled);
-	synthMutex->unlock();
+	midiMutex.unlock();
 }
 
 void QSynth::setNiceAmpRampEnabled(bool enabled) {
-	synthMutex->lock();
-	if (!isOpen()) {
-		synthMutex->unlock();
-		return;
-	}
-	synth->setNiceAmpRampEnabled(enabled);
-	synthMutex->unlock();
+	niceAmpRamp = enabled;
+	pushSynthCommand(SynthCommand::Type_SET_NICE_AMP_RAMP_ENABLED, enabled);
 }
 
 void QSynth::resetMIDIChannelsAssignment(bool engageChannel1) {
 	static const Bit8u sysexStandardChannelAssignment[] = {0x10, 0x00, 0x0d, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08, 0x09};
 	static const Bit8u sysexChannel1EngagedAssignment[] = {0x10, 0x00, 0x0d, 0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x09};
-	synthMutex->lock();
-	if (!isOpen()) {
-		synthMutex->unlock();
-		return;
-	}
-	synth->writeSysex(16, engageChannel1 ? sysexChannel1EngagedAssignment : sysexStandardChannelAssignment, sizeof(sysexStandardChannelAssignment));
-	synthMutex->unlock();
+	const Bit8u *sysex = engageChannel1 ? sysexChannel1EngagedAssignment : sysexStandardChannelAssignment;
+	pushSynthCommand(SynthCommand::Type_WRITE_SYSEX, 16, QByteArray((const char *)sysex, sizeof(sysexStandardChannelAssignment)));
 }
 
 void QSynth::setInitialMIDIChannelsAssignment(bool engageChannel1) {
@@ -351,39 +482,23 @@ void QSynth::setInitialMIDIChannelsAssignment(bool engageChannel1) {
 
 void QSynth::setReverbCompatibilityMode(ReverbCompatibilityMode useReverbCompatibilityMode) {
 	reverbCompatibilityMode = useReverbCompatibilityMode;
-	synthMutex->lock();
-	if (!isOpen()) {
-		synthMutex->unlock();
-		return;
-	}
-	bool mt32CompatibleReverb;
-	if (useReverbCompatibilityMode == ReverbCompatibilityMode_DEFAULT) {
-		mt32CompatibleReverb = synth->isDefaultReverbMT32Compatible();
-	} else {
-		mt32CompatibleReverb = useReverbCompatibilityMode == ReverbCompatibilityMode_MT32;
-	}
-	synth->setReverbCompatibilityMode(mt32CompatibleReverb);
-	synthMutex->unlock();
+	pushSynthCommand(SynthCommand::Type_SET_REVERB_COMPATIBILITY_MODE, useReverbCompatibilityMode);
 }
 
-void QSynth::setMIDIDelayMode(MIDIDelayMode midiDelayMode) {
-	synthMutex->lock();
-	if (!isOpen()) {
-		synthMutex->unlock();
-		return;
-	}
-	synth->setMIDIDelayMode(midiDelayMode);
-	synthMutex->unlock();
+void QSynth::setMIDIDelayMode(MIDIDelayMode newMIDIDelayMode) {
+	midiDelayMode = newMIDIDelayMode;
+	pushSynthCommand(SynthCommand::Type_SET_MIDI_DELAY_MODE, newMIDIDelayMode);
 }
 
-void QSynth::setDACInputMode(DACInputMode emuDACInputMode) {
-	synthMutex->lock();
-	if (!isOpen()) {
-		synthMutex->unlock();
-		return;
+void QSynth::setDACInputMode(DACInputMode newEmuDACInputMode) {
+	emuDACInputMode = newEmuDACInputMode;
+	midiMutex.lock();
+	if (isOpen() && !synth->setDACInputMode(emuDACInputMode, getControlTimestamp())) {
+		lockSynthForImmediateChange();
+		synth->setDACInputMode(emuDACInputMode);
+		unlockSynth();
 	}
-	synth->setDACInputMode(emuDACInputMode);
-	synthMutex->unlock();
+	midiMutex.unlock();
 }
 
 void QSynth::setAnalogOutputMode(MT32Emu::AnalogOutputMode useAnalogOutputMode) {
@@ -398,70 +513,72 @@ void QSynth::setPartialCount(int newPartialCount) {
 	partialCount = qBound(MIN_PARTIAL_COUNT, newPartialCount, MAX_PARTIAL_COUNT);
 }
 
+// The state queries below are only invoked from the GUI thread that also opens and closes the synth.
+// They read the snapshots published by the renderer and never take the render guard.
+bool QSynth::getStateSnapshot(StateSnapshot &snapshot) const {
+	return isOpen() && synth->getStateSnapshot(snapshot);
+}
+
 const QString QSynth::getPatchName(int partNum) const {
-	synthMutex->lock();
-	QString name = isOpen() ? QString().fromLocal8Bit(synth->getPatchName(partNum)) : QString("Channel %1").arg(partNum + 1);
-	synthMutex->unlock();
-	return name;
+	StateSnapshot snapshot = StateSnapshot();
+	if (!getStateSnapshot(snapshot)) return QString("Channel %1").arg(partNum + 1);
+	return QString().fromLocal8Bit(snapshot.patchNames[partNum]);
 }
 
 void QSynth::getPartStates(bool *partStates) const {
-	synthMutex->lock();
-	if (isOpen()) {
-		synth->getPartStates(partStates);
+	StateSnapshot snapshot = StateSnapshot();
+	if (!getStateSnapshot(snapshot)) return;
+	for (int partNumber = 0; partNumber < 9; partNumber++) {
+		partStates[partNumber] = (snapshot.partStates & (1 << partNumber)) != 0;
 	}
-	synthMutex->unlock();
 }
 
 void QSynth::getPartialStates(MT32Emu::PartialState *partialStates) const {
-	synthMutex->lock();
-	if (isOpen()) {
-		synth->getPartialStates(partialStates);
-	}
-	synthMutex->unlock();
+	StateSnapshot snapshot = StateSnapshot();
+	snapshot.partialStates = partialStates;
+	getStateSnapshot(snapshot);
 }
 
 unsigned int QSynth::getPlayingNotes(unsigned int partNumber, Bit8u *keys, Bit8u *velocities) const {
-	unsigned int playingNotes = 0;
-	synthMutex->lock();
-	playingNotes = synth->getPlayingNotes(partNumber, keys, velocities);
-	synthMutex->unlock();
+	StateSnapshot snapshot = StateSnapshot();
+	snapshot.keys = keys;
+	snapshot.velocities = velocities;
+	if (partNumber > 8 || !getStateSnapshot(snapshot)) return 0;
+	unsigned int firstNote = 0;
+	for (unsigned int i = 0; i < partNumber; i++) {
+		firstNote += snapshot.playingNoteCounts[i];
+	}
+	unsigned int playingNotes = snapshot.playingNoteCounts[partNumber];
+	memmove(keys, keys + firstNote, playingNotes);
+	memmove(velocities, velocities + firstNote, playingNotes);
 	return playingNotes;
 }
 
 unsigned int QSynth::getPartialCount() const {
-	synthMutex->lock();
-	unsigned int partialCount = synth->getPartialCount();
-	synthMutex->unlock();
-	return partialCount;
+	return synth->getPartialCount();
 }
 
 unsigned int QSynth::getSynthSampleRate() const {
 	return synth->getStereoOutputSampleRate();
 }
 
+// Only meant for the offline rendering where the caller is also the thread that renders.
 bool QSynth::isActive() const {
-	synthMutex->lock();
-	if (!isOpen()) {
-		synthMutex->unlock();
-		return false;
-	}
-	bool result = synth->isActive();
-	synthMutex->unlock();
-	return result;
+	return isOpen() && synth->isActive();
 }
 
 bool QSynth::reset() {
 	static Bit8u sysex[] = { 0x7f, 0, 0 };
 
 	midiMutex.lock();
-	synthMutex->lock();
 	if (isOpen()) {
 		setState(SynthState_CLOSING);
+		lockSynth();
+		processSynthCommands();
 		synth->writeSysex(16, sysex, 3);
+		unlockSynth();
 		setState(SynthState_OPEN);
 	}
-	synthMutex->unlock();
 	midiMutex.unlock();
 	return true;
 }
@@ -476,41 +593,41 @@ void QSynth::close() {
 	if (!isOpen()) return;
 	setState(SynthState_CLOSING);
 	midiMutex.lock();
-	synthMutex->lock();
+	lockSynth();
 	synth->close();
 	// This effectively resets rendered frame counter, audioStream is also going down
 	delete synth;
 	synth = new Synth(&reportHandler);
 	delete sampleRateConverter;
 	sampleRateConverter = NULL;
-	synthMutex->unlock();
+	// Commands pushed while the synth was open are stale now.
+	storeRelease(synthCommandQueueStart, loadAcquire(synthCommandQueueEnd));
+	unlockSynth();
 	midiMutex.unlock();
 	setState(SynthState_CLOSED);
 	freeROMImages();
 }
 
 void QSynth::getSynthProfile(SynthProfile &synthProfile) const {
-	synthMutex->lock();
 	synthProfile.romDir = romDir;
 	synthProfile.controlROMFileName = controlROMFileName;
 	synthProfile.pcmROMFileName = pcmROMFileName;
-	synthProfile.emuDACInputMode = synth->getDACInputMode();
-	synthProfile.midiDelayMode = synth->getMIDIDelayMode();
+	synthProfile.emuDACInputMode = emuDACInputMode;
+	synthProfile.midiDelayMode = midiDelayMode;
 	synthProfile.analogOutputMode = analogOutputMode;
 	synthProfile.rendererType = synth->getSelectedRendererType();
 	synthProfile.partialCount = partialCount;
 	synthProfile.reverbCompatibilityMode = reverbCompatibilityMode;
-	synthProfile.outputGain = synth->getOutputGain();
-	synthProfile.reverbOutputGain = synth->getReverbOutputGain();
-	synthProfile.reverbOverridden = synth->isReverbOverridden();
-	synthProfile.reverbEnabled = synth->isReverbEnabled() || !synthProfile.reverbOverridden;
+	synthProfile.outputGain = outputGain;
+	synthProfile.reverbOutputGain = reverbOutputGain;
+	synthProfile.reverbOverridden = reverbOverridden;
+	synthProfile.reverbEnabled = reverbEnabled || !reverbOverridden;
 	synthProfile.reverbMode = reverbMode;
 	synthProfile.reverbTime = reverbTime;
 	synthProfile.reverbLevel = reverbLevel;
-	synthProfile.reversedStereoEnabled = synth->isReversedStereoEnabled();
-	synthProfile.niceAmpRamp = synth->isNiceAmpRampEnabled();
+	synthProfile.reversedStereoEnabled = reversedStereoEnabled;
+	synthProfile.niceAmpRamp = niceAmpRamp;
 	synthProfile.engageChannel1OnOpen = engageChannel1OnOpen;
-	synthMutex->unlock();
 }
 
 void QSynth::setSynthProfile(const SynthProfile &synthProfile, QString useSynthProfileName) {
@@ -554,28 +671,31 @@ void QSynth::freeROMImages() {
 	Master::getInstance()->freeROMImages(cri, pri);
 }
 
+void QSynth::deliverDeferredReports() {
+	if (isOpen()) synth->deliverDeferredReports();
+}
+
 const QReportHandler *QSynth::getReportHandler() const {
 	return &reportHandler;
 }
 
+// The file I/O is done outside the render guard, only the recorder swap happens under it.
 void QSynth::startRecordingAudio(const QString &fileName) {
-	synthMutex->lock();
-	stopRecordingAudio();
-	audioRecorder = new AudioFileWriter(sampleRateConverter->convertSynthToOutputTimestamp(SAMPLE_RATE), fileName);
-	audioRecorder->open();
-	synthMutex->unlock();
+	AudioFileWriter *newAudioRecorder = new AudioFileWriter(sampleRateConverter->convertSynthToOutputTimestamp(SAMPLE_RATE), fileName);
+	newAudioRecorder->open();
+	lockSynth();
+	AudioFileWriter *oldAudioRecorder = audioRecorder;
+	audioRecorder = newAudioRecorder;
+	unlockSynth();
+	closeAudioRecorder(oldAudioRecorder);
 }
 
 void QSynth::stopRecordingAudio() {
-	synthMutex->lock();
-	if (!isRecordingAudio()) {
-		synthMutex->unlock();
-		return;
-	}
-	audioRecorder->close();
-	delete audioRecorder;
+	lockSynth();
+	AudioFileWriter *oldAudioRecorder = audioRecorder;
 	audioRecorder = NULL;
-	synthMutex->unlock();
+	unlockSynth();
+	closeAudioRecorder(oldAudioRecorder);
 }
 
 bool QSynth::isRecordingAudio() const {
@@ -40,6 +40,25 @@ struct SynthProfile {
 	bool niceAmpRamp;
 };
 
+// Operations that must be carried out by the thread rendering the synth.
+struct SynthCommand {
+	enum Type {
+		Type_PLAY_MSG_NOW,
+		Type_PLAY_SYSEX_NOW,
+		Type_WRITE_SYSEX,
+		Type_OVERRIDE_REVERB_SETTINGS,
+		Type_SET_REVERB_OVERRIDDEN,
+		Type_SET_REVERB_COMPATIBILITY_MODE,
+		Type_SET_MIDI_DELAY_MODE,
+		Type_SET_NICE_AMP_RAMP_ENABLED
+	};
+
+	Type type;
+	MT32Emu::Bit32u param;
+	// Owned by the queue slot, so that the rendering thread never frees memory.
+	QByteArray data;
+};
+
 class QReportHandler : public QObject, public MT32Emu::ReportHandler {
 	Q_OBJECT
 
@@ -78,8 +97,16 @@ friend class QReportHandler;
 private:
 	volatile SynthState state;
 
+	// Serialises all the producers, i.e. MIDI input, GUI and the open / close sequence.
 	QMutex midiMutex;
-	QMutex *synthMutex;
+	// Grants exclusive access to the synth either to the renderer or to the open / close sequence.
+	// The renderer never waits on it and simply outputs silence when the synth is locked.
+	QAtomicInt renderGuard;
+
+	// Lock-free SPSC queue of commands applied by the renderer before producing the next block.
+	SynthCommand *synthCommandQueue;
+	QAtomicInt synthCommandQueueStart;
+	QAtomicInt synthCommandQueueEnd;
 
 	QDir romDir;
 	QString controlROMFileName;
@@ -94,6 +121,16 @@ private:
 	ReverbCompatibilityMode reverbCompatibilityMode;
 	bool engageChannel1OnOpen;
 
+	// Requested settings that take effect asynchronously, cached for getSynthProfile().
+	MT32Emu::DACInputMode emuDACInputMode;
+	MT32Emu::MIDIDelayMode midiDelayMode;
+	float outputGain;
+	float reverbOutputGain;
+	bool reverbEnabled;
+	bool reverbOverridden;
+	bool reversedStereoEnabled;
+	bool niceAmpRamp;
+
 	MT32Emu::Synth *synth;
 	QReportHandler reportHandler;
 	QString synthProfileName;
@@ -101,9 +138,19 @@ private:
 	MT32Emu::SampleRateConverter *sampleRateConverter;
 	AudioFileWriter *audioRecorder;
 
+	// Delivers notifications gathered by the synth on the audio thread in the GUI thread.
+	QTimer deferredReportsTimer;
+
 	void setState(SynthState newState);
 	void freeROMImages();
 	MT32Emu::Bit32u convertOutputToSynthTimestamp(quint64 timestamp);
+	MT32Emu::Bit32u getControlTimestamp() const;
+	void lockSynth();
+	void unlockSynth();
+	void pushSynthCommand(SynthCommand::Type type, MT32Emu::Bit32u param, const QByteArray &data = QByteArray());
+	void processSynthCommands();
+	void executeSynthCommand(const SynthCommand &command);
+	void lockSynthForImmediateChange();
 
 public:
 	QSynth(QObject *parent = NULL);
@@ -143,6 +190,7 @@ public:
 	void setAnalogOutputMode(MT32Emu::AnalogOutputMode analogOutputMode);
 	void setRendererType(MT32Emu::RendererType useRendererType);
 	void setPartialCount(int partialCount);
+	bool getStateSnapshot(MT32Emu::StateSnapshot &snapshot) const;
 	const QString getPatchName(int partNum) const;
 	void getPartStates(bool *partStates) const;
 	void getPartialStates(MT32Emu::PartialState *partialStates) const;
@@ -155,6 +203,9 @@ public:
 	void stopRecordingAudio();
 	bool isRecordingAudio() const;
 
+private slots:
+	void deliverDeferredReports();
+
 signals:
 	void stateChanged(SynthState state);
 	void audioBlockRendered();
@@ -19,7 +19,7 @@
 #include "../Master.h"
 
 AudioStream::AudioStream(const AudioDriverSettings &useSettings, QSynth &useSynth, const quint32 useSampleRate) :
-	synth(useSynth), sampleRate(useSampleRate), settings(useSettings), renderedFramesCount(0), lastEstimatedPlayedFramesCount(0), resetScheduled(true)
+	synth(useSynth), sampleRate(useSampleRate), settings(useSettings), renderedFramesCount(0), lastEstimatedPlayedFramesCount(0), resetScheduled(true), lateMIDIEventCount(0)
 {
 	audioLatencyFrames = settings.audioLatency * sampleRate / MasterClock::MILLIS_PER_SECOND;
 	midiLatencyFrames = settings.midiLatency * sampleRate / MasterClock::MILLIS_PER_SECOND;
@@ -43,6 +43,7 @@ quint64 AudioStream::estimateMIDITimestamp(const MasterClockNanos refNanos) {
 	qint64 delay = qint64(timestamp - renderedFramesCount);
 	if (delay < 0) {
 		// Negative delay means our timing is broken. We want to absort all the jitter while keeping the latency at the minimum.
+		lateMIDIEventCount++;
 		if (isAutoLatencyMode()) {
 			midiLatencyFrames -= delay;
 		}
@@ -116,6 +117,10 @@ void AudioStream::updateTimeInfo(const MasterClockNanos measuredNanos, const qui
 	timeInfoIx = nextTimeInfoIx;
 }
 
+quint32 AudioStream::getLateMIDIEventCount() const {
+	return lateMIDIEventCount;
+}
+
 bool AudioStream::isAutoLatencyMode() const {
 	return settings.midiLatency == 0;
 }
@@ -26,6 +26,8 @@ protected:
 	quint64 renderedFramesCount;
 	quint64 lastEstimatedPlayedFramesCount;
 	bool resetScheduled;
+	// Number of MIDI events that arrived too late to be rendered at the estimated time
+	volatile quint32 lateMIDIEventCount;
 
 	struct {
 		MasterClockNanos lastPlayedNanos;
@@ -41,6 +43,7 @@ public:
 	AudioStream(const AudioDriverSettings &settings, QSynth &synth, const quint32 sampleRate);
 	virtual ~AudioStream() {}
 	virtual quint64 estimateMIDITimestamp(const MasterClockNanos refNanos = 0);
+	quint32 getLateMIDIEventCount() const;
 };
 
 class AudioDevice {
@@ -0,0 +1,149 @@
+/* Copyright (C) 2011-2019 Jerome Fisher, Sergey V. Mikayev
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include "NullAudioDriver.h"
+
+#include "../Master.h"
+#include "../MasterClock.h"
+#include "../QSynth.h"
+
+using namespace MT32Emu;
+
+static const unsigned int DEFAULT_CHUNK_MS = 10;
+static const unsigned int DEFAULT_AUDIO_LATENCY = 40;
+static const unsigned int DEFAULT_MIDI_LATENCY = 20;
+
+NullAudioProcessor::NullAudioProcessor(NullAudioStream &useStream) : stream(useStream), stopProcessing(false) {}
+
+void NullAudioProcessor::stop() {
+	stopProcessing = true;
+	wait();
+	stopProcessing = false;
+}
+
+void NullAudioProcessor::run() {
+	qDebug() << "NullAudioDriver: Processing thread started";
+	while (!stopProcessing) {
+		MasterClockNanos nanosNow = MasterClock::getClockNanos();
+		// The device must have played everything except the audio latency worth of frames before the next chunk fits.
+		const quint64 nextChunkEnd = stream.renderedFramesCount + stream.bufferSize;
+		const MasterClockNanos spaceAvailableNanos = stream.getFramePlaybackNanos(nextChunkEnd) - stream.audioLatencyFrames * MasterClock::NANOS_PER_SECOND / stream.sampleRate;
+		if (nanosNow < spaceAvailableNanos) {
+			MasterClock::sleepUntilClockNanos(spaceAvailableNanos);
+			continue;
+		}
+		const MasterClockNanos nextFrameNanos = stream.getFramePlaybackNanos(stream.renderedFramesCount);
+		if (nextFrameNanos < nanosNow) {
+			// Underrun, the device plays silence until the next chunk is rendered.
+			stream.firstFrameNanos += nanosNow - nextFrameNanos;
+			stream.underrunCount++;
+		}
+		const qint64 framesInAudioBuffer = qint64(stream.renderedFramesCount) - qint64((nanosNow - stream.firstFrameNanos) * stream.sampleRate / MasterClock::NANOS_PER_SECOND);
+		stream.updateTimeInfo(nanosNow, stream.settings.advancedTiming ? quint32(qMax(qint64(0), framesInAudioBuffer)) : 0);
+		stream.synth.render(stream.buffer, stream.bufferSize);
+		if (stream.monitor != NULL) {
+			stream.monitor->onAudioRendered(stream, stream.buffer, stream.bufferSize, stream.getFramePlaybackNanos(stream.renderedFramesCount));
+		}
+		stream.renderedFramesCount += stream.bufferSize;
+	}
+	qDebug() << "NullAudioDriver: Processing thread stopped";
+}
+
+NullAudioStream::NullAudioStream(const AudioDriverSettings &useSettings, QSynth &useSynth, const quint32 useSampleRate, NullAudioMonitor *useMonitor) :
+	AudioStream(useSettings, useSynth, useSampleRate), processor(*this), monitor(useMonitor), firstFrameNanos(0), underrunCount(0)
+{
+	bufferSize = settings.chunkLen * sampleRate / MasterClock::MILLIS_PER_SECOND;
+	buffer = new Bit16s[/* channels */ 2 * bufferSize];
+}
+
+NullAudioStream::~NullAudioStream() {
+	close();
+	delete[] buffer;
+}
+
+MasterClockNanos NullAudioStream::getFramePlaybackNanos(quint64 frameIx) const {
+	return firstFrameNanos + MasterClockNanos(frameIx * MasterClock::NANOS_PER_SECOND / sampleRate);
+}
+
+bool NullAudioStream::start() {
+	if (bufferSize == 0) return false;
+
+	// Setup initial MIDI latency
+	if (isAutoLatencyMode()) midiLatencyFrames = audioLatencyFrames + ((DEFAULT_MIDI_LATENCY * sampleRate) / MasterClock::MILLIS_PER_SECOND);
+
+	// The device starts with the buffer filled with silence.
+	timeInfo[0].lastPlayedNanos = MasterClock::getClockNanos();
+	timeInfo[1] = timeInfo[0];
+	firstFrameNanos = timeInfo[0].lastPlayedNanos + MasterClockNanos(audioLatencyFrames) * MasterClock::NANOS_PER_SECOND / sampleRate;
+	processor.start(QThread::TimeCriticalPriority);
+	return true;
+}
+
+void NullAudioStream::close() {
+	if (processor.isRunning()) processor.stop();
+}
+
+quint32 NullAudioStream::getSampleRate() const {
+	return sampleRate;
+}
+
+quint32 NullAudioStream::getUnderrunCount() const {
+	return underrunCount;
+}
+
+NullAudioDevice::NullAudioDevice(NullAudioDriver &driver) : AudioDevice(driver, "Null (no output)") {}
+
+AudioStream *NullAudioDevice::startAudioStream(QSynth &synth, const uint sampleRate) const {
+	NullAudioStream *stream = new NullAudioStream(driver.getAudioSettings(), synth, sampleRate, static_cast<NullAudioDriver &>(driver).monitor);
+	if (stream->start()) return stream;
+	delete stream;
+	return NULL;
+}
+
+NullAudioDriver::NullAudioDriver(Master *master) : AudioDriver("null", "Null"), monitor(NULL) {
+	Q_UNUSED(master);
+
+	loadAudioSettings();
+}
+
+NullAudioDriver::NullAudioDriver(const AudioDriverSettings &useSettings, NullAudioMonitor *useMonitor) :
+	AudioDriver("null", "Null"), monitor(useMonitor)
+{
+	settings = useSettings;
+	validateAudioSettings(settings);
+}
+
+const QList<const AudioDevice *> NullAudioDriver::createDeviceList() {
+	QList<const AudioDevice *> deviceList;
+	deviceList.append(new NullAudioDevice(*this));
+	return deviceList;
+}
+
+void NullAudioDriver::validateAudioSettings(AudioDriverSettings &settings) const {
+	if (settings.audioLatency == 0) {
+		settings.audioLatency = DEFAULT_AUDIO_LATENCY;
+	}
+	if (settings.chunkLen == 0) {
+		settings.chunkLen = DEFAULT_CHUNK_MS;
+	}
+	if (settings.chunkLen > settings.audioLatency) {
+		settings.chunkLen = settings.audioLatency;
+	}
+	if ((settings.midiLatency != 0) && (settings.midiLatency < settings.chunkLen)) {
+		settings.midiLatency = settings.chunkLen;
+	}
+}
@@ -0,0 +1,83 @@
+#ifndef NULL_AUDIO_DRIVER_H
+#define NULL_AUDIO_DRIVER_H
+
+#include <QtCore>
+
+#include <mt32emu/mt32emu.h>
+
+#include "AudioDriver.h"
+
+class Master;
+class QSynth;
+class NullAudioDriver;
+class NullAudioStream;
+
+// Receives the audio output of a NullAudioStream in the processing thread.
+class NullAudioMonitor {
+public:
+	virtual ~NullAudioMonitor() {}
+	// playbackNanos is the time when the first frame of the buffer is played by the simulated device.
+	virtual void onAudioRendered(const NullAudioStream &stream, const MT32Emu::Bit16s *buffer, const uint frameCount, const MasterClockNanos playbackNanos) = 0;
+};
+
+class NullAudioProcessor : public QThread {
+	Q_OBJECT
+public:
+	NullAudioProcessor(NullAudioStream &stream);
+	void stop();
+
+protected:
+	void run();
+
+private:
+	NullAudioStream &stream;
+	volatile bool stopProcessing;
+};
+
+// Simulates a playback device that consumes the rendered frames in real time from a buffer of the configured audio latency.
+// Rendering is done in a separate thread that blocks while the buffer is full, the same way the drivers with a blocking
+// write do. When rendering does not keep up, the device plays silence and the subsequent frames are delayed.
+class NullAudioStream : public AudioStream {
+	friend class NullAudioProcessor;
+private:
+	MT32Emu::Bit16s *buffer;
+	uint bufferSize;
+	NullAudioProcessor processor;
+	NullAudioMonitor *monitor;
+	// Time when the device starts playing the rendered frames, shifted forward on each underrun.
+	MasterClockNanos firstFrameNanos;
+	volatile quint32 underrunCount;
+
+	MasterClockNanos getFramePlaybackNanos(quint64 frameIx) const;
+
+public:
+	NullAudioStream(const AudioDriverSettings &settings, QSynth &synth, const quint32 sampleRate, NullAudioMonitor *monitor);
+	~NullAudioStream();
+	bool start();
+	void close();
+	quint32 getSampleRate() const;
+	quint32 getUnderrunCount() const;
+};
+
+class NullAudioDevice : public AudioDevice {
+friend class NullAudioDriver;
+	NullAudioDevice(NullAudioDriver &driver);
+public:
+	AudioStream *startAudioStream(QSynth &synth, const uint sampleRate) const;
+};
+
+// Renders audio with realistic timing but discards the output. Useful for measurements and for running without
+// a sound card. The output can be observed with a NullAudioMonitor.
+class NullAudioDriver : public AudioDriver {
+friend class NullAudioDevice;
+private:
+	NullAudioMonitor *monitor;
+	void validateAudioSettings(AudioDriverSettings &settings) const;
+public:
+	NullAudioDriver(Master *useMaster);
+	// Uses the given settings as is, rather than the stored ones. Intended for measurements.
+	NullAudioDriver(const AudioDriverSettings &useSettings, NullAudioMonitor *useMonitor);
+	const QList<const AudioDevice *> createDeviceList();
+};
+
+#endif
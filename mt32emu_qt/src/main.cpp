@@ -17,10 +17,20 @@
 #include <locale>
 #include <QApplication>
 
+#include "LatencyTester.h"
 #include "MainWindow.h"
 #include "Master.h"
 
 int main(int argv, char **args) {
+	if (argv > 1 && QString::compare(QString::fromLocal8Bit(args[1]), "latency_test", Qt::CaseInsensitive) == 0) {
+		// Headless mode, no windows are shown and the MIDI drivers are not started. As the GUI isn't initialised,
+		// it also runs without a display.
+		QCoreApplication app(argv, args);
+		app.setApplicationName("Munt mt32emu-qt");
+		std::locale::global(std::locale(""));
+		Master master;
+		return LatencyTester::run(master, app.arguments().mid(2));
+	}
 	QApplication app(argv, args);
 	app.setApplicationName("Munt mt32emu-qt");
 	app.setQuitOnLastWindowClosed(false);
@@ -23,6 +23,11 @@
 
 static const qint64 TEST1_EVENT_INTERVAL_NANOS = 8000000; // 256 samples;
 
+// Claves on the rhythm channel have a sharp attack and decay quickly, so that the onsets are easy to detect.
+static const MT32Emu::Bit32u PROBE_NOTE_ON = 0x7F4B99;
+static const MT32Emu::Bit32u PROBE_NOTE_OFF = 0x004B89;
+static const qint64 PROBE_NOTE_DURATION_NANOS = 20000000;
+
 TestProcessor::TestProcessor(TestMidiDriver *useTestMidiDriver) : testMidiDriver(useTestMidiDriver), stopProcessing(false) {
 }
 
@@ -36,6 +41,10 @@ void TestProcessor::stop() {
 }
 
 void TestProcessor::run() {
+	if (testMidiDriver->probeSynthRoute != NULL) {
+		runLatencyProbe();
+		return;
+	}
 	MidiSession *session1 = testMidiDriver->createMidiSession("Test 1");
 	MidiSession *session2 = NULL;//testMidiDriver->createMidiSession("Test 2");
 	qint64 currentNanos = MasterClock::getClockNanos();
@@ -57,8 +66,32 @@ void TestProcessor::run() {
 	}
 }
 
+void TestProcessor::runLatencyProbe() {
+	SynthRoute *synthRoute = testMidiDriver->probeSynthRoute;
+	const MasterClockNanos intervalNanos = testMidiDriver->probeIntervalNanos;
+	MasterClockNanos currentNanos = MasterClock::getClockNanos() + intervalNanos;
+	uint probeIx = 0;
+	while (!stopProcessing) {
+		MasterClock::sleepUntilClockNanos(currentNanos);
+		synthRoute->pushMIDIShortMessage(PROBE_NOTE_ON, currentNanos);
+		testMidiDriver->probeListener->onProbeNoteSent(currentNanos);
+		MasterClock::sleepUntilClockNanos(currentNanos + PROBE_NOTE_DURATION_NANOS);
+		synthRoute->pushMIDIShortMessage(PROBE_NOTE_OFF, currentNanos + PROBE_NOTE_DURATION_NANOS);
+		// Vary the interval by up to a quarter, so that the notes arrive at all phases relative to the audio chunks.
+		currentNanos += intervalNanos + (intervalNanos / 4) * ((probeIx++ * 37) % 101) / 100;
+	}
+	qDebug() << "Latency probe finished";
+}
+
+TestMidiDriver::TestMidiDriver(Master *useMaster) :
+	MidiDriver(useMaster), processor(this), probeSynthRoute(NULL), probeListener(NULL), probeIntervalNanos(0)
+{
+	name = "Test Driver";
+}
 
-TestMidiDriver::TestMidiDriver(Master *useMaster) : MidiDriver(useMaster), processor(this) {
+TestMidiDriver::TestMidiDriver(Master *useMaster, SynthRoute *useProbeSynthRoute, LatencyProbeListener *useProbeListener, MasterClockNanos useProbeIntervalNanos) :
+	MidiDriver(useMaster), processor(this), probeSynthRoute(useProbeSynthRoute), probeListener(useProbeListener), probeIntervalNanos(useProbeIntervalNanos)
+{
 	name = "Test Driver";
 }
 
@@ -6,8 +6,16 @@
 #include "MidiDriver.h"
 #include "../Master.h"
 
+class SynthRoute;
 class TestMidiDriver;
 
+// Receives the times at which the notes are sent in the latency probe mode.
+class LatencyProbeListener {
+public:
+	virtual ~LatencyProbeListener() {}
+	virtual void onProbeNoteSent(MasterClockNanos sentNanos) = 0;
+};
+
 class TestProcessor : public QThread {
 	Q_OBJECT
 public:
@@ -21,6 +29,8 @@ protected:
 private:
 	TestMidiDriver *testMidiDriver;
 	volatile bool stopProcessing;
+
+	void runLatencyProbe();
 };
 
 class TestMidiDriver : public MidiDriver {
@@ -28,11 +38,17 @@ class TestMidiDriver : public MidiDriver {
 	friend class TestProcessor;
 public:
 	TestMidiDriver(Master *master);
+	// In the latency probe mode, short notes are sent directly to the synth route at about the given interval,
+	// with the MasterClock time of sending as the timestamp, and the listener is notified of each note.
+	TestMidiDriver(Master *master, SynthRoute *probeSynthRoute, LatencyProbeListener *probeListener, MasterClockNanos probeIntervalNanos);
 	~TestMidiDriver();
 	void start();
 	void stop();
 private:
 	TestProcessor processor;
+	SynthRoute *probeSynthRoute;
+	LatencyProbeListener *probeListener;
+	MasterClockNanos probeIntervalNanos;
 };
 
 #endif
@@ -46,6 +46,13 @@ static const int DEFAULT_BUFFER_SIZE = 128 * 1024;
 // Maximum number of frames to render in each pass while waiting for reverb to become inactive.
 static const unsigned int MAX_REVERB_END_FRAMES = 8192;
 
+// Maximum number of raw streams that can be written to the output file multiplexed.
+static const int MAX_RAW_CHANNEL_COUNT = 20;
+// Number of streams rendered in the default raw stream mode.
+static const int DAC_STREAM_COUNT = 6;
+// Number of streams rendered when per-part streams are requested: 9 stereo parts followed by the stereo reverb return.
+static const int PART_STREAM_COUNT = 20;
+
 static const int HEADEROFFS_RIFFLEN = 4;
 static const int HEADEROFFS_FORMAT_TAG = 20;
 static const int HEADEROFFS_SAMPLERATE = 24;
@@ -101,8 +108,9 @@ struct Options {
 	MT32Emu::RendererType rendererType;
 	MT32Emu::SamplerateConversionQuality srcQuality;
 	int partialCount;
-	int rawChannelMap[8];
+	int rawChannelMap[MAX_RAW_CHANNEL_COUNT];
 	int rawChannelCount;
+	gboolean partStreams;
 
 	unsigned int renderMinFrames;
 	unsigned int renderMaxFrames;
@@ -117,7 +125,7 @@ struct Options {
 
 struct State {
 	void *stereoSampleBuffer;
-	void *rawSampleBuffer[6];
+	void *rawSampleBuffer[PART_STREAM_COUNT];
 	MT32Emu::Service &service;
 	FILE *outputFile;
 	bool lastInputFile;
@@ -161,6 +169,7 @@ static bool parseOptions(int argc, char *argv[], Options *options) {
 	options->srcQuality = SRC_QUALITIES[2];
 	options->sampleRate = 0;
 	options->rawChannelCount = 0;
+	options->partStreams = false;
 	options->outputSampleFormat = OUTPUT_SAMPLE_FORMAT_SINT16;
 
 	options->recordMaxStartSilentFrames = 0;
@@ -214,7 +223,7 @@ static bool parseOptions(int argc, char *argv[], Options *options) {
 		 "                 2: GENERATION1\n"
 		 "                 3: GENERATION2", "<dac_input_mode>"},
 		{"raw-stream", 'w', 0, G_OPTION_ARG_STRING_ARRAY, &rawStreams, "Write a raw file with signed 16-bit big-endian samples instead of a WAVE file, and include the specified channel.\n"
-		 "                This option can be specified multiple times (up to eight), in which case streams will be written to the file multiplexed sample-by-sample in the order given.\n"
+		 "                This option can be specified multiple times (up to twenty), in which case streams will be written to the file multiplexed sample-by-sample in the order given.\n"
 		 "                Available stream IDs:\n"
 		 "                -1: Dummy stream filled with 0\n"
 		 "                 0: [LA32] Left non-reverb\n"
@@ -222,7 +231,16 @@ static bool parseOptions(int argc, char *argv[], Options *options) {
 		 "                 2: [LA32] Left reverb dry\n"
 		 "                 3: [LA32] Right reverb dry\n"
 		 "                 4: [Reverb] Left reverb wet\n"
-		 "                 5: [Reverb] Right reverb wet", "<stream_id>"},
+		 "                 5: [Reverb] Right reverb wet\n"
+		 "                See --part-streams for stream IDs available in that mode.", "<stream_id>"},
+		{"part-streams", 0, 0, G_OPTION_ARG_NONE, &options->partStreams, "Render the dry signal of each part separately in a single pass and use these for the raw-stream option.\n"
+		 "                Available stream IDs:\n"
+		 "                -1: Dummy stream filled with 0\n"
+		 "                 0..15: [LA32] Left and right dry signal of parts 1 to 8, interleaved\n"
+		 "                 16: [LA32] Left dry signal of rhythm part\n"
+		 "                 17: [LA32] Right dry signal of rhythm part\n"
+		 "                 18: [Reverb] Left reverb wet\n"
+		 "                 19: [Reverb] Right reverb wet", NULL},
 
 		{"render-min", 0, 0, G_OPTION_ARG_INT, &renderMinFrames, "Render at least this many frames (default: 0) (NYI)", "<frame_count>"},
 		{"render-max", 'e', 0, G_OPTION_ARG_INT, &renderMaxFrames, "Render at most this many frames (default: -1)", "<frame_count>|-1 (unlimited)"},
@@ -288,17 +306,22 @@ static bool parseOptions(int argc, char *argv[], Options *options) {
 	if (options->recordMaxLA32EndSilentFrames < 0) {
 		options->recordMaxLA32EndSilentFrames = INT_MAX;
 	}
+	if (options->partStreams && (rawStreams == NULL || g_strv_length(rawStreams) == 0)) {
+		fprintf(stderr, "part-streams requires at least one raw-stream option\n");
+		parseSuccess = false;
+	}
 	if (rawStreams != NULL && g_strv_length(rawStreams) > 0) {
+		const int maxStreamId = (options->partStreams ? PART_STREAM_COUNT : DAC_STREAM_COUNT) - 1;
 		gchar **rawStream = rawStreams;
 		while(*rawStream != NULL) {
-			if (options->rawChannelCount == 8) {
-				fprintf(stderr, "Too many raw-stream options - maximum 8\n");
+			if (options->rawChannelCount == MAX_RAW_CHANNEL_COUNT) {
+				fprintf(stderr, "Too many raw-stream options - maximum %d\n", MAX_RAW_CHANNEL_COUNT);
 				parseSuccess = false;
 				break;
 			}
 			options->rawChannelMap[options->rawChannelCount] = atoi(*rawStream);
-			if (options->rawChannelMap[options->rawChannelCount] < -1 || options->rawChannelMap[options->rawChannelCount] > 5) {
-				fprintf(stderr, "Invalid option raw-stream option %s - must be a number between -1 and 5 (inclusive)\n", *rawStream);
+			if (options->rawChannelMap[options->rawChannelCount] < -1 || options->rawChannelMap[options->rawChannelCount] > maxStreamId) {
+				fprintf(stderr, "Invalid option raw-stream option %s - must be a number between -1 and %d (inclusive)\n", *rawStream, maxStreamId);
 				parseSuccess = false;
 				break;
 			}
@@ -590,11 +613,37 @@ static void renderStereo(unsigned int frameCount, const Options &options, State
 	}
 }
 
+static inline void renderPartStreams(MT32Emu::Service &service, void *rawSampleBuffer[], const unsigned int frameCount, const OUTPUT_SAMPLE_FORMAT outputSampleFormat) {
+	if (outputSampleFormat == OUTPUT_SAMPLE_FORMAT_IEEE_FLOAT32) {
+		mt32emu_part_output_float_streams streams;
+		for (int partNum = 0; partNum < 9; partNum++) {
+			streams.partLeft[partNum] = static_cast<float *>(rawSampleBuffer[2 * partNum]);
+			streams.partRight[partNum] = static_cast<float *>(rawSampleBuffer[2 * partNum + 1]);
+		}
+		streams.reverbWetLeft = static_cast<float *>(rawSampleBuffer[18]);
+		streams.reverbWetRight = static_cast<float *>(rawSampleBuffer[19]);
+		service.renderFloatPartStreams(&streams, frameCount);
+	} else {
+		mt32emu_part_output_bit16s_streams streams;
+		for (int partNum = 0; partNum < 9; partNum++) {
+			streams.partLeft[partNum] = static_cast<MT32Emu::Bit16s *>(rawSampleBuffer[2 * partNum]);
+			streams.partRight[partNum] = static_cast<MT32Emu::Bit16s *>(rawSampleBuffer[2 * partNum + 1]);
+		}
+		streams.reverbWetLeft = static_cast<MT32Emu::Bit16s *>(rawSampleBuffer[18]);
+		streams.reverbWetRight = static_cast<MT32Emu::Bit16s *>(rawSampleBuffer[19]);
+		service.renderBit16sPartStreams(&streams, frameCount);
+	}
+}
+
 static void renderRaw(unsigned int frameCount, const Options &options, State &state) {
 	state.renderedFrames += frameCount;
 	while (frameCount > 0) {
 		unsigned int renderedFramesThisPass = MIN(frameCount, options.bufferFrameCount);
-		renderRaw(state.service, state.rawSampleBuffer, renderedFramesThisPass, options.outputSampleFormat);
+		if (options.partStreams) {
+			renderPartStreams(state.service, state.rawSampleBuffer, renderedFramesThisPass, options.outputSampleFormat);
+		} else {
+			renderRaw(state.service, state.rawSampleBuffer, renderedFramesThisPass, options.outputSampleFormat);
+		}
 		for (unsigned int i = 0; i < renderedFramesThisPass; i++) {
 			bool allSilent = true;
 			for (int chanMapIx = 0; chanMapIx < options.rawChannelCount; chanMapIx++) {
@@ -884,10 +933,11 @@ int main(int argc, char *argv[]) {
 
 		if (outputFile != NULL) {
 			if (options.rawChannelCount > 0 || writeWAVEHeader(outputFile, options.sampleRate, options.outputSampleFormat)) {
-				State state = {NULL, {NULL, NULL, NULL, NULL, NULL, NULL}, service, outputFile, false, false, 0, 0, 0};
+				State state = {NULL, {NULL}, service, outputFile, false, false, 0, 0, 0};
 				state.outputFile = outputFile;
+				const int rawStreamCount = options.partStreams ? PART_STREAM_COUNT : DAC_STREAM_COUNT;
 				if (options.rawChannelCount > 0) {
-					for (int i = 0; i < 6; i++) {
+					for (int i = 0; i < rawStreamCount; i++) {
 						if (options.outputSampleFormat == OUTPUT_SAMPLE_FORMAT_IEEE_FLOAT32) {
 							state.rawSampleBuffer[i] = new float[options.bufferFrameCount];
 						} else {
@@ -911,12 +961,12 @@ int main(int argc, char *argv[]) {
 				}
 				if (options.outputSampleFormat == OUTPUT_SAMPLE_FORMAT_IEEE_FLOAT32) {
 					delete[] static_cast<float *>(state.stereoSampleBuffer);
-					for (int i = 0; i < 6; i++) {
+					for (int i = 0; i < PART_STREAM_COUNT; i++) {
 						delete[] static_cast<float *>(state.rawSampleBuffer[i]);
 					}
 				} else {
 					delete[] static_cast<MT32Emu::Bit16s *>(state.stereoSampleBuffer);
-					for (int i = 0; i < 6; i++) {
+					for (int i = 0; i < PART_STREAM_COUNT; i++) {
 						delete[] static_cast<MT32Emu::Bit16s *>(state.rawSampleBuffer[i]);
 					}
 				}